@@ -32,7 +32,17 @@
 
 // ASIHub implements serial communication
 ASIHub::ASIHub() :
-    ASIBase< ::HubBase, ASIHub >("") { // Note: do not pass a name
+    ASIBase< ::HubBase, ASIHub >(""), // Note: do not pass a name
+    pipeline_(
+        [this](const std::string &data) {
+            RETURN_ON_MM_ERROR ( ClearComPort() );
+            return WriteToComPort(port_.c_str(), reinterpret_cast<const unsigned char*>(data.c_str()),
+                (unsigned)data.length());
+        },
+        [this](std::string &reply) {
+            return GetSerialAnswer(port_.c_str(), g_SerialTerminatorDefault, reply);
+        }),
+    statusCache_(pipeline_) {
 
    CPropertyAction* pAct = new CPropertyAction(this, &ASIHub::OnPort);
    CreateProperty(MM::g_Keyword_Port, "Undefined", MM::String, false, pAct, true);
@@ -68,6 +78,11 @@ ASIHub::ASIHub() :
    AddAllowedValue(g_SerialTerminatorPropertyName, g_SerialTerminator_2);
    AddAllowedValue(g_SerialTerminatorPropertyName, g_SerialTerminator_3);
    AddAllowedValue(g_SerialTerminatorPropertyName, g_SerialTerminator_4);
+
+   // how long a status query answers the Busy() calls of all peripherals; 0 disables the cache
+   pAct = new CPropertyAction (this, &ASIHub::OnStatusCacheWindow);
+   CreateProperty(g_StatusCacheWindowPropertyName, "0", MM::Integer, false, pAct);
+   SetPropertyLimits(g_StatusCacheWindowPropertyName, 0, 1000);
 }
 
 int ASIHub::ClearComPort() {
@@ -76,6 +91,8 @@ int ASIHub::ClearComPort() {
 
 // Sends a command and gets the serial buffer (doesn't try to verify end of transmission)
 int ASIHub::QueryCommandUnterminatedResponse(const char *command, const long timeoutMs, unsigned long replyLength) {
+   MMThreadGuard g(threadLock_);
+   statusCache_.Invalidate();
    RETURN_ON_MM_ERROR ( ClearComPort() );
    RETURN_ON_MM_ERROR ( SendSerialCommand(port_.c_str(), command, "\r") );
    serialCommand_ = command;
@@ -102,6 +119,8 @@ int ASIHub::QueryCommandUnterminatedResponse(const char *command, const long tim
 // Note that the property SerialResponse property will only show the first 1023 characters of the controller's reply.
 int ASIHub::QueryCommandLongReply(const char *command, const char *replyTerminator)
 {
+   MMThreadGuard g(threadLock_);
+   statusCache_.Invalidate();
    RETURN_ON_MM_ERROR ( ClearComPort() );
    RETURN_ON_MM_ERROR ( SendSerialCommand(port_.c_str(), command, "\r") );
    serialCommand_ = command;
@@ -125,6 +144,7 @@ int ASIHub::QueryCommandLongReply(const char *command, const char *replyTerminat
 int ASIHub::QueryCommand(const char *command, const char *replyTerminator, const long delayMs)
 {
    MMThreadGuard g(threadLock_);
+   statusCache_.Invalidate();
    RETURN_ON_MM_ERROR ( ClearComPort() );
    RETURN_ON_MM_ERROR ( SendSerialCommand(port_.c_str(), command, "\r") );
    serialCommand_ = command;
@@ -133,6 +153,25 @@ int ASIHub::QueryCommand(const char *command, const char *replyTerminator, const
    return DEVICE_OK;
 }
 
+int ASIHub::QueryCommands(const std::vector<std::string> &commands, std::vector<std::string> &replies)
+{
+   MMThreadGuard g(threadLock_);
+   statusCache_.Invalidate();
+   RETURN_ON_MM_ERROR ( pipeline_.Query(commands, replies) );
+   if (!commands.empty())
+   {
+      serialCommand_ = commands.back();
+      serialAnswer_ = replies.back();
+   }
+   return DEVICE_OK;
+}
+
+int ASIHub::QueryAxesBusy(const std::vector<std::string> &axisLetters, bool &busy)
+{
+   MMThreadGuard g(threadLock_);
+   return statusCache_.QueryBusy(axisLetters, busy);
+}
+
 int ASIHub::QueryCommandVerify(const char *command, const char *expectedReplyPrefix, const char *replyTerminator, const long delayMs)
 {
    RETURN_ON_MM_ERROR ( QueryCommand(command, replyTerminator, delayMs) );
@@ -639,6 +678,21 @@ int ASIHub::OnSerialCommandOnlySendChanged(MM::PropertyBase* pProp, MM::ActionTy
    return DEVICE_OK;
 }
 
+int ASIHub::OnStatusCacheWindow(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+   if (eAct == MM::BeforeGet) {
+      MMThreadGuard g(threadLock_);
+      pProp->Set(statusCache_.GetWindowMs());
+   }
+   else if (eAct == MM::AfterSet) {
+      long tmp;
+      pProp->Get(tmp);
+      MMThreadGuard g(threadLock_);
+      statusCache_.SetWindowMs(tmp);
+   }
+   return DEVICE_OK;
+}
+
 // based on similar function in FreeSerialPort.cpp
 std::string ASIHub::EscapeControlCharacters(const std::string &v)
 {
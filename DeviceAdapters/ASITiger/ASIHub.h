@@ -23,6 +23,7 @@
 #pragma once
 
 #include "ASIBase.h"
+#include "ASIQueryPipeline.h"
 #include "MMDevice.h"
 #include "DeviceBase.h"
 #include "DeviceThreads.h"
@@ -88,6 +89,14 @@ public:
    int QueryCommandVerify(const std::string &command, const std::string &expectedReplyPrefix, const std::string &replyTerminator, const long delayMs)
       { return QueryCommandVerify(command.c_str(), expectedReplyPrefix.c_str(), replyTerminator.c_str(), delayMs); }
 
+   // QueryCommands sends all commands back to back and then reads the replies in order, saving
+   // the serial turnaround between commands; replies are not verified
+   int QueryCommands(const std::vector<std::string> &commands, std::vector<std::string> &replies);
+
+   // QueryAxesBusy asks for the status of the given axes ("RS <axis>?", firmware 2.7 and later) in one
+   // round trip, possibly answered from the status cache shared by all peripherals (see StatusCacheWindow property)
+   int QueryAxesBusy(const std::vector<std::string> &axisLetters, bool &busy);
+
    // accessing serial commands and answers
    std::string LastSerialAnswer() const { return serialAnswer_; } // use with caution!; crashes to access something that doesn't exist!
    std::string LastSerialCommand() const { return serialCommand_; }
@@ -146,6 +155,7 @@ public:
    int OnSerialCommandRepeatDuration(MM::PropertyBase* pProp, MM::ActionType eAct);
    int OnSerialCommandRepeatPeriod  (MM::PropertyBase* pProp, MM::ActionType eAct);
    int OnSerialCommandOnlySendChanged(MM::PropertyBase* pProp, MM::ActionType eAct);
+   int OnStatusCacheWindow          (MM::PropertyBase* pProp, MM::ActionType eAct);
 
 protected:
     std::string port_ = "Undefined"; // serial port to use for communication
@@ -159,6 +169,9 @@ private:
 
     MMThreadLock threadLock_; // used to lock thread during serial transaction
 
+    ASIQueryPipeline pipeline_; // pipelined queries through port_
+    ASIStatusCache statusCache_; // must be invalidated whenever a command is sent
+
     std::map<std::string, std::string> deviceMap_{}; // to implement properties shared between devices
     // key is the device name, value is the Tiger address (normally a single character, see note about addressChar_ in ASIPeripheralBase
 
@@ -0,0 +1,125 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          ASIQueryPipeline.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Pipelined serial queries and shared axis status cache
+//
+// COPYRIGHT:     Applied Scientific Instrumentation, Eugene OR
+//
+// LICENSE:       This file is distributed under the BSD license.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+//
+
+#include "ASIQueryPipeline.h"
+#include "ASITiger.h"
+#include "MMDeviceConstants.h"
+#include <cstdlib>
+
+int ASIQueryPipeline::Query(const std::vector<std::string>& commands,
+   std::vector<std::string>& replies) const
+{
+   replies.clear();
+   if (commands.empty())
+      return DEVICE_OK;
+
+   std::string data;
+   for (const std::string& command : commands)
+      data += command + "\r";
+   int ret = write_(data);
+   if (ret != DEVICE_OK)
+      return ret;
+
+   for (size_t i = 0; i < commands.size(); ++i)
+   {
+      std::string reply;
+      ret = readReply_(reply);
+      if (ret != DEVICE_OK)
+         return ret;
+      replies.push_back(reply);
+   }
+   return DEVICE_OK;
+}
+
+int ASIStatusCache::QueryBusy(const std::vector<std::string>& axisLetters, bool& busy)
+{
+   bool fresh = valid_ && windowMs_ > 0 &&
+      std::chrono::steady_clock::now() - refreshTime_ < std::chrono::milliseconds(windowMs_);
+   if (fresh)
+   {
+      for (const std::string& axis : axisLetters)
+      {
+         if (axisBusy_.find(axis) == axisBusy_.end())
+         {
+            fresh = false;
+            break;
+         }
+      }
+   }
+
+   if (!fresh)
+   {
+      int ret = Refresh(axisLetters);
+      if (ret != DEVICE_OK)
+         return ret;
+   }
+
+   busy = false;
+   for (const std::string& axis : axisLetters)
+      busy = busy || axisBusy_[axis];
+   return DEVICE_OK;
+}
+
+int ASIStatusCache::Refresh(const std::vector<std::string>& axisLetters)
+{
+   valid_ = false;
+   axisBusy_.clear();
+
+   // Without caching there is no point in querying other axes
+   std::vector<std::string> axes;
+   if (windowMs_ > 0)
+   {
+      knownAxes_.insert(axisLetters.begin(), axisLetters.end());
+      axes.assign(knownAxes_.begin(), knownAxes_.end());
+   }
+   else
+   {
+      axes = axisLetters;
+   }
+
+   std::vector<std::string> commands;
+   for (const std::string& axis : axes)
+      commands.push_back("RS " + axis + "?");
+
+   std::vector<std::string> replies;
+   int ret = pipeline_.Query(commands, replies);
+   if (ret != DEVICE_OK)
+      return ret;
+
+   // replies are of the form ":A B" (busy) or ":A N" (not busy)
+   for (size_t i = 0; i < axes.size(); ++i)
+   {
+      const std::string& reply = replies[i];
+      if (reply.compare(0, 2, ":A") != 0 || reply.length() < 4)
+      {
+         // start over from the requested axes, in case one of the other
+         // axes is no longer valid
+         knownAxes_.clear();
+         if (reply.length() > 3 && reply.compare(0, 2, ":N") == 0)
+            return ERR_ASICODE_OFFSET + atoi(reply.substr(3).c_str());
+         return ERR_UNRECOGNIZED_ANSWER;
+      }
+      axisBusy_[axes[i]] = (reply[3] == 'B');
+   }
+
+   refreshTime_ = std::chrono::steady_clock::now();
+   valid_ = true;
+   return DEVICE_OK;
+}
@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          ASIQueryPipeline.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Pipelined serial queries and shared axis status cache
+//
+// COPYRIGHT:     Applied Scientific Instrumentation, Eugene OR
+//
+// LICENSE:       This file is distributed under the BSD license.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+//
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////
+// Sends several queries back to back and matches the replies, which the
+// controller sends in command order, to the queries. This saves one serial
+// turnaround per query compared to sending each query after the previous
+// reply has arrived.
+// The transport is passed in so that this can be used without a Core (the
+// hub passes functions that go through the Core's serial port).
+////////////////////////////////////////////////////////////////
+
+class ASIQueryPipeline {
+public:
+   // Write raw characters to the controller
+   typedef std::function<int(const std::string& data)> WriteFunc;
+   // Read one terminated reply from the controller (without the terminator)
+   typedef std::function<int(std::string& reply)> ReadReplyFunc;
+
+   ASIQueryPipeline(WriteFunc write, ReadReplyFunc readReply) :
+      write_(write), readReply_(readReply) {}
+
+   // Send all commands (each terminated by CR) in a single write, then read
+   // one reply per command. Stops at the first reply that cannot be read, in
+   // which case replies holds the replies read so far.
+   int Query(const std::vector<std::string>& commands,
+      std::vector<std::string>& replies) const;
+
+private:
+   WriteFunc write_;
+   ReadReplyFunc readReply_;
+};
+
+////////////////////////////////////////////////////////////////
+// Caches the replies to "RS <axis>?" (firmware 2.7 and later) for a short
+// window, so that the Busy() calls of all peripherals on a controller are
+// served by one pipelined status query. Every axis queried once is included
+// in later refreshes. With a window of zero (the default), nothing is cached
+// and only the requested axes are queried (still in one round trip).
+// The cache must be invalidated whenever any other command is sent, because
+// a command may start a move.
+////////////////////////////////////////////////////////////////
+
+class ASIStatusCache {
+public:
+   explicit ASIStatusCache(const ASIQueryPipeline& pipeline) :
+      pipeline_(pipeline) {}
+
+   void SetWindowMs(long windowMs) { windowMs_ = windowMs; Invalidate(); }
+   long GetWindowMs() const { return windowMs_; }
+   void Invalidate() { valid_ = false; }
+
+   // Sets busy to true if any of the axes reports busy
+   int QueryBusy(const std::vector<std::string>& axisLetters, bool& busy);
+
+private:
+   int Refresh(const std::vector<std::string>& axisLetters);
+
+   const ASIQueryPipeline& pipeline_;
+   long windowMs_ = 0;
+   bool valid_ = false;
+   std::chrono::steady_clock::time_point refreshTime_;
+   std::set<std::string> knownAxes_;
+   std::map<std::string, bool> axisBusy_;
+};
@@ -573,21 +573,11 @@ bool CXYStage::Busy()
    std::ostringstream command;
    if (FirmwareVersionAtLeast(2.7)) // can use more accurate RS <axis>?
    {
-      command << "RS " << axisLetterX_ << "?";
-      if (hub_->QueryCommandVerify(command.str(),":A") != DEVICE_OK)  // say we aren't busy if we can't communicate
-         return false;
-      char c;
-      if (hub_->GetAnswerCharAtPosition3(c) != DEVICE_OK)
-         return false;
-      if (c == 'B')
-         return true;
-      command.str("");
-      command << "RS " << axisLetterY_ << "?";
-      if (hub_->QueryCommandVerify(command.str(),":A") != DEVICE_OK)  // say we aren't busy if we can't communicate
-         return false;
-      if (hub_->GetAnswerCharAtPosition3(c) != DEVICE_OK)
+      // both axes are queried in one round trip
+      bool busy;
+      if (hub_->QueryAxesBusy({ axisLetterX_, axisLetterY_ }, busy) != DEVICE_OK)  // say we aren't busy if we can't communicate
          return false;
-      return (c == 'B');
+      return busy;
    }
    else  // use LSB of the status byte as approximate status, not quite equivalent
    {
@@ -486,13 +486,10 @@ bool CZStage::Busy()
    }
    if (FirmwareVersionAtLeast(2.7)) // can use more accurate RS <axis>?
    {
-      command << "RS " << axisLetter_ << "?";
-      if (hub_->QueryCommandVerify(command.str(),":A") != DEVICE_OK)  // say we aren't busy if we can't communicate
-         return false;
-      char c;
-      if (hub_->GetAnswerCharAtPosition3(c) != DEVICE_OK)
+      bool busy;
+      if (hub_->QueryAxesBusy({ axisLetter_ }, busy) != DEVICE_OK)  // say we aren't busy if we can't communicate
          return false;
-      return (c == 'B');
+      return busy;
    }
    else  // use LSB of the status byte as approximate status, not quite equivalent
    {
@@ -0,0 +1,292 @@
+// DESCRIPTION:   Unit tests for ASITiger pipelined queries and status cache,
+//                against a scripted fake controller on a pseudoterminal
+//
+// COPYRIGHT:     Applied Scientific Instrumentation, Eugene OR
+//
+// LICENSE:       This file is distributed under the BSD license.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include <gtest/gtest.h>
+
+#include "ASIQueryPipeline.h"
+#include "ASITiger.h"
+#include "MMDeviceConstants.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// Answers each CR-terminated command written to the slave side of a pty
+// with the scripted reply (":N-1" if none), terminated by CRLF. Replies are
+// written one character at a time so that the reader sees them split.
+class FakeController
+{
+public:
+   FakeController() : stop_(false)
+   {
+      masterFd_ = posix_openpt(O_RDWR | O_NOCTTY);
+      EXPECT_GE(masterFd_, 0);
+      EXPECT_EQ(0, grantpt(masterFd_));
+      EXPECT_EQ(0, unlockpt(masterFd_));
+      slaveFd_ = open(ptsname(masterFd_), O_RDWR | O_NOCTTY);
+      EXPECT_GE(slaveFd_, 0);
+      termios tio;
+      tcgetattr(slaveFd_, &tio);
+      cfmakeraw(&tio);
+      tcsetattr(slaveFd_, TCSANOW, &tio);
+      thread_ = std::thread(&FakeController::Run, this);
+   }
+
+   ~FakeController()
+   {
+      stop_ = true;
+      thread_.join();
+      close(slaveFd_);
+      close(masterFd_);
+   }
+
+   void SetReply(const std::string& command, const std::string& reply)
+   {
+      std::lock_guard<std::mutex> g(mutex_);
+      script_[command] = reply;
+   }
+
+   std::vector<std::string> ReceivedCommands()
+   {
+      std::lock_guard<std::mutex> g(mutex_);
+      return received_;
+   }
+
+   void ClearReceivedCommands()
+   {
+      std::lock_guard<std::mutex> g(mutex_);
+      received_.clear();
+   }
+
+   ASIQueryPipeline MakePipeline()
+   {
+      return ASIQueryPipeline(
+         [this](const std::string& data) {
+            ++writes;
+            ssize_t n = write(slaveFd_, data.c_str(), data.length());
+            return n == (ssize_t)data.length() ? DEVICE_OK : DEVICE_ERR;
+         },
+         [this](std::string& reply) { return ReadReply(reply); });
+   }
+
+   int writes = 0;
+
+private:
+   int ReadReply(std::string& reply)
+   {
+      for (;;)
+      {
+         size_t pos = pending_.find("\r\n");
+         if (pos != std::string::npos)
+         {
+            reply = pending_.substr(0, pos);
+            pending_.erase(0, pos + 2);
+            return DEVICE_OK;
+         }
+         pollfd pfd = { slaveFd_, POLLIN, 0 };
+         if (poll(&pfd, 1, 2000) <= 0)
+            return DEVICE_SERIAL_TIMEOUT;
+         char buf[256];
+         ssize_t n = read(slaveFd_, buf, sizeof(buf));
+         if (n <= 0)
+            return DEVICE_SERIAL_TIMEOUT;
+         pending_.append(buf, n);
+      }
+   }
+
+   void Run()
+   {
+      std::string line;
+      while (!stop_)
+      {
+         pollfd pfd = { masterFd_, POLLIN, 0 };
+         if (poll(&pfd, 1, 20) <= 0)
+            continue;
+         char buf[256];
+         ssize_t n = read(masterFd_, buf, sizeof(buf));
+         for (ssize_t i = 0; i < n; ++i)
+         {
+            if (buf[i] != '\r')
+            {
+               line += buf[i];
+               continue;
+            }
+            std::string reply = ":N-1";
+            {
+               std::lock_guard<std::mutex> g(mutex_);
+               received_.push_back(line);
+               auto it = script_.find(line);
+               if (it != script_.end())
+                  reply = it->second;
+            }
+            reply += "\r\n";
+            for (char c : reply)
+               (void)write(masterFd_, &c, 1);
+            line.clear();
+         }
+      }
+   }
+
+   int masterFd_;
+   int slaveFd_;
+   std::string pending_;
+   std::atomic<bool> stop_;
+   std::mutex mutex_;
+   std::map<std::string, std::string> script_;
+   std::vector<std::string> received_;
+   std::thread thread_;
+};
+
+
+TEST(QueryPipelineTests, RepliesMatchCommandsInOrder)
+{
+   FakeController controller;
+   controller.SetReply("W X", ":A 100");
+   controller.SetReply("W Y", ":A 200");
+   controller.SetReply("W Z", ":A 300");
+   ASIQueryPipeline pipeline = controller.MakePipeline();
+
+   std::vector<std::string> replies;
+   ASSERT_EQ(DEVICE_OK, pipeline.Query({ "W X", "W Y", "W Z" }, replies));
+   ASSERT_EQ(3u, replies.size());
+   EXPECT_EQ(":A 100", replies[0]);
+   EXPECT_EQ(":A 200", replies[1]);
+   EXPECT_EQ(":A 300", replies[2]);
+   // All commands were sent before any reply was read
+   EXPECT_EQ(1, controller.writes);
+
+   std::vector<std::string> expected = { "W X", "W Y", "W Z" };
+   EXPECT_EQ(expected, controller.ReceivedCommands());
+}
+
+TEST(QueryPipelineTests, EmptyQuerySendsNothing)
+{
+   FakeController controller;
+   ASIQueryPipeline pipeline = controller.MakePipeline();
+   std::vector<std::string> replies = { "stale" };
+   EXPECT_EQ(DEVICE_OK, pipeline.Query({}, replies));
+   EXPECT_TRUE(replies.empty());
+   EXPECT_EQ(0, controller.writes);
+}
+
+TEST(StatusCacheTests, WithoutWindowEveryCallQueriesRequestedAxes)
+{
+   FakeController controller;
+   controller.SetReply("RS X?", ":A N");
+   controller.SetReply("RS Y?", ":A B");
+   controller.SetReply("RS Z?", ":A N");
+   ASIQueryPipeline pipeline = controller.MakePipeline();
+   ASIStatusCache cache(pipeline);
+
+   bool busy = false;
+   ASSERT_EQ(DEVICE_OK, cache.QueryBusy({ "X", "Y" }, busy));
+   EXPECT_TRUE(busy);
+   ASSERT_EQ(DEVICE_OK, cache.QueryBusy({ "Z" }, busy));
+   EXPECT_FALSE(busy);
+   ASSERT_EQ(DEVICE_OK, cache.QueryBusy({ "Z" }, busy));
+
+   std::vector<std::string> expected = { "RS X?", "RS Y?", "RS Z?", "RS Z?" };
+   EXPECT_EQ(expected, controller.ReceivedCommands());
+   EXPECT_EQ(3, controller.writes);
+}
+
+TEST(StatusCacheTests, OneQueryServesAllKnownAxesWithinWindow)
+{
+   FakeController controller;
+   controller.SetReply("RS X?", ":A N");
+   controller.SetReply("RS Y?", ":A N");
+   controller.SetReply("RS Z?", ":A B");
+   ASIQueryPipeline pipeline = controller.MakePipeline();
+   ASIStatusCache cache(pipeline);
+   cache.SetWindowMs(60000);
+
+   bool busy = true;
+   ASSERT_EQ(DEVICE_OK, cache.QueryBusy({ "X", "Y" }, busy));
+   EXPECT_FALSE(busy);
+   // Z is not known yet, so all axes are refreshed
+   ASSERT_EQ(DEVICE_OK, cache.QueryBusy({ "Z" }, busy));
+   EXPECT_TRUE(busy);
+   controller.ClearReceivedCommands();
+
+   // Served from the cache
+   ASSERT_EQ(DEVICE_OK, cache.QueryBusy({ "X", "Y" }, busy));
+   EXPECT_FALSE(busy);
+   ASSERT_EQ(DEVICE_OK, cache.QueryBusy({ "Z" }, busy));
+   EXPECT_TRUE(busy);
+   EXPECT_TRUE(controller.ReceivedCommands().empty());
+
+   // After a command (e.g. a move) the status must be queried again
+   controller.SetReply("RS Z?", ":A N");
+   cache.Invalidate();
+   ASSERT_EQ(DEVICE_OK, cache.QueryBusy({ "Z" }, busy));
+   EXPECT_FALSE(busy);
+   std::vector<std::string> expected = { "RS X?", "RS Y?", "RS Z?" };
+   EXPECT_EQ(expected, controller.ReceivedCommands());
+}
+
+TEST(StatusCacheTests, ExpiredWindowQueriesAgain)
+{
+   FakeController controller;
+   controller.SetReply("RS X?", ":A B");
+   ASIQueryPipeline pipeline = controller.MakePipeline();
+   ASIStatusCache cache(pipeline);
+   cache.SetWindowMs(20);
+
+   bool busy = false;
+   ASSERT_EQ(DEVICE_OK, cache.QueryBusy({ "X" }, busy));
+   EXPECT_TRUE(busy);
+   std::this_thread::sleep_for(std::chrono::milliseconds(40));
+   controller.SetReply("RS X?", ":A N");
+   ASSERT_EQ(DEVICE_OK, cache.QueryBusy({ "X" }, busy));
+   EXPECT_FALSE(busy);
+   EXPECT_EQ(2u, controller.ReceivedCommands().size());
+}
+
+TEST(StatusCacheTests, ErrorReplyIsReported)
+{
+   FakeController controller;
+   controller.SetReply("RS X?", ":A N");
+   ASIQueryPipeline pipeline = controller.MakePipeline();
+   ASIStatusCache cache(pipeline);
+   cache.SetWindowMs(60000);
+
+   bool busy;
+   ASSERT_EQ(DEVICE_OK, cache.QueryBusy({ "X" }, busy));
+   // Q is unscripted, so the controller replies ":N-1"
+   EXPECT_EQ(ERR_ASICODE_OFFSET + 1, cache.QueryBusy({ "Q" }, busy));
+
+   // The failed refresh is not cached and X alone can still be queried
+   controller.ClearReceivedCommands();
+   ASSERT_EQ(DEVICE_OK, cache.QueryBusy({ "X" }, busy));
+   std::vector<std::string> expected = { "RS X?" };
+   EXPECT_EQ(expected, controller.ReceivedCommands());
+}
+
+int main(int argc, char **argv)
+{
+   ::testing::InitGoogleTest(&argc, argv);
+   return RUN_ALL_TESTS();
+}
@@ -34,7 +34,10 @@
 #include <sstream>
 #include <algorithm>
 #include <iostream>
+#include <fstream>
 #include <future>
+#include <chrono>
+#include <thread>
 
 #ifdef _WIN32
    #define WIN32_LEAN_AND_MEAN
@@ -103,6 +106,7 @@ CDemoCamera::CDemoCamera()
 
    // call the base class method to set-up default error codes/messages
    InitializeDefaultErrorMessages();
+   SetErrorText(ERR_BENCHMARK_RAW_FILE, "Benchmark raw file cannot be read or is smaller than one frame");
    readoutStartTime_ = GetCurrentMMTime();
    thd_ = new MySequenceThread(this);
 
@@ -322,6 +326,22 @@ int CDemoCamera::Initialize()
    AddAllowedValue("FastImage", "0");
    AddAllowedValue("FastImage", "1");
 
+   // Benchmark mode: sequence acquisitions replay a ring of frames, rendered
+   // (or read from a raw file of frames matching the current image size)
+   // when the sequence starts, at a fixed frame rate (0 for no pacing)
+   CreateIntegerProperty("BenchmarkMode", 0, false);
+   AddAllowedValue("BenchmarkMode", "0");
+   AddAllowedValue("BenchmarkMode", "1");
+   CreateFloatProperty("BenchmarkFrameRate", 100.0, false);
+   SetPropertyLimits("BenchmarkFrameRate", 0.0, 100000.0);
+   CreateIntegerProperty("BenchmarkRingSize", 16, false);
+   SetPropertyLimits("BenchmarkRingSize", 1, 1024);
+   CreateStringProperty("BenchmarkRawFile", "", false);
+   pAct = new CPropertyAction (this, &CDemoCamera::OnBenchmarkPacingError);
+   CreateFloatProperty("BenchmarkPacingErrorUs", 0.0, true, pAct);
+   pAct = new CPropertyAction (this, &CDemoCamera::OnBenchmarkDroppedFrames);
+   CreateIntegerProperty("BenchmarkDroppedFrames", 0, true, pAct);
+
    pAct = new CPropertyAction (this, &CDemoCamera::OnFractionOfPixelsToDropOrSaturate);
    CreateFloatProperty("FractionOfPixelsToDropOrSaturate", 0.002, false, pAct);
 	SetPropertyLimits("FractionOfPixelsToDropOrSaturate", 0., 0.1);
@@ -383,6 +403,11 @@ int CDemoCamera::Initialize()
    CreateFloatProperty(propName.c_str(), photonFlux_, false, pAct);
    SetPropertyLimits(propName.c_str(), 2.0, 5000.0);
 
+   // Seed for the Noise type camera; setting it restarts the (reproducible)
+   // sequence of noise frames
+   pAct = new CPropertyAction(this, &CDemoCamera::OnNoiseSeed);
+   CreateIntegerProperty("NoiseSeed", 0, false, pAct);
+
    // Bead mode properties
    pAct = new CPropertyAction(this, &CDemoCamera::OnBeadDensity);
    nRet = CreateIntegerProperty("BeadDensity", beadDensity_, false, pAct);
@@ -947,11 +972,22 @@ int CDemoCamera::StartSequenceAcquisition(long numImages, double interval_ms, bo
    if (IsCapturing())
       return DEVICE_CAMERA_BUSY_ACQUIRING;
 
+   long benchmarkMode = 0;
+   GetProperty("BenchmarkMode", benchmarkMode);
+   benchmarkMode_ = (benchmarkMode != 0);
+   if (benchmarkMode_)
+   {
+      int ret = BuildBenchmarkRing();
+      if (ret != DEVICE_OK)
+         return ret;
+   }
+
    int ret = GetCoreCallback()->PrepareForAcq(this);
    if (ret != DEVICE_OK)
       return ret;
    sequenceStartTime_ = GetCurrentMMTime();
    imageCounter_ = 0;
+   benchmarkStart_ = std::chrono::steady_clock::now();
    thd_->Start(numImages,interval_ms);
    stopOnOverflow_ = stopOnOverflow;
    return DEVICE_OK;
@@ -998,6 +1034,9 @@ int CDemoCamera::InsertImage()
  */
 int CDemoCamera::RunSequenceOnThread()
 {
+   if (benchmarkMode_)
+      return InsertBenchmarkFrame();
+
    MM::MMTime startTime = GetCurrentMMTime();
    
    // Trigger
@@ -1030,6 +1069,125 @@ int CDemoCamera::RunSequenceOnThread()
    return InsertImage();
 };
 
+/*
+ * Fills the benchmark ring, either from the raw file (frames of the current
+ * image size, repeated if the file holds fewer than the ring size) or with
+ * synthetic images, and resets the pacing statistics
+ */
+int CDemoCamera::BuildBenchmarkRing()
+{
+   long ringSize = 1;
+   GetProperty("BenchmarkRingSize", ringSize);
+   GetProperty("BenchmarkFrameRate", benchmarkFrameRate_);
+   char rawFile[MM::MaxStrLength];
+   GetProperty("BenchmarkRawFile", rawFile);
+
+   const size_t frameBytes = GetImageBufferSize();
+   benchmarkRing_.assign(ringSize, std::vector<unsigned char>(frameBytes));
+   if (rawFile[0] != '\0')
+   {
+      std::ifstream ifs(rawFile, std::ios::binary);
+      long nrRead = 0;
+      while (nrRead < ringSize && ifs.read(
+            reinterpret_cast<char*>(benchmarkRing_[nrRead].data()), frameBytes))
+         ++nrRead;
+      if (nrRead == 0)
+      {
+         benchmarkRing_.clear();
+         return ERR_BENCHMARK_RAW_FILE;
+      }
+      for (long i = nrRead; i < ringSize; ++i)
+         benchmarkRing_[i] = benchmarkRing_[i % nrRead];
+   }
+   else
+   {
+      const double exposure = GetExposure();
+      for (long i = 0; i < ringSize; ++i)
+      {
+         GenerateSyntheticImage(img_, exposure);
+         MMThreadGuard g(imgPixelsLock_);
+         memcpy(benchmarkRing_[i].data(), img_.GetPixels(), frameBytes);
+      }
+   }
+
+   benchmarkSlot_ = 0;
+   std::lock_guard<std::mutex> lock(benchmarkStatsMutex_);
+   benchmarkDroppedFrames_ = 0;
+   benchmarkPacedFrames_ = 0;
+   benchmarkSumSqErrorUs_ = 0.0;
+   return DEVICE_OK;
+}
+
+/*
+ * Sleep until shortly before the deadline, then spin, as sleeping alone is
+ * only accurate to the scheduler tick
+ */
+static void WaitUntil(std::chrono::steady_clock::time_point deadline)
+{
+   const auto spinTime = std::chrono::milliseconds(2);
+   const auto now = std::chrono::steady_clock::now();
+   if (deadline - now > spinTime)
+      std::this_thread::sleep_for(deadline - now - spinTime);
+   while (std::chrono::steady_clock::now() < deadline)
+      ;
+}
+
+/*
+ * Inserts the next frame of the benchmark ring at its scheduled time.
+ * Frame n is due at n / BenchmarkFrameRate after the start of the sequence;
+ * frames whose time has entirely passed are dropped (and counted), as a real
+ * camera would overwrite them. The ImageNumber tag is the schedule slot, so
+ * drops show up as gaps.
+ */
+int CDemoCamera::InsertBenchmarkFrame()
+{
+   using namespace std::chrono;
+   const bool paced = benchmarkFrameRate_ > 0.0;
+   steady_clock::time_point due = benchmarkStart_;
+   long dropped = 0;
+   if (paced)
+   {
+      const duration<double> period(1.0 / benchmarkFrameRate_);
+      const auto dueAt = [&](long long slot) {
+         return benchmarkStart_ +
+            duration_cast<steady_clock::duration>(period * static_cast<double>(slot));
+      };
+      due = dueAt(benchmarkSlot_);
+      const auto late = steady_clock::now() - due;
+      if (late >= period)
+      {
+         dropped = static_cast<long>(late / period);
+         benchmarkSlot_ += dropped;
+         due = dueAt(benchmarkSlot_);
+      }
+      WaitUntil(due);
+   }
+   const steady_clock::time_point now = steady_clock::now();
+   const long long slot = benchmarkSlot_++;
+
+   if (paced)
+   {
+      const double errorUs = duration<double, std::micro>(now - due).count();
+      std::lock_guard<std::mutex> lock(benchmarkStatsMutex_);
+      benchmarkDroppedFrames_ += dropped;
+      ++benchmarkPacedFrames_;
+      benchmarkSumSqErrorUs_ += errorUs * errorUs;
+   }
+
+   char label[MM::MaxStrLength];
+   GetLabel(label);
+   MM::CameraImageMetadata md;
+   md.AddTag(MM::g_Keyword_Metadata_CameraLabel, label);
+   md.AddTag(MM::g_Keyword_Metadata_ImageNumber, CDeviceUtils::ConvertToString(static_cast<long>(slot)));
+   md.AddTag(MM::g_Keyword_Elapsed_Time_ms, CDeviceUtils::ConvertToString(
+         duration<double, std::milli>(now - benchmarkStart_).count()));
+   imageCounter_++;
+
+   const std::vector<unsigned char>& frame = benchmarkRing_[slot % benchmarkRing_.size()];
+   return GetCoreCallback()->InsertImage(this, frame.data(), GetImageWidth(),
+         GetImageHeight(), GetImageBytesPerPixel(), nComponents_, md.Serialize());
+}
+
 bool CDemoCamera::IsCapturing() {
    return !thd_->IsStopped();
 }
@@ -1264,6 +1422,7 @@ int CDemoCamera::OnPixelType(MM::PropertyBase* pProp, MM::ActionType eAct)
          {
             nComponents_ = 1;
             img_.Resize(img_.Width(), img_.Height(), 1);
+            pixelType_ = PIXELTYPE_8BIT;
             bitDepth_ = 8;
             ret=DEVICE_OK;
          }
@@ -1271,6 +1430,7 @@ int CDemoCamera::OnPixelType(MM::PropertyBase* pProp, MM::ActionType eAct)
          {
             nComponents_ = 1;
             img_.Resize(img_.Width(), img_.Height(), 2);
+            pixelType_ = PIXELTYPE_16BIT;
             bitDepth_ = 16;
             ret=DEVICE_OK;
          }
@@ -1278,6 +1438,7 @@ int CDemoCamera::OnPixelType(MM::PropertyBase* pProp, MM::ActionType eAct)
          {
             nComponents_ = 4;
             img_.Resize(img_.Width(), img_.Height(), 4);
+            pixelType_ = PIXELTYPE_32BITRGB;
             bitDepth_ = 8;
             ret=DEVICE_OK;
          }
@@ -1285,6 +1446,7 @@ int CDemoCamera::OnPixelType(MM::PropertyBase* pProp, MM::ActionType eAct)
          {
             nComponents_ = 4;
             img_.Resize(img_.Width(), img_.Height(), 8);
+            pixelType_ = PIXELTYPE_64BITRGB;
             bitDepth_ = 16;
             ret=DEVICE_OK;
          }
@@ -1292,6 +1454,7 @@ int CDemoCamera::OnPixelType(MM::PropertyBase* pProp, MM::ActionType eAct)
          {
             nComponents_ = 1;
             img_.Resize(img_.Width(), img_.Height(), 4);
+            pixelType_ = PIXELTYPE_32BIT;
             bitDepth_ = 32;
             ret=DEVICE_OK;
          }
@@ -1301,6 +1464,7 @@ int CDemoCamera::OnPixelType(MM::PropertyBase* pProp, MM::ActionType eAct)
             nComponents_ = 1;
             img_.Resize(img_.Width(), img_.Height(), 1);
             pProp->Set(g_PixelType_8bit);
+            pixelType_ = PIXELTYPE_8BIT;
             bitDepth_ = 8;
             ret = ERR_UNKNOWN_MODE;
          }
@@ -1830,6 +1994,44 @@ int CDemoCamera::OnReadNoise(MM::PropertyBase* pProp, MM::ActionType eAct)
    return DEVICE_OK;
 }
 
+int CDemoCamera::OnNoiseSeed(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+   if (eAct == MM::BeforeGet)
+   {
+      pProp->Set(static_cast<long>(noiseGenerator_.GetSeed()));
+   }
+   else if (eAct == MM::AfterSet)
+   {
+      long seed;
+      pProp->Get(seed);
+      MMThreadGuard g(imgPixelsLock_);
+      noiseGenerator_.SetSeed(static_cast<uint64_t>(seed));
+   }
+   return DEVICE_OK;
+}
+
+
+int CDemoCamera::OnBenchmarkPacingError(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+   if (eAct == MM::BeforeGet)
+   {
+      // Root mean square deviation of frame insertion from the schedule
+      std::lock_guard<std::mutex> lock(benchmarkStatsMutex_);
+      pProp->Set(benchmarkPacedFrames_ > 0 ?
+            sqrt(benchmarkSumSqErrorUs_ / benchmarkPacedFrames_) : 0.0);
+   }
+   return DEVICE_OK;
+}
+
+int CDemoCamera::OnBenchmarkDroppedFrames(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+   if (eAct == MM::BeforeGet)
+   {
+      std::lock_guard<std::mutex> lock(benchmarkStatsMutex_);
+      pProp->Set(benchmarkDroppedFrames_);
+   }
+   return DEVICE_OK;
+}
 
 int CDemoCamera::OnCrash(MM::PropertyBase* pProp, MM::ActionType eAct)
 {
@@ -32,12 +32,14 @@
 #include "DeviceBase.h"
 #include "ImgBuffer.h"
 #include "DeviceThreads.h"
+#include "DemoNoiseGenerator.h"
 #include <string>
 #include <map>
 #include <algorithm>
 #include <cstring>
 #include <stdint.h>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <future>
 #include <mutex>
@@ -52,6 +54,7 @@
 #define ERR_SEQUENCE_INACTIVE    105
 #define ERR_STAGE_MOVING         106
 #define HUB_NOT_AVAILABLE        107
+#define ERR_BENCHMARK_RAW_FILE   108
 
 extern const char* NoHubError;
 
@@ -92,6 +95,10 @@ extern double g_IntensityFactor_;
 
 enum { MODE_ARTIFICIAL_WAVES, MODE_NOISE, MODE_COLOR_TEST, MODE_BEADS };
 
+// Current value of the PixelType property, cached to avoid string compares
+// for every frame
+enum { PIXELTYPE_8BIT, PIXELTYPE_16BIT, PIXELTYPE_32BITRGB, PIXELTYPE_64BITRGB, PIXELTYPE_32BIT };
+
 // Bead structure for fluorescent beads mode
 struct Bead {
    double worldX;  // World coordinates in microns
@@ -251,6 +258,9 @@ public:
    int OnPCF(MM::PropertyBase* pProp, MM::ActionType eAct);
    int OnPhotonFlux(MM::PropertyBase* pProp, MM::ActionType eAct);
    int OnReadNoise(MM::PropertyBase* pProp, MM::ActionType eAct);
+   int OnNoiseSeed(MM::PropertyBase* pProp, MM::ActionType eAct);
+   int OnBenchmarkPacingError(MM::PropertyBase* pProp, MM::ActionType eAct);
+   int OnBenchmarkDroppedFrames(MM::PropertyBase* pProp, MM::ActionType eAct);
    int OnCrash(MM::PropertyBase* pProp, MM::ActionType eAct);
    int OnBeadDensity(MM::PropertyBase* pProp, MM::ActionType eAct);
    int OnBeadSize(MM::PropertyBase* pProp, MM::ActionType eAct);
@@ -258,11 +268,6 @@ public:
    int OnBeadBlurRate(MM::PropertyBase* pProp, MM::ActionType eAct);
 
    // Special public DemoCamera methods
-   void AddBackgroundAndNoise(ImgBuffer& img, double mean, double stdDev);
-   void AddSignal(ImgBuffer& img, double photonFlux, double exp, double cf);
-   // this function replace normal_distribution in C++11
-   double GaussDistributedValue(double mean, double std);
-
    int RegisterImgManipulatorCallBack(ImgManipulator* imgManpl);
    long GetCCDXSize() { return cameraCCDXSize_; }
    long GetCCDYSize() { return cameraCCDYSize_; }
@@ -282,6 +287,8 @@ private:
    void GenerateBeadsImage(ImgBuffer& img, double exposure);
    double GetCurrentZPosition();
    void GetCurrentXYPosition(double& x, double& y);
+   int BuildBenchmarkRing();
+   int InsertBenchmarkFrame();
 
    double exposureMaximum_ = 10000.0;
    double dPhase_ = 0.0;
@@ -331,6 +338,7 @@ private:
    MMThreadLock asyncFollowerLock_;
    friend class MySequenceThread;
    int nComponents_ = 1;
+   int pixelType_ = PIXELTYPE_8BIT;
    MySequenceThread * thd_;
    std::future<void> fut_;
    int mode_ = MODE_ARTIFICIAL_WAVES;
@@ -338,6 +346,7 @@ private:
    double pcf_ = 1.0;
    double photonFlux_ = 50.0;
    double readNoise_ = 2.5;
+   DemoNoiseGenerator noiseGenerator_;
    
    // Bead mode members
    std::vector<Bead> beads_;
@@ -346,6 +355,18 @@ private:
    double beadSize_ = 2.0;
    double beadBrightness_ = 1.0;
    double beadBlurRate_ = 0.5;
+
+   // Benchmark mode: sequence acquisitions replay a ring of prebuilt frames
+   // at a fixed rate (settings are read when the sequence starts)
+   bool benchmarkMode_ = false;
+   double benchmarkFrameRate_ = 0.0;
+   std::vector<std::vector<unsigned char>> benchmarkRing_;
+   std::chrono::steady_clock::time_point benchmarkStart_;
+   long long benchmarkSlot_ = 0;
+   std::mutex benchmarkStatsMutex_;
+   long benchmarkDroppedFrames_ = 0;
+   long benchmarkPacedFrames_ = 0;
+   double benchmarkSumSqErrorUs_ = 0.0;
 };
 
 class MySequenceThread : public MMDeviceThreadBase
@@ -62,8 +62,10 @@ void CDemoCamera::GenerateSyntheticImage(ImgBuffer& img, double exp)
          offset = 100;
       }
 	   double readNoiseDN = readNoise_ / pcf_;
-      AddBackgroundAndNoise(img, offset, readNoiseDN);
-      AddSignal (img, photonFlux_, exp, pcf_);
+      // Offset, read noise and shot noise in one pass (8 and 16 bit only)
+      noiseGenerator_.Generate(img.GetPixelsRW(), img.Width(), img.Height(),
+            img.Depth(), GetBitDepth(), offset, readNoiseDN,
+            photonFlux_ * exp, pcf_);
       if (imgManpl_ != 0)
       {
          imgManpl_->ChangePixels(img);
@@ -76,11 +78,6 @@ void CDemoCamera::GenerateSyntheticImage(ImgBuffer& img, double exp)
          return;
    }
 
-	//std::string pixelType;
-	char buf[MM::MaxStrLength];
-   GetProperty(MM::g_Keyword_PixelType, buf);
-   std::string pixelType(buf);
-
 	if (img.Height() == 0 || img.Width() == 0 || img.Depth() == 0)
       return;
 
@@ -119,7 +116,7 @@ void CDemoCamera::GenerateSyntheticImage(ImgBuffer& img, double exp)
 		pixelsToSaturate = (long)(0.5 + fractionOfPixelsToDropOrSaturate_*img.Height()*imgWidth);
 
    unsigned j, k;
-   if (pixelType.compare(g_PixelType_8bit) == 0)
+   if (pixelType_ == PIXELTYPE_8BIT)
    {
       double pedestal = 127 * exp / 100.0 * GetBinning() * GetBinning();
       unsigned char* pBuf = const_cast<unsigned char*>(img.GetPixels());
@@ -151,7 +148,7 @@ void CDemoCamera::GenerateSyntheticImage(ImgBuffer& img, double exp)
 		}
 
    }
-   else if (pixelType.compare(g_PixelType_16bit) == 0)
+   else if (pixelType_ == PIXELTYPE_16BIT)
    {
       double pedestal = maxValue/2 * exp / 100.0 * GetBinning() * GetBinning();
       double dAmp16 = dAmp * maxValue/255.0; // scale to behave like 8-bit
@@ -184,7 +181,7 @@ void CDemoCamera::GenerateSyntheticImage(ImgBuffer& img, double exp)
 		}
 
 	}
-   else if (pixelType.compare(g_PixelType_32bit) == 0)
+   else if (pixelType_ == PIXELTYPE_32BIT)
    {
       double pedestal = 127 * exp / 100.0 * GetBinning() * GetBinning();
       float* pBuf = (float*) const_cast<unsigned char*>(img.GetPixels());
@@ -227,7 +224,7 @@ void CDemoCamera::GenerateSyntheticImage(ImgBuffer& img, double exp)
       }
 
 	}
-	else if (pixelType.compare(g_PixelType_32bitRGB) == 0)
+	else if (pixelType_ == PIXELTYPE_32BITRGB)
 	{
       double pedestal = 127 * exp / 100.0;
       unsigned int * pBuf = (unsigned int*) rawBuf;
@@ -305,7 +302,7 @@ void CDemoCamera::GenerateSyntheticImage(ImgBuffer& img, double exp)
 	}
 
 	// generate an RGB image with bitDepth_ bits in each color
-	else if (pixelType.compare(g_PixelType_64bitRGB) == 0)
+	else if (pixelType_ == PIXELTYPE_64BITRGB)
 	{
       double pedestal = maxValue/2 * exp / 100.0 * GetBinning() * GetBinning();
       double dAmp16 = dAmp * maxValue/255.0; // scale to behave like 8-bit
@@ -351,14 +348,14 @@ void CDemoCamera::GenerateSyntheticImage(ImgBuffer& img, double exp)
                 for (int y = yBase; y < yBase + 20; ++y) {
                     long lIndex = imgWidth*y + x;
 
-                    if (pixelType.compare(g_PixelType_8bit) == 0) {
+                    if (pixelType_ == PIXELTYPE_8BIT) {
                         *((unsigned char*) rawBuf + lIndex) = 0;
                     }
-                    else if (pixelType.compare(g_PixelType_16bit) == 0) {
+                    else if (pixelType_ == PIXELTYPE_16BIT) {
                         *((unsigned short*) rawBuf + lIndex) = 0;
                     }
-                    else if (pixelType.compare(g_PixelType_32bit) == 0 ||
-                             pixelType.compare(g_PixelType_32bitRGB) == 0) {
+                    else if (pixelType_ == PIXELTYPE_32BIT ||
+                             pixelType_ == PIXELTYPE_32BITRGB) {
                         *((unsigned int*) rawBuf + lIndex) = 0;
                     }
                 }
@@ -379,14 +376,14 @@ void CDemoCamera::GenerateSyntheticImage(ImgBuffer& img, double exp)
                 // Draw one pixel at a time of the segment.
                 for (int pixNum = 0; pixNum < 8 * (xStep + 1); ++pixNum) {
                     long lIndex = imgWidth * (yStart + pixNum * yStep) + (xStart + pixNum * xStep);
-                    if (pixelType.compare(g_PixelType_8bit) == 0) {
+                    if (pixelType_ == PIXELTYPE_8BIT) {
                         *((unsigned char*) rawBuf + lIndex) = static_cast<unsigned char>(maxDrawnVal);
                     }
-                    else if (pixelType.compare(g_PixelType_16bit) == 0) {
+                    else if (pixelType_ == PIXELTYPE_16BIT) {
                         *((unsigned short*) rawBuf + lIndex) = static_cast<unsigned short>(maxDrawnVal);
                     }
-                    else if (pixelType.compare(g_PixelType_32bit) == 0 ||
-                             pixelType.compare(g_PixelType_32bitRGB) == 0) {
+                    else if (pixelType_ == PIXELTYPE_32BIT ||
+                             pixelType_ == PIXELTYPE_32BITRGB) {
                         *((unsigned int*) rawBuf + lIndex) = static_cast<unsigned int>(maxDrawnVal);
                     }
                 }
@@ -423,16 +420,16 @@ void CDemoCamera::GenerateSyntheticImage(ImgBuffer& img, double exp)
             {
                // Blank the pixel.
                long lIndex = imgWidth * h + i;
-               if (pixelType.compare(g_PixelType_8bit) == 0)
+               if (pixelType_ == PIXELTYPE_8BIT)
                {
                   *((unsigned char*) rawBuf + lIndex) = static_cast<unsigned char>(multiROIFillValue_);
                }
-               else if (pixelType.compare(g_PixelType_16bit) == 0)
+               else if (pixelType_ == PIXELTYPE_16BIT)
                {
                   *((unsigned short*) rawBuf + lIndex) = static_cast<unsigned short>(multiROIFillValue_);
                }
-               else if (pixelType.compare(g_PixelType_32bit) == 0 ||
-                        pixelType.compare(g_PixelType_32bitRGB) == 0)
+               else if (pixelType_ == PIXELTYPE_32BIT ||
+                        pixelType_ == PIXELTYPE_32BITRGB)
                {
                   *((unsigned int*) rawBuf + lIndex) = static_cast<unsigned int>(multiROIFillValue_);
                }
@@ -522,133 +519,6 @@ bool CDemoCamera::GenerateColorTestPattern(ImgBuffer& img)
 }
 
 
-/**
-* Generate an image with offset plus noise
-*/
-void CDemoCamera::AddBackgroundAndNoise(ImgBuffer& img, double mean, double stdDev)
-{
-	char buf[MM::MaxStrLength];
-   GetProperty(MM::g_Keyword_PixelType, buf);
-	std::string pixelType(buf);
-
-   int maxValue = 1 << GetBitDepth();
-   long nrPixels = img.Width() * img.Height();
-   if (pixelType.compare(g_PixelType_8bit) == 0)
-   {
-      unsigned char* pBuf = (unsigned char*) const_cast<unsigned char*>(img.GetPixels());
-      for (long i = 0; i < nrPixels; i++)
-      {
-         double value = GaussDistributedValue(mean, stdDev);
-         if (value < 0)
-         {
-            value = 0;
-         }
-         else if (value > maxValue)
-         {
-            value = maxValue;
-         }
-         *(pBuf + i) = (unsigned char) value;
-      }
-   }
-   else if (pixelType.compare(g_PixelType_16bit) == 0)
-   {
-      unsigned short* pBuf = (unsigned short*) const_cast<unsigned char*>(img.GetPixels());
-      for (long i = 0; i < nrPixels; i++)
-      {
-         double value = GaussDistributedValue(mean, stdDev);
-         if (value < 0)
-         {
-            value = 0;
-         }
-         else if (value > maxValue)
-         {
-            value = maxValue;
-         }
-         *(pBuf + i) = (unsigned short) value;
-      }
-   }
-}
-
-
-/**
-* Adds signal to an image
-* Assume a homogenuous illumination
-* Calculates the signal for each pixel individually as:
-* photon flux * exposure time / conversion factor
-* Assumes QE of 100%
-*/
-void CDemoCamera::AddSignal(ImgBuffer& img, double photonFlux, double exp, double cf)
-{
-	char buf[MM::MaxStrLength];
-   GetProperty(MM::g_Keyword_PixelType, buf);
-	std::string pixelType(buf);
-
-   int maxValue = (1 << GetBitDepth()) -1;
-   long nrPixels = img.Width() * img.Height();
-   double photons = photonFlux * exp;
-   double shotNoise = sqrt(photons);
-   double digitalValue = photons / cf;
-   double shotNoiseDigital = shotNoise / cf;
-   if (pixelType.compare(g_PixelType_8bit) == 0)
-   {
-      unsigned char* pBuf = (unsigned char*) const_cast<unsigned char*>(img.GetPixels());
-      for (long i = 0; i < nrPixels; i++)
-      {
-         double value = *(pBuf + i) + GaussDistributedValue(digitalValue, shotNoiseDigital);
-         if (value < 0)
-         {
-            value = 0;
-         }
-         else if (value > maxValue)
-         {
-            value = maxValue;
-         }
-         *(pBuf + i) =  (unsigned char) value;
-      }
-   }
-   else if (pixelType.compare(g_PixelType_16bit) == 0)
-   {
-      unsigned short* pBuf = (unsigned short*) const_cast<unsigned char*>(img.GetPixels());
-      for (long i = 0; i < nrPixels; i++)
-      {
-         double value = *(pBuf + i) + GaussDistributedValue(digitalValue, shotNoiseDigital);
-         if (value < 0)
-         {
-            value = 0;
-         }
-         else if (value > maxValue)
-         {
-            value = maxValue;
-         }
-         *(pBuf + i) = (unsigned short) value;
-      }
-   }
-}
-
-
-/**
- * Uses Marsaglia polar method to generate Gaussian distributed value.
- * Then distributes this around mean with the desired std
- */
-double CDemoCamera::GaussDistributedValue(double mean, double std)
-{
-   double s = 2;
-   double u = 1; // inconsequential, but avoid potential use of uninitialized value
-   double v;
-   double halfRandMax = (double) RAND_MAX / 2.0;
-   while (s >= 1 || s <= 0)
-   {
-      // get random values between -1 and 1
-      u = (double) rand() / halfRandMax - 1.0;
-      v = (double) rand() / halfRandMax - 1.0;
-      s = u * u + v * v;
-   }
-   double tmp = sqrt( -2 * log(s) / s);
-   double x = u * tmp;
-
-   return mean + std * x;
-}
-
 ///////////////////////////////////////////////////////////////////////////////
 // Bead mode implementation
 ///////////////////////////////////////////////////////////////////////////////
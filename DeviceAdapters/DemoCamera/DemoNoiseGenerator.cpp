@@ -0,0 +1,255 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          DemoNoiseGenerator.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Fast, reproducible generator of noisy camera frames for the
+//                "Noise" mode of the demo camera.
+//
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "DemoNoiseGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace {
+
+const unsigned tableBits = 16;
+const size_t tableSize = size_t(1) << tableBits;
+const uint32_t tableMask = tableSize - 1;
+
+// Means above this use a Gaussian approximation of the Poisson distribution
+const double maxPoissonTableMean = 1000.0;
+
+// Frames with fewer pixels are generated on the calling thread only
+const size_t minPixelsPerThread = 1 << 16;
+const unsigned maxThreads = 8;
+
+uint64_t SplitMix64(uint64_t& state)
+{
+   uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+   z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+   z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+   return z ^ (z >> 31);
+}
+
+uint64_t Rotl(uint64_t x, int k)
+{
+   return (x << k) | (x >> (64 - k));
+}
+
+struct Xoshiro256pp
+{
+   uint64_t s[4];
+
+   explicit Xoshiro256pp(uint64_t seed)
+   {
+      for (int i = 0; i < 4; ++i)
+         s[i] = SplitMix64(seed);
+   }
+
+   uint64_t Next()
+   {
+      const uint64_t result = Rotl(s[0] + s[3], 23) + s[0];
+      const uint64_t t = s[1] << 17;
+      s[2] ^= s[0];
+      s[3] ^= s[1];
+      s[1] ^= s[2];
+      s[0] ^= s[3];
+      s[2] ^= t;
+      s[3] = Rotl(s[3], 45);
+      return result;
+   }
+};
+
+uint64_t RowSeed(uint64_t seed, uint64_t frame, unsigned row)
+{
+   uint64_t state = seed;
+   state = SplitMix64(state) ^ frame;
+   state = SplitMix64(state) ^ row;
+   return SplitMix64(state);
+}
+
+double StandardNormalCDF(double z)
+{
+   return 0.5 * std::erfc(-z / std::sqrt(2.0));
+}
+
+// Standard normal quantiles at the midpoints of tableSize equal-probability
+// bins (so the tails are cut off at about 4.2 standard deviations)
+const std::vector<float>& NormalTable()
+{
+   static const std::vector<float> table = []
+   {
+      std::vector<float> t(tableSize);
+      for (size_t i = 0; i < tableSize / 2; ++i)
+      {
+         const double p = (i + 0.5) / tableSize;
+         double lo = -10.0;
+         double hi = 0.0;
+         for (int iter = 0; iter < 48; ++iter)
+         {
+            const double mid = 0.5 * (lo + hi);
+            if (StandardNormalCDF(mid) < p)
+               lo = mid;
+            else
+               hi = mid;
+         }
+         const float z = static_cast<float>(0.5 * (lo + hi));
+         t[i] = z;
+         t[tableSize - 1 - i] = -z;
+      }
+      return t;
+   }();
+   return table;
+}
+
+} // namespace
+
+
+DemoNoiseGenerator::DemoNoiseGenerator() :
+   seed_(0),
+   frame_(0),
+   threadCount_(0),
+   signalTableMean_(-1.0),
+   signalTableCF_(0.0)
+{
+}
+
+
+void DemoNoiseGenerator::SetSeed(uint64_t seed)
+{
+   seed_ = seed;
+   frame_ = 0;
+}
+
+
+void DemoNoiseGenerator::UpdateSignalTable(double meanPhotons, double photonsPerDN)
+{
+   if (meanPhotons < 0.0)
+      meanPhotons = 0.0;
+   if (!signalTable_.empty() && meanPhotons == signalTableMean_ &&
+         photonsPerDN == signalTableCF_)
+      return;
+
+   signalTable_.resize(tableSize);
+   if (meanPhotons > maxPoissonTableMean)
+   {
+      const std::vector<float>& normal = NormalTable();
+      const double sd = std::sqrt(meanPhotons);
+      for (size_t i = 0; i < tableSize; ++i)
+         signalTable_[i] = static_cast<float>((meanPhotons + sd * normal[i]) / photonsPerDN);
+   }
+   else
+   {
+      // Poisson quantiles at the bin midpoints, walking up the CDF
+      const double logMean = meanPhotons > 0.0 ? std::log(meanPhotons) : 0.0;
+      const double maxK = meanPhotons + 20.0 * std::sqrt(meanPhotons) + 50.0;
+      size_t i = 0;
+      double cdf = 0.0;
+      double k = 0.0;
+      for (; i < tableSize && k < maxK; k += 1.0)
+      {
+         cdf += meanPhotons > 0.0 ?
+            std::exp(k * logMean - meanPhotons - std::lgamma(k + 1.0)) :
+            (k == 0.0 ? 1.0 : 0.0);
+         const float value = static_cast<float>(k / photonsPerDN);
+         while (i < tableSize && (i + 0.5) / tableSize <= cdf)
+            signalTable_[i++] = value;
+      }
+      // Rounding can leave the CDF just short of 1
+      for (; i < tableSize; ++i)
+         signalTable_[i] = static_cast<float>(k / photonsPerDN);
+   }
+   signalTableMean_ = meanPhotons;
+   signalTableCF_ = photonsPerDN;
+}
+
+
+template <typename PixelT>
+void DemoNoiseGenerator::GenerateRows(PixelT* pixels, unsigned width,
+      unsigned firstRow, unsigned endRow, uint64_t frame, float offset,
+      float readNoiseDN, float maxValue) const
+{
+   const float* normal = NormalTable().data();
+   const float* signal = signalTable_.data();
+   for (unsigned row = firstRow; row < endRow; ++row)
+   {
+      Xoshiro256pp rng(RowSeed(seed_, frame, row));
+      PixelT* p = pixels + static_cast<size_t>(row) * width;
+      // Each 64-bit random number supplies two pixels, each using 16 bits
+      // for the read noise and 16 bits for the signal
+      const auto pixel = [&](uint32_t bits)
+      {
+         const float v = offset + readNoiseDN * normal[bits & tableMask] +
+            signal[bits >> tableBits];
+         return static_cast<PixelT>(std::min(std::max(v, 0.0f), maxValue));
+      };
+      unsigned x = 0;
+      for (; x + 1 < width; x += 2)
+      {
+         const uint64_t r = rng.Next();
+         p[x] = pixel(static_cast<uint32_t>(r));
+         p[x + 1] = pixel(static_cast<uint32_t>(r >> 32));
+      }
+      if (x < width)
+         p[x] = pixel(static_cast<uint32_t>(rng.Next()));
+   }
+}
+
+
+void DemoNoiseGenerator::Generate(unsigned char* pixels, unsigned width,
+      unsigned height, unsigned bytesPerPixel, unsigned bitDepth, double offset,
+      double readNoiseDN, double meanPhotons, double photonsPerDN)
+{
+   if (bytesPerPixel != 1 && bytesPerPixel != 2)
+      return;
+   if (width == 0 || height == 0)
+      return;
+
+   UpdateSignalTable(meanPhotons, photonsPerDN);
+   const uint64_t frame = frame_++;
+   const float maxValue = static_cast<float>((1u << std::min(bitDepth, 8u * bytesPerPixel)) - 1);
+
+   auto generate = [&](unsigned firstRow, unsigned endRow)
+   {
+      if (bytesPerPixel == 1)
+         GenerateRows(pixels, width, firstRow, endRow, frame,
+               static_cast<float>(offset), static_cast<float>(readNoiseDN), maxValue);
+      else
+         GenerateRows(reinterpret_cast<uint16_t*>(pixels), width, firstRow,
+               endRow, frame, static_cast<float>(offset),
+               static_cast<float>(readNoiseDN), maxValue);
+   };
+
+   const size_t nrPixels = static_cast<size_t>(width) * height;
+   unsigned nThreads = threadCount_;
+   if (nThreads == 0)
+      nThreads = std::min(std::max(1u, std::thread::hardware_concurrency()), maxThreads);
+   nThreads = std::min<size_t>(nThreads, std::max<size_t>(1, nrPixels / minPixelsPerThread));
+   nThreads = std::min(nThreads, height);
+
+   std::vector<std::thread> workers;
+   const unsigned rowsPerThread = (height + nThreads - 1) / nThreads;
+   for (unsigned t = 1; t < nThreads; ++t)
+   {
+      const unsigned firstRow = t * rowsPerThread;
+      const unsigned endRow = std::min(height, firstRow + rowsPerThread);
+      if (firstRow < endRow)
+         workers.emplace_back(generate, firstRow, endRow);
+   }
+   generate(0, std::min(height, rowsPerThread));
+   for (std::thread& worker : workers)
+      worker.join();
+}
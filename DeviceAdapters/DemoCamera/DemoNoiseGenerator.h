@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          DemoNoiseGenerator.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Fast, reproducible generator of noisy camera frames for the
+//                "Noise" mode of the demo camera.
+//
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Generates frames of a homogeneously illuminated sensor: a constant offset,
+ * Gaussian read noise and Poisson distributed photon (shot) noise.
+ *
+ * Random numbers come from xoshiro256++, seeded independently for each row
+ * of each frame from the seed and the frame number. Noise samples are looked
+ * up in inverse cumulative distribution tables, so that each pixel costs one
+ * 32-bit random number and two table lookups. Rows are generated in parallel
+ * for large frames; since every row has its own random stream, the result
+ * does not depend on the number of threads.
+ *
+ * The generated frames are fully determined by the seed and by how many
+ * frames have been generated since the seed was set.
+ */
+class DemoNoiseGenerator
+{
+public:
+   DemoNoiseGenerator();
+
+   /// Set the seed and restart the frame sequence.
+   void SetSeed(uint64_t seed);
+   uint64_t GetSeed() const { return seed_; }
+
+   /// Set the number of threads used for large frames (0: the default,
+   /// based on the hardware). Does not change the generated frames.
+   void SetThreadCount(unsigned count) { threadCount_ = count; }
+
+   /**
+    * Fill a frame with offset + read noise + shot noise, in digital numbers,
+    * clamped to [0, 2^bitDepth - 1].
+    *
+    * bytesPerPixel must be 1 or 2; other pixel types are left untouched.
+    * readNoiseDN is the standard deviation of the read noise in digital
+    * numbers, meanPhotons the expected number of photons per pixel and
+    * photonsPerDN the photon conversion factor.
+    */
+   void Generate(unsigned char* pixels, unsigned width, unsigned height,
+         unsigned bytesPerPixel, unsigned bitDepth, double offset,
+         double readNoiseDN, double meanPhotons, double photonsPerDN);
+
+private:
+   template <typename PixelT>
+   void GenerateRows(PixelT* pixels, unsigned width, unsigned firstRow,
+         unsigned endRow, uint64_t frame, float offset, float readNoiseDN,
+         float maxValue) const;
+   void UpdateSignalTable(double meanPhotons, double photonsPerDN);
+
+   uint64_t seed_;
+   uint64_t frame_;
+   unsigned threadCount_;
+
+   // Signal in digital numbers (shot noise included), indexed by 16 random
+   // bits; rebuilt when the mean photon count or conversion factor changes
+   std::vector<float> signalTable_;
+   double signalTableMean_;
+   double signalTableCF_;
+};
@@ -0,0 +1,101 @@
+// DESCRIPTION:   Tests of the demo camera's noise frame generator
+//
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include <gtest/gtest.h>
+
+#include "DemoNoiseGenerator.h"
+
+#include <vector>
+
+
+namespace {
+
+// Large enough to be split across the maximum number of threads
+const unsigned largeWidth = 1024;
+const unsigned largeHeight = 1024;
+
+std::vector<unsigned char> Frame(DemoNoiseGenerator& gen, unsigned width,
+      unsigned height, unsigned bytesPerPixel)
+{
+   std::vector<unsigned char> pixels(
+         static_cast<size_t>(width) * height * bytesPerPixel);
+   gen.Generate(pixels.data(), width, height, bytesPerPixel,
+         8 * bytesPerPixel, 100.0, 3.0, 50.0, 0.5);
+   return pixels;
+}
+
+} // anonymous namespace
+
+
+TEST(DemoNoiseGeneratorTests, SameSeedGivesSameFrames)
+{
+   DemoNoiseGenerator gen1, gen2;
+   gen1.SetSeed(42);
+   gen2.SetSeed(42);
+   for (int i = 0; i < 3; ++i)
+   {
+      EXPECT_EQ(Frame(gen1, 100, 75, 1), Frame(gen2, 100, 75, 1));
+      EXPECT_EQ(Frame(gen1, 100, 75, 2), Frame(gen2, 100, 75, 2));
+   }
+}
+
+TEST(DemoNoiseGeneratorTests, FramesDifferWithFrameNumberAndSeed)
+{
+   DemoNoiseGenerator gen1, gen2;
+   gen1.SetSeed(42);
+   gen2.SetSeed(43);
+   std::vector<unsigned char> first = Frame(gen1, 100, 75, 2);
+   EXPECT_NE(first, Frame(gen1, 100, 75, 2));
+   EXPECT_NE(first, Frame(gen2, 100, 75, 2));
+}
+
+TEST(DemoNoiseGeneratorTests, SettingSeedRestartsSequence)
+{
+   DemoNoiseGenerator gen;
+   gen.SetSeed(7);
+   std::vector<unsigned char> first = Frame(gen, 64, 64, 2);
+   std::vector<unsigned char> second = Frame(gen, 64, 64, 2);
+   gen.SetSeed(7);
+   EXPECT_EQ(first, Frame(gen, 64, 64, 2));
+   EXPECT_EQ(second, Frame(gen, 64, 64, 2));
+}
+
+TEST(DemoNoiseGeneratorTests, OutputDoesNotDependOnThreadCount)
+{
+   for (unsigned bytesPerPixel = 1; bytesPerPixel <= 2; ++bytesPerPixel)
+   {
+      DemoNoiseGenerator reference;
+      reference.SetSeed(1234);
+      reference.SetThreadCount(1);
+      Frame(reference, largeWidth, largeHeight, bytesPerPixel);
+      const std::vector<unsigned char> expected =
+         Frame(reference, largeWidth, largeHeight, bytesPerPixel);
+
+      for (unsigned threads : {2u, 3u, 8u, 0u})
+      {
+         DemoNoiseGenerator gen;
+         gen.SetSeed(1234);
+         gen.SetThreadCount(threads);
+         Frame(gen, largeWidth, largeHeight, bytesPerPixel);
+         EXPECT_EQ(expected, Frame(gen, largeWidth, largeHeight, bytesPerPixel))
+            << threads << " threads, " << bytesPerPixel << " bytes per pixel";
+      }
+   }
+}
+
+
+int main(int argc, char **argv)
+{
+   ::testing::InitGoogleTest(&argc, argv);
+   return RUN_ALL_TESTS();
+}
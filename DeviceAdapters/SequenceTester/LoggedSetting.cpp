@@ -50,6 +50,16 @@ LoggedSetting::MarkBusy()
 }
 
 
+std::unique_lock<std::recursive_mutex>
+LoggedSetting::LockHubGlobalMutex()
+{
+   std::shared_ptr<TesterHub> hub = device_->GetHub();
+   if (!hub)
+      return std::unique_lock<std::recursive_mutex>();
+   return hub->LockGlobalMutex();
+}
+
+
 int
 LoggedSetting::GetSequenceMaxLength(long& len) const
 {
@@ -214,6 +224,7 @@ BoolSetting::NewPropertyAction(PropertyDisplay displayMode)
 
       virtual int Execute(MM::PropertyBase* pProp, MM::ActionType eAct)
       {
+         std::unique_lock<std::recursive_mutex> g(setting_.LockHubGlobalMutex());
          if (eAct == MM::BeforeGet)
          {
             bool v;
@@ -407,6 +418,7 @@ IntegerSetting::NewPropertyAction()
 
       virtual int Execute(MM::PropertyBase* pProp, MM::ActionType eAct)
       {
+         std::unique_lock<std::recursive_mutex> g(setting_.LockHubGlobalMutex());
          if (eAct == MM::BeforeGet)
          {
             long v;
@@ -573,6 +585,7 @@ FloatSetting::NewPropertyAction()
 
       virtual int Execute(MM::PropertyBase* pProp, MM::ActionType eAct)
       {
+         std::unique_lock<std::recursive_mutex> g(setting_.LockHubGlobalMutex());
          if (eAct == MM::BeforeGet)
          {
             double v;
@@ -671,6 +684,7 @@ StringSetting::NewPropertyAction()
 
       virtual int Execute(MM::PropertyBase* pProp, MM::ActionType eAct)
       {
+         std::unique_lock<std::recursive_mutex> g(setting_.LockHubGlobalMutex());
          if (eAct == MM::BeforeGet)
          {
             std::string v;
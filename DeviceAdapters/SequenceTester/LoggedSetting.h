@@ -28,6 +28,7 @@
 #include <boost/signals2.hpp>
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -79,6 +80,10 @@ protected:
 
    void FirePostSetSignal() { postSetSignal_(); }
 
+   // Property actions must hold the hub's global mutex, because the Core
+   // may call devices of this adapter concurrently (per-device locking).
+   std::unique_lock<std::recursive_mutex> LockHubGlobalMutex();
+
 public:
    typedef std::shared_ptr<Self> Ptr;
    typedef std::shared_ptr<const Self> ConstPtr;
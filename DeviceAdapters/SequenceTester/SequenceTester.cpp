@@ -52,6 +52,9 @@ InitializeModuleData()
 {
    RegisterDevice("THub", MM::HubDevice,
          "Fake devices for automated and interactive testing");
+
+   // All device state is guarded by the hub's global mutex
+   EnablePerDeviceLocking();
 }
 
 
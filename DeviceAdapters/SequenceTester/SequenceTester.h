@@ -94,11 +94,12 @@ class TesterHub : public TesterBase<HubBase, TesterHub>
 {
    // Synchronizes access to the hub and all devices attached to it. Must be
    // locked during every call from the Core (except for the ones that do not
-   // access or modify state) _and_ when reading the current state from the
-   // camera's sequence acquisition thread. (There is not much point in having
-   // finer-grained locking because the Core already synchronizes access to the
-   // device adapter. However, we do need this lock to be per-hub so that
-   // access from different Core instances can run concurrently.)
+   // access or modify state), including property actions, _and_ when reading
+   // the current state from the camera's sequence acquisition thread. The
+   // module enables per-device locking, so the Core relies on this lock (not
+   // the module lock) to serialize calls to different devices. (The lock is
+   // per-hub so that access from different Core instances can run
+   // concurrently.)
    mutable std::recursive_mutex hubGlobalMutex_;
 
    SettingLogger logger_;
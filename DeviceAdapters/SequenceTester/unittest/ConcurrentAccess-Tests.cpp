@@ -0,0 +1,294 @@
+// Stress test of SequenceTester devices called concurrently, as the Core
+// does with per-device locking
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by the
+// Free Software Foundation.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+// for more details.
+//
+// IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <gtest/gtest.h>
+
+#include "ModuleInterface.h"
+#include "MMDevice.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// The parts of the Core callback interface used by SequenceTester. All
+// devices are children of the single hub.
+class FakeCore : public MM::Core
+{
+public:
+   MM::Hub* hub = 0;
+   std::atomic<long> imagesInserted{0};
+   std::atomic<long> acquisitionsFinished{0};
+
+   int LogMessage(const MM::Device*, const char*, bool) const override
+   { return DEVICE_OK; }
+   MM::Device* GetDevice(const MM::Device*, const char*) override
+   { return 0; }
+   int GetDeviceProperty(const char*, const char*, char*) override
+   { return DEVICE_ERR; }
+   int SetDeviceProperty(const char*, const char*, const char*) override
+   { return DEVICE_ERR; }
+   void GetLoadedDeviceOfType(const MM::Device*, MM::DeviceType, char* name,
+         const unsigned int) override
+   { name[0] = '\0'; }
+   int SetSerialProperties(const char*, const char*, const char*,
+         const char*, const char*, const char*, const char*) override
+   { return DEVICE_ERR; }
+   int SetSerialCommand(const MM::Device*, const char*, const char*,
+         const char*) override
+   { return DEVICE_ERR; }
+   int GetSerialAnswer(const MM::Device*, const char*, unsigned long, char*,
+         const char*) override
+   { return DEVICE_ERR; }
+   int WriteToSerial(const MM::Device*, const char*, const unsigned char*,
+         unsigned long) override
+   { return DEVICE_ERR; }
+   int ReadFromSerial(const MM::Device*, const char*, unsigned char*,
+         unsigned long, unsigned long&) override
+   { return DEVICE_ERR; }
+   int PurgeSerial(const MM::Device*, const char*) override
+   { return DEVICE_ERR; }
+   MM::PortType GetSerialPortType(const char*) const override
+   { return MM::InvalidPort; }
+   int OnPropertiesChanged(const MM::Device*) override { return DEVICE_OK; }
+   int OnPropertyChanged(const MM::Device*, const char*, const char*) override
+   { return DEVICE_OK; }
+   int OnStagePositionChanged(const MM::Device*, double) override
+   { return DEVICE_OK; }
+   int OnXYStagePositionChanged(const MM::Device*, double, double) override
+   { return DEVICE_OK; }
+   int OnExposureChanged(const MM::Device*, double) override
+   { return DEVICE_OK; }
+   int OnSLMExposureChanged(const MM::Device*, double) override
+   { return DEVICE_OK; }
+   int OnMagnifierChanged(const MM::Device*) override { return DEVICE_OK; }
+   int OnShutterOpenChanged(const MM::Device*, bool) override
+   { return DEVICE_OK; }
+   int OnBusyChanged(const MM::Device*, bool) override { return DEVICE_OK; }
+   unsigned long GetClockTicksUs(const MM::Device*) override { return 0; }
+   MM::MMTime GetCurrentMMTime() override
+   {
+      return MM::MMTime::fromUs(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count());
+   }
+   int AcqFinished(const MM::Device*, int) override
+   {
+      ++acquisitionsFinished;
+      return DEVICE_OK;
+   }
+   int PrepareForAcq(const MM::Device*) override { return DEVICE_OK; }
+   int InsertImage(const MM::Device*, const unsigned char*, unsigned,
+         unsigned, unsigned, unsigned, const char*) override
+   {
+      ++imagesInserted;
+      return DEVICE_OK;
+   }
+   int InsertImage(const MM::Device*, const unsigned char*, unsigned,
+         unsigned, unsigned, const char*) override
+   {
+      ++imagesInserted;
+      return DEVICE_OK;
+   }
+   bool InitializeImageBuffer(unsigned, unsigned, unsigned int,
+         unsigned int, unsigned int) override
+   { return true; }
+   int GetFocusPosition(double&) override { return DEVICE_ERR; }
+   MM::SignalIO* GetSignalIODevice(const MM::Device*, const char*) override
+   { return 0; }
+   MM::Hub* GetParentHub(const MM::Device* caller) const override
+   { return caller == hub ? 0 : hub; }
+};
+
+
+// A device together with the lock the Core holds while calling it when the
+// module enables per-device locking.
+struct LockedDevice
+{
+   MM::Device* device;
+   std::mutex mutex;
+
+   explicit LockedDevice(MM::Device* d) : device(d) {}
+
+   int Call(const std::function<int(MM::Device*)>& f)
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      return f(device);
+   }
+};
+
+
+class SequenceTesterTest : public ::testing::Test
+{
+protected:
+   FakeCore core_;
+   std::vector<MM::Device*> devices_;
+
+   MM::Device* Load(const char* name)
+   {
+      MM::Device* device = CreateDevice(name);
+      EXPECT_TRUE(device != 0);
+      device->SetLabel(name);
+      device->SetCallback(&core_);
+      EXPECT_EQ(DEVICE_OK, device->Initialize());
+      devices_.push_back(device);
+      return device;
+   }
+
+   void SetUp() override
+   {
+      InitializeModuleData();
+      ASSERT_TRUE(GetPerDeviceLocking());
+      core_.hub = static_cast<MM::Hub*>(Load("THub"));
+   }
+
+   void TearDown() override
+   {
+      for (auto it = devices_.rbegin(); it != devices_.rend(); ++it)
+      {
+         (*it)->Shutdown();
+         DeleteDevice(*it);
+      }
+   }
+};
+
+
+TEST_F(SequenceTesterTest, DevicesCanBeCalledConcurrently)
+{
+   LockedDevice camera(Load("TCamera-0"));
+   LockedDevice xyStage(Load("TXYStage-0"));
+   LockedDevice zStage(Load("TZStage-0"));
+   LockedDevice shutter(Load("TShutter-0"));
+   LockedDevice hub(core_.hub);
+
+   const int sequences = 20;
+   const long framesPerSequence = 10;
+   const int iterations = 500;
+   std::atomic<int> errors{0};
+   auto check = [&errors](int err) { if (err != DEVICE_OK) ++errors; };
+
+   std::vector<std::thread> threads;
+   threads.emplace_back([&] {
+      for (int i = 0; i < sequences; ++i)
+      {
+         check(camera.Call([&](MM::Device* d) {
+            return static_cast<MM::Camera*>(d)->
+               StartSequenceAcquisition(framesPerSequence, 0.0, true);
+         }));
+         bool capturing = true;
+         auto deadline =
+            std::chrono::steady_clock::now() + std::chrono::seconds(10);
+         while (capturing && std::chrono::steady_clock::now() < deadline)
+         {
+            camera.Call([&](MM::Device* d) {
+               capturing = static_cast<MM::Camera*>(d)->IsCapturing();
+               return DEVICE_OK;
+            });
+         }
+         check(camera.Call([](MM::Device* d) {
+            return static_cast<MM::Camera*>(d)->StopSequenceAcquisition();
+         }));
+      }
+   });
+   threads.emplace_back([&] {
+      for (int i = 0; i < iterations; ++i)
+      {
+         check(xyStage.Call([i](MM::Device* d) {
+            return static_cast<MM::XYStage*>(d)->SetPositionUm(i, -i);
+         }));
+         check(xyStage.Call([](MM::Device* d) {
+            double x, y;
+            return static_cast<MM::XYStage*>(d)->GetPositionUm(x, y);
+         }));
+      }
+   });
+   threads.emplace_back([&] {
+      for (int i = 0; i < iterations; ++i)
+      {
+         check(zStage.Call([i](MM::Device* d) {
+            return static_cast<MM::Stage*>(d)->SetPositionUm(0.5 * i);
+         }));
+         check(zStage.Call([](MM::Device* d) {
+            double z;
+            return static_cast<MM::Stage*>(d)->GetPositionUm(z);
+         }));
+         check(zStage.Call([](MM::Device* d) {
+            char value[MM::MaxStrLength];
+            return d->GetProperty(MM::g_Keyword_Name, value);
+         }));
+      }
+   });
+   threads.emplace_back([&] {
+      for (int i = 0; i < iterations; ++i)
+      {
+         check(shutter.Call([i](MM::Device* d) {
+            return static_cast<MM::Shutter*>(d)->SetOpen(i % 2 == 0);
+         }));
+         check(shutter.Call([](MM::Device* d) {
+            bool open;
+            return static_cast<MM::Shutter*>(d)->GetOpen(open);
+         }));
+      }
+   });
+   threads.emplace_back([&] {
+      for (int i = 0; i < iterations; ++i)
+      {
+         hub.Call([](MM::Device* d) {
+            char name[MM::MaxStrLength];
+            char value[MM::MaxStrLength];
+            for (unsigned j = 0; j < d->GetNumberOfProperties(); ++j)
+            {
+               if (d->GetPropertyName(j, name))
+                  d->GetProperty(name, value);
+            }
+            return DEVICE_OK;
+         });
+      }
+   });
+   for (auto& t : threads)
+      t.join();
+
+   EXPECT_EQ(0, errors.load());
+   EXPECT_EQ(sequences, core_.acquisitionsFinished.load());
+   EXPECT_EQ(sequences * framesPerSequence, core_.imagesInserted.load());
+
+   double x, y, z;
+   ASSERT_EQ(DEVICE_OK,
+         static_cast<MM::XYStage*>(xyStage.device)->GetPositionUm(x, y));
+   EXPECT_DOUBLE_EQ(iterations - 1, x);
+   EXPECT_DOUBLE_EQ(-(iterations - 1), y);
+   ASSERT_EQ(DEVICE_OK,
+         static_cast<MM::Stage*>(zStage.device)->GetPositionUm(z));
+   EXPECT_DOUBLE_EQ(0.5 * (iterations - 1), z);
+   bool open;
+   ASSERT_EQ(DEVICE_OK,
+         static_cast<MM::Shutter*>(shutter.device)->GetOpen(open));
+   EXPECT_FALSE(open);
+}
+
+
+int main(int argc, char **argv)
+{
+   ::testing::InitGoogleTest(&argc, argv);
+   return RUN_ALL_TESTS();
+}
@@ -30,8 +30,13 @@
 #include <boost/bind/bind.hpp>
 #include <boost/lexical_cast.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
 #include <deque>
 #include <exception>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -304,7 +309,7 @@ public:
    {
       // clear read buffer;
       {
-         MMThreadGuard g(readBufferLock_);
+         std::lock_guard<std::mutex> g(readBufferLock_);
          data_read_.clear();
       }
 
@@ -316,18 +321,50 @@ public:
    }
 
 
-   // read one character, ret. is false if no characters are available.
-   bool ReadOneCharacter(char& msg)
+   // Read up to maxLen available characters; returns the number read (zero
+   // if no characters are available).
+   size_t ReadCharacters(char* buf, size_t maxLen)
    {
-      bool retval = false;
-      MMThreadGuard g(readBufferLock_);
-      if (0 < data_read_.size())
+      std::lock_guard<std::mutex> g(readBufferLock_);
+      size_t n = (std::min)(maxLen, data_read_.size());
+      std::copy(data_read_.begin(), data_read_.begin() + n, buf);
+      data_read_.erase(data_read_.begin(), data_read_.begin() + n);
+      return n;
+   }
+
+   // Append available characters to buf (which already holds len characters)
+   // until buf ends with term, buf is full (len == bufLen), or no more
+   // characters are available. Characters following the terminator are left
+   // in the read buffer. Only the newly appended characters are checked for
+   // completing the terminator. Returns true if the terminator was found.
+   bool ReadCharactersUntil(char* buf, size_t& len, size_t bufLen,
+         const char* term, size_t termLen)
+   {
+      std::lock_guard<std::mutex> g(readBufferLock_);
+      size_t n = 0;
+      bool found = false;
+      while (n < data_read_.size() && len < bufLen)
       {
-         retval = true;
-         msg = data_read_.front();
-         data_read_.pop_front();
+         buf[len++] = data_read_[n++];
+         if (termLen > 0 && len >= termLen &&
+               buf[len - 1] == term[termLen - 1] &&
+               std::memcmp(buf + len - termLen, term, termLen) == 0)
+         {
+            found = true;
+            break;
+         }
       }
-      return retval;
+      data_read_.erase(data_read_.begin(), data_read_.begin() + n);
+      return found;
+   }
+
+   // Block until characters are available to read or the deadline passes.
+   // Returns true if characters are available.
+   bool WaitForCharacters(std::chrono::steady_clock::time_point deadline)
+   {
+      std::unique_lock<std::mutex> g(readBufferLock_);
+      return dataReadCv_.wait_until(g, deadline,
+            [this] { return !data_read_.empty(); });
    }
 
    void ShutDownInProgress(const bool v){ shutDownInProgress_ = v;};
@@ -363,13 +400,11 @@ private:
       if (!error)
       { // read completed, so process the data
          {
-            MMThreadGuard g(readBufferLock_);
-            for(unsigned int ib = 0; ib < bytes_transferred; ++ib)
-            {
-               data_read_.push_back(read_msg_[ib]);
-            }
+            std::lock_guard<std::mutex> g(readBufferLock_);
+            data_read_.insert(data_read_.end(),
+                  read_msg_, read_msg_ + bytes_transferred);
          }
-         CDeviceUtils::SleepMs(1);
+         dataReadCv_.notify_all(); // wake up readers waiting for an answer
          ReadStart(); // start waiting for another asynchronous read again
       }
       else
@@ -466,7 +501,8 @@ private:
    SerialPort* pSerialPortAdapter_;
    std::string device_;
 
-   MMThreadLock readBufferLock_;
+   std::mutex readBufferLock_;
+   std::condition_variable dataReadCv_; // notified when data_read_ grows
    MMThreadLock writeBufferLock_;
    MMThreadLock implementationLock_;
    bool shutDownInProgress_;
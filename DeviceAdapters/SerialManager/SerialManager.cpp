@@ -44,6 +44,7 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/thread.hpp>
 
+#include <chrono>
 #include <iostream>
 #include <sstream>
 
@@ -771,66 +772,65 @@ int SerialPort::GetAnswer(char* answer, unsigned bufLen, const char* term)
       LogMessage("BUFFER_OVERRUN error occured!");
       return ERR_BUFFER_OVERRUN;
    }
-   std::ostringstream logMsg;
-   unsigned long answerOffset = 0;
    memset(answer,0,bufLen);
-   char theData = 0;
-
-   MM::MMTime startTime = GetCurrentMMTime();
-   MM::MMTime answerTimeout(answerTimeoutMs_ * 1000.0);
-   MM::MMTime nonTerminatedAnswerTimeout(5.0 * 1000.0); // For bug-compatibility
-   while ((GetCurrentMMTime() - startTime)  < answerTimeout)
-   {
-      bool anyRead =  pPort_->ReadOneCharacter(theData);
-      if (anyRead)
+   size_t answerLen = 0;
+   const size_t termLen = term ? strlen(term) : 0;
+
+   typedef std::chrono::steady_clock Clock;
+   const Clock::time_point startTime = Clock::now();
+   const Clock::time_point deadline = startTime +
+      std::chrono::microseconds(static_cast<long long>(answerTimeoutMs_ * 1000.0));
+   // For bug-compatibility
+   const Clock::time_point nonTerminatedDeadline = startTime + std::chrono::seconds(5);
+
+   for (;;)
+   {
+      // Take whatever has arrived, up to and including the terminator; the
+      // terminator is only searched for in the newly received characters.
+      bool found = pPort_->ReadCharactersUntil(answer, answerLen,
+            bufLen, term, termLen);
+      if (found)
       {
-         if (bufLen <= answerOffset)
-         {
-            answer[answerOffset] = '\0';
-            LogMessage("BUFFER_OVERRUN error occured!");
-            return ERR_BUFFER_OVERRUN;
-         }
-         answer[answerOffset++] = theData;
+         LogAsciiCommunication("GetAnswer", true, answer);
+
+         // erase the terminator from the answer:
+         answer[answerLen - termLen] = '\0';
+
+         return DEVICE_OK;
       }
-      else
+      if (answerLen == bufLen && pPort_->WaitForCharacters(Clock::now()))
       {
-         //Yield to other threads:
-         CDeviceUtils::SleepMs(1);
+         answer[bufLen - 1] = '\0';
+         LogMessage("BUFFER_OVERRUN error occured!");
+         return ERR_BUFFER_OVERRUN;
       }
 
-      // look for the terminator, if any
-      if (term && term[0])
-      {
-         // check for terminating sequence
-         char* termPos = strstr(answer, term);
-         if (termPos != 0) // found the terminator
-         {
-            LogAsciiCommunication("GetAnswer", true, answer);
-
-            // erase the terminator from the answer:
-            *termPos = '\0';
-
-            return DEVICE_OK;
-         }
-      }
-      else
+      Clock::time_point waitUntil = deadline;
+      if (termLen == 0)
       {
          // XXX Shouldn't it be an error to not have a terminator?
          // TODO Make it a precondition check (immediate error) once we've made
          // sure that no device adapter calls us without a terminator. For now,
          // keep the behavior for the sake of bug-compatibility.
 
-         MM::MMTime elapsed = GetCurrentMMTime() - startTime;
-         if (elapsed > nonTerminatedAnswerTimeout)
+         Clock::time_point now = Clock::now();
+         if (now > nonTerminatedDeadline && now < deadline)
          {
             LogAsciiCommunication("GetAnswer", true, answer);
-            long millisecs = static_cast<long>(elapsed.getMsec());
+            long millisecs = static_cast<long>(std::chrono::duration_cast<
+                  std::chrono::milliseconds>(now - startTime).count());
             LogMessage(("GetAnswer without terminator returning after " +
                      boost::lexical_cast<std::string>(millisecs) +
                      "msec").c_str(), true);
             return DEVICE_OK;
          }
+         if (nonTerminatedDeadline < waitUntil)
+            waitUntil = nonTerminatedDeadline + std::chrono::milliseconds(1);
       }
+
+      // Sleep until the read completion handler signals new data
+      if (!pPort_->WaitForCharacters(waitUntil) && Clock::now() >= deadline)
+         break;
    }
 
    LogMessage("TERM_TIMEOUT error occured!");
@@ -880,26 +880,8 @@ int SerialPort::Read(unsigned char* buf, unsigned long bufLen, unsigned long& ch
       memset(buf, 0, bufLen);
       charsRead = 0;
 
-      bool anyRead = false;
-      char theData = 0;
-      for (;;)
-      {
-         anyRead = pPort_->ReadOneCharacter(theData);
-         if (anyRead)
-         {
-            buf[charsRead] = (unsigned char)theData;
-            if (bufLen <= ++charsRead)
-            {
-               // buffer is full
-               break;
-            }
-         }
-         else
-         {
-            // no data was available
-            break;
-         }
-      }
+      charsRead = static_cast<unsigned long>(pPort_->ReadCharacters(
+               reinterpret_cast<char*>(buf), bufLen));
       if (0 < charsRead)
       {
          if (verbose_)
@@ -0,0 +1,146 @@
+// DESCRIPTION:   Command/answer latency benchmark for SerialManager, using a
+//                pseudoterminal in place of hardware (POSIX only)
+//
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+//
+// Usage: AnswerLatency-Bench [round_trips [answer_length]]
+//
+// A responder thread on the master side of the pty answers every
+// CR-terminated command with answer_length characters followed by CRLF. The
+// benchmark reports the distribution of SetCommand() + GetAnswer() round-trip
+// times through the slave side, opened by SerialPort as a regular port.
+
+#include "../SerialManager.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+void Respond(int masterFd, const std::string& answer, std::atomic<bool>& stop)
+{
+   std::vector<char> buf(4096);
+   while (!stop)
+   {
+      pollfd pfd = { masterFd, POLLIN, 0 };
+      if (poll(&pfd, 1, 50) <= 0)
+         continue;
+      ssize_t n = read(masterFd, buf.data(), buf.size());
+      if (n <= 0)
+         continue;
+      // One answer per command terminator received
+      for (ssize_t i = 0; i < n; ++i)
+      {
+         if (buf[i] != '\r')
+            continue;
+         size_t written = 0;
+         while (written < answer.size())
+         {
+            ssize_t w = write(masterFd, answer.data() + written,
+                  answer.size() - written);
+            if (w <= 0)
+               return;
+            written += static_cast<size_t>(w);
+         }
+      }
+   }
+}
+
+double Percentile(const std::vector<double>& sorted, double p)
+{
+   size_t i = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+   return sorted[i];
+}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+   const int roundTrips = argc > 1 ? atoi(argv[1]) : 2000;
+   const size_t answerLength = argc > 2 ? atoi(argv[2]) : 16;
+
+   int masterFd = posix_openpt(O_RDWR | O_NOCTTY);
+   if (masterFd < 0 || grantpt(masterFd) != 0 || unlockpt(masterFd) != 0)
+   {
+      perror("Failed to create pseudoterminal");
+      return 1;
+   }
+   const std::string slaveName = ptsname(masterFd);
+
+   std::string answer(answerLength, 'x');
+   answer += "\r\n";
+   std::atomic<bool> stop(false);
+   std::thread responder(Respond, masterFd, answer, std::ref(stop));
+
+   SerialPort port(slaveName.c_str());
+   if (port.Initialize() != DEVICE_OK)
+   {
+      fprintf(stderr, "Failed to initialize port %s\n", slaveName.c_str());
+      stop = true;
+      responder.join();
+      return 1;
+   }
+
+   std::vector<char> answerBuf(answerLength + 64);
+   std::vector<double> latenciesUs;
+   latenciesUs.reserve(roundTrips);
+   int errors = 0;
+   for (int i = 0; i < roundTrips; ++i)
+   {
+      auto start = std::chrono::steady_clock::now();
+      int err = port.SetCommand("PING", "\r");
+      if (err == DEVICE_OK)
+         err = port.GetAnswer(answerBuf.data(),
+               static_cast<unsigned>(answerBuf.size()), "\r\n");
+      auto end = std::chrono::steady_clock::now();
+      if (err != DEVICE_OK)
+      {
+         ++errors;
+         continue;
+      }
+      latenciesUs.push_back(
+            std::chrono::duration<double, std::micro>(end - start).count());
+   }
+
+   port.Shutdown();
+   stop = true;
+   responder.join();
+   close(masterFd);
+
+   if (latenciesUs.empty())
+   {
+      fprintf(stderr, "All %d round trips failed\n", roundTrips);
+      return 1;
+   }
+   std::sort(latenciesUs.begin(), latenciesUs.end());
+   double sum = 0.0;
+   for (double l : latenciesUs)
+      sum += l;
+   printf("round trips: %zu (errors: %d), answer length: %zu\n",
+         latenciesUs.size(), errors, answerLength);
+   printf("latency (us): mean %.1f, median %.1f, p99 %.1f, max %.1f\n",
+         sum / latenciesUs.size(), Percentile(latenciesUs, 0.5),
+         Percentile(latenciesUs, 0.99), latenciesUs.back());
+   return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,321 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          SerialReplay.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Virtual serial port that records the traffic of a real port,
+//                or replays a recording in place of the instrument, so that
+//                device adapters can be benchmarked without hardware
+//
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "SerialReplay.h"
+#include "ModuleInterface.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <thread>
+
+const char* g_DeviceName = "SerialReplayPort";
+
+const char* g_PropMode = "Mode";
+const char* g_PropTrafficFile = "TrafficFile";
+const char* g_PropTimingScale = "TimingScale";
+const char* g_PropMismatches = "Mismatches";
+
+const char* g_ModeReplay = "Replay";
+const char* g_ModeRecord = "Record";
+
+
+MODULE_API void InitializeModuleData()
+{
+   RegisterDevice(g_DeviceName, MM::SerialDevice,
+      "Virtual port that records or replays serial traffic");
+}
+
+MODULE_API MM::Device* CreateDevice(const char* deviceName)
+{
+   if (deviceName == 0)
+      return 0;
+   if (strcmp(deviceName, g_DeviceName) == 0)
+      return new SerialReplayPort();
+   return 0;
+}
+
+MODULE_API void DeleteDevice(MM::Device* pDevice)
+{
+   delete pDevice;
+}
+
+
+SerialReplayPort::SerialReplayPort() :
+   initialized_(false),
+   mode_(g_ModeReplay),
+   timingScale_(1.0),
+   answerTimeoutMs_(500.0)
+{
+   InitializeDefaultErrorMessages();
+   SetErrorText(ERR_TRAFFIC_FILE_READ, "Cannot read the traffic file");
+   SetErrorText(ERR_TRAFFIC_FILE_WRITE, "Cannot write the traffic file");
+   SetErrorText(ERR_TRAFFIC_FILE_FORMAT, "The traffic file contains a malformed record");
+   SetErrorText(ERR_NO_RECORDING_PORT, "Recording requires the Port of the instrument to be set");
+   SetErrorText(ERR_REPLAY_MISMATCH, "Data written does not match the recorded session");
+   SetErrorText(ERR_BUFFER_OVERRUN, "Answer does not fit in the buffer");
+   SetErrorText(ERR_TERM_TIMEOUT, "Timed out waiting for the answer terminator");
+
+   CreateStringProperty(MM::g_Keyword_Name, g_DeviceName, true);
+   CreateStringProperty(MM::g_Keyword_Description,
+      "Virtual port that records or replays serial traffic", true);
+
+   CreateStringProperty(g_PropMode, g_ModeReplay, false, 0, true);
+   AddAllowedValue(g_PropMode, g_ModeReplay);
+   AddAllowedValue(g_PropMode, g_ModeRecord);
+
+   CreateStringProperty(g_PropTrafficFile, "", false, 0, true);
+
+   // In Record mode, the (already initialized) port the instrument is on
+   CreateStringProperty(MM::g_Keyword_Port, "Undefined", false, 0, true);
+
+   // Multiplies the recorded delays before each answer; 0 answers as soon
+   // as the command has been written
+   CreateFloatProperty(g_PropTimingScale, timingScale_, false, 0, true);
+   SetPropertyLimits(g_PropTimingScale, 0.0, 100.0);
+
+   CreateFloatProperty(MM::g_Keyword_AnswerTimeout, answerTimeoutMs_, false, 0, true);
+}
+
+SerialReplayPort::~SerialReplayPort()
+{
+   Shutdown();
+}
+
+void SerialReplayPort::GetName(char* pszName) const
+{
+   CDeviceUtils::CopyLimitedString(pszName, g_DeviceName);
+}
+
+int SerialReplayPort::Initialize()
+{
+   if (initialized_)
+      return DEVICE_OK;
+
+   char buf[MM::MaxStrLength];
+   GetProperty(g_PropMode, buf);
+   mode_ = buf;
+   GetProperty(g_PropTrafficFile, buf);
+   trafficFile_ = buf;
+   GetProperty(MM::g_Keyword_Port, buf);
+   port_ = buf;
+   GetProperty(g_PropTimingScale, timingScale_);
+   GetProperty(MM::g_Keyword_AnswerTimeout, answerTimeoutMs_);
+
+   if (IsRecording())
+   {
+      if (port_.empty() || port_ == "Undefined")
+         return ERR_NO_RECORDING_PORT;
+      if (!recorder_.Open(trafficFile_))
+         return ERR_TRAFFIC_FILE_WRITE;
+   }
+   else
+   {
+      std::vector<SerialTrafficRecord> records;
+      int errorLine;
+      if (!LoadSerialTraffic(trafficFile_, records, errorLine))
+      {
+         if (errorLine > 0)
+         {
+            std::ostringstream msg;
+            msg << "Malformed record at line " << errorLine << " of " << trafficFile_;
+            LogMessage(msg.str());
+            return ERR_TRAFFIC_FILE_FORMAT;
+         }
+         return ERR_TRAFFIC_FILE_READ;
+      }
+      engine_.reset(new SerialReplayEngine(records, timingScale_,
+         SerialReplayEngine::Clock::now()));
+      rxBuffer_.clear();
+
+      CPropertyAction* pAct = new CPropertyAction(this, &SerialReplayPort::OnMismatches);
+      CreateIntegerProperty(g_PropMismatches, 0, true, pAct);
+   }
+
+   initialized_ = true;
+   return DEVICE_OK;
+}
+
+int SerialReplayPort::Shutdown()
+{
+   if (!initialized_)
+      return DEVICE_OK;
+   recorder_.Close();
+   if (engine_ && !engine_->IsFinished())
+      LogMessage("Replay ended before the end of the recorded session", true);
+   engine_.reset();
+   initialized_ = false;
+   return DEVICE_OK;
+}
+
+int SerialReplayPort::SetCommand(const char* command, const char* term)
+{
+   if (IsRecording())
+   {
+      int ret = GetCoreCallback()->SetSerialCommand(this, port_.c_str(), command, term);
+      if (ret == DEVICE_OK)
+      {
+         std::string sent = std::string(command) + (term ? term : "");
+         recorder_.Record(false, sent.c_str(), sent.size());
+      }
+      return ret;
+   }
+   return ReplayWrite(std::string(command) + (term ? term : ""));
+}
+
+int SerialReplayPort::GetAnswer(char* answer, unsigned bufLen, const char* term)
+{
+   if (IsRecording())
+   {
+      int ret = GetCoreCallback()->GetSerialAnswer(this, port_.c_str(), bufLen, answer, term);
+      if (ret == DEVICE_OK)
+      {
+         std::string received = std::string(answer) + (term ? term : "");
+         recorder_.Record(true, received.c_str(), received.size());
+      }
+      return ret;
+   }
+   return ReplayGetAnswer(answer, bufLen, term);
+}
+
+int SerialReplayPort::Write(const unsigned char* buf, unsigned long bufLen)
+{
+   if (IsRecording())
+   {
+      int ret = GetCoreCallback()->WriteToSerial(this, port_.c_str(), buf, bufLen);
+      if (ret == DEVICE_OK)
+         recorder_.Record(false, reinterpret_cast<const char*>(buf), bufLen);
+      return ret;
+   }
+   return ReplayWrite(std::string(reinterpret_cast<const char*>(buf), bufLen));
+}
+
+int SerialReplayPort::Read(unsigned char* buf, unsigned long bufLen, unsigned long& charsRead)
+{
+   if (IsRecording())
+   {
+      int ret = GetCoreCallback()->ReadFromSerial(this, port_.c_str(), buf, bufLen, charsRead);
+      if (ret == DEVICE_OK)
+         recorder_.Record(true, reinterpret_cast<const char*>(buf), charsRead);
+      return ret;
+   }
+
+   if (!engine_)
+      return DEVICE_NOT_CONNECTED;
+   rxBuffer_ += engine_->Read(std::string::npos, SerialReplayEngine::Clock::now());
+   charsRead = static_cast<unsigned long>(std::min<size_t>(bufLen, rxBuffer_.size()));
+   memcpy(buf, rxBuffer_.data(), charsRead);
+   rxBuffer_.erase(0, charsRead);
+   return DEVICE_OK;
+}
+
+int SerialReplayPort::Purge()
+{
+   if (IsRecording())
+      return GetCoreCallback()->PurgeSerial(this, port_.c_str());
+
+   if (!engine_)
+      return DEVICE_NOT_CONNECTED;
+   rxBuffer_.clear();
+   engine_->Purge(SerialReplayEngine::Clock::now());
+   return DEVICE_OK;
+}
+
+bool SerialReplayPort::IsRecording() const
+{
+   return mode_ == g_ModeRecord;
+}
+
+int SerialReplayPort::ReplayWrite(const std::string& bytes)
+{
+   if (!engine_)
+      return DEVICE_NOT_CONNECTED;
+   if (!engine_->Write(bytes, SerialReplayEngine::Clock::now()))
+   {
+      LogMessage("Unexpected data written: " + bytes);
+      return ERR_REPLAY_MISMATCH;
+   }
+   return DEVICE_OK;
+}
+
+int SerialReplayPort::ReplayGetAnswer(char* answer, unsigned bufLen, const char* term)
+{
+   if (!engine_)
+      return DEVICE_NOT_CONNECTED;
+   if (bufLen < 1)
+      return ERR_BUFFER_OVERRUN;
+
+   typedef SerialReplayEngine::Clock Clock;
+   const Clock::time_point deadline = Clock::now() +
+      std::chrono::microseconds(static_cast<long long>(answerTimeoutMs_ * 1000.0));
+   const std::string terminator = term ? term : "";
+
+   for (;;)
+   {
+      rxBuffer_ += engine_->Read(std::string::npos, Clock::now());
+
+      size_t answerLen = std::string::npos;
+      size_t consumed = 0;
+      if (terminator.empty())
+      {
+         // Without a terminator, return whatever has arrived
+         if (!rxBuffer_.empty() || !engine_->HasPendingBytes())
+            answerLen = consumed = std::min<size_t>(rxBuffer_.size(), bufLen - 1);
+      }
+      else
+      {
+         size_t pos = rxBuffer_.find(terminator);
+         if (pos != std::string::npos)
+         {
+            answerLen = pos;
+            consumed = pos + terminator.size();
+         }
+      }
+
+      if (answerLen != std::string::npos)
+      {
+         if (answerLen >= bufLen)
+         {
+            rxBuffer_.erase(0, consumed);
+            return ERR_BUFFER_OVERRUN;
+         }
+         memcpy(answer, rxBuffer_.data(), answerLen);
+         answer[answerLen] = '\0';
+         rxBuffer_.erase(0, consumed);
+         return DEVICE_OK;
+      }
+
+      // Nothing more will arrive unless something is written, which cannot
+      // happen while we wait, so don't sit out the timeout
+      if (!engine_->HasPendingBytes() || engine_->NextAvailableTime() > deadline)
+         break;
+      std::this_thread::sleep_until(engine_->NextAvailableTime());
+   }
+
+   answer[0] = '\0';
+   return ERR_TERM_TIMEOUT;
+}
+
+int SerialReplayPort::OnMismatches(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+   if (eAct == MM::BeforeGet && engine_)
+      pProp->Set(static_cast<long>(engine_->GetMismatchCount()));
+   return DEVICE_OK;
+}
@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          SerialReplay.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Virtual serial port that records the traffic of a real port,
+//                or replays a recording in place of the instrument, so that
+//                device adapters can be benchmarked without hardware
+//
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+
+#include "DeviceBase.h"
+#include "SerialTraffic.h"
+
+#include <memory>
+#include <string>
+
+#define ERR_TRAFFIC_FILE_READ     101
+#define ERR_TRAFFIC_FILE_WRITE    102
+#define ERR_TRAFFIC_FILE_FORMAT   103
+#define ERR_NO_RECORDING_PORT     104
+#define ERR_REPLAY_MISMATCH       105
+#define ERR_BUFFER_OVERRUN        106
+#define ERR_TERM_TIMEOUT          107
+
+
+class SerialReplayPort : public CSerialBase<SerialReplayPort>
+{
+public:
+   SerialReplayPort();
+   ~SerialReplayPort();
+
+   int Initialize();
+   int Shutdown();
+
+   void GetName(char* pszName) const;
+   bool Busy() { return false; }
+
+   MM::PortType GetPortType() const { return MM::SerialPort; }
+   int SetCommand(const char* command, const char* term);
+   int GetAnswer(char* answer, unsigned bufLen, const char* term);
+   int Write(const unsigned char* buf, unsigned long bufLen);
+   int Read(unsigned char* buf, unsigned long bufLen, unsigned long& charsRead);
+   int Purge();
+
+   int OnMismatches(MM::PropertyBase* pProp, MM::ActionType eAct);
+
+private:
+   bool IsRecording() const;
+
+   int ReplayWrite(const std::string& bytes);
+   int ReplayGetAnswer(char* answer, unsigned bufLen, const char* term);
+
+   bool initialized_;
+   std::string mode_;
+   std::string trafficFile_;
+   std::string port_;
+   double timingScale_;
+   double answerTimeoutMs_;
+
+   SerialTrafficRecorder recorder_;
+   std::unique_ptr<SerialReplayEngine> engine_;
+   std::string rxBuffer_;
+};
@@ -0,0 +1,233 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          SerialTraffic.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Recording and replay of serial port traffic
+//
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "SerialTraffic.h"
+
+#include <algorithm>
+#include <sstream>
+
+
+namespace {
+
+int HexDigitValue(char c)
+{
+   if (c >= '0' && c <= '9')
+      return c - '0';
+   if (c >= 'a' && c <= 'f')
+      return c - 'a' + 10;
+   if (c >= 'A' && c <= 'F')
+      return c - 'A' + 10;
+   return -1;
+}
+
+} // namespace
+
+
+std::string FormatSerialTrafficRecord(const SerialTrafficRecord& record)
+{
+   static const char digits[] = "0123456789abcdef";
+   std::ostringstream line;
+   line << record.timeUs << ' ' << (record.fromInstrument ? 'R' : 'W') << ' ';
+   for (char c : record.bytes)
+   {
+      unsigned char b = static_cast<unsigned char>(c);
+      line << digits[b >> 4] << digits[b & 0xf];
+   }
+   return line.str();
+}
+
+
+bool ParseSerialTrafficRecord(const std::string& line, SerialTrafficRecord& record)
+{
+   std::istringstream strm(line);
+   std::string direction, hex;
+   if (!(strm >> record.timeUs >> direction))
+      return false;
+   if (direction == "R")
+      record.fromInstrument = true;
+   else if (direction == "W")
+      record.fromInstrument = false;
+   else
+      return false;
+   strm >> hex; // may be empty
+   if (hex.size() % 2 != 0)
+      return false;
+   record.bytes.clear();
+   record.bytes.reserve(hex.size() / 2);
+   for (size_t i = 0; i < hex.size(); i += 2)
+   {
+      int hi = HexDigitValue(hex[i]);
+      int lo = HexDigitValue(hex[i + 1]);
+      if (hi < 0 || lo < 0)
+         return false;
+      record.bytes.push_back(static_cast<char>((hi << 4) | lo));
+   }
+   return true;
+}
+
+
+bool LoadSerialTraffic(const std::string& path,
+   std::vector<SerialTrafficRecord>& records, int& errorLine)
+{
+   errorLine = 0;
+   records.clear();
+   std::ifstream file(path.c_str());
+   if (!file)
+      return false;
+
+   std::string line;
+   int lineNr = 0;
+   while (std::getline(file, line))
+   {
+      ++lineNr;
+      if (!line.empty() && line.back() == '\r')
+         line.pop_back();
+      if (line.empty() || line[0] == '#')
+         continue;
+      SerialTrafficRecord record;
+      if (!ParseSerialTrafficRecord(line, record))
+      {
+         errorLine = lineNr;
+         return false;
+      }
+      records.push_back(record);
+   }
+   return true;
+}
+
+
+bool SerialTrafficRecorder::Open(const std::string& path)
+{
+   std::lock_guard<std::mutex> g(mutex_);
+   file_.open(path.c_str(), std::ios::out | std::ios::trunc);
+   if (!file_)
+      return false;
+   file_ << "# Serial traffic: <microseconds> <W(rite)|R(ead)> <hex bytes>\n";
+   start_ = std::chrono::steady_clock::now();
+   return true;
+}
+
+
+void SerialTrafficRecorder::Close()
+{
+   std::lock_guard<std::mutex> g(mutex_);
+   if (file_.is_open())
+      file_.close();
+}
+
+
+void SerialTrafficRecorder::Record(bool fromInstrument, const char* data, size_t len)
+{
+   std::lock_guard<std::mutex> g(mutex_);
+   if (!file_.is_open() || len == 0)
+      return;
+   SerialTrafficRecord record;
+   record.timeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start_).count();
+   record.fromInstrument = fromInstrument;
+   record.bytes.assign(data, len);
+   file_ << FormatSerialTrafficRecord(record) << '\n';
+}
+
+
+SerialReplayEngine::SerialReplayEngine(
+      const std::vector<SerialTrafficRecord>& records,
+      double timingScale, Clock::time_point start) :
+   records_(records),
+   timingScale_(timingScale),
+   next_(0),
+   mismatches_(0)
+{
+   // Anything the instrument sent before the first command
+   ScheduleReplies(0, start);
+}
+
+
+void SerialReplayEngine::ScheduleReplies(long long writeTimeUs,
+      Clock::time_point writeTime)
+{
+   while (next_ < records_.size() && records_[next_].fromInstrument)
+   {
+      const SerialTrafficRecord& record = records_[next_++];
+      long long delayUs = std::max(0LL, record.timeUs - writeTimeUs);
+      Clock::time_point at = writeTime + std::chrono::microseconds(
+         static_cast<long long>(delayUs * timingScale_));
+      // Keep the byte order even if the scaled times are not monotonic
+      if (!scheduled_.empty() && at < scheduled_.back().first)
+         at = scheduled_.back().first;
+      scheduled_.push_back(std::make_pair(at, record.bytes));
+   }
+}
+
+
+bool SerialReplayEngine::Write(const std::string& bytes, Clock::time_point now)
+{
+   unmatchedWrite_ += bytes;
+   while (!unmatchedWrite_.empty())
+   {
+      if (next_ >= records_.size() || records_[next_].fromInstrument)
+      {
+         // The instrument would not have expected anything here
+         unmatchedWrite_.clear();
+         ++mismatches_;
+         return false;
+      }
+
+      const SerialTrafficRecord& record = records_[next_];
+      const size_t n = std::min(record.bytes.size(), unmatchedWrite_.size());
+      if (unmatchedWrite_.compare(0, n, record.bytes, 0, n) != 0)
+      {
+         unmatchedWrite_.clear();
+         ++mismatches_;
+         return false;
+      }
+      if (unmatchedWrite_.size() < record.bytes.size())
+         return true; // Wait for the rest of the recorded write
+
+      unmatchedWrite_.erase(0, record.bytes.size());
+      ++next_;
+      ScheduleReplies(record.timeUs, now);
+   }
+   return true;
+}
+
+
+void SerialReplayEngine::MakeAvailable(Clock::time_point now)
+{
+   while (!scheduled_.empty() && scheduled_.front().first <= now)
+   {
+      available_ += scheduled_.front().second;
+      scheduled_.pop_front();
+   }
+}
+
+
+std::string SerialReplayEngine::Read(size_t maxLen, Clock::time_point now)
+{
+   MakeAvailable(now);
+   std::string ret = available_.substr(0, maxLen);
+   available_.erase(0, ret.size());
+   return ret;
+}
+
+
+void SerialReplayEngine::Purge(Clock::time_point now)
+{
+   MakeAvailable(now);
+   available_.clear();
+}
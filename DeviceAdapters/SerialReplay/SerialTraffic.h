@@ -0,0 +1,113 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          SerialTraffic.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Recording and replay of serial port traffic
+//
+// LICENSE:       This file is distributed under the BSD license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// A traffic file is a text file with one record per line:
+//
+//    <microseconds since start of session> <W|R> <bytes as hex>
+//
+// W records hold bytes written to the instrument, R records bytes received
+// from it. Lines that are empty or start with '#' are ignored.
+
+struct SerialTrafficRecord
+{
+   long long timeUs;
+   bool fromInstrument;
+   std::string bytes;
+};
+
+std::string FormatSerialTrafficRecord(const SerialTrafficRecord& record);
+bool ParseSerialTrafficRecord(const std::string& line, SerialTrafficRecord& record);
+
+// Returns false if the file cannot be read or contains a malformed record
+// (in which case errorLine is set to the 1-based line number, or 0)
+bool LoadSerialTraffic(const std::string& path,
+   std::vector<SerialTrafficRecord>& records, int& errorLine);
+
+
+// Appends records to a traffic file, timed relative to Open()
+class SerialTrafficRecorder
+{
+public:
+   bool Open(const std::string& path);
+   void Close();
+   bool IsOpen() const { return file_.is_open(); }
+
+   void Record(bool fromInstrument, const char* data, size_t len);
+
+private:
+   std::mutex mutex_;
+   std::ofstream file_;
+   std::chrono::steady_clock::time_point start_;
+};
+
+
+// Plays the part of the instrument in a recorded session. Bytes written by
+// the host are matched against the W records; the R records that follow
+// become available for reading after the delay (relative to the preceding W
+// record) seen in the recording, multiplied by the timing scale.
+class SerialReplayEngine
+{
+public:
+   typedef std::chrono::steady_clock Clock;
+
+   SerialReplayEngine(const std::vector<SerialTrafficRecord>& records,
+      double timingScale, Clock::time_point start);
+
+   // Returns false if the bytes do not match the recorded session (the
+   // unmatched bytes are discarded)
+   bool Write(const std::string& bytes, Clock::time_point now);
+
+   // Move bytes that have become available by now into the receive buffer
+   // and return (and remove) up to maxLen of them
+   std::string Read(size_t maxLen, Clock::time_point now);
+
+   // Discard bytes that have become available by now
+   void Purge(Clock::time_point now);
+
+   // Whether bytes are scheduled to become available later, and when the
+   // next ones will be
+   bool HasPendingBytes() const { return !scheduled_.empty(); }
+   Clock::time_point NextAvailableTime() const { return scheduled_.front().first; }
+
+   // Whether all records have been played
+   bool IsFinished() const
+   { return next_ == records_.size() && scheduled_.empty(); }
+
+   size_t GetMismatchCount() const { return mismatches_; }
+
+private:
+   void ScheduleReplies(long long writeTimeUs, Clock::time_point writeTime);
+   void MakeAvailable(Clock::time_point now);
+
+   std::vector<SerialTrafficRecord> records_;
+   double timingScale_;
+   size_t next_;
+   std::string unmatchedWrite_;
+   std::deque<std::pair<Clock::time_point, std::string>> scheduled_;
+   std::string available_;
+   size_t mismatches_;
+};
@@ -0,0 +1,176 @@
+// DESCRIPTION:   Unit tests for serial traffic recording and replay
+//
+// LICENSE:       This file is distributed under the BSD license.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include <gtest/gtest.h>
+
+#include "SerialTraffic.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+typedef SerialReplayEngine::Clock Clock;
+using std::chrono::milliseconds;
+
+namespace {
+
+SerialTrafficRecord W(long long timeUs, const std::string& bytes)
+{
+   SerialTrafficRecord r = { timeUs, false, bytes };
+   return r;
+}
+
+SerialTrafficRecord R(long long timeUs, const std::string& bytes)
+{
+   SerialTrafficRecord r = { timeUs, true, bytes };
+   return r;
+}
+
+} // namespace
+
+
+TEST(SerialTrafficRecordTests, FormatAndParseRoundTrip)
+{
+   SerialTrafficRecord record = R(12345, std::string("A\r\n\0\xff", 5));
+   std::string line = FormatSerialTrafficRecord(record);
+   EXPECT_EQ("12345 R 410d0a00ff", line);
+
+   SerialTrafficRecord parsed;
+   ASSERT_TRUE(ParseSerialTrafficRecord(line, parsed));
+   EXPECT_EQ(12345, parsed.timeUs);
+   EXPECT_TRUE(parsed.fromInstrument);
+   EXPECT_EQ(record.bytes, parsed.bytes);
+}
+
+TEST(SerialTrafficRecordTests, MalformedRecordsAreRejected)
+{
+   SerialTrafficRecord parsed;
+   EXPECT_FALSE(ParseSerialTrafficRecord("12 X 41", parsed));
+   EXPECT_FALSE(ParseSerialTrafficRecord("12 W 4", parsed));
+   EXPECT_FALSE(ParseSerialTrafficRecord("12 W 4g", parsed));
+   EXPECT_FALSE(ParseSerialTrafficRecord("W 41", parsed));
+}
+
+TEST(SerialTrafficRecordTests, RecorderOutputCanBeLoaded)
+{
+   const std::string path = "SerialTraffic-Tests.traffic";
+   SerialTrafficRecorder recorder;
+   ASSERT_TRUE(recorder.Open(path));
+   recorder.Record(false, "W X\r", 4);
+   recorder.Record(true, ":A 10\r\n", 7);
+   recorder.Close();
+
+   std::vector<SerialTrafficRecord> records;
+   int errorLine;
+   ASSERT_TRUE(LoadSerialTraffic(path, records, errorLine));
+   ASSERT_EQ(2u, records.size());
+   EXPECT_FALSE(records[0].fromInstrument);
+   EXPECT_EQ("W X\r", records[0].bytes);
+   EXPECT_TRUE(records[1].fromInstrument);
+   EXPECT_EQ(":A 10\r\n", records[1].bytes);
+   EXPECT_LE(records[0].timeUs, records[1].timeUs);
+
+   std::ofstream(path.c_str(), std::ios::app) << "bogus\n";
+   EXPECT_FALSE(LoadSerialTraffic(path, records, errorLine));
+   EXPECT_EQ(4, errorLine);
+   std::remove(path.c_str());
+}
+
+TEST(SerialReplayEngineTests, AnswersFollowMatchingWritesAfterRecordedDelay)
+{
+   std::vector<SerialTrafficRecord> records = {
+      W(1000, "W X\r"), R(4000, ":A 10\r\n"),
+      W(10000, "W Y\r"), R(10500, ":A 20\r\n"),
+   };
+   Clock::time_point t0 = Clock::now();
+   SerialReplayEngine engine(records, 1.0, t0);
+
+   EXPECT_EQ("", engine.Read(100, t0));
+   ASSERT_TRUE(engine.Write("W X\r", t0));
+   ASSERT_TRUE(engine.HasPendingBytes());
+   EXPECT_EQ(t0 + milliseconds(3), engine.NextAvailableTime());
+   EXPECT_EQ("", engine.Read(100, t0 + milliseconds(2)));
+   EXPECT_EQ(":A 10\r\n", engine.Read(100, t0 + milliseconds(3)));
+
+   // Timing is relative to the write, not to the start of the session
+   Clock::time_point t1 = t0 + milliseconds(100);
+   ASSERT_TRUE(engine.Write("W Y\r", t1));
+   EXPECT_EQ(":A", engine.Read(2, t1 + milliseconds(1)));
+   EXPECT_EQ(" 20\r\n", engine.Read(100, t1 + milliseconds(1)));
+   EXPECT_TRUE(engine.IsFinished());
+   EXPECT_EQ(0u, engine.GetMismatchCount());
+}
+
+TEST(SerialReplayEngineTests, TimingScaleAppliesToDelays)
+{
+   std::vector<SerialTrafficRecord> records = { W(0, "?\r"), R(8000, "!\r") };
+   Clock::time_point t0 = Clock::now();
+
+   SerialReplayEngine half(records, 0.5, t0);
+   ASSERT_TRUE(half.Write("?\r", t0));
+   EXPECT_EQ(t0 + milliseconds(4), half.NextAvailableTime());
+
+   SerialReplayEngine instant(records, 0.0, t0);
+   ASSERT_TRUE(instant.Write("?\r", t0));
+   EXPECT_EQ("!\r", instant.Read(100, t0));
+}
+
+TEST(SerialReplayEngineTests, SplitWritesAreMatched)
+{
+   std::vector<SerialTrafficRecord> records = { W(0, "MOVE X=1\r"), R(0, ":A\r\n") };
+   Clock::time_point t0 = Clock::now();
+   SerialReplayEngine engine(records, 1.0, t0);
+
+   ASSERT_TRUE(engine.Write("MOVE ", t0));
+   EXPECT_FALSE(engine.HasPendingBytes());
+   ASSERT_TRUE(engine.Write("X=1\r", t0));
+   EXPECT_EQ(":A\r\n", engine.Read(100, t0));
+}
+
+TEST(SerialReplayEngineTests, MismatchedWriteIsReported)
+{
+   std::vector<SerialTrafficRecord> records = { W(0, "W X\r"), R(0, ":A 1\r\n") };
+   Clock::time_point t0 = Clock::now();
+   SerialReplayEngine engine(records, 1.0, t0);
+
+   EXPECT_FALSE(engine.Write("W Z\r", t0));
+   EXPECT_EQ(1u, engine.GetMismatchCount());
+   // The session can continue with the expected command
+   ASSERT_TRUE(engine.Write("W X\r", t0));
+   EXPECT_EQ(":A 1\r\n", engine.Read(100, t0));
+   // Nothing more is expected
+   EXPECT_FALSE(engine.Write("W X\r", t0));
+   EXPECT_EQ(2u, engine.GetMismatchCount());
+}
+
+TEST(SerialReplayEngineTests, PurgeDiscardsOnlyArrivedBytes)
+{
+   std::vector<SerialTrafficRecord> records = {
+      R(0, "banner\r\n"), W(1000, "?\r"), R(6000, "ok\r\n"),
+   };
+   Clock::time_point t0 = Clock::now();
+   SerialReplayEngine engine(records, 1.0, t0);
+
+   // Bytes sent before the first command are available from the start
+   engine.Purge(t0);
+   ASSERT_TRUE(engine.Write("?\r", t0));
+   engine.Purge(t0 + milliseconds(1));
+   EXPECT_EQ("ok\r\n", engine.Read(100, t0 + milliseconds(5)));
+}
+
+int main(int argc, char **argv)
+{
+   ::testing::InitGoogleTest(&argc, argv);
+   return RUN_ALL_TESTS();
+}
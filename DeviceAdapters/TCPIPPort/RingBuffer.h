@@ -0,0 +1,101 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          RingBuffer.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Fixed-capacity byte ring buffer for received data
+//
+// LICENSE:       Licensed under the Apache License, Version 2.0 (the "License");
+//                you may not use this file except in compliance with the License.
+//                You may obtain a copy of the License at
+//
+//                http://www.apache.org/licenses/LICENSE-2.0
+//
+//                Unless required by applicable law or agreed to in writing, software
+//                distributed under the License is distributed on an "AS IS" BASIS,
+//                WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//                See the License for the specific language governing permissions and
+//                limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+// The socket reads directly into FreeRegion() and then calls Commit(), so
+// received data is copied only once, into the caller's buffer by Take().
+// Not synchronized: the owner must serialize access, except that the bytes
+// in a region returned by FreeRegion() may be written without holding the
+// owner's lock (nothing else touches them until they are committed).
+class RingBuffer
+{
+public:
+	explicit RingBuffer(std::size_t capacity) :
+		data_(capacity), start_(0), size_(0)
+	{}
+
+	std::size_t Size() const { return size_; }
+	std::size_t Capacity() const { return data_.size(); }
+	bool Full() const { return size_ == data_.size(); }
+
+	// The contiguous free space following the stored bytes
+	std::pair<char*, std::size_t> FreeRegion()
+	{
+		std::size_t end = (start_ + size_) % data_.size();
+		std::size_t len = (end >= start_ && !Full()) ?
+			data_.size() - end : data_.size() - size_;
+		return std::make_pair(&data_[end], len);
+	}
+
+	// Append n bytes that have been written to FreeRegion()
+	void Commit(std::size_t n) { size_ += n; }
+
+	// Position of the first occurrence of pattern at or after from, or npos
+	std::size_t Find(const char* pattern, std::size_t patternLen, std::size_t from) const
+	{
+		if (patternLen == 0 || size_ < patternLen)
+			return npos;
+		for (std::size_t i = from; i + patternLen <= size_; ++i)
+		{
+			std::size_t j = 0;
+			while (j < patternLen && At(i + j) == pattern[j])
+				++j;
+			if (j == patternLen)
+				return i;
+		}
+		return npos;
+	}
+
+	// Copy up to n bytes to dest and remove them; returns the number copied
+	std::size_t Take(char* dest, std::size_t n)
+	{
+		n = std::min(n, size_);
+		std::size_t first = std::min(n, data_.size() - start_);
+		std::memcpy(dest, &data_[start_], first);
+		std::memcpy(dest + first, &data_[0], n - first);
+		Consume(n);
+		return n;
+	}
+
+	void Consume(std::size_t n)
+	{
+		n = std::min(n, size_);
+		start_ = (start_ + n) % data_.size();
+		size_ -= n;
+	}
+
+	// Does not move the free region, which may be being received into
+	void Clear() { Consume(size_); }
+
+	static const std::size_t npos = static_cast<std::size_t>(-1);
+
+private:
+	char At(std::size_t i) const { return data_[(start_ + i) % data_.size()]; }
+
+	std::vector<char> data_;
+	std::size_t start_;
+	std::size_t size_;
+};
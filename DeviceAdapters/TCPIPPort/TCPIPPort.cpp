@@ -30,19 +30,31 @@
 
 #include "Util.h"
 
+#include <chrono>
+#include <future>
+
 using boost::asio::ip::tcp;
 
 const char* deviceName = "TCP/IP serial port adapter";
 
+// Received data beyond this is left in the socket's receive buffer (and TCP
+// flow control applies) until the adapter reads some
+static const std::size_t receiveRingCapacity = 64 * 1024;
+
 int TCPIPPort::count_ = 0;
 
 TCPIPPort::TCPIPPort(int index) :
+	initialized_(false),
 	index_(index),
+	sock_(ios_),
 	host_("127.0.0.1"),
 	port_(0),
-	initialized_(false),
-	sock_(ios_),
-	answerTimeoutMs_(500)
+	answerTimeoutMs_(500),
+	noDelay_(true),
+	sendBufferSize_(0),
+	receiveBufferSize_(0),
+	rxBuffer_(receiveRingCapacity),
+	receivePending_(false)
 {
 	SetErrorText(ERR_BUFFER_OVERRUN, "Buffer overrun occured during read");
 	SetErrorText(ERR_TERM_TIMEOUT, "Timeout occured during init or read");
@@ -52,10 +64,18 @@ TCPIPPort::TCPIPPort(int index) :
 	CreateProperty("Host", "127.0.0.1", MM::String, false, new CPropertyAction(this, &TCPIPPort::OnHost), true);
 	CreateProperty("TCP Port", "0", MM::Integer, false, new CPropertyAction(this, &TCPIPPort::OnPort), true);
 	CreateProperty("Answer timeout", "500", MM::Integer, false, new CPropertyAction(this, &TCPIPPort::OnAnswerTimeout), false);
+
+	// Disabling Nagle's algorithm sends short commands immediately
+	CreateProperty("TCP_NODELAY", "Yes", MM::String, false, new CPropertyAction(this, &TCPIPPort::OnNoDelay), true);
+	AddAllowedValue("TCP_NODELAY", "Yes");
+	AddAllowedValue("TCP_NODELAY", "No");
+	CreateProperty("Send buffer size", "0", MM::Integer, false, new CPropertyAction(this, &TCPIPPort::OnSendBufferSize), true);
+	CreateProperty("Receive buffer size", "0", MM::Integer, false, new CPropertyAction(this, &TCPIPPort::OnReceiveBufferSize), true);
 }
 
 TCPIPPort::~TCPIPPort()
 {
+	Shutdown();
 }
 
 bool TCPIPPort::Busy()
@@ -82,7 +102,11 @@ ERRH_START
 
 	boost::asio::deadline_timer deadline(ios_);
 	deadline.expires_from_now(boost::posix_time::millisec(answerTimeoutMs_));
-	deadline.async_wait(boost::lambda::bind(&TCPIPPort::close_sock, this));
+	deadline.async_wait([this](const boost::system::error_code& timerEc) {
+		// The timer is cancelled when Initialize() returns
+		if (!timerEc)
+			close_sock();
+	});
 	
 	boost::asio::async_connect(sock_, it, boost::lambda::var(ec) = boost::lambda::_1);
 
@@ -91,6 +115,22 @@ ERRH_START
 	if (ec || !sock_.is_open())
 		return ERR_TERM_TIMEOUT;
 
+	sock_.set_option(tcp::no_delay(noDelay_));
+	if (sendBufferSize_ > 0)
+		sock_.set_option(boost::asio::socket_base::send_buffer_size(sendBufferSize_));
+	if (receiveBufferSize_ > 0)
+		sock_.set_option(boost::asio::socket_base::receive_buffer_size(receiveBufferSize_));
+
+	{
+		std::lock_guard<std::mutex> lock(rxMutex_);
+		rxBuffer_.Clear();
+		rxError_.clear();
+		receivePending_ = false;
+		StartReceive();
+	}
+	ioWork_.reset(new boost::asio::io_service::work(ios_));
+	ioThread_ = std::thread([this] { ios_.run(); });
+
 	initialized_ = true;
 
 	if (index_ == GetCount())
@@ -104,8 +144,16 @@ ERRH_START
 	if (!initialized_)
 		return DEVICE_OK;
 
-	sock_.shutdown(tcp::socket::shutdown_both);
-	sock_.close();
+	// Close on the I/O thread, which owns the pending receive
+	ios_.post([this] {
+		boost::system::error_code ignored;
+		sock_.shutdown(tcp::socket::shutdown_both, ignored);
+		sock_.close(ignored);
+	});
+	ioWork_.reset();
+	if (ioThread_.joinable())
+		ioThread_.join();
+	ios_.reset();
 
 	initialized_ = false;
 ERRH_END
@@ -137,13 +185,76 @@ int TCPIPPort::SetCommand(const char* command, const char* term)
 	if (term != 0)
 		cmd += term;
 
-	boost::asio::write(sock_, boost::asio::buffer(cmd));
+	Send(cmd.data(), cmd.size());
 
 	LogAsciiCommunication("SetCommand", false, cmd);
 	ERRH_END
 }
 
-//mostly copied from SerialManager.cpp (Serialport::GetAnswer)
+// Writes on the I/O thread, where the receive operation is also started, and
+// waits for completion. Throws boost::system::system_error on failure.
+void TCPIPPort::Send(const void* data, std::size_t len)
+{
+	std::promise<boost::system::error_code> done;
+	std::future<boost::system::error_code> result = done.get_future();
+	ios_.post([this, data, len, &done] {
+		boost::asio::async_write(sock_, boost::asio::buffer(data, len),
+			[&done](const boost::system::error_code& ec, std::size_t) {
+				done.set_value(ec);
+			});
+	});
+	boost::system::error_code ec = result.get();
+	if (ec)
+		throw boost::system::system_error(ec);
+}
+
+// Must be called with rxMutex_ held. Receives directly into the free space of
+// rxBuffer_; if there is none, receiving resumes once data has been consumed.
+void TCPIPPort::StartReceive()
+{
+	if (receivePending_ || rxError_ || rxBuffer_.Full())
+		return;
+	std::pair<char*, std::size_t> region = rxBuffer_.FreeRegion();
+	receivePending_ = true;
+	sock_.async_read_some(boost::asio::buffer(region.first, region.second),
+		[this](const boost::system::error_code& ec, std::size_t bytesTransferred) {
+			ReceiveComplete(ec, bytesTransferred);
+		});
+}
+
+// Must be called with rxMutex_ held, after consuming data from rxBuffer_
+void TCPIPPort::ResumeReceive()
+{
+	if (receivePending_ || rxError_)
+		return;
+	// The socket is only used for receiving on the I/O thread
+	ios_.post([this] {
+		std::lock_guard<std::mutex> lock(rxMutex_);
+		StartReceive();
+	});
+}
+
+void TCPIPPort::ReceiveComplete(const boost::system::error_code& ec, std::size_t bytesTransferred)
+{
+	{
+		std::lock_guard<std::mutex> lock(rxMutex_);
+		receivePending_ = false;
+		rxBuffer_.Commit(bytesTransferred);
+		if (ec)
+			rxError_ = ec; // Including EOF and cancellation; stop receiving
+		else
+			StartReceive();
+	}
+	rxCv_.notify_all();
+}
+
+// Must be called with rxMutex_ held, when rxError_ is set
+int TCPIPPort::ReceiveErrorCode()
+{
+	SetErrorText(BOOST_ERROR, rxError_.message().c_str());
+	return BOOST_ERROR;
+}
+
 int TCPIPPort::GetAnswer(char* txt, unsigned maxChars, const char* term)
 {
 ERRH_START
@@ -155,76 +266,82 @@ ERRH_START
 		LogMessage("BUFFER_OVERRUN error occured!");
 		return ERR_BUFFER_OVERRUN;
 	}
-	std::ostringstream logMsg;
-	unsigned long answerOffset = 0;
 	memset(txt, 0, maxChars);
-	char theData = 0;
+	const std::size_t termLen = term ? strlen(term) : 0;
 
-	MM::MMTime startTime = GetCurrentMMTime();
-	MM::MMTime answerTimeout(answerTimeoutMs_ * 1000.0);
-	MM::MMTime nonTerminatedAnswerTimeout(5.0 * 1000.0); // For bug-compatibility
-	while ((GetCurrentMMTime() - startTime) < answerTimeout)
-	{
-		boost::asio::socket_base::bytes_readable command(true);
-		sock_.io_control(command);
-		size_t bytes_readable = command.get();
+	typedef std::chrono::steady_clock Clock;
+	const Clock::time_point startTime = Clock::now();
+	const Clock::time_point deadline = startTime + std::chrono::milliseconds(answerTimeoutMs_);
+	// For bug-compatibility
+	const Clock::time_point nonTerminatedDeadline = startTime + std::chrono::seconds(5);
 
-		if (bytes_readable > 0)
+	std::unique_lock<std::mutex> lock(rxMutex_);
+	std::size_t scanned = 0;
+	for (;;)
+	{
+		if (termLen > 0)
 		{
-			sock_.read_some(boost::asio::buffer(&theData, 1));
-
-			if (maxChars <= answerOffset)
+			// Only scan bytes that have arrived since the last look (allowing for
+			// a terminator split across arrivals)
+			std::size_t from = scanned >= termLen ? scanned - termLen + 1 : 0;
+			std::size_t pos = rxBuffer_.Find(term, termLen, from);
+			if (pos != RingBuffer::npos && pos < maxChars)
+			{
+				rxBuffer_.Take(txt, pos);
+				rxBuffer_.Consume(termLen);
+				ResumeReceive();
+				lock.unlock();
+				LogAsciiCommunication("GetAnswer", true, std::string(txt) + term);
+				return DEVICE_OK;
+			}
+			if (pos != RingBuffer::npos || rxBuffer_.Size() >= maxChars + termLen - 1)
 			{
-				txt[answerOffset] = '\0';
+				rxBuffer_.Take(txt, maxChars - 1);
+				ResumeReceive();
 				LogMessage("BUFFER_OVERRUN error occured!");
 				return ERR_BUFFER_OVERRUN;
 			}
-			txt[answerOffset++] = theData;
-		}
-		else
-		{
-			//Yield to other threads:
-			CDeviceUtils::SleepMs(1);
+			scanned = rxBuffer_.Size();
 		}
 
-		// look for the terminator, if any
-		if (term && term[0])
-		{
-			// check for terminating sequence
-			char* termPos = strstr(txt, term);
-			if (termPos != 0) // found the terminator
-			{
-				LogAsciiCommunication("GetAnswer", true, txt);
-
-				// erase the terminator from the answer:
-				*termPos = '\0';
+		if (rxError_)
+			return ReceiveErrorCode();
 
-				return DEVICE_OK;
-			}
-		}
-		else
+		Clock::time_point waitUntil = deadline;
+		if (termLen == 0)
 		{
 			// XXX Shouldn't it be an error to not have a terminator?
 			// TODO Make it a precondition check (immediate error) once we've made
 			// sure that no device adapter calls us without a terminator. For now,
 			// keep the behavior for the sake of bug-compatibility.
 
-			MM::MMTime elapsed = GetCurrentMMTime() - startTime;
-			if (elapsed > nonTerminatedAnswerTimeout)
+			Clock::time_point now = Clock::now();
+			if (now > nonTerminatedDeadline && now < deadline)
 			{
+				rxBuffer_.Take(txt, maxChars - 1);
+				ResumeReceive();
+				lock.unlock();
 				LogAsciiCommunication("GetAnswer", true, txt);
-				long millisecs = static_cast<long>(elapsed.getMsec());
+				long millisecs = static_cast<long>(std::chrono::duration_cast<
+					std::chrono::milliseconds>(now - startTime).count());
 				LogMessage(("GetAnswer without terminator returning after " +
 					boost::lexical_cast<std::string>(millisecs) +
 					"msec").c_str(), true);
 				return DEVICE_OK;
 			}
+			if (nonTerminatedDeadline < waitUntil)
+				waitUntil = nonTerminatedDeadline + std::chrono::milliseconds(1);
 		}
+
+		// Sleep until the receive handler signals new data
+		if (rxCv_.wait_until(lock, waitUntil) == std::cv_status::timeout &&
+			Clock::now() >= deadline)
+			break;
 	}
 
 	LogMessage("TERM_TIMEOUT error occured!");
 	return ERR_TERM_TIMEOUT;
-	ERRH_END
+ERRH_END
 }
 
 int TCPIPPort::Write(const unsigned char* buf, unsigned long bufLen)
@@ -233,24 +350,28 @@ int TCPIPPort::Write(const unsigned char* buf, unsigned long bufLen)
 		if (!initialized_)
 			return ERR_PORT_NOTINITIALIZED;
 
-	boost::asio::write(sock_, boost::asio::buffer(buf, bufLen));
+	Send(buf, bufLen);
 
 	LogBinaryCommunication("Write", false, buf, bufLen);
 	ERRH_END
 }
 
+// Returns the data received so far (up to bufLen), without waiting
 int TCPIPPort::Read(unsigned char* buf, unsigned long bufLen, unsigned long& charsRead)
 {
 	ERRH_START
 		if (!initialized_)
 			return ERR_PORT_NOTINITIALIZED;
 
-	if (bufLen < 0)
-		return ERR_BUFFER_OVERRUN;
-
 	memset(buf, 0, bufLen);
 
-	charsRead = (unsigned long)boost::asio::read(sock_, boost::asio::buffer(buf, bufLen));
+	{
+		std::lock_guard<std::mutex> lock(rxMutex_);
+		charsRead = (unsigned long)rxBuffer_.Take(reinterpret_cast<char*>(buf), bufLen);
+		if (charsRead == 0 && rxError_)
+			return ReceiveErrorCode();
+		ResumeReceive();
+	}
 
 	if (charsRead > 0)
 		LogBinaryCommunication("Read", true, buf, charsRead);
@@ -259,6 +380,9 @@ int TCPIPPort::Read(unsigned char* buf, unsigned long bufLen, unsigned long& cha
 
 int TCPIPPort::Purge()
 {
+	std::lock_guard<std::mutex> lock(rxMutex_);
+	rxBuffer_.Clear();
+	ResumeReceive();
 	return DEVICE_OK;
 }
 
@@ -320,6 +444,72 @@ int TCPIPPort::OnAnswerTimeout(MM::PropertyBase* pProp, MM::ActionType eAct)
 	return DEVICE_OK;
 }
 
+int TCPIPPort::OnNoDelay(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(noDelay_ ? "Yes" : "No");
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (initialized_)
+		{
+			// revert
+			pProp->Set(noDelay_ ? "Yes" : "No");
+			return ERR_PORT_CHANGE_FORBIDDEN;
+		}
+		std::string s;
+		pProp->Get(s);
+		noDelay_ = (s == "Yes");
+	}
+
+	return DEVICE_OK;
+}
+
+int TCPIPPort::OnSendBufferSize(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(to_string(sendBufferSize_).c_str());
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (initialized_)
+		{
+			// revert
+			pProp->Set(to_string(sendBufferSize_).c_str());
+			return ERR_PORT_CHANGE_FORBIDDEN;
+		}
+		std::string s;
+		pProp->Get(s);
+		sendBufferSize_ = atoi(s.c_str());
+	}
+
+	return DEVICE_OK;
+}
+
+int TCPIPPort::OnReceiveBufferSize(MM::PropertyBase* pProp, MM::ActionType eAct)
+{
+	if (eAct == MM::BeforeGet)
+	{
+		pProp->Set(to_string(receiveBufferSize_).c_str());
+	}
+	else if (eAct == MM::AfterSet)
+	{
+		if (initialized_)
+		{
+			// revert
+			pProp->Set(to_string(receiveBufferSize_).c_str());
+			return ERR_PORT_CHANGE_FORBIDDEN;
+		}
+		std::string s;
+		pProp->Get(s);
+		receiveBufferSize_ = atoi(s.c_str());
+	}
+
+	return DEVICE_OK;
+}
+
 int TCPIPPort::GetCount()
 {
 	return count_;
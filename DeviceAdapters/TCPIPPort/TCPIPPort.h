@@ -25,7 +25,12 @@
 
 #include "boost/asio.hpp"
 
+#include <condition_variable>
+#include <cstddef>
 #include <istream>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 #include "MMDevice.h"
 #include "DeviceBase.h"
@@ -33,6 +38,7 @@
 #define BOOST_ERROR 20000
 
 #include "error_code.h"
+#include "RingBuffer.h"
 
 #define ERR_BUFFER_OVERRUN 106
 #define ERR_TERM_TIMEOUT 107
@@ -67,6 +73,9 @@ public:
 	int OnHost(MM::PropertyBase* pProp, MM::ActionType eAct);
 	int OnPort(MM::PropertyBase* pProp, MM::ActionType eAct);
 	int OnAnswerTimeout(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnNoDelay(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnSendBufferSize(MM::PropertyBase* pProp, MM::ActionType eAct);
+	int OnReceiveBufferSize(MM::PropertyBase* pProp, MM::ActionType eAct);
 
 	void close_sock();
 
@@ -84,6 +93,28 @@ private:
 	std::string host_;
 	unsigned short port_;
 	unsigned int answerTimeoutMs_;
+	bool noDelay_;
+	int sendBufferSize_; // 0 for system default
+	int receiveBufferSize_; // 0 for system default
+
+	// Once connected, the socket is only used on ioThread_: writes are posted
+	// to it and received data is read asynchronously into rxBuffer_, from
+	// which Read() and GetAnswer() are served. rxMutex_ guards the buffer and
+	// the receive state; rxCv_ is notified when data arrives or the
+	// connection fails.
+	std::unique_ptr<boost::asio::io_service::work> ioWork_;
+	std::thread ioThread_;
+	std::mutex rxMutex_;
+	std::condition_variable rxCv_;
+	RingBuffer rxBuffer_;
+	bool receivePending_;
+	boost::system::error_code rxError_;
+
+	void Send(const void* data, std::size_t len);
+	void StartReceive();
+	void ResumeReceive();
+	void ReceiveComplete(const boost::system::error_code& ec, std::size_t bytesTransferred);
+	int ReceiveErrorCode();
 
 	void LogAsciiCommunication(const char * prefix, bool isInput, const std::string & data);
 	void LogBinaryCommunication(const char* prefix, bool isInput, const unsigned char* content, std::size_t length);
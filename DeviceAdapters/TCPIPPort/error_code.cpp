@@ -25,7 +25,7 @@
 
 error_code::error_code(int code, std::string msg) : code(code), msg(msg) {}
 
-void error_code::ThrowErr(int code) throw (error_code)
+void error_code::ThrowErr(int code)
 {
 	if (code != DEVICE_OK)
 		throw error_code(code);
@@ -23,13 +23,13 @@
 
 #pragma once
 
-#include "boost\system\system_error.hpp"
-#include "..\MMDevice\DeviceBase.h"
+#include "boost/system/system_error.hpp"
+#include "DeviceBase.h"
 #include <exception>
 #include <string>
 
 #define ERRH_START try {
-#define ERRH_END } catch (boost::system::system_error e) { SetErrorText(BOOST_ERROR, e.what()); return BOOST_ERROR; } return DEVICE_OK;
+#define ERRH_END } catch (const boost::system::system_error& e) { SetErrorText(BOOST_ERROR, e.what()); return BOOST_ERROR; } return DEVICE_OK;
 
 class error_code : public std::exception
 {
@@ -39,5 +39,5 @@ public:
 	int code;
 	std::string msg;
 
-	static void ThrowErr(int code) throw (error_code);
+	static void ThrowErr(int code);
 }; 
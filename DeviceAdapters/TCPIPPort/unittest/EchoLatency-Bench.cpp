@@ -0,0 +1,171 @@
+// DESCRIPTION:   Command/answer latency benchmark for TCPIPPort, against a
+//                loopback server (POSIX only)
+//
+// LICENSE:       Licensed under the Apache License, Version 2.0 (the "License");
+//                you may not use this file except in compliance with the License.
+//                You may obtain a copy of the License at
+//
+//                http://www.apache.org/licenses/LICENSE-2.0
+//
+//                Unless required by applicable law or agreed to in writing, software
+//                distributed under the License is distributed on an "AS IS" BASIS,
+//                WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//                See the License for the specific language governing permissions and
+//                limitations under the License.
+//
+// Usage: EchoLatency-Bench [round_trips [answer_length]]
+//
+// A server thread answers every CR-terminated command with answer_length
+// characters followed by CRLF. The benchmark reports the distribution of
+// SetCommand() + GetAnswer() round-trip times through a TCPIPPort connected
+// to it over the loopback interface.
+
+#include "../TCPIPPort.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+void Serve(int listenFd, const std::string& answer, std::atomic<bool>& stop)
+{
+   int fd = accept(listenFd, 0, 0);
+   if (fd < 0)
+      return;
+   int one = 1;
+   setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+   std::vector<char> buf(4096);
+   while (!stop)
+   {
+      pollfd pfd = { fd, POLLIN, 0 };
+      if (poll(&pfd, 1, 50) <= 0)
+         continue;
+      ssize_t n = read(fd, buf.data(), buf.size());
+      if (n <= 0)
+         break;
+      // One answer per command terminator received
+      for (ssize_t i = 0; i < n; ++i)
+      {
+         if (buf[i] != '\r')
+            continue;
+         size_t written = 0;
+         while (written < answer.size())
+         {
+            ssize_t w = write(fd, answer.data() + written,
+                  answer.size() - written);
+            if (w <= 0)
+            {
+               close(fd);
+               return;
+            }
+            written += static_cast<size_t>(w);
+         }
+      }
+   }
+   close(fd);
+}
+
+double Percentile(const std::vector<double>& sorted, double p)
+{
+   size_t i = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+   return sorted[i];
+}
+
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+   const int roundTrips = argc > 1 ? atoi(argv[1]) : 2000;
+   const size_t answerLength = argc > 2 ? atoi(argv[2]) : 16;
+
+   int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+   sockaddr_in addr = {};
+   addr.sin_family = AF_INET;
+   addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   addr.sin_port = 0;
+   socklen_t addrLen = sizeof(addr);
+   if (listenFd < 0 ||
+         bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+         listen(listenFd, 1) != 0 ||
+         getsockname(listenFd, reinterpret_cast<sockaddr*>(&addr), &addrLen) != 0)
+   {
+      perror("Failed to create server socket");
+      return 1;
+   }
+   const std::string tcpPort = std::to_string(ntohs(addr.sin_port));
+
+   std::string answer(answerLength, 'x');
+   answer += "\r\n";
+   std::atomic<bool> stop(false);
+   std::thread server(Serve, listenFd, answer, std::ref(stop));
+
+   TCPIPPort port(1);
+   port.SetProperty("Host", "127.0.0.1");
+   port.SetProperty("TCP Port", tcpPort.c_str());
+   if (port.Initialize() != DEVICE_OK)
+   {
+      fprintf(stderr, "Failed to connect to port %s\n", tcpPort.c_str());
+      stop = true;
+      shutdown(listenFd, SHUT_RDWR);
+      server.join();
+      return 1;
+   }
+
+   std::vector<char> answerBuf(answerLength + 64);
+   std::vector<double> latenciesUs;
+   latenciesUs.reserve(roundTrips);
+   int errors = 0;
+   for (int i = 0; i < roundTrips; ++i)
+   {
+      auto start = std::chrono::steady_clock::now();
+      int err = port.SetCommand("PING", "\r");
+      if (err == DEVICE_OK)
+         err = port.GetAnswer(answerBuf.data(),
+               static_cast<unsigned>(answerBuf.size()), "\r\n");
+      auto end = std::chrono::steady_clock::now();
+      if (err != DEVICE_OK)
+      {
+         ++errors;
+         continue;
+      }
+      latenciesUs.push_back(
+            std::chrono::duration<double, std::micro>(end - start).count());
+   }
+
+   port.Shutdown();
+   stop = true;
+   server.join();
+   close(listenFd);
+
+   if (latenciesUs.empty())
+   {
+      fprintf(stderr, "All %d round trips failed\n", roundTrips);
+      return 1;
+   }
+   std::sort(latenciesUs.begin(), latenciesUs.end());
+   double sum = 0.0;
+   for (double l : latenciesUs)
+      sum += l;
+   printf("round trips: %zu (errors: %d), answer length: %zu\n",
+         latenciesUs.size(), errors, answerLength);
+   printf("latency (us): mean %.1f, median %.1f, p99 %.1f, max %.1f\n",
+         sum / latenciesUs.size(), Percentile(latenciesUs, 0.5),
+         Percentile(latenciesUs, 0.99), latenciesUs.back());
+   return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,157 @@
+// DESCRIPTION:   Tests of the receive ring buffer used by TCPIPPort
+//
+// LICENSE:       Licensed under the Apache License, Version 2.0 (the "License");
+//                you may not use this file except in compliance with the License.
+//                You may obtain a copy of the License at
+//
+//                http://www.apache.org/licenses/LICENSE-2.0
+//
+//                Unless required by applicable law or agreed to in writing, software
+//                distributed under the License is distributed on an "AS IS" BASIS,
+//                WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//                See the License for the specific language governing permissions and
+//                limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "../RingBuffer.h"
+
+#include <cstring>
+#include <string>
+#include <utility>
+
+
+namespace {
+
+// Copied so that EXPECT_EQ does not need the address of the static member
+const std::size_t npos = RingBuffer::npos;
+
+// Append as much of s as fits, the way the receive handler does
+std::size_t Receive(RingBuffer& ring, const std::string& s)
+{
+   std::size_t written = 0;
+   while (written < s.size())
+   {
+      std::pair<char*, std::size_t> region = ring.FreeRegion();
+      std::size_t n = std::min(region.second, s.size() - written);
+      if (n == 0)
+         break;
+      std::memcpy(region.first, s.data() + written, n);
+      ring.Commit(n);
+      written += n;
+   }
+   return written;
+}
+
+std::string TakeAll(RingBuffer& ring)
+{
+   std::string s(ring.Size(), '\0');
+   s.resize(ring.Take(&s[0], s.size()));
+   return s;
+}
+
+} // anonymous namespace
+
+
+TEST(RingBufferTests, StartsEmpty)
+{
+   RingBuffer ring(8);
+   EXPECT_EQ(0u, ring.Size());
+   EXPECT_EQ(8u, ring.Capacity());
+   EXPECT_FALSE(ring.Full());
+   EXPECT_EQ(8u, ring.FreeRegion().second);
+   EXPECT_EQ(npos, ring.Find("a", 1, 0));
+}
+
+TEST(RingBufferTests, TakeReturnsBytesInOrder)
+{
+   RingBuffer ring(8);
+   ASSERT_EQ(5u, Receive(ring, "hello"));
+   EXPECT_EQ(5u, ring.Size());
+   char buf[3];
+   ASSERT_EQ(3u, ring.Take(buf, 3));
+   EXPECT_EQ("hel", std::string(buf, 3));
+   EXPECT_EQ("lo", TakeAll(ring));
+   EXPECT_EQ(0u, ring.Size());
+}
+
+TEST(RingBufferTests, FreeRegionStopsAtEndOfStorage)
+{
+   RingBuffer ring(8);
+   ASSERT_EQ(6u, Receive(ring, "abcdef"));
+   ring.Consume(4);
+   // Free space is [6, 8) followed by [0, 4); only the first is contiguous
+   EXPECT_EQ(2u, ring.FreeRegion().second);
+   std::memcpy(ring.FreeRegion().first, "gh", 2);
+   ring.Commit(2);
+   EXPECT_EQ(4u, ring.FreeRegion().second);
+}
+
+TEST(RingBufferTests, DataWrapsAround)
+{
+   RingBuffer ring(8);
+   ASSERT_EQ(6u, Receive(ring, "abcdef"));
+   ring.Consume(5);
+   ASSERT_EQ(6u, Receive(ring, "ghijkl"));
+   EXPECT_EQ(7u, ring.Size());
+   EXPECT_EQ("fghijkl", TakeAll(ring));
+}
+
+TEST(RingBufferTests, FindsPatternAcrossWrap)
+{
+   RingBuffer ring(8);
+   ASSERT_EQ(5u, Receive(ring, "xxxxx"));
+   ring.Consume(5);
+   ASSERT_EQ(5u, Receive(ring, "ab\r\nc"));
+   // "\r" is stored at the last index and "\n" at index 0
+   EXPECT_EQ(2u, ring.Find("\r\n", 2, 0));
+   EXPECT_EQ(2u, ring.Find("\r\n", 2, 2));
+   EXPECT_EQ(npos, ring.Find("\r\n", 2, 3));
+   EXPECT_EQ(npos, ring.Find("cd", 2, 0));
+}
+
+TEST(RingBufferTests, StopsAcceptingDataWhenFull)
+{
+   RingBuffer ring(8);
+   EXPECT_EQ(8u, Receive(ring, "0123456789"));
+   EXPECT_TRUE(ring.Full());
+   EXPECT_EQ(0u, ring.FreeRegion().second);
+
+   ring.Consume(3);
+   EXPECT_FALSE(ring.Full());
+   EXPECT_EQ(3u, Receive(ring, "89ab"));
+   EXPECT_TRUE(ring.Full());
+   EXPECT_EQ("3456789a", TakeAll(ring));
+}
+
+TEST(RingBufferTests, TakeAndConsumeAreLimitedToSize)
+{
+   RingBuffer ring(8);
+   ASSERT_EQ(3u, Receive(ring, "abc"));
+   char buf[8];
+   EXPECT_EQ(3u, ring.Take(buf, sizeof(buf)));
+   EXPECT_EQ("abc", std::string(buf, 3));
+   EXPECT_EQ(0u, ring.Take(buf, sizeof(buf)));
+
+   ASSERT_EQ(2u, Receive(ring, "de"));
+   ring.Consume(10);
+   EXPECT_EQ(0u, ring.Size());
+}
+
+TEST(RingBufferTests, ClearKeepsFreeRegionInPlace)
+{
+   RingBuffer ring(8);
+   ASSERT_EQ(5u, Receive(ring, "abcde"));
+   char* receiving = ring.FreeRegion().first;
+   ring.Clear();
+   EXPECT_EQ(0u, ring.Size());
+   EXPECT_EQ(receiving, ring.FreeRegion().first);
+   EXPECT_EQ(3u, ring.FreeRegion().second);
+}
+
+
+int main(int argc, char **argv)
+{
+   ::testing::InitGoogleTest(&argc, argv);
+   return RUN_ALL_TESTS();
+}
@@ -0,0 +1,285 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          V4L2Convert.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Conversion of video4linux2 frames to Micro-Manager pixel types
+//
+// LICENSE:       This file is distributed under the "LGPL" license.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "V4L2Convert.h"
+
+#include <cstring>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#ifdef HAVE_LIBJPEG
+#include <csetjmp>
+#include <cstdio>
+#include <jpeglib.h>
+#endif
+
+
+namespace {
+
+inline unsigned char Clip(int val)
+{
+   if (val <= 0)
+      return 0;
+   else if (val >= 255)
+      return 255;
+   else
+      return static_cast<unsigned char>(val);
+}
+
+// Fixed-point BT.601, in the same arithmetic as the SSE2 kernel below
+inline void YUVToBGRA(int y, int d, int e, unsigned char* out)
+{
+   const int c = y - 16;
+   out[0] = Clip((298 * c + 516 * d + 128) >> 8); // blue
+   out[1] = Clip((298 * c - 100 * d - 208 * e + 128) >> 8); // green
+   out[2] = Clip((298 * c + 409 * e + 128) >> 8); // red
+   out[3] = 255; // alpha
+}
+
+#ifdef __SSE2__
+// Coefficients for _mm_madd_epi16 on interleaved (a, b) pairs
+inline __m128i PairCoefficients(short a, short b)
+{
+   return _mm_set_epi16(b, a, b, a, b, a, b, a);
+}
+
+// Rounds and shifts the 32-bit sums of 8 pixels, saturating to 16 bits
+inline __m128i ShiftAndPack(__m128i lo, __m128i hi)
+{
+   return _mm_packs_epi32(_mm_srai_epi32(lo, 8), _mm_srai_epi32(hi, 8));
+}
+#endif
+
+void ConvertYUYVRowToBGRA(const unsigned char* in, unsigned width,
+   unsigned char* out)
+{
+   unsigned x = 0;
+#ifdef __SSE2__
+   const __m128i lowBytes = _mm_set1_epi16(0x00ff);
+   const __m128i lumaOffset = _mm_set1_epi16(16);
+   const __m128i chromaOffset = _mm_set1_epi16(128);
+   const __m128i one = _mm_set1_epi16(1);
+   const __m128i rounding = _mm_set1_epi32(128);
+   const __m128i alpha = _mm_set1_epi16(255);
+   const __m128i blueCD = PairCoefficients(298, 516);
+   const __m128i greenCD = PairCoefficients(298, -100);
+   const __m128i greenE = PairCoefficients(-208, 128); // With the rounding
+   const __m128i redCE = PairCoefficients(298, 409);
+
+   // 8 pixels (4 macropixels) at a time
+   for (; x + 8 <= width; x += 8)
+   {
+      const __m128i yuyv = _mm_loadu_si128(
+         reinterpret_cast<const __m128i*>(in + 2 * x));
+      const __m128i c = _mm_sub_epi16(_mm_and_si128(yuyv, lowBytes), lumaOffset);
+      const __m128i uv = _mm_sub_epi16(_mm_srli_epi16(yuyv, 8), chromaOffset);
+      const __m128i d = _mm_shufflehi_epi16(
+         _mm_shufflelo_epi16(uv, _MM_SHUFFLE(2, 2, 0, 0)), _MM_SHUFFLE(2, 2, 0, 0));
+      const __m128i e = _mm_shufflehi_epi16(
+         _mm_shufflelo_epi16(uv, _MM_SHUFFLE(3, 3, 1, 1)), _MM_SHUFFLE(3, 3, 1, 1));
+
+      const __m128i cdLo = _mm_unpacklo_epi16(c, d);
+      const __m128i cdHi = _mm_unpackhi_epi16(c, d);
+      const __m128i ceLo = _mm_unpacklo_epi16(c, e);
+      const __m128i ceHi = _mm_unpackhi_epi16(c, e);
+      const __m128i e1Lo = _mm_unpacklo_epi16(e, one);
+      const __m128i e1Hi = _mm_unpackhi_epi16(e, one);
+
+      const __m128i blue = ShiftAndPack(
+         _mm_add_epi32(_mm_madd_epi16(cdLo, blueCD), rounding),
+         _mm_add_epi32(_mm_madd_epi16(cdHi, blueCD), rounding));
+      const __m128i green = ShiftAndPack(
+         _mm_add_epi32(_mm_madd_epi16(cdLo, greenCD), _mm_madd_epi16(e1Lo, greenE)),
+         _mm_add_epi32(_mm_madd_epi16(cdHi, greenCD), _mm_madd_epi16(e1Hi, greenE)));
+      const __m128i red = ShiftAndPack(
+         _mm_add_epi32(_mm_madd_epi16(ceLo, redCE), rounding),
+         _mm_add_epi32(_mm_madd_epi16(ceHi, redCE), rounding));
+
+      // Saturation to unsigned bytes does the clipping
+      const __m128i bg = _mm_packus_epi16(blue, green);
+      const __m128i ra = _mm_packus_epi16(red, alpha);
+      const __m128i bgPairs = _mm_unpacklo_epi8(bg, _mm_srli_si128(bg, 8));
+      const __m128i raPairs = _mm_unpacklo_epi8(ra, _mm_srli_si128(ra, 8));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4 * x),
+         _mm_unpacklo_epi16(bgPairs, raPairs));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4 * x + 16),
+         _mm_unpackhi_epi16(bgPairs, raPairs));
+   }
+#endif
+
+   for (; x + 2 <= width; x += 2)
+   {
+      const unsigned char* p = in + 2 * x;
+      const int d = p[1] - 128;
+      const int e = p[3] - 128;
+      YUVToBGRA(p[0], d, e, out + 4 * x);
+      YUVToBGRA(p[2], d, e, out + 4 * x + 4);
+   }
+   if (x < width)
+   {
+      // Odd width: the last macropixel is only half used
+      const unsigned char* p = in + 2 * x;
+      YUVToBGRA(p[0], p[1] - 128, p[3] - 128, out + 4 * x);
+   }
+}
+
+void ConvertYUYVRowToGray8(const unsigned char* in, unsigned width,
+   unsigned char* out)
+{
+   unsigned x = 0;
+#ifdef __SSE2__
+   const __m128i lowBytes = _mm_set1_epi16(0x00ff);
+   for (; x + 16 <= width; x += 16)
+   {
+      const __m128i a = _mm_loadu_si128(
+         reinterpret_cast<const __m128i*>(in + 2 * x));
+      const __m128i b = _mm_loadu_si128(
+         reinterpret_cast<const __m128i*>(in + 2 * x + 16));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x),
+         _mm_packus_epi16(_mm_and_si128(a, lowBytes), _mm_and_si128(b, lowBytes)));
+   }
+#endif
+   for (; x < width; ++x)
+      out[x] = in[2 * x];
+}
+
+#ifdef HAVE_LIBJPEG
+struct JpegErrorManager
+{
+   struct jpeg_error_mgr pub;
+   std::jmp_buf jump;
+   char message[JMSG_LENGTH_MAX];
+};
+
+// The default handler exits the process
+void OnJpegError(j_common_ptr cinfo)
+{
+   JpegErrorManager* err = reinterpret_cast<JpegErrorManager*>(cinfo->err);
+   (*cinfo->err->format_message)(cinfo, err->message);
+   std::longjmp(err->jump, 1);
+}
+
+// Corrupt-data warnings are common in webcam streams; don't print them
+void OnJpegMessage(j_common_ptr)
+{
+}
+#endif
+
+} // namespace
+
+
+void ConvertYUYVToBGRA(const unsigned char* in, unsigned width,
+   unsigned height, unsigned inLineBytes, unsigned char* out)
+{
+   const std::size_t inStride = inLineBytes ? inLineBytes : 2 * width;
+   for (unsigned y = 0; y < height; ++y)
+      ConvertYUYVRowToBGRA(in + y * inStride, width,
+         out + static_cast<std::size_t>(y) * width * 4);
+}
+
+void ConvertYUYVToGray8(const unsigned char* in, unsigned width,
+   unsigned height, unsigned inLineBytes, unsigned char* out)
+{
+   const std::size_t inStride = inLineBytes ? inLineBytes : 2 * width;
+   for (unsigned y = 0; y < height; ++y)
+      ConvertYUYVRowToGray8(in + y * inStride, width,
+         out + static_cast<std::size_t>(y) * width);
+}
+
+void CopyPackedRows(const unsigned char* in, unsigned rowBytes,
+   unsigned height, unsigned inLineBytes, unsigned char* out)
+{
+   if (inLineBytes == 0 || inLineBytes == rowBytes)
+   {
+      std::memcpy(out, in, static_cast<std::size_t>(rowBytes) * height);
+      return;
+   }
+   for (unsigned y = 0; y < height; ++y)
+      std::memcpy(out + static_cast<std::size_t>(y) * rowBytes,
+         in + static_cast<std::size_t>(y) * inLineBytes, rowBytes);
+}
+
+bool IsMJPEGDecodingSupported()
+{
+#ifdef HAVE_LIBJPEG
+   return true;
+#else
+   return false;
+#endif
+}
+
+#ifdef HAVE_LIBJPEG
+bool DecodeMJPEGToBGRA(const unsigned char* in, std::size_t size,
+   unsigned width, unsigned height, unsigned char* out, std::string& error)
+{
+   std::vector<unsigned char> row(static_cast<std::size_t>(width) * 3);
+
+   struct jpeg_decompress_struct cinfo;
+   JpegErrorManager err;
+   cinfo.err = jpeg_std_error(&err.pub);
+   err.pub.error_exit = OnJpegError;
+   err.pub.output_message = OnJpegMessage;
+   if (setjmp(err.jump))
+   {
+      jpeg_destroy_decompress(&cinfo);
+      error = std::string("could not decode MJPEG frame: ") + err.message;
+      return false;
+   }
+
+   jpeg_create_decompress(&cinfo);
+   jpeg_mem_src(&cinfo, const_cast<unsigned char*>(in),
+      static_cast<unsigned long>(size));
+   jpeg_read_header(&cinfo, TRUE);
+   cinfo.out_color_space = JCS_RGB;
+   jpeg_start_decompress(&cinfo);
+   if (cinfo.output_width != width || cinfo.output_height != height ||
+      cinfo.output_components != 3)
+   {
+      jpeg_destroy_decompress(&cinfo);
+      error = "MJPEG frame does not have the negotiated size";
+      return false;
+   }
+
+   while (cinfo.output_scanline < cinfo.output_height)
+   {
+      unsigned char* dst = out +
+         static_cast<std::size_t>(cinfo.output_scanline) * width * 4;
+      JSAMPROW rows[1] = { row.data() };
+      jpeg_read_scanlines(&cinfo, rows, 1);
+      for (unsigned x = 0; x < width; ++x)
+      {
+         dst[4 * x + 0] = row[3 * x + 2];
+         dst[4 * x + 1] = row[3 * x + 1];
+         dst[4 * x + 2] = row[3 * x + 0];
+         dst[4 * x + 3] = 255;
+      }
+   }
+   jpeg_finish_decompress(&cinfo);
+   jpeg_destroy_decompress(&cinfo);
+   return true;
+}
+#else
+bool DecodeMJPEGToBGRA(const unsigned char*, std::size_t, unsigned, unsigned,
+   unsigned char*, std::string& error)
+{
+   error = "MJPEG is not supported (built without libjpeg)";
+   return false;
+}
+#endif
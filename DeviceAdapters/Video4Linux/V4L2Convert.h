@@ -0,0 +1,43 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          V4L2Convert.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Conversion of video4linux2 frames to Micro-Manager pixel types
+//
+// LICENSE:       This file is distributed under the "LGPL" license.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Rows of the input are inLineBytes apart, or packed if it is 0. The output
+// is always packed.
+
+// YUYV (4:2:2, BT.601 studio range) to RGB32 (BGRA, opaque)
+void ConvertYUYVToBGRA(const unsigned char* in, unsigned width,
+   unsigned height, unsigned inLineBytes, unsigned char* out);
+
+// The luma of YUYV, as 8-bit grayscale
+void ConvertYUYVToGray8(const unsigned char* in, unsigned width,
+   unsigned height, unsigned inLineBytes, unsigned char* out);
+
+// Row-by-row copy of formats that need no conversion (GREY, Y16)
+void CopyPackedRows(const unsigned char* in, unsigned rowBytes,
+   unsigned height, unsigned inLineBytes, unsigned char* out);
+
+// Whether the adapter was built with a JPEG decoder (libjpeg)
+bool IsMJPEGDecodingSupported();
+
+// Decodes a Motion-JPEG frame of the given size to RGB32
+bool DecodeMJPEGToBGRA(const unsigned char* in, std::size_t size,
+   unsigned width, unsigned height, unsigned char* out, std::string& error);
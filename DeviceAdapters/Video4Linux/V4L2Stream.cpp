@@ -0,0 +1,430 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          V4L2Stream.cpp
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Memory-mapped streaming capture from a video4linux2 device
+//
+// LICENSE:       This file is distributed under the "LGPL" license.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "V4L2Stream.h"
+
+#include <linux/videodev2.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+
+namespace {
+
+// How long a busy device is waited for before an ioctl gives up
+const int busyTimeoutMs = 10000;
+
+std::string ErrnoMessage(const std::string& what)
+{
+   const int err = errno;
+   std::ostringstream msg;
+   msg << what << ": " << strerror(err) << " (errno " << err << ")";
+   return msg.str();
+}
+
+} // namespace
+
+
+int SystemV4L2Io::Open(const char* path)
+{
+   return open(path, O_RDWR);
+}
+
+int SystemV4L2Io::Close(int fd)
+{
+   return close(fd);
+}
+
+int SystemV4L2Io::Ioctl(int fd, unsigned long request, void* arg)
+{
+   return ioctl(fd, request, arg);
+}
+
+int SystemV4L2Io::Poll(int fd, int timeoutMs)
+{
+   struct pollfd pfd;
+   pfd.fd = fd;
+   pfd.events = POLLIN;
+   pfd.revents = 0;
+   const int ret = poll(&pfd, 1, timeoutMs);
+   return ret > 0 ? 1 : ret;
+}
+
+void* SystemV4L2Io::Mmap(std::size_t length, int fd, long offset)
+{
+   return mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, offset);
+}
+
+int SystemV4L2Io::Munmap(void* start, std::size_t length)
+{
+   return munmap(start, length);
+}
+
+
+V4L2Stream::V4L2Stream(V4L2Io& io) :
+   io_(io),
+   fd_(-1),
+   streaming_(false),
+   haveSequence_(false),
+   lastSequence_(0),
+   frameCount_(0),
+   droppedCount_(0)
+{
+   std::memset(&format_, 0, sizeof(format_));
+}
+
+V4L2Stream::~V4L2Stream()
+{
+   Close();
+}
+
+bool V4L2Stream::Open(const std::string& path, std::string& error)
+{
+   Close();
+
+   fd_ = io_.Open(path.c_str());
+   if (fd_ < 0)
+   {
+      error = ErrnoMessage("could not open the video device " + path);
+      return false;
+   }
+
+   struct v4l2_capability cap;
+   std::memset(&cap, 0, sizeof(cap));
+   if (TryIoctl(VIDIOC_QUERYCAP, &cap) == -1)
+   {
+      error = errno == EINVAL ? std::string("device is not a v4l2 device") :
+         ErrnoMessage("could not query v4l2 capabilities");
+      Close();
+      return false;
+   }
+
+   const std::uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ?
+      cap.device_caps : cap.capabilities;
+   if (!(caps & V4L2_CAP_VIDEO_CAPTURE))
+   {
+      error = "device is not a v4l2 capture device";
+      Close();
+      return false;
+   }
+   if (!(caps & V4L2_CAP_STREAMING))
+   {
+      error = "device does not support streaming I/O";
+      Close();
+      return false;
+   }
+   return true;
+}
+
+void V4L2Stream::Close()
+{
+   Stop();
+   if (fd_ >= 0)
+      io_.Close(fd_);
+   fd_ = -1;
+   std::memset(&format_, 0, sizeof(format_));
+}
+
+std::vector<std::uint32_t> V4L2Stream::GetPixelFormats()
+{
+   std::vector<std::uint32_t> formats;
+   for (std::uint32_t i = 0; ; ++i)
+   {
+      struct v4l2_fmtdesc desc;
+      std::memset(&desc, 0, sizeof(desc));
+      desc.index = i;
+      desc.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+      if (TryIoctl(VIDIOC_ENUM_FMT, &desc) == -1)
+         break;
+      formats.push_back(desc.pixelformat);
+   }
+   return formats;
+}
+
+bool V4L2Stream::SetFormat(std::uint32_t pixelFormat, unsigned width,
+   unsigned height, std::string& error)
+{
+   struct v4l2_format fmt;
+   std::memset(&fmt, 0, sizeof(fmt));
+   fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+   fmt.fmt.pix.pixelformat = pixelFormat;
+   fmt.fmt.pix.field = V4L2_FIELD_ANY;
+   fmt.fmt.pix.width = width;
+   fmt.fmt.pix.height = height;
+
+   if (TryIoctl(VIDIOC_S_FMT, &fmt) == -1)
+   {
+      error = ErrnoMessage("could not set format " + FourccToString(pixelFormat));
+      return false;
+   }
+   if (fmt.fmt.pix.pixelformat != pixelFormat)
+   {
+      error = "device does not support format " + FourccToString(pixelFormat) +
+         " (offered " + FourccToString(fmt.fmt.pix.pixelformat) + ")";
+      return false;
+   }
+
+   format_.pixelFormat = fmt.fmt.pix.pixelformat;
+   format_.width = fmt.fmt.pix.width;
+   format_.height = fmt.fmt.pix.height;
+   format_.bytesPerLine = fmt.fmt.pix.bytesperline;
+   format_.imageSize = fmt.fmt.pix.sizeimage;
+   return true;
+}
+
+bool V4L2Stream::Start(unsigned bufferCount, std::string& error)
+{
+   Stop();
+
+   struct v4l2_requestbuffers reqbuf;
+   std::memset(&reqbuf, 0, sizeof(reqbuf));
+   reqbuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+   reqbuf.memory = V4L2_MEMORY_MMAP;
+   reqbuf.count = bufferCount;
+   if (TryIoctl(VIDIOC_REQBUFS, &reqbuf) == -1)
+   {
+      error = errno == EINVAL ?
+         std::string("the device does not support memory mapping") :
+         ErrnoMessage("could not request memory map buffers");
+      return false;
+   }
+   if (reqbuf.count == 0)
+   {
+      error = "the device did not provide any buffers";
+      return false;
+   }
+
+   for (unsigned i = 0; i < reqbuf.count; ++i)
+   {
+      struct v4l2_buffer buf;
+      std::memset(&buf, 0, sizeof(buf));
+      buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+      buf.memory = V4L2_MEMORY_MMAP;
+      buf.index = i;
+      if (TryIoctl(VIDIOC_QUERYBUF, &buf) == -1)
+      {
+         error = ErrnoMessage("could not query the buffer state");
+         UnmapBuffers();
+         return false;
+      }
+
+      Buffer buffer;
+      buffer.length = buf.length;
+      buffer.start = io_.Mmap(buf.length, fd_, static_cast<long>(buf.m.offset));
+      if (buffer.start == MAP_FAILED)
+      {
+         error = ErrnoMessage("memory map failed");
+         UnmapBuffers();
+         return false;
+      }
+      buffers_.push_back(buffer);
+   }
+
+   for (unsigned i = 0; i < buffers_.size(); ++i)
+   {
+      if (!QueueBuffer(i, error))
+      {
+         UnmapBuffers();
+         return false;
+      }
+   }
+
+   int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+   if (TryIoctl(VIDIOC_STREAMON, &type) == -1)
+   {
+      error = ErrnoMessage("could not start the stream");
+      UnmapBuffers();
+      return false;
+   }
+
+   streaming_ = true;
+   ResetCounters();
+   return true;
+}
+
+void V4L2Stream::Stop()
+{
+   if (streaming_)
+   {
+      // Dequeues all buffers
+      int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+      TryIoctl(VIDIOC_STREAMOFF, &type);
+      streaming_ = false;
+   }
+   UnmapBuffers();
+}
+
+int V4L2Stream::Dequeue(int timeoutMs, V4L2Frame& frame, std::string& error)
+{
+   for (;;)
+   {
+      const int ready = io_.Poll(fd_, timeoutMs);
+      if (ready == -1)
+      {
+         if (errno == EINTR)
+            continue;
+         error = ErrnoMessage("could not wait for the next frame");
+         return -1;
+      }
+      if (ready == 0)
+         return 0;
+
+      struct v4l2_buffer buf;
+      std::memset(&buf, 0, sizeof(buf));
+      buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+      buf.memory = V4L2_MEMORY_MMAP;
+      if (TryIoctl(VIDIOC_DQBUF, &buf) == -1)
+      {
+         error = ErrnoMessage("could not dequeue the next image buffer");
+         return -1;
+      }
+      if (buf.index >= buffers_.size())
+      {
+         error = "driver returned an unknown buffer";
+         return -1;
+      }
+
+      CountSequence(buf.sequence);
+      if (buf.flags & V4L2_BUF_FLAG_ERROR)
+      {
+         ++droppedCount_;
+         if (!QueueBuffer(buf.index, error))
+            return -1;
+         continue;
+      }
+
+      ++frameCount_;
+      frame.data = static_cast<const unsigned char*>(buffers_[buf.index].start);
+      frame.bytesUsed = buf.bytesused;
+      frame.index = buf.index;
+      frame.sequence = buf.sequence;
+      return 1;
+   }
+}
+
+bool V4L2Stream::Requeue(const V4L2Frame& frame, std::string& error)
+{
+   return QueueBuffer(frame.index, error);
+}
+
+bool V4L2Stream::Discard(std::string& error)
+{
+   for (unsigned i = 0; i < buffers_.size(); ++i)
+   {
+      V4L2Frame frame;
+      const int ret = Dequeue(0, frame, error);
+      if (ret < 0)
+         return false;
+      if (ret == 0)
+         return true;
+      // Not delivered, so neither captured nor dropped
+      --frameCount_;
+      if (!Requeue(frame, error))
+         return false;
+   }
+   return true;
+}
+
+void V4L2Stream::ResetCounters()
+{
+   haveSequence_ = false;
+   frameCount_ = 0;
+   droppedCount_ = 0;
+}
+
+int V4L2Stream::TryIoctl(unsigned long request, void* arg)
+{
+   while (io_.Ioctl(fd_, request, arg) == -1)
+   {
+      if (errno == EINTR)
+         continue;
+      if (!(errno == EBUSY || errno == EAGAIN))
+         return -1;
+
+      const int ready = io_.Poll(fd_, busyTimeoutMs);
+      if (ready == 0)
+      {
+         errno = ETIMEDOUT;
+         return -1;
+      }
+      if (ready == -1 && errno != EINTR)
+         return -1;
+   }
+   return 0;
+}
+
+bool V4L2Stream::QueueBuffer(unsigned index, std::string& error)
+{
+   struct v4l2_buffer buf;
+   std::memset(&buf, 0, sizeof(buf));
+   buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+   buf.memory = V4L2_MEMORY_MMAP;
+   buf.index = index;
+   if (TryIoctl(VIDIOC_QBUF, &buf) == -1)
+   {
+      error = ErrnoMessage("could not enqueue buffer");
+      return false;
+   }
+   return true;
+}
+
+void V4L2Stream::UnmapBuffers()
+{
+   if (buffers_.empty())
+      return;
+
+   for (const Buffer& buffer : buffers_)
+      io_.Munmap(buffer.start, buffer.length);
+   buffers_.clear();
+
+   // Free the buffers in the driver, so that the format can be changed
+   struct v4l2_requestbuffers reqbuf;
+   std::memset(&reqbuf, 0, sizeof(reqbuf));
+   reqbuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+   reqbuf.memory = V4L2_MEMORY_MMAP;
+   reqbuf.count = 0;
+   TryIoctl(VIDIOC_REQBUFS, &reqbuf);
+}
+
+void V4L2Stream::CountSequence(std::uint32_t sequence)
+{
+   // A sequence number going backwards (the driver restarting) is not a gap
+   const std::uint32_t gap = sequence - lastSequence_;
+   if (haveSequence_ && gap > 1 && gap < 0x80000000u)
+      droppedCount_ += gap - 1;
+   lastSequence_ = sequence;
+   haveSequence_ = true;
+}
+
+
+std::string FourccToString(std::uint32_t fourcc)
+{
+   std::string s;
+   for (int i = 0; i < 4; ++i)
+   {
+      const char c = static_cast<char>((fourcc >> (8 * i)) & 0xff);
+      if (c != ' ')
+         s += c;
+   }
+   return s;
+}
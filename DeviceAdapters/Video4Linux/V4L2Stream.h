@@ -0,0 +1,148 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE:          V4L2Stream.h
+// PROJECT:       Micro-Manager
+// SUBSYSTEM:     DeviceAdapters
+//-----------------------------------------------------------------------------
+// DESCRIPTION:   Memory-mapped streaming capture from a video4linux2 device
+//
+// LICENSE:       This file is distributed under the "LGPL" license.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// The system calls used to talk to the device, so that the stream can be
+// driven by a fake device in tests. Like the system calls, the functions
+// return -1 (or MAP_FAILED) and set errno on failure.
+class V4L2Io
+{
+public:
+   virtual ~V4L2Io() {}
+
+   virtual int Open(const char* path) = 0;
+   virtual int Close(int fd) = 0;
+   virtual int Ioctl(int fd, unsigned long request, void* arg) = 0;
+   // Returns 1 if fd is readable, 0 on timeout
+   virtual int Poll(int fd, int timeoutMs) = 0;
+   virtual void* Mmap(std::size_t length, int fd, long offset) = 0;
+   virtual int Munmap(void* start, std::size_t length) = 0;
+};
+
+class SystemV4L2Io : public V4L2Io
+{
+public:
+   int Open(const char* path) override;
+   int Close(int fd) override;
+   int Ioctl(int fd, unsigned long request, void* arg) override;
+   int Poll(int fd, int timeoutMs) override;
+   void* Mmap(std::size_t length, int fd, long offset) override;
+   int Munmap(void* start, std::size_t length) override;
+};
+
+
+// Format of the frames, as negotiated with the driver
+struct V4L2FrameFormat
+{
+   std::uint32_t pixelFormat;
+   unsigned width;
+   unsigned height;
+   unsigned bytesPerLine;
+   std::size_t imageSize;
+};
+
+// A filled buffer, valid until it is requeued
+struct V4L2Frame
+{
+   const unsigned char* data;
+   std::size_t bytesUsed;
+   unsigned index;
+   std::uint32_t sequence;
+};
+
+// Capture with all the memory-mapped buffers kept queued in the driver
+// except for the one being read. Functions that can fail return false and
+// set the error message.
+class V4L2Stream
+{
+public:
+   explicit V4L2Stream(V4L2Io& io);
+   ~V4L2Stream();
+
+   V4L2Stream(const V4L2Stream&) = delete;
+   V4L2Stream& operator=(const V4L2Stream&) = delete;
+
+   bool Open(const std::string& path, std::string& error);
+   void Close();
+   bool IsOpen() const { return fd_ >= 0; }
+
+   // Pixel formats offered by the device (fourcc codes)
+   std::vector<std::uint32_t> GetPixelFormats();
+
+   // The driver may adjust the size; a different pixel format is an error
+   bool SetFormat(std::uint32_t pixelFormat, unsigned width, unsigned height,
+      std::string& error);
+   const V4L2FrameFormat& GetFormat() const { return format_; }
+
+   // Map and queue the buffers (the driver may provide a different count)
+   // and start streaming
+   bool Start(unsigned bufferCount, std::string& error);
+   void Stop();
+   bool IsStreaming() const { return streaming_; }
+   unsigned GetBufferCount() const { return static_cast<unsigned>(buffers_.size()); }
+
+   // Waits for the next filled buffer. Returns 1 with a frame that must be
+   // returned with Requeue(), 0 on timeout and -1 on error. Buffers that the
+   // driver flags as corrupted are requeued and counted as dropped.
+   int Dequeue(int timeoutMs, V4L2Frame& frame, std::string& error);
+   bool Requeue(const V4L2Frame& frame, std::string& error);
+
+   // Requeue the buffers that are already filled, so that the next frame is
+   // one that started after this call
+   bool Discard(std::string& error);
+
+   // Counted since Start() or ResetCounters(); may be read from any thread.
+   // Frames that the driver skipped are found from gaps in its sequence
+   // numbers.
+   std::uint64_t GetFrameCount() const { return frameCount_; }
+   std::uint64_t GetDroppedFrameCount() const { return droppedCount_; }
+   void ResetCounters();
+
+private:
+   struct Buffer
+   {
+      void* start;
+      std::size_t length;
+   };
+
+   // Retries while the device is busy
+   int TryIoctl(unsigned long request, void* arg);
+   bool QueueBuffer(unsigned index, std::string& error);
+   void UnmapBuffers();
+   void CountSequence(std::uint32_t sequence);
+
+   V4L2Io& io_;
+   int fd_;
+   V4L2FrameFormat format_;
+   std::vector<Buffer> buffers_;
+   bool streaming_;
+   bool haveSequence_;
+   std::uint32_t lastSequence_;
+   std::atomic<std::uint64_t> frameCount_;
+   std::atomic<std::uint64_t> droppedCount_;
+};
+
+// "YUYV" for a fourcc code
+std::string FourccToString(std::uint32_t fourcc);
@@ -0,0 +1,219 @@
+// DESCRIPTION:   Unit tests for video4linux2 frame conversion
+//
+// LICENSE:       This file is distributed under the "LGPL" license.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include <gtest/gtest.h>
+
+#include "V4L2Convert.h"
+
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_LIBJPEG
+#include <cstdio>
+#include <jpeglib.h>
+#endif
+
+
+namespace {
+
+std::vector<unsigned char> RandomBytes(std::size_t n)
+{
+   std::mt19937 rng(42);
+   std::vector<unsigned char> bytes(n);
+   for (unsigned char& b : bytes)
+      b = static_cast<unsigned char>(rng());
+   return bytes;
+}
+
+unsigned char Clip(int val)
+{
+   return static_cast<unsigned char>(val < 0 ? 0 : val > 255 ? 255 : val);
+}
+
+// The conversion of the original adapter, one pixel at a time
+void ReferenceYUYVToBGRA(int y, int u, int v, unsigned char* out)
+{
+   const int c = y - 16;
+   const int d = u - 128;
+   const int e = v - 128;
+   out[0] = Clip((298 * c + 516 * d + 128) >> 8);
+   out[1] = Clip((298 * c - 100 * d - 208 * e + 128) >> 8);
+   out[2] = Clip((298 * c + 409 * e + 128) >> 8);
+   out[3] = 255;
+}
+
+#ifdef HAVE_LIBJPEG
+std::vector<unsigned char> EncodeJpeg(unsigned width, unsigned height,
+   unsigned char r, unsigned char g, unsigned char b)
+{
+   jpeg_compress_struct cinfo;
+   jpeg_error_mgr jerr;
+   cinfo.err = jpeg_std_error(&jerr);
+   jpeg_create_compress(&cinfo);
+   unsigned char* data = nullptr;
+   unsigned long size = 0;
+   jpeg_mem_dest(&cinfo, &data, &size);
+   cinfo.image_width = width;
+   cinfo.image_height = height;
+   cinfo.input_components = 3;
+   cinfo.in_color_space = JCS_RGB;
+   jpeg_set_defaults(&cinfo);
+   jpeg_set_quality(&cinfo, 95, TRUE);
+   jpeg_start_compress(&cinfo, TRUE);
+   std::vector<unsigned char> row(width * 3);
+   for (unsigned x = 0; x < width; ++x)
+   {
+      row[3 * x + 0] = r;
+      row[3 * x + 1] = g;
+      row[3 * x + 2] = b;
+   }
+   while (cinfo.next_scanline < height)
+   {
+      JSAMPROW rows[1] = { row.data() };
+      jpeg_write_scanlines(&cinfo, rows, 1);
+   }
+   jpeg_finish_compress(&cinfo);
+   jpeg_destroy_compress(&cinfo);
+   std::vector<unsigned char> jpeg(data, data + size);
+   std::free(data);
+   return jpeg;
+}
+#endif
+
+} // namespace
+
+
+TEST(V4L2ConvertTests, YUYVToBGRAMatchesTheReference)
+{
+   // Widths around the 8-pixel blocks, including odd ones, with padded rows
+   for (unsigned width = 1; width <= 37; ++width)
+   {
+      const unsigned height = 3;
+      const unsigned lineBytes = 2 * ((width + 1) / 2) * 2 + 6;
+      const std::vector<unsigned char> in = RandomBytes(lineBytes * height);
+      std::vector<unsigned char> out(width * height * 4, 0);
+      ConvertYUYVToBGRA(in.data(), width, height, lineBytes, out.data());
+
+      for (unsigned y = 0; y < height; ++y)
+      {
+         for (unsigned x = 0; x < width; ++x)
+         {
+            const unsigned char* macropixel = &in[y * lineBytes + 4 * (x / 2)];
+            unsigned char expected[4];
+            ReferenceYUYVToBGRA(macropixel[2 * (x % 2)], macropixel[1],
+               macropixel[3], expected);
+            const unsigned char* actual = &out[4 * (y * width + x)];
+            for (int c = 0; c < 4; ++c)
+               ASSERT_EQ(expected[c], actual[c]) << "width " << width <<
+                  " pixel (" << x << ", " << y << ") component " << c;
+         }
+      }
+   }
+}
+
+TEST(V4L2ConvertTests, YUYVToBGRAClipsAtTheExtremes)
+{
+   const unsigned char in[] = {
+      255, 255, 0, 255, 0, 0, 255, 0, // Saturated, then dark
+      255, 0, 255, 0, 0, 255, 0, 255,
+      128, 128, 128, 128, 128, 128, 128, 128,
+      16, 128, 235, 128, 16, 128, 235, 128,
+   };
+   unsigned char out[16 * 4];
+   ConvertYUYVToBGRA(in, 16, 1, 0, out);
+   for (unsigned x = 0; x < 16; ++x)
+   {
+      unsigned char expected[4];
+      ReferenceYUYVToBGRA(in[2 * x], in[4 * (x / 2) + 1], in[4 * (x / 2) + 3],
+         expected);
+      for (int c = 0; c < 4; ++c)
+         ASSERT_EQ(expected[c], out[4 * x + c]) << "pixel " << x;
+   }
+   EXPECT_EQ(0, out[4 * 12 + 1]); // Black (Y = 16)
+   EXPECT_EQ(255, out[4 * 13 + 1]); // White (Y = 235)
+}
+
+TEST(V4L2ConvertTests, YUYVToGray8TakesTheLuma)
+{
+   const unsigned width = 35;
+   const unsigned height = 2;
+   const unsigned lineBytes = 80;
+   const std::vector<unsigned char> in = RandomBytes(lineBytes * height);
+   std::vector<unsigned char> out(width * height);
+   ConvertYUYVToGray8(in.data(), width, height, lineBytes, out.data());
+   for (unsigned y = 0; y < height; ++y)
+      for (unsigned x = 0; x < width; ++x)
+         ASSERT_EQ(in[y * lineBytes + 2 * x], out[y * width + x]);
+}
+
+TEST(V4L2ConvertTests, PackedRowsDropThePadding)
+{
+   const std::vector<unsigned char> in = RandomBytes(3 * 10);
+   std::vector<unsigned char> out(3 * 8);
+   CopyPackedRows(in.data(), 8, 3, 10, out.data());
+   for (unsigned y = 0; y < 3; ++y)
+      for (unsigned x = 0; x < 8; ++x)
+         ASSERT_EQ(in[y * 10 + x], out[y * 8 + x]);
+
+   std::vector<unsigned char> packed(3 * 10);
+   CopyPackedRows(in.data(), 10, 3, 0, packed.data());
+   EXPECT_EQ(in, packed);
+}
+
+#ifdef HAVE_LIBJPEG
+TEST(V4L2ConvertTests, MJPEGIsDecodedToBGRA)
+{
+   ASSERT_TRUE(IsMJPEGDecodingSupported());
+   const std::vector<unsigned char> jpeg = EncodeJpeg(24, 16, 200, 100, 50);
+   std::vector<unsigned char> out(24 * 16 * 4);
+   std::string error;
+   ASSERT_TRUE(DecodeMJPEGToBGRA(jpeg.data(), jpeg.size(), 24, 16, out.data(),
+      error)) << error;
+   for (unsigned i = 0; i < 24 * 16; ++i)
+   {
+      ASSERT_NEAR(50, out[4 * i + 0], 3);
+      ASSERT_NEAR(100, out[4 * i + 1], 3);
+      ASSERT_NEAR(200, out[4 * i + 2], 3);
+      ASSERT_EQ(255, out[4 * i + 3]);
+   }
+
+   EXPECT_FALSE(DecodeMJPEGToBGRA(jpeg.data(), jpeg.size(), 32, 16, out.data(),
+      error));
+}
+
+TEST(V4L2ConvertTests, CorruptMJPEGIsAnError)
+{
+   const std::vector<unsigned char> garbage = RandomBytes(100);
+   std::vector<unsigned char> out(8 * 8 * 4);
+   std::string error;
+   EXPECT_FALSE(DecodeMJPEGToBGRA(garbage.data(), garbage.size(), 8, 8,
+      out.data(), error));
+   EXPECT_FALSE(error.empty());
+}
+#else
+TEST(V4L2ConvertTests, MJPEGNeedsLibjpeg)
+{
+   EXPECT_FALSE(IsMJPEGDecodingSupported());
+   unsigned char out[4];
+   std::string error;
+   EXPECT_FALSE(DecodeMJPEGToBGRA(out, 0, 1, 1, out, error));
+}
+#endif
+
+
+int main(int argc, char **argv)
+{
+   ::testing::InitGoogleTest(&argc, argv);
+   return RUN_ALL_TESTS();
+}
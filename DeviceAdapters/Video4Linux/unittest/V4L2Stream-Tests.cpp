@@ -0,0 +1,392 @@
+// DESCRIPTION:   Unit tests for video4linux2 streaming, against a fake device
+//
+// LICENSE:       This file is distributed under the "LGPL" license.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include <gtest/gtest.h>
+
+#include "V4L2Stream.h"
+
+#include <linux/videodev2.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+const int fd = 7;
+const unsigned pageSize = 1 << 16;
+
+// A capture device with YUYV and GREY formats, whose frames are produced by
+// Capture(). Rows are padded by 8 bytes.
+class FakeV4L2Device : public V4L2Io
+{
+public:
+   explicit FakeV4L2Device(unsigned maxBuffers = 4) :
+      maxBuffers_(maxBuffers),
+      open_(false),
+      streaming_(false),
+      unmapped_(0)
+   {
+      std::memset(&format_, 0, sizeof(format_));
+   }
+
+   int Open(const char* path) override
+   {
+      if (std::string(path) != "/dev/video0")
+      {
+         errno = ENOENT;
+         return -1;
+      }
+      open_ = true;
+      return fd;
+   }
+
+   int Close(int f) override
+   {
+      EXPECT_EQ(fd, f);
+      open_ = false;
+      return 0;
+   }
+
+   int Ioctl(int f, unsigned long request, void* arg) override
+   {
+      EXPECT_EQ(fd, f);
+      switch (request)
+      {
+         case VIDIOC_QUERYCAP:
+         {
+            v4l2_capability* cap = static_cast<v4l2_capability*>(arg);
+            cap->capabilities = V4L2_CAP_VIDEO_CAPTURE | V4L2_CAP_STREAMING;
+            return 0;
+         }
+         case VIDIOC_ENUM_FMT:
+         {
+            v4l2_fmtdesc* desc = static_cast<v4l2_fmtdesc*>(arg);
+            const std::uint32_t formats[] = { V4L2_PIX_FMT_YUYV, V4L2_PIX_FMT_GREY };
+            if (desc->index >= 2)
+               return Fail(EINVAL);
+            desc->pixelformat = formats[desc->index];
+            return 0;
+         }
+         case VIDIOC_S_FMT:
+         {
+            if (!buffers_.empty())
+               return Fail(EBUSY);
+            v4l2_pix_format& pix = static_cast<v4l2_format*>(arg)->fmt.pix;
+            if (pix.pixelformat != V4L2_PIX_FMT_GREY)
+               pix.pixelformat = V4L2_PIX_FMT_YUYV;
+            pix.width = std::min(pix.width, 64u);
+            pix.height = std::min(pix.height, 48u);
+            const unsigned bpp = pix.pixelformat == V4L2_PIX_FMT_YUYV ? 2 : 1;
+            pix.bytesperline = pix.width * bpp + 8;
+            pix.sizeimage = pix.bytesperline * pix.height;
+            format_ = pix;
+            return 0;
+         }
+         case VIDIOC_REQBUFS:
+         {
+            v4l2_requestbuffers* req = static_cast<v4l2_requestbuffers*>(arg);
+            if (streaming_)
+               return Fail(EBUSY);
+            req->count = std::min(req->count, maxBuffers_);
+            buffers_.assign(req->count, std::vector<unsigned char>(format_.sizeimage));
+            queued_.clear();
+            done_.clear();
+            return 0;
+         }
+         case VIDIOC_QUERYBUF:
+         {
+            v4l2_buffer* buf = static_cast<v4l2_buffer*>(arg);
+            if (buf->index >= buffers_.size())
+               return Fail(EINVAL);
+            buf->length = format_.sizeimage;
+            buf->m.offset = buf->index * pageSize;
+            return 0;
+         }
+         case VIDIOC_QBUF:
+         {
+            const v4l2_buffer* buf = static_cast<v4l2_buffer*>(arg);
+            if (buf->index >= buffers_.size() || IsQueued(buf->index))
+               return Fail(EINVAL);
+            queued_.push_back(buf->index);
+            return 0;
+         }
+         case VIDIOC_DQBUF:
+         {
+            if (done_.empty())
+               return Fail(EAGAIN);
+            *static_cast<v4l2_buffer*>(arg) = done_.front();
+            done_.pop_front();
+            return 0;
+         }
+         case VIDIOC_STREAMON:
+            streaming_ = true;
+            return 0;
+         case VIDIOC_STREAMOFF:
+            streaming_ = false;
+            queued_.clear();
+            done_.clear();
+            return 0;
+      }
+      return Fail(ENOTTY);
+   }
+
+   int Poll(int f, int) override
+   {
+      EXPECT_EQ(fd, f);
+      return done_.empty() ? 0 : 1;
+   }
+
+   void* Mmap(std::size_t length, int f, long offset) override
+   {
+      EXPECT_EQ(fd, f);
+      const std::size_t index = static_cast<std::size_t>(offset) / pageSize;
+      if (index >= buffers_.size() || length != buffers_[index].size())
+      {
+         errno = EINVAL;
+         return MAP_FAILED;
+      }
+      return buffers_[index].data();
+   }
+
+   int Munmap(void*, std::size_t) override
+   {
+      ++unmapped_;
+      return 0;
+   }
+
+   // Fills the next queued buffer with the value; false if none is queued
+   bool Capture(std::uint32_t sequence, unsigned char value, bool corrupted = false)
+   {
+      if (!streaming_ || queued_.empty())
+         return false;
+      const unsigned index = queued_.front();
+      queued_.pop_front();
+      std::fill(buffers_[index].begin(), buffers_[index].end(), value);
+
+      v4l2_buffer buf;
+      std::memset(&buf, 0, sizeof(buf));
+      buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+      buf.memory = V4L2_MEMORY_MMAP;
+      buf.index = index;
+      buf.bytesused = format_.sizeimage;
+      buf.sequence = sequence;
+      buf.flags = corrupted ? V4L2_BUF_FLAG_ERROR : 0;
+      done_.push_back(buf);
+      return true;
+   }
+
+   std::size_t GetQueuedCount() const { return queued_.size(); }
+   std::size_t GetBufferCount() const { return buffers_.size(); }
+   bool IsOpen() const { return open_; }
+   bool IsStreaming() const { return streaming_; }
+   unsigned GetUnmappedCount() const { return unmapped_; }
+
+private:
+   int Fail(int err)
+   {
+      errno = err;
+      return -1;
+   }
+
+   bool IsQueued(unsigned index) const
+   {
+      if (std::find(queued_.begin(), queued_.end(), index) != queued_.end())
+         return true;
+      for (const v4l2_buffer& buf : done_)
+         if (buf.index == index)
+            return true;
+      return false;
+   }
+
+   unsigned maxBuffers_;
+   bool open_;
+   bool streaming_;
+   unsigned unmapped_;
+   v4l2_pix_format format_;
+   std::vector<std::vector<unsigned char>> buffers_;
+   std::deque<unsigned> queued_;
+   std::deque<v4l2_buffer> done_;
+};
+
+class V4L2StreamTest : public ::testing::Test
+{
+protected:
+   V4L2StreamTest() : stream(device) {}
+
+   void SetUp() override
+   {
+      ASSERT_TRUE(stream.Open("/dev/video0", error)) << error;
+      ASSERT_TRUE(stream.SetFormat(V4L2_PIX_FMT_YUYV, 32, 16, error)) << error;
+      ASSERT_TRUE(stream.Start(8, error)) << error;
+   }
+
+   FakeV4L2Device device;
+   V4L2Stream stream;
+   std::string error;
+};
+
+} // namespace
+
+
+TEST(V4L2StreamOpenTests, ReportsMissingDevice)
+{
+   FakeV4L2Device device;
+   V4L2Stream stream(device);
+   std::string error;
+   EXPECT_FALSE(stream.Open("/dev/video9", error));
+   EXPECT_NE(std::string::npos, error.find("/dev/video9"));
+   EXPECT_FALSE(stream.IsOpen());
+}
+
+TEST(V4L2StreamOpenTests, NegotiatesFormat)
+{
+   FakeV4L2Device device;
+   V4L2Stream stream(device);
+   std::string error;
+   ASSERT_TRUE(stream.Open("/dev/video0", error));
+
+   std::vector<std::uint32_t> formats = stream.GetPixelFormats();
+   ASSERT_EQ(2u, formats.size());
+   EXPECT_EQ("YUYV", FourccToString(formats[0]));
+   EXPECT_EQ("GREY", FourccToString(formats[1]));
+
+   ASSERT_TRUE(stream.SetFormat(V4L2_PIX_FMT_GREY, 640, 40, error));
+   EXPECT_EQ(64u, stream.GetFormat().width);
+   EXPECT_EQ(40u, stream.GetFormat().height);
+   EXPECT_EQ(72u, stream.GetFormat().bytesPerLine);
+
+   EXPECT_FALSE(stream.SetFormat(V4L2_PIX_FMT_MJPEG, 64, 48, error));
+   EXPECT_NE(std::string::npos, error.find("MJPG"));
+
+   stream.Close();
+   EXPECT_FALSE(device.IsOpen());
+}
+
+TEST_F(V4L2StreamTest, AllBuffersAreQueuedWhileStreaming)
+{
+   EXPECT_TRUE(stream.IsStreaming());
+   EXPECT_EQ(4u, stream.GetBufferCount());
+   EXPECT_EQ(4u, device.GetQueuedCount());
+   EXPECT_TRUE(device.IsStreaming());
+}
+
+TEST_F(V4L2StreamTest, FramesAreReadFromTheMappedBuffer)
+{
+   V4L2Frame frame;
+   EXPECT_EQ(0, stream.Dequeue(10, frame, error));
+
+   ASSERT_TRUE(device.Capture(0, 42));
+   ASSERT_EQ(1, stream.Dequeue(10, frame, error)) << error;
+   EXPECT_EQ(42, frame.data[0]);
+   EXPECT_EQ(42, frame.data[frame.bytesUsed - 1]);
+   EXPECT_EQ((32u * 2 + 8) * 16, frame.bytesUsed);
+   EXPECT_EQ(3u, device.GetQueuedCount());
+
+   ASSERT_TRUE(stream.Requeue(frame, error)) << error;
+   EXPECT_EQ(4u, device.GetQueuedCount());
+   EXPECT_EQ(1u, stream.GetFrameCount());
+}
+
+TEST_F(V4L2StreamTest, BuffersAreReusedInTurn)
+{
+   for (std::uint32_t i = 0; i < 10; ++i)
+   {
+      ASSERT_TRUE(device.Capture(i, static_cast<unsigned char>(i)));
+      V4L2Frame frame;
+      ASSERT_EQ(1, stream.Dequeue(10, frame, error)) << error;
+      EXPECT_EQ(i, frame.sequence);
+      EXPECT_EQ(i % 4, frame.index);
+      EXPECT_EQ(i, frame.data[0]);
+      ASSERT_TRUE(stream.Requeue(frame, error)) << error;
+   }
+   EXPECT_EQ(10u, stream.GetFrameCount());
+   EXPECT_EQ(0u, stream.GetDroppedFrameCount());
+}
+
+TEST_F(V4L2StreamTest, DroppedFramesAreCounted)
+{
+   std::vector<std::uint32_t> delivered;
+   auto dequeueAll = [&]()
+   {
+      V4L2Frame frame;
+      int ret;
+      while ((ret = stream.Dequeue(10, frame, error)) == 1)
+      {
+         delivered.push_back(frame.sequence);
+         ASSERT_TRUE(stream.Requeue(frame, error)) << error;
+      }
+      EXPECT_EQ(0, ret);
+   };
+
+   // The driver skipped 2 and 3, and 5 is corrupted
+   const std::uint32_t sequences[] = { 0, 1, 4, 5 };
+   for (std::uint32_t sequence : sequences)
+      ASSERT_TRUE(device.Capture(sequence, 1, sequence == 5));
+   dequeueAll();
+   ASSERT_TRUE(device.Capture(6, 1));
+   dequeueAll();
+
+   EXPECT_EQ(std::vector<std::uint32_t>({ 0, 1, 4, 6 }), delivered);
+   EXPECT_EQ(4u, stream.GetFrameCount());
+   EXPECT_EQ(3u, stream.GetDroppedFrameCount());
+   EXPECT_EQ(4u, device.GetQueuedCount());
+
+   stream.ResetCounters();
+   ASSERT_TRUE(device.Capture(100, 1));
+   V4L2Frame frame;
+   ASSERT_EQ(1, stream.Dequeue(10, frame, error));
+   EXPECT_EQ(0u, stream.GetDroppedFrameCount());
+}
+
+TEST_F(V4L2StreamTest, DiscardRequeuesWaitingFrames)
+{
+   ASSERT_TRUE(device.Capture(0, 1));
+   ASSERT_TRUE(device.Capture(1, 2));
+   EXPECT_EQ(2u, device.GetQueuedCount());
+
+   ASSERT_TRUE(stream.Discard(error)) << error;
+   EXPECT_EQ(4u, device.GetQueuedCount());
+   EXPECT_EQ(0u, stream.GetFrameCount());
+
+   ASSERT_TRUE(device.Capture(2, 3));
+   V4L2Frame frame;
+   ASSERT_EQ(1, stream.Dequeue(10, frame, error));
+   EXPECT_EQ(3, frame.data[0]);
+   EXPECT_EQ(0u, stream.GetDroppedFrameCount());
+}
+
+TEST_F(V4L2StreamTest, StopReleasesTheBuffers)
+{
+   stream.Stop();
+   EXPECT_FALSE(stream.IsStreaming());
+   EXPECT_FALSE(device.IsStreaming());
+   EXPECT_EQ(4u, device.GetUnmappedCount());
+   EXPECT_EQ(0u, device.GetBufferCount());
+
+   // The format can be changed once stopped
+   ASSERT_TRUE(stream.SetFormat(V4L2_PIX_FMT_GREY, 16, 16, error)) << error;
+   ASSERT_TRUE(stream.Start(2, error)) << error;
+   EXPECT_EQ(2u, device.GetQueuedCount());
+}
+
+
+int main(int argc, char **argv)
+{
+   ::testing::InitGoogleTest(&argc, argv);
+   return RUN_ALL_TESTS();
+}
@@ -39,6 +39,13 @@ strace -f java -Djava.library.path=/usr/lib/micro-manager -classpath /usr/share/
 *              - USB ID 1871:7670 Aveo Technology Corp. (uvcvideo) - COLEMETER(R) USB 2.0 Digital Microscope
 *              - USB ID 046d:0826 Logitech, Inc. HD Webcam C525
 *
+* 2026-10-18
+*
+*            - Real sequence acquisition: all memory-mapped buffers stay queued, frames are
+*              waited for with poll and converted straight from the driver's buffer, which is
+*              requeued right away (see V4L2Stream.h).
+*            - Added GREY, Y16 and MJPEG (with libjpeg) pixel types; dropped frame counters.
+*
 */
 // LICENSE:       This file is distributed under the "LGPL" license.
 //
@@ -58,22 +65,22 @@ strace -f java -Djava.library.path=/usr/lib/micro-manager -classpath /usr/share/
 #include "DeviceBase.h"
 #include "ModuleInterface.h"
 #include "ImgBuffer.h"
+#include "V4L2Convert.h"
+#include "V4L2Stream.h"
 #include <sstream>
 #include <map>
 #include <vector>
 
-#include <sys/ioctl.h>
 #include <linux/videodev2.h>
 #include <cstdio>
-#include <fcntl.h>
-#include <unistd.h>
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
+#include <climits>
 #include <cstdlib>
 #include <cstring>
 #include <cerrno>
-#include <sys/mman.h>
-
-#include <pthread.h>
+#include <thread>
 
 using namespace std;
 
@@ -83,43 +90,42 @@ const char
   *gPropertyDevicePath = "DevicePath",
   *gPropertyDevicePathDefault = "/dev/video0",
   *gPropertyNameResolution = "Resolution",
-  *gResolutionDefault = "640x480";
+  *gResolutionDefault = "640x480",
+  *gPropertyDroppedFrames = "DroppedFrames",
+  *gTagSequence = "V4L2Sequence";
 
 const long gWidthDefault = 640,
            gHeightDefault = 480;
 
-struct VidBuffer {
-  void *start;
-  size_t length;
-};
-
-// v4l2 state
-typedef struct State State;
-struct State {
-  int W, H, fd;
-  struct VidBuffer *buffers;
-  unsigned int buffers_count;
-  struct v4l2_buffer *buf;
-};
+// Buffers kept queued in the driver while streaming
+const unsigned gBufferCount = 8;
+// Frames are waited for in slices, so that a sequence can be stopped
+const int gPollSliceMs = 100;
+const int gFrameTimeoutMs = 10000;
 
 class PixelType {
   public:
-    PixelType(string propertyValue, unsigned bytesPerPixel, unsigned numberOfComponents, unsigned bitDepth) :
+    PixelType(string propertyValue, uint32_t v4l2PixelFormat, unsigned bytesPerPixel,
+        unsigned numberOfComponents, unsigned bitDepth) :
       m_propertyValue(propertyValue),
+      m_v4l2PixelFormat(v4l2PixelFormat),
       m_bytesPerPixel(bytesPerPixel),
       m_numberOfComponents(numberOfComponents),
       m_bitDepth(bitDepth) {
       }
 
     string GetPropertyValue() const { return m_propertyValue; }
+    uint32_t GetV4l2PixelFormat() const { return m_v4l2PixelFormat; }
     unsigned GetImageBytesPerPixel() const { return m_bytesPerPixel; }
     unsigned GetNumberOfComponents() const { return m_numberOfComponents; }
     unsigned GetBitDepth() const { return m_bitDepth; }
 
-    virtual void convertV4l2ToOutput(
-        State *state, unsigned char* in, unsigned char* output) const = 0;
+    // Converts a frame of the negotiated format into the image buffer
+    virtual bool convertV4l2ToOutput(const V4L2Frame& frame,
+        const V4L2FrameFormat& format, unsigned char* output, string& error) const = 0;
   private:
     string m_propertyValue;
+    uint32_t m_v4l2PixelFormat;
     unsigned m_bytesPerPixel;
     unsigned m_numberOfComponents;
     unsigned m_bitDepth;
@@ -130,18 +136,14 @@ class PixelType8Bit : public PixelType {
     static string PROPERTY_VALUE;
 
     PixelType8Bit() :
-      PixelType(PROPERTY_VALUE, 1, 1, 8) {
+      PixelType(PROPERTY_VALUE, V4L2_PIX_FMT_YUYV, 1, 1, 8) {
       }
 
-    virtual void convertV4l2ToOutput(
-        State *state, unsigned char* in, unsigned char* output) const {
-      int i,j;
-      for (j = 0; j < state->H; j++) {
-        int wj = state->W * j;
-        for (i = 0; i < state->W; i++) {
-          output[i + wj] = in[2*i + 2*wj];
-        }
-      }
+    virtual bool convertV4l2ToOutput(const V4L2Frame& frame,
+        const V4L2FrameFormat& format, unsigned char* output, string&) const {
+      ConvertYUYVToGray8(frame.data, format.width, format.height,
+          format.bytesPerLine, output);
+      return true;
     }
 };
 string PixelType8Bit::PROPERTY_VALUE = "8bit";
@@ -152,50 +154,60 @@ class PixelTypeYUYV : public PixelType {
     static string PROPERTY_VALUE;
 
     PixelTypeYUYV() :
-      PixelType(PROPERTY_VALUE, 4, 4, 8) {
+      PixelType(PROPERTY_VALUE, V4L2_PIX_FMT_YUYV, 4, 4, 8) {
       }
 
-    virtual void convertV4l2ToOutput(
-        State *state, unsigned char* ptrIn, unsigned char* ptrOut) const {
-      /* Convert YUYV to RGBA32, apparently mm does only display colors
-       * in this format */
-      for (int i = 0;  i < state->W * state->H / 2; ++i) {
-        int y0 = ptrIn[0];
-        int u0 = ptrIn[1];
-        int y1 = ptrIn[2];
-        int v0 = ptrIn[3];
-        ptrIn += 4;
-        int c = y0 - 16;
-        int d = u0 - 128;
-        int e = v0 - 128;
-
-        ptrOut[0] = clip((298 * c + 516 * d + 128) >> 8); // blue
-        ptrOut[1] = clip((298 * c - 100 * d - 208 * e + 128) >> 8); // green
-        ptrOut[2] = clip((298 * c + 409 * e + 128) >> 8); // red
-        ptrOut[4] = 255; // alpha
-        c = y1 - 16;
-        ptrOut[4] = clip((298 * c + 516 * d + 128) >> 8); // blue
-        ptrOut[5] = clip((298 * c - 100 * d - 208 * e + 128) >> 8); // green
-        ptrOut[6] = clip((298 * c + 409 * e + 128) >> 8); // red
-        ptrOut[7] = 255; // alpha
-        ptrOut += 8;
+    /* Convert YUYV to RGBA32, apparently mm does only display colors
+     * in this format */
+    virtual bool convertV4l2ToOutput(const V4L2Frame& frame,
+        const V4L2FrameFormat& format, unsigned char* output, string&) const {
+      ConvertYUYVToBGRA(frame.data, format.width, format.height,
+          format.bytesPerLine, output);
+      return true;
+    }
+};
+string PixelTypeYUYV::PROPERTY_VALUE = "YUYV";
+PixelTypeYUYV PIXELTYPE_YUYV;
+
+// Monochrome formats that are stored as they come
+class PixelTypeGray : public PixelType {
+  public:
+    PixelTypeGray(string propertyValue, uint32_t v4l2PixelFormat, unsigned bytesPerPixel) :
+      PixelType(propertyValue, v4l2PixelFormat, bytesPerPixel, 1, 8 * bytesPerPixel) {
       }
+
+    virtual bool convertV4l2ToOutput(const V4L2Frame& frame,
+        const V4L2FrameFormat& format, unsigned char* output, string&) const {
+      CopyPackedRows(frame.data, format.width * GetImageBytesPerPixel(),
+          format.height, format.bytesPerLine, output);
+      return true;
     }
+};
+PixelTypeGray PIXELTYPE_GREY("GREY", V4L2_PIX_FMT_GREY, 1);
+PixelTypeGray PIXELTYPE_Y16("Y16", V4L2_PIX_FMT_Y16, 2);
 
-  private:
-    inline unsigned char clip(int val) const {
-      if (val <= 0)
-        return 0;
-      else if (val >= 255)
-        return 255;
-      else
-        return val;
+class PixelTypeMJPEG : public PixelType {
+  public:
+    static string PROPERTY_VALUE;
+
+    PixelTypeMJPEG() :
+      PixelType(PROPERTY_VALUE, V4L2_PIX_FMT_MJPEG, 4, 4, 8) {
+      }
+
+    virtual bool convertV4l2ToOutput(const V4L2Frame& frame,
+        const V4L2FrameFormat& format, unsigned char* output, string& error) const {
+      return DecodeMJPEGToBGRA(frame.data, frame.bytesUsed, format.width,
+          format.height, output, error);
     }
 };
-string PixelTypeYUYV::PROPERTY_VALUE = "YUYV";
-PixelTypeYUYV PIXELTYPE_YUYV;
+string PixelTypeMJPEG::PROPERTY_VALUE = "MJPEG";
+PixelTypeMJPEG PIXELTYPE_MJPEG;
+
+const PixelType* const gPixelTypes[] = {
+  &PIXELTYPE_8BIT, &PIXELTYPE_YUYV, &PIXELTYPE_GREY, &PIXELTYPE_Y16, &PIXELTYPE_MJPEG
+};
 
-class V4L2 : public CLegacyCameraBase<V4L2>
+class V4L2 : public CCameraBase<V4L2>
 {
 public:
 
@@ -204,7 +216,10 @@ public:
   // little as possible, don't access hardware, do everything else in
   // Initialize()
   V4L2() :
-    pixelType(&PIXELTYPE_8BIT)
+    stream(io),
+    pixelType(&PIXELTYPE_8BIT),
+    capturing_(false),
+    stopRequested_(false)
   {
     initialized_ = 0;
   }
@@ -254,9 +269,7 @@ public:
     if (nRet != DEVICE_OK)
        return nRet;
 
-    vector<string> pixTypes;
-    pixTypes.push_back(PixelType8Bit::PROPERTY_VALUE);
-    pixTypes.push_back(PixelTypeYUYV::PROPERTY_VALUE);
+    vector<string> pixTypes = getPixelTypeNames(vector<uint32_t>());
     nRet = SetAllowedValues(MM::g_Keyword_PixelType, pixTypes);
     if (nRet != DEVICE_OK)
        return nRet;
@@ -271,6 +284,12 @@ public:
     pAct = new CPropertyAction(this, &V4L2::OnExposure);
     nRet = CreateProperty(MM::g_Keyword_Exposure, "0.0", MM::Float, false, pAct);
     assert(nRet == DEVICE_OK);
+
+    // Frames skipped by the driver or delivered corrupted, since the start of
+    // the last sequence acquisition
+    pAct = new CPropertyAction(this, &V4L2::OnDroppedFrames);
+    nRet = CreateProperty(gPropertyDroppedFrames, "0", MM::Integer, true, pAct);
+    assert(nRet == DEVICE_OK);
     
     LogMessage("calling video init");
     if (VideoInit()) {
@@ -287,6 +306,7 @@ public:
   // afterwards, unload device, release all resources
   int Shutdown()
   {
+    StopSequenceAcquisition();
     if (initialized_) {
       VideoClose();
     }
@@ -299,13 +319,25 @@ public:
     CDeviceUtils::CopyLimitedString(name,gName);
   }
 
+  bool Busy() { return false; }
+
   // blocks until exposure is finished
   int SnapImage()
   {
-    unsigned char* data = VideoTakeBuffer();
-    pixelType->convertV4l2ToOutput(state, data, const_cast<unsigned char*>(imageBuffer.GetPixels()));
-    VideoReturnBuffer();
-    return DEVICE_OK;
+    if (IsCapturing())
+      return DEVICE_CAMERA_BUSY_ACQUIRING;
+
+    // The stream runs all the time; take a frame that starts after this call
+    string error;
+    if (!stream.Discard(error)) {
+      LogMessage("error: " + error);
+      return DEVICE_SNAP_IMAGE_FAILED;
+    }
+    V4L2Frame frame;
+    int ret = VideoTakeFrame(gFrameTimeoutMs, frame);
+    if (ret != DEVICE_OK)
+      return ret;
+    return VideoConvertAndReturnFrame(frame, imageBuffer);
   }
 
   // waits for camera readout
@@ -366,7 +398,7 @@ public:
   {
     // FIXME
     // get_roi(&x,&y,&xSize,&ySize);
-    x=0; y=0; xSize=state->W; ySize=state->H;
+    x=0; y=0; xSize=imageBuffer.Width(); ySize=imageBuffer.Height();
     return DEVICE_OK;
   }
 
@@ -376,6 +408,52 @@ public:
     //clear_roi();
     return DEVICE_OK;
   }
+
+  int StartSequenceAcquisition(double /*unused*/)
+  {
+    return StartSequenceAcquisition(LONG_MAX, 0.0, false);
+  }
+
+  // Images are inserted as they are converted; if the Core cannot take one,
+  // the sequence stops, whatever stopOnOverflow
+  int StartSequenceAcquisition(long numImages, double /*unused*/, bool /*stopOnOverflow*/)
+  {
+    if (IsCapturing())
+      return DEVICE_CAMERA_BUSY_ACQUIRING;
+    if (!initialized_ || !stream.IsStreaming())
+      return DEVICE_NOT_CONNECTED;
+    if (sequenceThread_.joinable())
+      sequenceThread_.join();
+
+    int ret = GetCoreCallback()->PrepareForAcq(this);
+    if (ret != DEVICE_OK)
+      return ret;
+
+    string error;
+    if (!stream.Discard(error)) {
+      LogMessage("error: " + error);
+      return DEVICE_ERR;
+    }
+    stream.ResetCounters();
+    sequenceBuffer.Resize(imageBuffer.Width(), imageBuffer.Height(),
+        imageBuffer.Depth());
+
+    stopRequested_ = false;
+    capturing_ = true;
+    sequenceThread_ = std::thread([this, numImages]() { RunSequence(numImages); });
+    return DEVICE_OK;
+  }
+
+  int StopSequenceAcquisition()
+  {
+    stopRequested_ = true;
+    if (sequenceThread_.joinable())
+      sequenceThread_.join();
+    return DEVICE_OK;
+  }
+
+  // Remains true until the sequence thread has called AcqFinished()
+  bool IsCapturing() { return capturing_; }
   
   // action interface
   int OnExposure(MM::PropertyBase* pProp, MM::ActionType eAct)
@@ -445,17 +523,17 @@ public:
 
       string pixType;
       pProp->Get(pixType);
-      if (pixType == PixelType8Bit::PROPERTY_VALUE) {
-        pixelType = &PIXELTYPE_8BIT;
-      }
-      else if (pixType == PixelTypeYUYV::PROPERTY_VALUE) {
-        pixelType = &PIXELTYPE_YUYV;
-      }
-      else {
+      const PixelType* newPixelType = findPixelType(pixType);
+      if (!newPixelType) {
         return DEVICE_INVALID_PROPERTY;
       }
   
+      const bool formatChanged =
+        newPixelType->GetV4l2PixelFormat() != pixelType->GetV4l2PixelFormat();
+      pixelType = newPixelType;
       LogMessage("setting pixelType " + pixelType->GetPropertyValue());
+      if (formatChanged)
+        return reinitializeDeviceIfRunning();
       return this->resizeBuffer();
     }
     else if (eAct == MM::BeforeGet)
@@ -474,6 +552,14 @@ public:
     return DEVICE_OK;
   }
 
+  int OnDroppedFrames(MM::PropertyBase* pProp, MM::ActionType eAct)
+  {
+    if (eAct == MM::BeforeGet) {
+      pProp->Set(static_cast<long>(stream.GetDroppedFrameCount()));
+    }
+    return DEVICE_OK;
+  }
+
   /**
    * TODO: implement if possible
    */
@@ -514,78 +600,21 @@ private:
     if (ret != DEVICE_OK)
       return false;
 
-    struct v4l2_requestbuffers reqbuf;
-    memset(&reqbuf, 0, sizeof(reqbuf));
-    reqbuf.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    reqbuf.memory = V4L2_MEMORY_MMAP;
-    reqbuf.count = 4;
-
-    if (-1 == tryIoctl(state->fd, VIDIOC_REQBUFS, &reqbuf)) {
-      ostringstream msg;
-      if (EINVAL == errno) {
-        msg << "error: the device does not support memory mapping";
-      }
-      else {
-        msg << "error: could not request memory map buffers: "
-            << strerror(errno) << " (errno " << errno << ")";
-      }
-      LogMessage(msg.str().c_str());
+    string error;
+    if (!stream.Start(gBufferCount, error)) {
+      LogMessage("error: " + error);
       return false;
     }
 
     ostringstream bufMsg;
-    bufMsg << "got " << reqbuf.count << " out of 4 requested buffers";
+    bufMsg << "got " << stream.GetBufferCount() << " out of " << gBufferCount
+           << " requested buffers";
     LogMessage(bufMsg.str().c_str());
 
-    state->buffers = (struct VidBuffer*)calloc(reqbuf.count, sizeof(*(state->buffers)));
-    if (!state->buffers) {
-      LogMessage("could not allocate buffer(s)");
-      return false;
-    }
-
-    state->buf = (struct v4l2_buffer*) malloc(sizeof(struct v4l2_buffer));
-
-    unsigned int i;
-    for (i = 0; i < reqbuf.count; i++) {
-      struct v4l2_buffer buf;
-      memset(&buf, 0 , sizeof(buf));
-
-      buf.type = reqbuf.type;
-      buf.memory = V4L2_MEMORY_MMAP;
-      buf.index = i;
-      if (-1 == tryIoctl(state->fd, VIDIOC_QUERYBUF, &buf)) {
-        LogMessage("could not query the buffer state");
-        return false;
-      }
-
-      state->buffers[i].length = buf.length; // remember for munmap
-      state->buffers[i].start = mmap(NULL, buf.length,
-          PROT_READ | PROT_WRITE,
-          MAP_SHARED, state->fd, buf.m.offset);
-
-      if (state->buffers[i].start == MAP_FAILED) {
-        LogMessage("memory map failed");
-        return false;
-      }
-
-      if (-1 == tryIoctl(state->fd, VIDIOC_QBUF, &buf)) {
-        LogMessage("could not enqueue buffer");
-        return false;
-      }
-    }
-
-    state->buffers_count = reqbuf.count;
-
     ret = this->resizeBuffer();
     if (ret != DEVICE_OK)
       return false;
 
-    int type = V4L2_BUF_TYPE_VIDEO_CAPTURE; 
-    if (-1 == tryIoctl(state->fd, VIDIOC_STREAMON, &type)) {
-      LogMessage("could not initialize stream");
-      return false;
-    }
-
     LogMessage("initialized data stream");
     return true;
   }
@@ -593,73 +622,57 @@ private:
   int
   initDevice(const char* devicePath, long requestedWidth, long requestedHeight)
   {
-    struct v4l2_capability cap;
-    struct v4l2_format fmt;
-
-    state->fd = open(devicePath, O_RDWR);
-  
-    if (-1 == state->fd) {
-      LogMessage("could not open the video device");
-      return false;
+    string error;
+    if (!stream.Open(devicePath, error)) {
+      LogMessage("error: " + error);
+      return DEVICE_ERR;
     }
     LogMessage("opened device");
 
-    if (-1 == tryIoctl(state->fd, VIDIOC_QUERYCAP, &cap)) {
-      ostringstream msg;
-      if (EINVAL == errno) {
-        msg << "error: device is not a v4l2 device";
-      } else {
-        msg << "error: could not query v4l2 capabilities: " << strerror(errno);
+    const vector<uint32_t> formats = stream.GetPixelFormats();
+    ostringstream formatsMsg;
+    formatsMsg << "device offers formats:";
+    for (uint32_t format : formats)
+      formatsMsg << " " << FourccToString(format);
+    LogMessage(formatsMsg.str().c_str());
+    if (!formats.empty()) {
+      vector<string> names = getPixelTypeNames(formats);
+      SetAllowedValues(MM::g_Keyword_PixelType, names);
+      if (!names.empty() && find(formats.begin(), formats.end(),
+            pixelType->GetV4l2PixelFormat()) == formats.end()) {
+        LogMessage("pixel type " + pixelType->GetPropertyValue() +
+            " is not offered by the device, using " + names[0]);
+        pixelType = findPixelType(names[0]);
       }
-      LogMessage(msg.str().c_str());
-      return DEVICE_ERR;
-    }
-
-    if (!(cap.capabilities & V4L2_CAP_VIDEO_CAPTURE)) {
-      ostringstream msg;
-      msg << "error: device is not a v4l2 capture device";
-      LogMessage(msg.str().c_str());
-      return DEVICE_ERR;
     }
 
-    memset(&fmt, 0, sizeof(fmt));
-
-    fmt.type                = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    fmt.fmt.pix.pixelformat = V4L2_PIX_FMT_YUYV;
-    fmt.fmt.pix.field       = V4L2_FIELD_INTERLACED;
-    fmt.fmt.pix.height      = (unsigned) requestedWidth;
-    fmt.fmt.pix.width       = (unsigned) requestedHeight;
-
-    if (-1 == tryIoctl(state->fd, VIDIOC_S_FMT, &fmt)) {
-      ostringstream msg;
-      msg << "error: could not set format YUYV: " << strerror(errno);
-      LogMessage(msg.str().c_str());
+    if (!stream.SetFormat(pixelType->GetV4l2PixelFormat(),
+          (unsigned) requestedWidth, (unsigned) requestedHeight, error)) {
+      LogMessage("error: " + error);
       return DEVICE_ERR;
     }
 
-    if (fmt.fmt.pix.width != requestedWidth) {
+    const V4L2FrameFormat& fmt = stream.GetFormat();
+    if (fmt.width != requestedWidth) {
       ostringstream msg;
       msg << "warning: device did not match requested pixel width: "
-          << fmt.fmt.pix.width << " requested: " << requestedWidth;
+          << fmt.width << " requested: " << requestedWidth;
       LogMessage(msg.str().c_str());
       // not necessarily fatal
     }
 
-    if (fmt.fmt.pix.height != requestedHeight) {
+    if (fmt.height != requestedHeight) {
       ostringstream msg;
       msg << "warning: device did not match requested pixel height: "
-          << fmt.fmt.pix.height << " requested: " << requestedHeight;
+          << fmt.height << " requested: " << requestedHeight;
       LogMessage(msg.str().c_str());
       // not necessarily fatal
     }
 
-    state->W = fmt.fmt.pix.width;
-    state->H = fmt.fmt.pix.height;
-
     ostringstream formatMsg;
-    formatMsg << "device is configured for " << state->W << "x" << state->H << " pixel"
-              << " and " << fmt.fmt.pix.bytesperline << " bytes per line ("
-              << (fmt.fmt.pix.bytesperline / state->H) <<" bpp)";
+    formatMsg << "device is configured for " << FourccToString(fmt.pixelFormat)
+              << " " << fmt.width << "x" << fmt.height << " pixel"
+              << " and " << fmt.bytesPerLine << " bytes per line";
     LogMessage(formatMsg.str().c_str());
     return DEVICE_OK;
   }
@@ -667,57 +680,97 @@ private:
   bool
   VideoClose()
   {
-    int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    if (-1 == tryIoctl(state->fd, VIDIOC_STREAMOFF, &type)) {
-      ostringstream msg;
-      msg << "warning setting streamoff: " << strerror(errno);
-      LogMessage(msg.str().c_str());
-      // not fatal
-    }
-  
-    unsigned int i;
-    for (i = 0; i < state->buffers_count; i++)
-      munmap(state->buffers[i].start, state->buffers[i].length);
-    close(state->fd);
-    free(state->buf);
-  
-    state->fd = 0;
-    state->W = 0;
-    state->H = 0;
-    state->buffers_count = 0;
-    state->buffers = 0;
-  
+    stream.Close();
     return true;
   }
 
-  /*  has to be followed by a call to videoreturnbuffer */
-  unsigned char*
-  VideoTakeBuffer()
+  /*  has to be followed by a call to VideoConvertAndReturnFrame */
+  int
+  VideoTakeFrame(int timeoutMs, V4L2Frame& frame)
   {
-    memset(state->buf, 0, sizeof(struct v4l2_buffer));
-    state->buf->type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    state->buf->memory = V4L2_MEMORY_MMAP;
-    // By default VIDIOC_DQBUF blocks when no buffer is in the outgoing queue
-    if (-1 == tryIoctl(state->fd, VIDIOC_DQBUF, state->buf)) {
-      ostringstream msg;
-      msg << "error: could not prepare next image buffer: " << strerror(errno);
-      LogMessage(msg.str().c_str());
-      assert(false);
+    string error;
+    int ret = stream.Dequeue(timeoutMs, frame, error);
+    if (ret < 0) {
+      LogMessage("error: " + error);
+      return DEVICE_ERR;
     }
-
-    assert(state->buf->index < state->buffers_count);
-    return (unsigned char*)state->buffers[state->buf->index].start;
+    if (ret == 0) {
+      LogMessage("error: timed out waiting for a frame");
+      return DEVICE_SNAP_IMAGE_FAILED;
+    }
+    return DEVICE_OK;
   }
   
-  void
-  VideoReturnBuffer()
+  // Converts straight from the driver's buffer, which is then requeued
+  // before the image is used
+  int
+  VideoConvertAndReturnFrame(const V4L2Frame& frame, ImgBuffer& output)
   {
-    if (-1 == tryIoctl(state->fd, VIDIOC_QBUF, state->buf)) {
-      ostringstream msg;
-      msg << "error: could not get next image buffer: " << strerror(errno);
-      LogMessage(msg.str().c_str());
-      return;
+    string error;
+    const bool converted = pixelType->convertV4l2ToOutput(frame,
+        stream.GetFormat(), output.GetPixelsRW(), error);
+    if (!converted)
+      LogMessage("error: " + error);
+
+    string requeueError;
+    if (!stream.Requeue(frame, requeueError)) {
+      LogMessage("error: " + requeueError);
+      return DEVICE_ERR;
     }
+    return converted ? DEVICE_OK : DEVICE_ERR;
+  }
+
+  void
+  RunSequence(long numImages)
+  {
+    char label[MM::MaxStrLength];
+    GetLabel(label);
+
+    int ret = DEVICE_OK;
+    long count = 0;
+    int waitedMs = 0;
+    while (!stopRequested_ && count < numImages) {
+      string error;
+      V4L2Frame frame;
+      int ready = stream.Dequeue(gPollSliceMs, frame, error);
+      if (ready < 0) {
+        LogMessage("error: " + error);
+        ret = DEVICE_ERR;
+        break;
+      }
+      if (ready == 0) {
+        waitedMs += gPollSliceMs;
+        if (waitedMs >= gFrameTimeoutMs) {
+          LogMessage("error: timed out waiting for a frame");
+          ret = DEVICE_ERR;
+          break;
+        }
+        continue;
+      }
+      waitedMs = 0;
+
+      ret = VideoConvertAndReturnFrame(frame, sequenceBuffer);
+      if (ret != DEVICE_OK)
+        break;
+
+      MM::CameraImageMetadata md;
+      md.AddTag(MM::g_Keyword_Metadata_CameraLabel, label);
+      md.AddTag(gTagSequence, frame.sequence);
+      md.AddTag(gPropertyDroppedFrames, stream.GetDroppedFrameCount());
+      ret = GetCoreCallback()->InsertImage(this, sequenceBuffer.GetPixels(),
+          sequenceBuffer.Width(), sequenceBuffer.Height(), sequenceBuffer.Depth(),
+          pixelType->GetNumberOfComponents(), md.Serialize());
+      if (ret != DEVICE_OK)
+        break;
+      ++count;
+    }
+
+    ostringstream msg;
+    msg << "sequence acquisition finished after " << count << " images, "
+        << stream.GetDroppedFrameCount() << " dropped";
+    LogMessage(msg.str().c_str());
+    GetCoreCallback()->AcqFinished(this, ret);
+    capturing_ = false;
   }
 
   int reinitializeDeviceIfRunning() {
@@ -763,40 +816,44 @@ private:
   
   int resizeBuffer()
   {
-    imageBuffer.Resize(state->W, state->H, pixelType->GetImageBytesPerPixel());
+    const V4L2FrameFormat& fmt = stream.GetFormat();
+    imageBuffer.Resize(fmt.width, fmt.height, pixelType->GetImageBytesPerPixel());
     return DEVICE_OK;
   }
 
-  int tryIoctl(int fd, unsigned long ioctlCode, void *parameter) const
+  static const PixelType* findPixelType(const string& propertyValue)
   {
-      while (-1 == ioctl(fd, ioctlCode, parameter)) {
-          if (!(errno == EBUSY || errno == EAGAIN))
-              return -1;
-  
-          fd_set fds;
-          FD_ZERO(&fds);
-          FD_SET(fd, &fds);
-  
-          struct timeval tv;
-          tv.tv_sec = 10;
-          tv.tv_usec = 0;
-  
-          int result = select(fd + 1, &fds, NULL, NULL, &tv);
-          if (0 == result) {
-            LogMessage("tryIoctl select timeout");
-            return -1;
-          }
-          else if (-1 == result && EINTR != errno) {
-            return -1;
-          }
-      }
-      return 0;
+    for (const PixelType* type : gPixelTypes) {
+      if (type->GetPropertyValue() == propertyValue)
+        return type;
+    }
+    return 0;
+  }
+
+  // Pixel types of the formats offered by the device, or all if unknown
+  static vector<string> getPixelTypeNames(const vector<uint32_t>& formats)
+  {
+    vector<string> names;
+    for (const PixelType* type : gPixelTypes) {
+      if (type == &PIXELTYPE_MJPEG && !IsMJPEGDecodingSupported())
+        continue;
+      if (!formats.empty() && find(formats.begin(), formats.end(),
+            type->GetV4l2PixelFormat()) == formats.end())
+        continue;
+      names.push_back(type->GetPropertyValue());
+    }
+    return names;
   }
 
   bool initialized_;
-  State state[1];
+  SystemV4L2Io io;
+  V4L2Stream stream;
   ImgBuffer imageBuffer;
-  PixelType *pixelType;
+  ImgBuffer sequenceBuffer;
+  const PixelType *pixelType;
+  std::thread sequenceThread_;
+  std::atomic<bool> capturing_;
+  std::atomic<bool> stopRequested_;
 };
 
 MODULE_API void InitializeModuleData()
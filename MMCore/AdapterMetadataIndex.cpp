@@ -0,0 +1,291 @@
+// DESCRIPTION:   On-disk index of the devices provided by device adapter
+//                libraries, so that they can be listed without loading the
+//                libraries
+//
+// LICENSE:       This file is distributed under the "Lesser GPL" (LGPL) license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "AdapterMetadataIndex.h"
+
+#include "LoadableModules/LoadedDeviceAdapter.h"
+
+#include "MMDevice.h"
+#include "ModuleInterface.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+
+namespace mmcore {
+namespace internal {
+
+namespace {
+
+// The first line of the index file. Format of the remaining lines (fields
+// separated by tabs, with backslash, tab, CR, and LF escaped):
+//   A <library path> <size> <mtime> <module version> <device version> <count>
+//   D <name> <type> <description>        (count lines, following each A)
+const char* const g_IndexHeader = "MMCore device adapter index 1";
+
+std::string Escape(const std::string& s)
+{
+   std::string ret;
+   ret.reserve(s.size());
+   for (char ch : s)
+   {
+      switch (ch)
+      {
+         case '\\': ret += "\\\\"; break;
+         case '\t': ret += "\\t"; break;
+         case '\r': ret += "\\r"; break;
+         case '\n': ret += "\\n"; break;
+         default: ret += ch;
+      }
+   }
+   return ret;
+}
+
+bool Unescape(const std::string& s, std::string& ret)
+{
+   ret.clear();
+   for (std::size_t i = 0; i < s.size(); ++i)
+   {
+      if (s[i] != '\\')
+      {
+         ret += s[i];
+         continue;
+      }
+      if (++i == s.size())
+         return false;
+      switch (s[i])
+      {
+         case '\\': ret += '\\'; break;
+         case 't': ret += '\t'; break;
+         case 'r': ret += '\r'; break;
+         case 'n': ret += '\n'; break;
+         default: return false;
+      }
+   }
+   return true;
+}
+
+std::vector<std::string> SplitFields(const std::string& line)
+{
+   std::vector<std::string> fields;
+   std::size_t start = 0;
+   for (;;)
+   {
+      std::size_t tab = line.find('\t', start);
+      fields.push_back(line.substr(start, tab - start));
+      if (tab == std::string::npos)
+         return fields;
+      start = tab + 1;
+   }
+}
+
+bool ParseInteger(const std::string& s, long long& value)
+{
+   if (s.empty())
+      return false;
+   char* end = nullptr;
+   value = std::strtoll(s.c_str(), &end, 10);
+   return *end == '\0';
+}
+
+} // namespace
+
+
+AdapterMetadata
+AdapterMetadata::FromModule(const LoadedDeviceAdapter& module)
+{
+   AdapterMetadata metadata;
+   metadata.moduleInterfaceVersion = MODULE_INTERFACE_VERSION;
+   metadata.deviceInterfaceVersion = DEVICE_INTERFACE_VERSION;
+   for (const std::string& name : module.GetAvailableDeviceNames())
+   {
+      AdapterDeviceMetadata device;
+      device.name = name;
+      device.description = module.GetDeviceDescription(name);
+      device.type = module.GetAdvertisedDeviceType(name);
+      metadata.devices.push_back(device);
+   }
+   return metadata;
+}
+
+
+AdapterMetadataIndex::AdapterMetadataIndex(const std::string& indexFile) :
+   indexFile_(indexFile)
+{
+   Read();
+}
+
+
+bool
+AdapterMetadataIndex::Lookup(const std::string& libraryPath,
+      AdapterMetadata& metadata) const
+{
+   std::uintmax_t size;
+   long long modificationTime;
+   if (!GetFileStamp(libraryPath, size, modificationTime))
+      return false;
+
+   std::lock_guard<std::mutex> lock(mutex_);
+   auto it = entries_.find(libraryPath);
+   if (it == entries_.end())
+      return false;
+   const Entry& entry = it->second;
+   if (entry.size != size || entry.modificationTime != modificationTime ||
+         entry.metadata.moduleInterfaceVersion != MODULE_INTERFACE_VERSION ||
+         entry.metadata.deviceInterfaceVersion != DEVICE_INTERFACE_VERSION)
+      return false;
+   metadata = entry.metadata;
+   return true;
+}
+
+
+void
+AdapterMetadataIndex::Store(const std::string& libraryPath,
+      const AdapterMetadata& metadata)
+{
+   Entry entry;
+   if (!GetFileStamp(libraryPath, entry.size, entry.modificationTime))
+      return;
+   entry.metadata = metadata;
+
+   std::lock_guard<std::mutex> lock(mutex_);
+   entries_[libraryPath] = std::move(entry);
+}
+
+
+bool
+AdapterMetadataIndex::Save() const
+{
+   std::ostringstream out;
+   out << g_IndexHeader << '\n';
+   {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (const auto& pathAndEntry : entries_)
+      {
+         const Entry& entry = pathAndEntry.second;
+         out << "A\t" << Escape(pathAndEntry.first) <<
+            '\t' << entry.size <<
+            '\t' << entry.modificationTime <<
+            '\t' << entry.metadata.moduleInterfaceVersion <<
+            '\t' << entry.metadata.deviceInterfaceVersion <<
+            '\t' << entry.metadata.devices.size() << '\n';
+         for (const AdapterDeviceMetadata& device : entry.metadata.devices)
+         {
+            out << "D\t" << Escape(device.name) <<
+               '\t' << static_cast<int>(device.type) <<
+               '\t' << Escape(device.description) << '\n';
+         }
+      }
+   }
+
+   // Write to a temporary file first, so that a concurrent reader never sees
+   // a partial index
+   const std::string tempFile = indexFile_ + ".tmp";
+   {
+      std::ofstream ofs(tempFile.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+      if (!ofs)
+         return false;
+      const std::string data = out.str();
+      ofs.write(data.data(), data.size());
+      if (!ofs)
+         return false;
+   }
+   std::error_code ec;
+   std::filesystem::rename(tempFile, indexFile_, ec);
+   if (ec)
+   {
+      std::filesystem::remove(tempFile, ec);
+      return false;
+   }
+   return true;
+}
+
+
+bool
+AdapterMetadataIndex::GetFileStamp(const std::string& path,
+      std::uintmax_t& size, long long& modificationTime)
+{
+   namespace fs = std::filesystem;
+   std::error_code ec;
+   size = fs::file_size(path, ec);
+   if (ec)
+      return false;
+   const fs::file_time_type mtime = fs::last_write_time(path, ec);
+   if (ec)
+      return false;
+   modificationTime = static_cast<long long>(std::chrono::duration_cast<
+      std::chrono::nanoseconds>(mtime.time_since_epoch()).count());
+   return true;
+}
+
+
+void
+AdapterMetadataIndex::Read()
+{
+   std::ifstream ifs(indexFile_.c_str(), std::ios::in | std::ios::binary);
+   if (!ifs)
+      return;
+
+   std::string line;
+   if (!std::getline(ifs, line) || line != g_IndexHeader)
+      return;
+
+   std::map<std::string, Entry> entries;
+   while (std::getline(ifs, line))
+   {
+      std::vector<std::string> fields = SplitFields(line);
+      long long size, mtime, moduleVersion, deviceVersion, count;
+      std::string path;
+      if (fields.size() != 7 || fields[0] != "A" ||
+            !Unescape(fields[1], path) ||
+            !ParseInteger(fields[2], size) || size < 0 ||
+            !ParseInteger(fields[3], mtime) ||
+            !ParseInteger(fields[4], moduleVersion) ||
+            !ParseInteger(fields[5], deviceVersion) ||
+            !ParseInteger(fields[6], count) || count < 0)
+         return;
+
+      Entry entry;
+      entry.size = static_cast<std::uintmax_t>(size);
+      entry.modificationTime = mtime;
+      entry.metadata.moduleInterfaceVersion = static_cast<long>(moduleVersion);
+      entry.metadata.deviceInterfaceVersion = static_cast<long>(deviceVersion);
+      for (long long i = 0; i < count; ++i)
+      {
+         if (!std::getline(ifs, line))
+            return;
+         fields = SplitFields(line);
+         AdapterDeviceMetadata device;
+         long long type;
+         if (fields.size() != 4 || fields[0] != "D" ||
+               !Unescape(fields[1], device.name) ||
+               !ParseInteger(fields[2], type) ||
+               !Unescape(fields[3], device.description))
+            return;
+         device.type = static_cast<MM::DeviceType>(type);
+         entry.metadata.devices.push_back(device);
+      }
+      entries[path] = std::move(entry);
+   }
+
+   std::lock_guard<std::mutex> lock(mutex_);
+   entries_ = std::move(entries);
+}
+
+} // namespace internal
+} // namespace mmcore
@@ -0,0 +1,85 @@
+// DESCRIPTION:   On-disk index of the devices provided by device adapter
+//                libraries, so that they can be listed without loading the
+//                libraries
+//
+// LICENSE:       This file is distributed under the "Lesser GPL" (LGPL) license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+
+#include "MMDeviceConstants.h"
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mmcore {
+namespace internal {
+
+class LoadedDeviceAdapter;
+
+struct AdapterDeviceMetadata
+{
+   std::string name;
+   std::string description;
+   MM::DeviceType type = MM::UnknownType;
+};
+
+struct AdapterMetadata
+{
+   long moduleInterfaceVersion = 0;
+   long deviceInterfaceVersion = 0;
+   std::vector<AdapterDeviceMetadata> devices;
+
+   // Throws CMMError if the module does not provide a device's name,
+   // description, or type
+   static AdapterMetadata FromModule(const LoadedDeviceAdapter& module);
+};
+
+// Entries are keyed by library path and are only returned while the
+// library's size and modification time are unchanged and its interface
+// versions are those of this MMCore. Thread-safe.
+class AdapterMetadataIndex
+{
+public:
+   // Reads the index file if it exists; an unreadable or malformed file
+   // results in an empty index
+   explicit AdapterMetadataIndex(const std::string& indexFile);
+
+   const std::string& GetIndexFile() const { return indexFile_; }
+
+   bool Lookup(const std::string& libraryPath, AdapterMetadata& metadata) const;
+   void Store(const std::string& libraryPath, const AdapterMetadata& metadata);
+
+   // Writes the index file (replacing it atomically); returns false on failure
+   bool Save() const;
+
+private:
+   struct Entry
+   {
+      std::uintmax_t size;
+      long long modificationTime;
+      AdapterMetadata metadata;
+   };
+
+   static bool GetFileStamp(const std::string& path, std::uintmax_t& size,
+         long long& modificationTime);
+   void Read();
+
+   const std::string indexFile_;
+   mutable std::mutex mutex_;
+   std::map<std::string, Entry> entries_;
+};
+
+} // namespace internal
+} // namespace mmcore
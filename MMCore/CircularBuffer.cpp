@@ -26,13 +26,18 @@
 #include "CircularBuffer.h"
 #include "CoreUtils.h"
 
+#include "Semaphore.h"
+#include "Task.h"
 #include "TaskSet_CopyMemory.h"
 #include "ThreadPool.h"
 
 #include "DeviceUtils.h"
 
 #include <algorithm>
+#include <cassert>
+#include <chrono>
 #include <cstddef>
+#include <cstring>
 #include <limits>
 #include <memory>
 #include <new>
@@ -48,19 +53,69 @@ constexpr std::size_t adjustThreshold = std::numeric_limits<std::size_t>::max()
 // division by zero can be added.
 constexpr std::size_t maxCBSize = 10000000;
 
+// Converts the raw pixels of one image and publishes it
+class CircularBuffer::ConversionTask : public Task
+{
+public:
+   ConversionTask(std::shared_ptr<Semaphore> semDone, CircularBuffer* buffer,
+         size_t taskIndex, size_t totalTaskCount) :
+      Task(semDone, taskIndex, totalTaskCount),
+      buffer_(buffer)
+   {}
+
+   void SetUp(std::size_t slot, FrameConversion convert)
+   {
+      slot_ = slot;
+      convert_ = std::move(convert);
+   }
+
+   std::size_t GetSlot() const { return slot_; }
+
+   void Execute() override
+   {
+      // The slot cannot be reused or reallocated before we are done
+      FrameBuffer& frame = buffer_->frameArray_[slot_];
+      convert_(frame.GetRawPixels(), frame.GetPixelsRW());
+      convert_ = nullptr; // Release captured state
+      buffer_->ConversionDone(this);
+   }
+
+   bool busy = false;
+
+private:
+   CircularBuffer* buffer_;
+   std::size_t slot_ = 0;
+   FrameConversion convert_;
+};
+
 CircularBuffer::CircularBuffer(std::size_t memorySizeMB) :
    frameSize_(0),
+   rawFrameSize_(0),
    insertIndex_(0),
+   publishedIndex_(0),
    saveIndex_(0),
+   highWaterMark_(0),
    overflow_(false),
    overwriteData_(false),
    memorySizeMB_(memorySizeMB),
    threadPool_(std::make_shared<ThreadPool>()),
    tasksMemCopy_(std::make_shared<TaskSet_CopyMemory>(threadPool_))
 {
+   // Enough conversions in flight to keep the pool busy while the next
+   // images arrive
+   const std::size_t taskCount = 2 * threadPool_->GetSize();
+   idleConversions_ = std::make_shared<Semaphore>(taskCount);
+   for (std::size_t n = 0; n < taskCount; ++n)
+      conversionTasks_.push_back(std::make_unique<ConversionTask>(
+            idleConversions_, this, n, taskCount));
 }
 
-CircularBuffer::~CircularBuffer() {}
+CircularBuffer::~CircularBuffer()
+{
+   // The thread pool drops queued tasks when destroyed
+   std::lock_guard<std::mutex> insertGuard(insertLock_);
+   WaitForConversionsLocked();
+}
 
 int CircularBuffer::SetOverwriteData(bool overwrite) {
    std::lock_guard<std::mutex> guard(bufferLock_);
@@ -68,50 +123,69 @@ int CircularBuffer::SetOverwriteData(bool overwrite) {
    return DEVICE_OK;
 }
 
-bool CircularBuffer::Initialize(std::size_t frameSize)
+bool CircularBuffer::Initialize(std::size_t frameSize, std::size_t rawFrameSize)
 {
+   std::lock_guard<std::mutex> insertGuard(insertLock_);
+   WaitForConversionsLocked();
+
    std::lock_guard<std::mutex> guard(bufferLock_);
 
    overflow_ = false;
    insertIndex_ = 0;
+   publishedIndex_ = 0;
    saveIndex_ = 0;
+   highWaterMark_ = 0;
 
    try
    {
       if (frameSize == 0)
       {
          frameSize_ = 0;
+         rawFrameSize_ = 0;
          return false;
       }
 
       const std::size_t cbSize = std::min(maxCBSize,
-         (memorySizeMB_ * bytesInMB) / frameSize);
+         (memorySizeMB_ * bytesInMB) / (frameSize + rawFrameSize));
 
       if (cbSize == 0)
       {
          frameSize_ = frameSize;
+         rawFrameSize_ = rawFrameSize;
          frameArray_.resize(0);
+         converting_.clear();
          return false; // memory footprint too small
       }
 
-      if (frameSize == frameSize_ && frameArray_.size() == cbSize)
+      converting_.assign(cbSize, false);
+
+      if (frameSize == frameSize_ && rawFrameSize == rawFrameSize_ &&
+            frameArray_.size() == cbSize)
          return true;
 
       frameSize_ = frameSize;
+      rawFrameSize_ = rawFrameSize;
       frameArray_.resize(cbSize);
       for (auto& frameBuf : frameArray_)
+      {
          frameBuf.Resize(frameSize_);
+         frameBuf.ResizeRaw(rawFrameSize_);
+      }
       return true;
    }
    catch (std::bad_alloc&)
    {
       frameArray_.resize(0);
+      converting_.clear();
       return false;
    }
 }
 
 void CircularBuffer::Clear()
 {
+   std::lock_guard<std::mutex> insertGuard(insertLock_);
+   WaitForConversionsLocked();
+
    std::lock_guard<std::mutex> guard(bufferLock_);
    ClearLocked();
 }
@@ -119,6 +193,7 @@ void CircularBuffer::Clear()
 void CircularBuffer::ClearLocked()
 {
    insertIndex_=0;
+   publishedIndex_=0;
    saveIndex_=0;
    overflow_ = false;
 }
@@ -138,7 +213,74 @@ std::size_t CircularBuffer::GetFreeSize() const
 std::size_t CircularBuffer::GetRemainingImageCount() const
 {
    std::lock_guard<std::mutex> guard(bufferLock_);
-   return insertIndex_ - saveIndex_;
+   return publishedIndex_ - saveIndex_;
+}
+
+std::size_t CircularBuffer::GetHighWaterMark() const
+{
+   std::lock_guard<std::mutex> guard(bufferLock_);
+   return highWaterMark_;
+}
+
+void CircularBuffer::ResetHighWaterMark()
+{
+   std::lock_guard<std::mutex> guard(bufferLock_);
+   highWaterMark_ = insertIndex_ - saveIndex_;
+}
+
+// Returns the slot for the next image, or null on overflow. Called with
+// insertLock_ held.
+FrameBuffer* CircularBuffer::ReserveSlot(std::size_t frameSize,
+   std::size_t rawFrameSize) MMCORE_LEGACY_THROW(CMMError)
+{
+   std::unique_lock<std::mutex> guard(bufferLock_);
+
+   if (overflow_)
+      return nullptr;
+
+   if (frameSize != frameSize_ ||
+         (rawFrameSize != 0 && rawFrameSize != rawFrameSize_))
+      throw CMMError("Incompatible image size in the circular buffer", MMERR_CircularBufferIncompatibleImage);
+
+   bool overflowed = (insertIndex_ - saveIndex_) >= frameArray_.size();
+   if (overflowed) {
+     if (overwriteData_) {
+        // Conversions in progress would publish into the discarded images
+        guard.unlock();
+        WaitForConversionsLocked();
+        guard.lock();
+        ClearLocked();
+     } else {
+        overflow_ = true;
+        return nullptr;
+     }
+   }
+
+   return &frameArray_[insertIndex_ % frameArray_.size()];
+}
+
+void CircularBuffer::CommitInsertLocked(bool pending)
+{
+   converting_[insertIndex_ % frameArray_.size()] = pending;
+   insertIndex_++;
+   highWaterMark_ = std::max(highWaterMark_, insertIndex_ - saveIndex_);
+   PublishLocked();
+   // Periodically rebase indices to keep them from growing without bound.
+   if (insertIndex_ > frameArray_.size() + adjustThreshold &&
+       saveIndex_  > frameArray_.size() + adjustThreshold)
+   {
+      insertIndex_    -= adjustThreshold;
+      publishedIndex_ -= adjustThreshold;
+      saveIndex_      -= adjustThreshold;
+   }
+}
+
+// Publishes, in insertion order, the images that are no longer converting
+void CircularBuffer::PublishLocked()
+{
+   while (publishedIndex_ < insertIndex_ &&
+         !converting_[publishedIndex_ % frameArray_.size()])
+      ++publishedIndex_;
 }
 
 /**
@@ -146,56 +288,119 @@ std::size_t CircularBuffer::GetRemainingImageCount() const
 */
 bool CircularBuffer::InsertImage(const unsigned char* pixArray,
    std::size_t frameSize,
-   std::string_view serializedMetadata) MMCORE_LEGACY_THROW(CMMError)
+   std::string_view serializedMetadata,
+   FrameTiming* timing) MMCORE_LEGACY_THROW(CMMError)
 {
-    std::lock_guard<std::mutex> insertGuard(insertLock_);
+   std::lock_guard<std::mutex> insertGuard(insertLock_);
+
+   FrameBuffer* pImg = ReserveSlot(frameSize, 0);
+   if (!pImg)
+      return false;
+
+   pImg->SetSerializedMetadata(serializedMetadata);
+   pImg->SetHasRawPixels(false);
 
-    FrameBuffer* pImg;
+   // TODO: Pass tasksMemCopy_ to FrameBuffer constructor and utilize
+   //       parallel copy also in single snap acquisitions.
+   tasksMemCopy_->MemCopy(pImg->GetPixelsRW(), pixArray, frameSize);
+
+   if (timing)
+   {
+      timing->copied = std::chrono::steady_clock::now();
+      pImg->SetTiming(*timing);
+   }
+   else
+   {
+      pImg->SetTiming(FrameTiming());
+   }
 
-    {
-       std::lock_guard<std::mutex> guard(bufferLock_);
+   {
+      std::lock_guard<std::mutex> guard(bufferLock_);
+      CommitInsertLocked(false);
+   }
 
-       if (overflow_)
-          return false;
+   return true;
+}
 
-       if (frameSize != frameSize_)
-          throw CMMError("Incompatible image size in the circular buffer", MMERR_CircularBufferIncompatibleImage);
+bool CircularBuffer::InsertRawImage(const unsigned char* rawPixArray,
+   std::size_t rawFrameSize, std::size_t frameSize,
+   std::string_view serializedMetadata, FrameConversion convert,
+   FrameTiming* timing) MMCORE_LEGACY_THROW(CMMError)
+{
+   std::lock_guard<std::mutex> insertGuard(insertLock_);
 
-       bool overflowed = (insertIndex_ - saveIndex_) >= frameArray_.size();
-       if (overflowed) {
-         if (overwriteData_) {
-            ClearLocked();
-         } else {
-            overflow_ = true;
-            return false;
-         }
-       }
+   FrameBuffer* pImg = ReserveSlot(frameSize, rawFrameSize);
+   if (!pImg)
+      return false;
 
-       pImg = &frameArray_[insertIndex_ % frameArray_.size()];
-    }
+   ConversionTask* task = AcquireConversionTask();
 
    pImg->SetSerializedMetadata(serializedMetadata);
+   // Not tasksMemCopy_, whose tasks would queue on the thread pool behind
+   // the conversions of earlier frames
+   std::memcpy(pImg->GetRawPixelsRW(), rawPixArray, rawFrameSize);
+   pImg->SetHasRawPixels(true);
 
-   // TODO: In MMCore the FrameBuffer::GetPixels() returns const pointer.
-   //       It would be better to have something like FrameBuffer::GetPixelsRW() in MMDevice.
-   //       Or even better - pass tasksMemCopy_ to FrameBuffer constructor
-   //       and utilize parallel copy also in single snap acquisitions.
-   tasksMemCopy_->MemCopy((void*)pImg->GetPixels(), pixArray, frameSize);
+   if (timing)
+   {
+      timing->copied = std::chrono::steady_clock::now();
+      pImg->SetTiming(*timing);
+   }
+   else
+   {
+      pImg->SetTiming(FrameTiming());
+   }
 
    {
       std::lock_guard<std::mutex> guard(bufferLock_);
+      task->SetUp(insertIndex_ % frameArray_.size(), std::move(convert));
+      CommitInsertLocked(true);
+   }
+
+   threadPool_->Execute(task);
+   return true;
+}
 
-      insertIndex_++;
-      // Periodically rebase indices to keep them from growing without bound.
-      if (insertIndex_ > frameArray_.size() + adjustThreshold &&
-          saveIndex_  > frameArray_.size() + adjustThreshold)
+// Called with insertLock_ held
+CircularBuffer::ConversionTask* CircularBuffer::AcquireConversionTask()
+{
+   idleConversions_->Wait();
+
+   std::lock_guard<std::mutex> guard(bufferLock_);
+   // Tasks are marked idle before they signal the semaphore
+   for (auto& task : conversionTasks_)
+   {
+      if (!task->busy)
       {
-         insertIndex_ -= adjustThreshold;
-         saveIndex_   -= adjustThreshold;
+         task->busy = true;
+         return task.get();
       }
    }
+   assert(false);
+   return nullptr;
+}
 
-   return true;
+void CircularBuffer::ConversionDone(ConversionTask* task)
+{
+   std::lock_guard<std::mutex> guard(bufferLock_);
+   converting_[task->GetSlot()] = false;
+   task->busy = false;
+   PublishLocked();
+}
+
+void CircularBuffer::WaitForConversions()
+{
+   std::lock_guard<std::mutex> insertGuard(insertLock_);
+   WaitForConversionsLocked();
+}
+
+// Called with insertLock_ (but not bufferLock_) held, so that no conversion
+// can be started while waiting
+void CircularBuffer::WaitForConversionsLocked()
+{
+   const std::size_t taskCount = conversionTasks_.size();
+   idleConversions_->Wait(taskCount);
+   idleConversions_->Release(taskCount);
 }
  
 
@@ -216,11 +421,11 @@ const FrameBuffer* CircularBuffer::GetNthFromTopImageBuffer(std::size_t n) const
 {
    std::lock_guard<std::mutex> guard(bufferLock_);
 
-   const std::size_t availableImages = insertIndex_ - saveIndex_;
+   const std::size_t availableImages = publishedIndex_ - saveIndex_;
    if (n >= availableImages)
       return nullptr;
 
-   const std::size_t targetIndex = (insertIndex_ - n - 1) % frameArray_.size();
+   const std::size_t targetIndex = (publishedIndex_ - n - 1) % frameArray_.size();
    return &frameArray_[targetIndex];
 }
 
@@ -236,7 +441,7 @@ const FrameBuffer* CircularBuffer::GetNextImageBuffer()
 {
    std::lock_guard<std::mutex> guard(bufferLock_);
 
-   if (insertIndex_ == saveIndex_)
+   if (publishedIndex_ == saveIndex_)
       return nullptr;
 
    const std::size_t targetIndex = saveIndex_ % frameArray_.size();
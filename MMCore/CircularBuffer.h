@@ -31,6 +31,7 @@
 #include "MMDevice.h"
 
 #include <cstddef>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <string_view>
@@ -39,6 +40,7 @@
 namespace mmcore {
 namespace internal {
 
+class Semaphore;
 class ThreadPool;
 class TaskSet_CopyMemory;
 
@@ -46,6 +48,11 @@ class TaskSet_CopyMemory;
 class CircularBuffer
 {
 public:
+   // Converts the raw pixels of a frame (first argument) into the pixels
+   // stored in the buffer (second argument). Must not throw.
+   using FrameConversion =
+      std::function<void(const unsigned char*, unsigned char*)>;
+
    CircularBuffer(std::size_t memorySizeMB);
    ~CircularBuffer();
 
@@ -53,13 +60,33 @@ public:
 
    std::size_t GetMemorySizeMB() const { return memorySizeMB_; }
 
-   bool Initialize(std::size_t frameSize);
+   // rawFrameSize is the size of the raw frames kept alongside converted
+   // frames (see InsertRawImage()), or 0 if all frames are stored as is.
+   bool Initialize(std::size_t frameSize, std::size_t rawFrameSize = 0);
    std::size_t GetSize() const;
    std::size_t GetFreeSize() const;
    std::size_t GetRemainingImageCount() const;
+   // Largest number of images waiting in the buffer since the last
+   // Initialize() or ResetHighWaterMark()
+   std::size_t GetHighWaterMark() const;
+   void ResetHighWaterMark();
 
+   // If timing is given, its copied time is set and it is stored with the
+   // image; otherwise the image is stored untimed.
    bool InsertImage(const unsigned char* pixArray, std::size_t frameSize,
-      std::string_view serializedMetadata) MMCORE_LEGACY_THROW(CMMError);
+      std::string_view serializedMetadata,
+      FrameTiming* timing = nullptr) MMCORE_LEGACY_THROW(CMMError);
+   // Stores a raw frame and converts it on the worker pool. The converted
+   // image is published (becomes visible to the Get functions and counts as
+   // remaining) when it and all images inserted before it are ready. The raw
+   // pixels stay available from the FrameBuffer. Blocks if too many
+   // conversions are already in progress.
+   bool InsertRawImage(const unsigned char* rawPixArray,
+      std::size_t rawFrameSize, std::size_t frameSize,
+      std::string_view serializedMetadata, FrameConversion convert,
+      FrameTiming* timing = nullptr) MMCORE_LEGACY_THROW(CMMError);
+   // Blocks until all images inserted so far have been published
+   void WaitForConversions();
    const unsigned char* GetTopImage() const;
    const unsigned char* GetNextImage();
    const FrameBuffer* GetTopImageBuffer() const;
@@ -70,6 +97,15 @@ public:
    bool Overflow() const {std::lock_guard<std::mutex> guard(bufferLock_); return overflow_;}
 
 private:
+   class ConversionTask;
+
+   FrameBuffer* ReserveSlot(std::size_t frameSize, std::size_t rawFrameSize)
+      MMCORE_LEGACY_THROW(CMMError);
+   void CommitInsertLocked(bool pending);
+   void PublishLocked();
+   ConversionTask* AcquireConversionTask();
+   void ConversionDone(ConversionTask* task);
+   void WaitForConversionsLocked();
    void ClearLocked();
 
    // Serializes InsertImage calls so that the pixel copy can occur
@@ -80,19 +116,30 @@ private:
    mutable std::mutex bufferLock_;
 
    std::size_t frameSize_;
+   std::size_t rawFrameSize_;
 
    // Invariants:
-   // 0 <= saveIndex_ <= insertIndex_
+   // 0 <= saveIndex_ <= publishedIndex_ <= insertIndex_
    // insertIndex_ - saveIndex_ <= frameArray_.size()
+   // Images from publishedIndex_ up to insertIndex_ are being converted, or
+   // are waiting for an earlier image to be converted.
    std::size_t insertIndex_;
+   std::size_t publishedIndex_;
    std::size_t saveIndex_;
+   std::size_t highWaterMark_;
 
    bool overflow_;
    bool overwriteData_;
    std::vector<FrameBuffer> frameArray_;
+   std::vector<bool> converting_; // Per slot of frameArray_
 
    // Effectively const after construction.
    std::size_t memorySizeMB_;
+   // Counts idle conversion tasks; conversions are started (under
+   // insertLock_) only after taking one.
+   std::shared_ptr<Semaphore> idleConversions_;
+   // Busy flags are guarded by bufferLock_.
+   std::vector<std::unique_ptr<ConversionTask>> conversionTasks_;
    std::shared_ptr<ThreadPool> threadPool_;
    std::shared_ptr<TaskSet_CopyMemory> tasksMemCopy_;
 };
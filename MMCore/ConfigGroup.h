@@ -24,7 +24,15 @@
 
 #include "Configuration.h"
 #include "Error.h"
+
+#include "MMDeviceConstants.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 /**
@@ -153,8 +161,52 @@ class ConfigGroup : public ConfigGroupBase<Configuration>
 namespace mmcore {
 namespace internal {
 
+/**
+ * The settings needed to switch a group from one preset to another.
+ *
+ * Only settings of devices that differ between the two presets are included.
+ * Once a device has a differing setting, all of its subsequent settings (in
+ * the order of the target preset) are included as well, because setting one
+ * property may reset another on the same device. Core settings are always
+ * included. The settings keep the order of the target preset.
+ */
+struct ConfigTransition
+{
+   Configuration settings; // To apply, in order
+   Configuration assumed; // Skipped because the source preset already has them
+
+   static ConfigTransition Compute(Configuration& from, const Configuration& to)
+   {
+      ConfigTransition transition;
+      std::set<std::string> changedDevices;
+      for (size_t i = 0; i < to.size(); i++)
+      {
+         PropertySetting setting = to.getSetting(i);
+         const std::string device = setting.getDeviceLabel();
+         if (device == MM::g_Keyword_CoreDevice ||
+               changedDevices.count(device) ||
+               !from.isSettingIncluded(setting))
+         {
+            if (device != MM::g_Keyword_CoreDevice)
+               changedDevices.insert(device);
+            transition.settings.addSetting(setting);
+         }
+         else
+         {
+            transition.assumed.addSetting(setting);
+         }
+      }
+      return transition;
+   }
+};
+
 /**
  * Encapsulates a collection of preset groups.
+ *
+ * Also keeps, per group, the preset most recently applied and a lazily
+ * filled table of transitions between its presets. Both are discarded
+ * whenever the group is modified. They are guarded by their own mutex, so
+ * that presets can be applied from several threads at once.
  */
 class ConfigGroupCollection {
 public:
@@ -166,6 +218,7 @@ public:
     */
    void Define(const char* groupName, const char* configName)
    {
+      Invalidate(groupName);
       groups_[groupName].Define(configName);
    }
 
@@ -174,6 +227,7 @@ public:
     */
    void Define(const char* groupName, const char* configName, const char* deviceLabel, const char* propName, const char* value)
    {
+      Invalidate(groupName);
       groups_[groupName].Define(configName, deviceLabel, propName, value);
    }
 
@@ -226,6 +280,7 @@ public:
          std::map<std::string, ConfigGroup>::iterator it = groups_.find(groupName);
          if (it == groups_.end())
             return false; // group not found
+         Invalidate(groupName);
          return it->second.Rename(oldConfigName, newConfigName);
       } else {
          return true;
@@ -244,6 +299,7 @@ public:
       std::map<std::string, ConfigGroup>::iterator it = groups_.find(groupName);
       if (it == groups_.end())
          return false; // group not found
+      Invalidate(groupName);
       return it->second.Delete(configName, deviceLabel, propName);
    }
 
@@ -260,6 +316,7 @@ public:
       std::map<std::string, ConfigGroup>::iterator it = groups_.find(groupName);
       if (it == groups_.end())
          return false; // group not found
+      Invalidate(groupName);
       return it->second.Delete(configName);
    }
 
@@ -275,6 +332,7 @@ public:
       std::map<std::string, ConfigGroup>::iterator it = groups_.find(groupName);
       if (it != groups_.end())
       {
+         Invalidate(groupName);
          groups_.erase(it->first);
          return true;
       }
@@ -295,6 +353,8 @@ public:
          std::map<std::string, ConfigGroup>::iterator it = groups_.find(oldGroupName);
          if (it != groups_.end())
          {
+            Invalidate(oldGroupName);
+            Invalidate(newGroupName);
             groups_[newGroupName] = it->second;
             groups_.erase(it->first);
             return true;
@@ -339,11 +399,77 @@ public:
    void Clear()
    {
       groups_.clear();
+      std::lock_guard<std::mutex> lock(planMutex_);
+      transitions_.clear();
+      lastApplied_.clear();
+   }
+
+   /**
+    * Returns the transition between two presets of a group, computing it if
+    * necessary. Returns null if the group or either preset does not exist.
+    *
+    * The returned transition remains valid after the group is modified.
+    */
+   std::shared_ptr<const ConfigTransition> FindTransition(const char* groupName,
+         const char* fromConfigName, const char* toConfigName)
+   {
+      auto key = std::make_pair(std::string(fromConfigName), std::string(toConfigName));
+      std::lock_guard<std::mutex> lock(planMutex_);
+      auto tableIt = transitions_.find(groupName);
+      if (tableIt != transitions_.end())
+      {
+         auto it = tableIt->second.find(key);
+         if (it != tableIt->second.end())
+            return it->second;
+      }
+
+      // Only cache transitions between existing configs, so that lookups of
+      // unknown groups or configs do not add entries
+      Configuration* pFrom = Find(groupName, fromConfigName);
+      Configuration* pTo = Find(groupName, toConfigName);
+      if (!pFrom || !pTo)
+         return nullptr;
+      auto transition = std::make_shared<const ConfigTransition>(
+         ConfigTransition::Compute(*pFrom, *pTo));
+      transitions_[groupName].insert({ key, transition });
+      return transition;
+   }
+
+   /**
+    * Records the preset most recently applied to a group (empty if unknown).
+    */
+   void SetLastApplied(const char* groupName, const std::string& configName)
+   {
+      std::lock_guard<std::mutex> lock(planMutex_);
+      if (configName.empty())
+         lastApplied_.erase(groupName);
+      else
+         lastApplied_[groupName] = configName;
    }
 
+   std::string GetLastApplied(const char* groupName) const
+   {
+      std::lock_guard<std::mutex> lock(planMutex_);
+      std::map<std::string, std::string>::const_iterator it = lastApplied_.find(groupName);
+      if (it == lastApplied_.end())
+         return std::string();
+      return it->second;
+   }
 
 private:
+   void Invalidate(const std::string& groupName)
+   {
+      std::lock_guard<std::mutex> lock(planMutex_);
+      transitions_.erase(groupName);
+      lastApplied_.erase(groupName);
+   }
+
    std::map<std::string, ConfigGroup> groups_;
+
+   mutable std::mutex planMutex_; // Protects transitions_ and lastApplied_
+   std::map<std::string, std::map<std::pair<std::string, std::string>,
+      std::shared_ptr<const ConfigTransition>>> transitions_;
+   std::map<std::string, std::string> lastApplied_;
 };
 
 } // namespace internal
@@ -27,7 +27,9 @@
 
 #include "CircularBuffer.h"
 #include "CoreCallback.h"
+#include "DemosaicStage.h"
 #include "DeviceManager.h"
+#include "FrameLatencyStats.h"
 #include "Notification.h"
 #include "SerializedMetadata.h"
 #include "SynchronizedConfiguration.h"
@@ -307,20 +309,75 @@ int CoreCallback::InsertImage(const MM::Device* caller, const unsigned char* buf
    unsigned width, unsigned height, unsigned bytesPerPixel, unsigned nComponents,
    const char* serializedMetadata)
 {
+   // Keep the cost of latency measurement to one relaxed load when disabled
+   FrameLatencyStats& latencyStats = *core_->latencyStats_;
+   FrameTiming timing;
+   timing.timed = latencyStats.IsTiming();
+   if (timing.timed)
+      timing.received = std::chrono::steady_clock::now();
+
    try
    {
-      SerializedMetadata md = BuildSequenceImageMetadata(
-         caller, width, height, bytesPerPixel, nComponents, serializedMetadata);
+      // Raw Bayer images are stored as is and demosaiced on the circular
+      // buffer's worker pool, as the buffer was sized for; they are
+      // described as the RGB32 images they become.
+      std::shared_ptr<const DemosaicConfig> demosaic =
+         core_->demosaicStage_->FindForBuffer(bytesPerPixel, nComponents);
+
+      SerializedMetadata md = BuildSequenceImageMetadata(caller, width, height,
+         demosaic ? 4 : bytesPerPixel, demosaic ? 4 : nComponents,
+         serializedMetadata);
+      if (demosaic)
+      {
+         md.AddTag("DemosaicPattern", demosaic->GetPattern());
+         md.AddTag("DemosaicAlgorithm", demosaic->GetAlgorithm());
+         md.AddTag("RawPixelType", bytesPerPixel == 1 ?
+            MM::g_Keyword_PixelType_GRAY8 : MM::g_Keyword_PixelType_GRAY16);
+      }
 
       MM::ImageProcessor* ip = GetImageProcessor(caller);
       if (ip != nullptr)
       {
          ip->Process(const_cast<unsigned char*>(buf), width, height, bytesPerPixel);
       }
-      if (core_->cbuf_->InsertImage(buf,
-            static_cast<std::size_t>(width) * height * bytesPerPixel,
-            md.View()))
+
+      if (timing.timed)
+      {
+         timing.processed = std::chrono::steady_clock::now();
+         if (latencyStats.IsEnabled())
+         {
+            auto cameraLabel = md.GetTag(MM::g_Keyword_Metadata_CameraLabel);
+            if (cameraLabel)
+               timing.stats = latencyStats.GetCamera(*cameraLabel);
+         }
+      }
+
+      const std::size_t pixels = static_cast<std::size_t>(width) * height;
+      bool inserted;
+      if (demosaic)
+      {
+         inserted = core_->cbuf_->InsertRawImage(buf, pixels * bytesPerPixel,
+            pixels * 4, md.View(),
+            [demosaic, width, height, bytesPerPixel](
+                  const unsigned char* raw, unsigned char* rgb32)
+            {
+               // Images are converted in parallel, one per pool thread
+               demosaic->Convert(raw, width, height, bytesPerPixel, rgb32, 1);
+            },
+            timing.timed ? &timing : nullptr);
+      }
+      else
+      {
+         inserted = core_->cbuf_->InsertImage(buf, pixels * bytesPerPixel,
+            md.View(), timing.timed ? &timing : nullptr);
+      }
+
+      if (inserted)
+      {
+         if (timing.stats)
+            timing.stats->RecordInserted(timing);
          return DEVICE_OK;
+      }
       else
          return DEVICE_BUFFER_OVERFLOW;
    }
@@ -341,7 +398,14 @@ bool CoreCallback::InitializeImageBuffer(unsigned channels, unsigned slices,
    if (slices != 1)
       return false;
 
-   return core_->cbuf_->Initialize(static_cast<std::size_t>(w) * h * pixDepth);
+   // There is no caller; assume images come from the current camera
+   std::string cameraLabel;
+   std::shared_ptr<CameraInstance> camera = core_->currentCameraDevice_.lock();
+   if (camera)
+      cameraLabel = camera->GetLabel();
+   const auto sizes = core_->demosaicStage_->InitializeBuffer(
+      cameraLabel, w, h, pixDepth, 1);
+   return core_->cbuf_->Initialize(sizes.first, sizes.second);
 }
 
 int CoreCallback::AcqFinished(const MM::Device* caller, int /*statusCode*/)
@@ -596,6 +660,25 @@ int CoreCallback::OnShutterOpenChanged(const MM::Device* device, bool state)
    return DEVICE_OK;
 }
 
+/**
+ * Handler for busy state changes; wakes up threads waiting for the device.
+ */
+int CoreCallback::OnBusyChanged(const MM::Device* device, bool /* busy */)
+{
+   std::shared_ptr<DeviceInstance> instance;
+   try
+   {
+      instance = core_->deviceManager_->GetDevice(device);
+   }
+   catch (const CMMError&)
+   {
+      return DEVICE_OK;
+   }
+   if (instance)
+      instance->NotifyBusyChanged();
+   return DEVICE_OK;
+}
+
 
 int CoreCallback::SetSerialProperties(const char* portName,
                                       const char* answerTimeout,
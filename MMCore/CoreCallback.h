@@ -112,6 +112,7 @@ public:
    int OnSLMExposureChanged(const MM::Device* device, double newExposure);
    int OnMagnifierChanged(const MM::Device* device);
    int OnShutterOpenChanged(const MM::Device* device, bool open);
+   int OnBusyChanged(const MM::Device* device, bool busy);
 
    // Deprecated
    MM::SignalIO* GetSignalIODevice(const MM::Device* caller,
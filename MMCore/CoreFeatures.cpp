@@ -119,6 +119,32 @@ const auto& featureMap() {
             [](bool e) { g_flags.ParallelDeviceInitialization = e; }
          }
       },
+      {
+         "ParallelConfigApply", {
+            [] { return g_flags.parallelConfigApply; },
+            [](bool e) { g_flags.parallelConfigApply = e; }
+            // Relies on the system state cache being accurate; settings
+            // whose cached value matches are not sent to the device. Off by
+            // default until we know how many adapters misbehave when their
+            // properties are set from a thread other than the caller's.
+         }
+      },
+      {
+         "ConfigTransitionPlans", {
+            [] { return g_flags.configTransitionPlans; },
+            [](bool e) { g_flags.configTransitionPlans = e; }
+            // Like ParallelConfigApply, trusts the system state cache (the
+            // skipped settings are checked against it before each use).
+         }
+      },
+      {
+         "ParallelConfigLoad", {
+            [] { return g_flags.parallelConfigLoad; },
+            [](bool e) { g_flags.parallelConfigLoad = e; }
+            // Changes the order of device calls during config loading, so
+            // off by default, like ParallelConfigApply.
+         }
+      },
       // How to add a new Core feature: see the comment at the top of this file.
       // Features (the string names) must never be removed once added!
    };
@@ -28,6 +28,9 @@ namespace features {
 struct Flags {
    bool strictInitializationChecks = false;
    bool ParallelDeviceInitialization = true;
+   bool parallelConfigApply = false;
+   bool configTransitionPlans = false;
+   bool parallelConfigLoad = false;
    // How to add a new Core feature: see the comment in the .cpp file.
 };
 
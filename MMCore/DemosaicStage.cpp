@@ -0,0 +1,175 @@
+// DESCRIPTION:   Per-camera demosaicing of raw Bayer images in the Core
+//
+// LICENSE:       This file is distributed under the "Lesser GPL" (LGPL) license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "DemosaicStage.h"
+
+#include "Error.h"
+
+#include "Debayer.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace mmcore {
+namespace internal {
+
+namespace {
+
+// Debayer order indices, by the pattern they actually decode (orders 2 and
+// 3 have the red and blue sites of their names swapped)
+const char* const patterns[] = { "RGGB", "BGGR", "GBRG", "GRBG" };
+
+std::string JoinNames(const std::vector<std::string>& names)
+{
+   std::string joined;
+   for (const std::string& name : names)
+   {
+      if (!joined.empty())
+         joined += ", ";
+      joined += name;
+   }
+   return joined;
+}
+
+} // namespace
+
+DemosaicConfig::DemosaicConfig(const std::string& pattern,
+      const std::string& algorithm, unsigned bitDepth) :
+   pattern_(pattern),
+   algorithm_(algorithm),
+   bitDepth_(bitDepth)
+{
+   const auto patternIt = std::find(std::begin(patterns), std::end(patterns), pattern);
+   if (patternIt == std::end(patterns))
+      throw CMMError("Unknown CFA pattern: " + pattern + " (expected " +
+            JoinNames(DemosaicStage::GetPatterns()) + ")");
+   orderIndex_ = static_cast<int>(patternIt - std::begin(patterns));
+
+   const std::vector<std::string> algorithms = DemosaicStage::GetAlgorithms();
+   if (std::find(algorithms.begin(), algorithms.end(), algorithm) == algorithms.end())
+      throw CMMError("Unknown demosaic algorithm: " + algorithm + " (expected " +
+            JoinNames(algorithms) + ")");
+   const std::vector<std::string> debayerAlgorithms = Debayer().GetAlgorithms();
+   algorithmIndex_ = static_cast<int>(std::find(debayerAlgorithms.begin(),
+            debayerAlgorithms.end(), algorithm) - debayerAlgorithms.begin());
+
+   if (bitDepth > 16)
+      throw CMMError("Invalid demosaic bit depth: " + std::to_string(bitDepth));
+}
+
+void DemosaicConfig::Convert(const unsigned char* raw, unsigned width,
+      unsigned height, unsigned bytesPerPixel, unsigned char* rgb32,
+      int maxThreads) const
+{
+   Debayer debayer;
+   debayer.SetOrderIndex(orderIndex_);
+   debayer.SetAlgorithmIndex(algorithmIndex_);
+   if (maxThreads > 0)
+      debayer.SetMaxThreads(maxThreads);
+
+   const unsigned pixelBits = 8 * bytesPerPixel;
+   const int bitDepth = static_cast<int>(
+         bitDepth_ == 0 ? pixelBits : std::min(bitDepth_, pixelBits));
+   // Settings were validated on construction
+   if (bytesPerPixel == 1)
+      debayer.Process(rgb32, raw, static_cast<int>(width),
+            static_cast<int>(height), bitDepth);
+   else
+      debayer.Process(rgb32, reinterpret_cast<const unsigned short*>(raw),
+            static_cast<int>(width), static_cast<int>(height), bitDepth);
+}
+
+std::vector<std::string> DemosaicStage::GetPatterns()
+{
+   return std::vector<std::string>(std::begin(patterns), std::end(patterns));
+}
+
+std::vector<std::string> DemosaicStage::GetAlgorithms()
+{
+   std::vector<std::string> algorithms = Debayer().GetAlgorithms();
+   // Listed by Debayer, but not implemented
+   algorithms.erase(std::remove(algorithms.begin(), algorithms.end(),
+            "Adaptive-Smooth-Hue"), algorithms.end());
+   return algorithms;
+}
+
+void DemosaicStage::Set(std::string_view camera,
+      std::shared_ptr<const DemosaicConfig> config)
+{
+   std::unique_lock<std::shared_mutex> lock(mutex_);
+   cameras_[std::string(camera)] = std::move(config);
+   count_.store(cameras_.size(), std::memory_order_relaxed);
+}
+
+void DemosaicStage::Remove(std::string_view camera)
+{
+   std::unique_lock<std::shared_mutex> lock(mutex_);
+   auto it = cameras_.find(camera);
+   if (it != cameras_.end())
+      cameras_.erase(it);
+   count_.store(cameras_.size(), std::memory_order_relaxed);
+}
+
+void DemosaicStage::Clear()
+{
+   std::unique_lock<std::shared_mutex> lock(mutex_);
+   cameras_.clear();
+   count_.store(0, std::memory_order_relaxed);
+}
+
+std::shared_ptr<const DemosaicConfig>
+DemosaicStage::Get(std::string_view camera) const
+{
+   std::shared_lock<std::shared_mutex> lock(mutex_);
+   auto it = cameras_.find(camera);
+   return it == cameras_.end() ? nullptr : it->second;
+}
+
+std::shared_ptr<const DemosaicConfig>
+DemosaicStage::Find(std::string_view camera, unsigned bytesPerPixel,
+      unsigned nComponents) const
+{
+   if (!IsActive() || !IsRawFormat(bytesPerPixel, nComponents))
+      return nullptr;
+   return Get(camera);
+}
+
+std::pair<std::size_t, std::size_t> DemosaicStage::InitializeBuffer(
+      std::string_view camera, unsigned width, unsigned height,
+      unsigned bytesPerPixel, unsigned nComponents)
+{
+   std::shared_ptr<const DemosaicConfig> config =
+      Find(camera, bytesPerPixel, nComponents);
+   const std::size_t pixels = static_cast<std::size_t>(width) * height;
+   const std::pair<std::size_t, std::size_t> sizes = config ?
+      std::make_pair(pixels * 4, pixels * bytesPerPixel) :
+      std::make_pair(pixels * bytesPerPixel, std::size_t(0));
+
+   std::unique_lock<std::shared_mutex> lock(mutex_);
+   bufferActive_.store(config != nullptr, std::memory_order_relaxed);
+   buffer_ = std::move(config);
+   return sizes;
+}
+
+std::shared_ptr<const DemosaicConfig>
+DemosaicStage::FindForBuffer(unsigned bytesPerPixel, unsigned nComponents) const
+{
+   if (!bufferActive_.load(std::memory_order_relaxed) ||
+         !IsRawFormat(bytesPerPixel, nComponents))
+      return nullptr;
+   std::shared_lock<std::shared_mutex> lock(mutex_);
+   return buffer_;
+}
+
+} // namespace internal
+} // namespace mmcore
@@ -0,0 +1,106 @@
+// DESCRIPTION:   Per-camera demosaicing of raw Bayer images in the Core
+//
+// LICENSE:       This file is distributed under the "Lesser GPL" (LGPL) license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace mmcore {
+namespace internal {
+
+// How the raw images of one camera are demosaiced; immutable, so that
+// images being converted keep the settings they were inserted with
+class DemosaicConfig
+{
+public:
+   // Throws CMMError for an unknown pattern or algorithm, or a bit depth
+   // above 16
+   DemosaicConfig(const std::string& pattern, const std::string& algorithm,
+         unsigned bitDepth);
+
+   const std::string& GetPattern() const { return pattern_; }
+   const std::string& GetAlgorithm() const { return algorithm_; }
+   unsigned GetBitDepth() const { return bitDepth_; }
+
+   // Converts a raw image of 1 or 2 bytes per pixel into RGB32. maxThreads
+   // of 0 uses the Debayer default.
+   void Convert(const unsigned char* raw, unsigned width, unsigned height,
+         unsigned bytesPerPixel, unsigned char* rgb32, int maxThreads) const;
+
+private:
+   std::string pattern_;
+   std::string algorithm_;
+   unsigned bitDepth_; // 0 for the full range of the pixel type
+   int orderIndex_;
+   int algorithmIndex_;
+};
+
+// Demosaic settings of all cameras
+class DemosaicStage
+{
+public:
+   // CFA patterns, named by the colors of the top-left 2x2 block
+   static std::vector<std::string> GetPatterns();
+   static std::vector<std::string> GetAlgorithms();
+
+   // Whether images of this format can be demosaiced
+   static bool IsRawFormat(unsigned bytesPerPixel, unsigned nComponents)
+   { return nComponents == 1 && (bytesPerPixel == 1 || bytesPerPixel == 2); }
+
+   void Set(std::string_view camera, std::shared_ptr<const DemosaicConfig> config);
+   void Remove(std::string_view camera);
+   void Clear();
+   std::shared_ptr<const DemosaicConfig> Get(std::string_view camera) const;
+
+   // Whether any camera is configured; cheap, for the image insertion path
+   bool IsActive() const { return count_.load(std::memory_order_relaxed) > 0; }
+
+   // The settings to apply to images of the given format from the camera,
+   // or null if they are stored as is
+   std::shared_ptr<const DemosaicConfig> Find(std::string_view camera,
+         unsigned bytesPerPixel, unsigned nComponents) const;
+
+   // Sizes of the stored and raw images in the circular buffer (the raw
+   // size being 0 unless the images are demosaiced) when it is initialized
+   // for images from the camera. The camera's settings then apply to all
+   // images inserted until the buffer is next initialized.
+   std::pair<std::size_t, std::size_t> InitializeBuffer(
+         std::string_view camera, unsigned width, unsigned height,
+         unsigned bytesPerPixel, unsigned nComponents);
+
+   // The settings to apply to images of the given format inserted into the
+   // circular buffer, or null if they are stored as is. These come from the
+   // camera the buffer was initialized for, whichever device inserts the
+   // images (e.g. the physical cameras of a Multi Camera), because all
+   // frames in the buffer have the same size.
+   std::shared_ptr<const DemosaicConfig> FindForBuffer(unsigned bytesPerPixel,
+         unsigned nComponents) const;
+
+private:
+   std::atomic<std::size_t> count_{0};
+   std::atomic<bool> bufferActive_{false};
+   mutable std::shared_mutex mutex_;
+   std::map<std::string, std::shared_ptr<const DemosaicConfig>, std::less<>> cameras_;
+   std::shared_ptr<const DemosaicConfig> buffer_;
+};
+
+} // namespace internal
+} // namespace mmcore
@@ -0,0 +1,191 @@
+// DESCRIPTION:   Runs tasks with ordering dependencies on a bounded number of
+//                threads, recording when each task ran
+//
+// LICENSE:       This file is distributed under the "Lesser GPL" (LGPL) license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "DependencyScheduler.h"
+
+#include "Error.h"
+#include "ErrorCodes.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace mmcore {
+namespace internal {
+
+DependencyScheduler::DependencyScheduler(std::size_t taskCount) :
+   dependencies_(taskCount),
+   dependents_(taskCount),
+   timings_(taskCount)
+{}
+
+void DependencyScheduler::AddDependency(std::size_t before, std::size_t after)
+{
+   if (before == after)
+      return;
+   std::vector<std::size_t>& deps = dependencies_[after];
+   if (std::find(deps.begin(), deps.end(), before) != deps.end())
+      return;
+   deps.push_back(before);
+   dependents_[before].push_back(after);
+}
+
+void DependencyScheduler::Run(const std::function<void(std::size_t)>& task,
+   std::size_t maxThreads)
+{
+   const std::size_t n = dependencies_.size();
+   timings_.assign(n, TaskTiming());
+
+   std::vector<std::size_t> remainingDeps(n);
+   std::deque<std::size_t> ready;
+   for (std::size_t i = 0; i < n; ++i)
+   {
+      remainingDeps[i] = dependencies_[i].size();
+      if (remainingDeps[i] == 0)
+         ready.push_back(i);
+   }
+
+   // Check for cycles before starting anything
+   {
+      std::vector<std::size_t> counts = remainingDeps;
+      std::deque<std::size_t> queue = ready;
+      std::size_t visited = 0;
+      while (!queue.empty())
+      {
+         std::size_t t = queue.front();
+         queue.pop_front();
+         ++visited;
+         for (std::size_t d : dependents_[t])
+            if (--counts[d] == 0)
+               queue.push_back(d);
+      }
+      if (visited < n)
+         throw CMMError("Circular dependency between devices", MMERR_GENERIC);
+   }
+
+   typedef std::chrono::steady_clock Clock;
+   const Clock::time_point start = Clock::now();
+
+   std::mutex mutex;
+   std::condition_variable cv;
+   std::size_t finished = 0;
+   std::exception_ptr firstException;
+
+   auto worker = [&] {
+      std::unique_lock<std::mutex> lock(mutex);
+      for (;;)
+      {
+         cv.wait(lock, [&] {
+            return !ready.empty() || finished == n || firstException;
+         });
+         if (ready.empty() || firstException)
+            return;
+
+         std::size_t t = ready.front();
+         ready.pop_front();
+         lock.unlock();
+
+         const Clock::time_point taskStart = Clock::now();
+         std::exception_ptr ex;
+         try
+         {
+            task(t);
+         }
+         catch (...)
+         {
+            ex = std::current_exception();
+         }
+         const Clock::time_point taskEnd = Clock::now();
+
+         lock.lock();
+         ++finished;
+         TaskTiming& timing = timings_[t];
+         timing.ran = true;
+         timing.startMs = std::chrono::duration<double, std::milli>(taskStart - start).count();
+         timing.durationMs = std::chrono::duration<double, std::milli>(taskEnd - taskStart).count();
+         if (ex)
+         {
+            if (!firstException)
+               firstException = ex;
+            ready.clear();
+         }
+         else if (!firstException)
+         {
+            for (std::size_t d : dependents_[t])
+               if (--remainingDeps[d] == 0)
+                  ready.push_back(d);
+         }
+         cv.notify_all();
+      }
+   };
+
+   const std::size_t threadCount = std::max<std::size_t>(1, std::min(maxThreads, n));
+   std::vector<std::thread> threads;
+   for (std::size_t i = 1; i < threadCount; ++i)
+      threads.emplace_back(worker);
+   worker();
+   for (std::thread& th : threads)
+      th.join();
+
+   if (firstException)
+      std::rethrow_exception(firstException);
+}
+
+std::vector<std::size_t> DependencyScheduler::GetCriticalPath() const
+{
+   std::vector<std::size_t> path;
+   auto endMs = [this](std::size_t t) {
+      return timings_[t].startMs + timings_[t].durationMs;
+   };
+
+   bool found = false;
+   std::size_t last = 0;
+   for (std::size_t t = 0; t < timings_.size(); ++t)
+   {
+      if (timings_[t].ran && (!found || endMs(t) > endMs(last)))
+      {
+         last = t;
+         found = true;
+      }
+   }
+   if (!found)
+      return path;
+
+   for (;;)
+   {
+      path.push_back(last);
+      bool hasPredecessor = false;
+      std::size_t pred = 0;
+      for (std::size_t d : dependencies_[last])
+      {
+         if (timings_[d].ran && (!hasPredecessor || endMs(d) > endMs(pred)))
+         {
+            pred = d;
+            hasPredecessor = true;
+         }
+      }
+      if (!hasPredecessor)
+         break;
+      last = pred;
+   }
+   std::reverse(path.begin(), path.end());
+   return path;
+}
+
+} // namespace internal
+} // namespace mmcore
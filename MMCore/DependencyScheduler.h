@@ -0,0 +1,65 @@
+// DESCRIPTION:   Runs tasks with ordering dependencies on a bounded number of
+//                threads, recording when each task ran
+//
+// LICENSE:       This file is distributed under the "Lesser GPL" (LGPL) license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace mmcore {
+namespace internal {
+
+// Tasks are identified by index (0 to taskCount - 1). A task is started once
+// all the tasks it depends on have completed.
+class DependencyScheduler
+{
+public:
+   struct TaskTiming
+   {
+      bool ran = false;
+      double startMs = 0.0; // Relative to the start of Run()
+      double durationMs = 0.0;
+   };
+
+   explicit DependencyScheduler(std::size_t taskCount);
+
+   // Task 'after' will not start before task 'before' has completed
+   void AddDependency(std::size_t before, std::size_t after);
+
+   const std::vector<std::size_t>& GetDependencies(std::size_t task) const
+   { return dependencies_[task]; }
+
+   // Run every task, using at most maxThreads threads (including the calling
+   // thread). Once a task has thrown, no further tasks are started; the first
+   // exception is rethrown when the running tasks have finished. Throws
+   // CMMError (before running anything) if the dependencies are circular.
+   void Run(const std::function<void(std::size_t)>& task, std::size_t maxThreads);
+
+   // Timing of each task in the last Run()
+   const std::vector<TaskTiming>& GetTimings() const { return timings_; }
+
+   // The chain of tasks that determined the total time of the last Run():
+   // starting from the task that finished last, each preceding entry is the
+   // dependency of the next that finished last. In order of execution.
+   std::vector<std::size_t> GetCriticalPath() const;
+
+private:
+   std::vector<std::vector<std::size_t>> dependencies_;
+   std::vector<std::vector<std::size_t>> dependents_;
+   std::vector<TaskTiming> timings_;
+};
+
+} // namespace internal
+} // namespace mmcore
@@ -0,0 +1,274 @@
+// DESCRIPTION:   Optional tracing of calls into device adapters, exported in
+//                the Chrome trace event (JSON) format
+//
+// LICENSE:       This file is distributed under the "Lesser GPL" (LGPL) license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "DeviceCallTracer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace mmcore {
+namespace internal {
+
+namespace {
+
+std::atomic<std::uint64_t> nextTracerInstanceId{1};
+
+// Gives up this thread's buffers when the thread exits. Does not keep them
+// alive, since a tracer may be destroyed before the threads that used it.
+template <typename Buffer>
+class ThreadBufferOwner
+{
+   std::vector<std::weak_ptr<Buffer>> buffers_;
+
+public:
+   ~ThreadBufferOwner()
+   {
+      for (const auto& weak : buffers_)
+      {
+         if (auto buffer = weak.lock())
+            buffer->owned.store(false, std::memory_order_release);
+      }
+   }
+
+   void Add(const std::shared_ptr<Buffer>& buffer)
+   {
+      buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(),
+               [](const std::weak_ptr<Buffer>& b) { return b.expired(); }),
+            buffers_.end());
+      buffers_.push_back(buffer);
+   }
+};
+
+void WriteJSONString(std::ostream& out, std::string_view s)
+{
+   out << '"';
+   for (char ch : s)
+   {
+      switch (ch)
+      {
+         case '"': out << "\\\""; break;
+         case '\\': out << "\\\\"; break;
+         case '\n': out << "\\n"; break;
+         case '\r': out << "\\r"; break;
+         case '\t': out << "\\t"; break;
+         default:
+            if (static_cast<unsigned char>(ch) < 0x20)
+            {
+               char buf[8];
+               std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(ch));
+               out << buf;
+            }
+            else
+               out << ch;
+      }
+   }
+   out << '"';
+}
+
+// Microseconds with nanosecond resolution, as expected by trace viewers
+void WriteMicroseconds(std::ostream& out, std::chrono::nanoseconds d)
+{
+   const long long ns = d.count();
+   const long long absNs = ns < 0 ? -ns : ns;
+   char buf[32];
+   std::snprintf(buf, sizeof(buf), "%s%lld.%03lld", ns < 0 ? "-" : "",
+         absNs / 1000, absNs % 1000);
+   out << buf;
+}
+
+} // namespace
+
+DeviceCallTracer::DeviceCallTracer(std::size_t eventsPerThread) :
+   instanceId_(nextTracerInstanceId.fetch_add(1)),
+   eventsPerThread_(eventsPerThread),
+   epoch_(Clock::now())
+{
+}
+
+std::uint32_t DeviceCallTracer::InternLabel(const std::string& label)
+{
+   std::lock_guard<std::mutex> lock(labelsMutex_);
+   auto it = std::find(labels_.begin(), labels_.end(), label);
+   if (it != labels_.end())
+      return static_cast<std::uint32_t>(it - labels_.begin());
+   labels_.push_back(label);
+   return static_cast<std::uint32_t>(labels_.size() - 1);
+}
+
+DeviceCallTracer::ThreadBuffer& DeviceCallTracer::GetThreadBuffer()
+{
+   // Cache the buffer of the last tracer used on this thread, so that the
+   // common case does not lock. Instance ids, unlike addresses, are never
+   // reused.
+   thread_local std::uint64_t cachedInstanceId = 0;
+   thread_local ThreadBuffer* cachedBuffer = nullptr;
+   if (cachedInstanceId == instanceId_)
+      return *cachedBuffer;
+
+   thread_local ThreadBufferOwner<ThreadBuffer> owner;
+
+   std::lock_guard<std::mutex> lock(buffersMutex_);
+   const std::thread::id self = std::this_thread::get_id();
+   auto it = std::find_if(buffers_.begin(), buffers_.end(),
+         [&](const std::shared_ptr<ThreadBuffer>& b) {
+            return b->threadId == self && b->owned.load(std::memory_order_relaxed);
+         });
+   if (it == buffers_.end())
+   {
+      // Take over the buffer of an exited thread, keeping its events
+      it = std::find_if(buffers_.begin(), buffers_.end(),
+            [](const std::shared_ptr<ThreadBuffer>& b) {
+               return !b->owned.load(std::memory_order_acquire);
+            });
+      if (it != buffers_.end())
+      {
+         (*it)->threadId = self;
+         (*it)->owned.store(true, std::memory_order_relaxed);
+      }
+      else
+      {
+         auto buffer = std::make_shared<ThreadBuffer>();
+         buffer->threadId = self;
+         buffer->traceThreadId = nextTraceThreadId_++;
+         buffer->events = std::make_unique<Event[]>(eventsPerThread_);
+         buffers_.push_back(std::move(buffer));
+         it = buffers_.end() - 1;
+      }
+      owner.Add(*it);
+   }
+   cachedInstanceId = instanceId_;
+   cachedBuffer = it->get();
+   return *cachedBuffer;
+}
+
+void DeviceCallTracer::Record(EventKind kind, std::uint32_t labelId,
+      const char* method, std::string_view detail, Clock::time_point start,
+      Clock::time_point end)
+{
+   ThreadBuffer& buffer = GetThreadBuffer();
+   // Only this thread appends to the buffer, so the count can only change
+   // under us by Clear()
+   std::size_t n = buffer.count.load(std::memory_order_relaxed);
+   if (n >= eventsPerThread_)
+   {
+      buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+   }
+   Event& e = buffer.events[n];
+   e.start = start;
+   e.end = end;
+   e.method = method;
+   e.labelId = labelId;
+   e.kind = kind;
+   const std::size_t len = std::min(detail.size(), sizeof(e.detail) - 1);
+   std::memcpy(e.detail, detail.data(), len);
+   e.detail[len] = '\0';
+   // If Clear() ran since we read the count, discard the event rather than
+   // bringing back the cleared events before it
+   buffer.count.compare_exchange_strong(n, n + 1, std::memory_order_release,
+         std::memory_order_relaxed);
+}
+
+void DeviceCallTracer::Clear()
+{
+   std::lock_guard<std::mutex> lock(buffersMutex_);
+   buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(),
+            [](const std::shared_ptr<ThreadBuffer>& b) {
+               return !b->owned.load(std::memory_order_acquire);
+            }),
+         buffers_.end());
+   for (auto& buffer : buffers_)
+   {
+      buffer->count.store(0, std::memory_order_relaxed);
+      buffer->dropped.store(0, std::memory_order_relaxed);
+   }
+}
+
+std::size_t DeviceCallTracer::GetThreadBufferCount() const
+{
+   std::lock_guard<std::mutex> lock(buffersMutex_);
+   return buffers_.size();
+}
+
+std::size_t DeviceCallTracer::GetEventCount() const
+{
+   std::lock_guard<std::mutex> lock(buffersMutex_);
+   std::size_t total = 0;
+   for (const auto& buffer : buffers_)
+      total += buffer->count.load(std::memory_order_acquire);
+   return total;
+}
+
+std::uint64_t DeviceCallTracer::GetDroppedEventCount() const
+{
+   std::lock_guard<std::mutex> lock(buffersMutex_);
+   std::uint64_t total = 0;
+   for (const auto& buffer : buffers_)
+      total += buffer->dropped.load(std::memory_order_relaxed);
+   return total;
+}
+
+void DeviceCallTracer::WriteChromeTrace(std::ostream& out) const
+{
+   std::vector<std::string> labels;
+   {
+      std::lock_guard<std::mutex> lock(labelsMutex_);
+      labels = labels_;
+   }
+
+   std::lock_guard<std::mutex> lock(buffersMutex_);
+   std::uint64_t dropped = 0;
+
+   out << "{\"traceEvents\":[\n";
+   out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+      "\"args\":{\"name\":\"MMCore\"}}";
+   for (const auto& buffer : buffers_)
+   {
+      out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" <<
+         buffer->traceThreadId << ",\"args\":{\"name\":\"Thread " <<
+         buffer->traceThreadId << "\"}}";
+
+      const std::size_t n = buffer->count.load(std::memory_order_acquire);
+      dropped += buffer->dropped.load(std::memory_order_relaxed);
+      for (std::size_t i = 0; i < n; ++i)
+      {
+         const Event& e = buffer->events[i];
+         const std::string_view label = e.labelId < labels.size() ?
+            std::string_view(labels[e.labelId]) : std::string_view();
+         out << ",\n{\"name\":";
+         WriteJSONString(out, e.method);
+         out << ",\"cat\":\"" <<
+            (e.kind == EventKind::LockWait ? "lock" : "device") <<
+            "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->traceThreadId <<
+            ",\"ts\":";
+         WriteMicroseconds(out, e.start - epoch_);
+         out << ",\"dur\":";
+         WriteMicroseconds(out, e.end - e.start);
+         out << ",\"args\":{\"device\":";
+         WriteJSONString(out, label);
+         if (e.detail[0] != '\0')
+         {
+            out << ",\"detail\":";
+            WriteJSONString(out, e.detail);
+         }
+         out << "}}";
+      }
+   }
+   out << "\n],\n\"displayTimeUnit\":\"ms\",\n"
+      "\"otherData\":{\"droppedEvents\":" << dropped << "}}\n";
+}
+
+} // namespace internal
+} // namespace mmcore
@@ -0,0 +1,141 @@
+// DESCRIPTION:   Optional tracing of calls into device adapters, exported in
+//                the Chrome trace event (JSON) format
+//
+// LICENSE:       This file is distributed under the "Lesser GPL" (LGPL) license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace mmcore {
+namespace internal {
+
+// Records calls into devices, and waits for device (module) locks, while
+// enabled.
+//
+// Each thread records into its own fixed-capacity buffer, without locking;
+// events arriving at a full buffer are counted as dropped. The buffers are
+// kept (and can be written out) after their threads exit, and are handed on
+// to threads that start tracing later, so that there are only as many
+// buffers as threads that have traced at the same time. Clear() frees the
+// buffers of exited threads.
+class DeviceCallTracer
+{
+public:
+   using Clock = std::chrono::steady_clock;
+
+   enum class EventKind : std::uint8_t
+   {
+      Call,
+      LockWait,
+   };
+
+   struct Event
+   {
+      Clock::time_point start;
+      Clock::time_point end;
+      const char* method; // Static string
+      std::uint32_t labelId;
+      EventKind kind;
+      char detail[39]; // Truncated, null-terminated
+   };
+
+   // Records a call event on destruction, unless default-constructed
+   class Scope
+   {
+      DeviceCallTracer* tracer_ = nullptr;
+      std::uint32_t labelId_ = 0;
+      const char* method_ = nullptr;
+      std::string_view detail_;
+      Clock::time_point start_;
+
+   public:
+      Scope() = default;
+      Scope(DeviceCallTracer* tracer, std::uint32_t labelId,
+            const char* method, std::string_view detail) :
+         tracer_(tracer), labelId_(labelId), method_(method),
+         detail_(detail), start_(Clock::now())
+      {}
+      ~Scope()
+      {
+         if (tracer_)
+            tracer_->Record(EventKind::Call, labelId_, method_, detail_,
+                  start_, Clock::now());
+      }
+
+      Scope(const Scope&) = delete;
+      Scope& operator=(const Scope&) = delete;
+   };
+
+   explicit DeviceCallTracer(std::size_t eventsPerThread = 32768);
+
+   void Enable(bool enable) { enabled_.store(enable, std::memory_order_relaxed); }
+   bool IsEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+   // Returns a small integer identifying the label in recorded events
+   std::uint32_t InternLabel(const std::string& label);
+
+   void Record(EventKind kind, std::uint32_t labelId, const char* method,
+         std::string_view detail, Clock::time_point start,
+         Clock::time_point end);
+
+   // Discards recorded events. Events being recorded concurrently may or may
+   // not be discarded.
+   void Clear();
+
+   std::size_t GetThreadBufferCount() const;
+   std::size_t GetEventCount() const;
+   std::uint64_t GetDroppedEventCount() const;
+
+   // Writes the recorded events as a Chrome trace (JSON object format),
+   // which can be viewed in Perfetto or chrome://tracing
+   void WriteChromeTrace(std::ostream& out) const;
+
+private:
+   struct ThreadBuffer
+   {
+      std::thread::id threadId;
+      unsigned traceThreadId;
+      std::unique_ptr<Event[]> events;
+      std::atomic<std::size_t> count{0};
+      std::atomic<std::uint64_t> dropped{0};
+      // Cleared when the thread exits; the buffer can then be reused
+      std::atomic<bool> owned{true};
+   };
+
+   ThreadBuffer& GetThreadBuffer();
+
+   const std::uint64_t instanceId_;
+   const std::size_t eventsPerThread_;
+   const Clock::time_point epoch_;
+   std::atomic<bool> enabled_{false};
+
+   mutable std::mutex buffersMutex_;
+   std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+   unsigned nextTraceThreadId_ = 1;
+
+   mutable std::mutex labelsMutex_;
+   std::vector<std::string> labels_;
+};
+
+} // namespace internal
+} // namespace mmcore
@@ -0,0 +1,63 @@
+// DESCRIPTION:   Handle to a loaded device, for calling the Core without a
+//                label lookup.
+//
+// LICENSE:       This file is distributed under the "Lesser GPL" (LGPL)
+//                license. License text is included with the source
+//                distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+
+class CMMCore;
+
+namespace mmcore {
+namespace internal {
+   class DeviceInstance;
+} // namespace internal
+} // namespace mmcore
+
+/// Opaque reference to a loaded device.
+/**
+ * Obtained with CMMCore::getDeviceHandle() and accepted in place of the
+ * device label by the frequently called CMMCore methods (positions,
+ * properties, state, exposure), which then skip the label lookup.
+ *
+ * A handle refers to the device instance, not to its label: it becomes
+ * invalid when the device is unloaded, and remains invalid even if a device
+ * is later loaded under the same label. Using an invalid handle throws
+ * CMMError. A default-constructed handle is invalid.
+ */
+class DeviceHandle
+{
+   friend class CMMCore;
+
+public:
+   DeviceHandle() = default;
+
+   /// The label of the device that the handle refers to.
+   std::string getLabel() const { return label_; }
+
+   /// Whether the device is still loaded.
+   bool isValid() const { return !device_.expired(); }
+
+private:
+   DeviceHandle(std::weak_ptr<mmcore::internal::DeviceInstance> device,
+         std::string label) :
+      device_(std::move(device)),
+      label_(std::move(label))
+   {}
+
+   std::weak_ptr<mmcore::internal::DeviceInstance> device_;
+   std::string label_;
+};
@@ -43,12 +43,17 @@ DeviceManager::LoadDevice(std::shared_ptr<LoadedDeviceAdapter> module,
 {
    // For now, "Core" (which always exists) is not a real-enough device to be
    // in 'devices_'; check as a special case.
-   if (std::find_if(devices_.begin(), devices_.end(),
-         [&](const auto& p) { return p.first == label; }) != devices_.end() ||
-      label == MM::g_Keyword_CoreDevice)
+   auto throwIfLabelInUse = [&]
    {
-      throw CMMError("The specified device label " + ToQuotedString(label) +
-         " is already in use", MMERR_DuplicateLabel);
+      if (labelIndex_.count(label) || label == MM::g_Keyword_CoreDevice)
+      {
+         throw CMMError("The specified device label " + ToQuotedString(label) +
+            " is already in use", MMERR_DuplicateLabel);
+      }
+   };
+   {
+      std::shared_lock<std::shared_mutex> lock(mutex_);
+      throwIfLabelInUse();
    }
 
    std::shared_ptr<DeviceInstance> device = module->LoadDevice(core,
@@ -73,7 +78,12 @@ DeviceManager::LoadDevice(std::shared_ptr<LoadedDeviceAdapter> module,
       device->SetDescription(description);
    }
 
+   // Check again, in case the label was taken while we were creating the
+   // device
+   std::unique_lock<std::shared_mutex> lock(mutex_);
+   throwIfLabelInUse();
    devices_.push_back(std::make_pair(label, device));
+   labelIndex_.emplace(label, device);
    deviceRawPtrIndex_.insert(std::make_pair(device->GetRawPtr(), device));
    return device;
 }
@@ -85,16 +95,23 @@ DeviceManager::UnloadDevice(std::shared_ptr<DeviceInstance> device)
    if (device == 0)
       return;
 
-   for (DeviceIterator it = devices_.begin(), end = devices_.end(); it != end; ++it)
    {
-      if (it->second == device)
-      {
-         device->Shutdown(); // TODO Should be automatic
-         deviceRawPtrIndex_.erase(it->second->GetRawPtr());
-         devices_.erase(it);
-         break;
-      }
+      std::shared_lock<std::shared_mutex> lock(mutex_);
+      if (std::find_if(devices_.begin(), devices_.end(),
+            [&](const auto& p) { return p.second == device; }) == devices_.end())
+         return;
    }
+
+   device->Shutdown(); // TODO Should be automatic
+
+   std::unique_lock<std::shared_mutex> lock(mutex_);
+   DeviceIterator it = std::find_if(devices_.begin(), devices_.end(),
+         [&](const auto& p) { return p.second == device; });
+   if (it == devices_.end())
+      return;
+   labelIndex_.erase(it->first);
+   deviceRawPtrIndex_.erase(device->GetRawPtr());
+   devices_.erase(it);
 }
 
 
@@ -110,7 +127,8 @@ DeviceManager::UnloadAllDevices()
 
    std::vector< std::shared_ptr<DeviceInstance> > nonSerialDevices;
    std::vector< std::shared_ptr<DeviceInstance> > serialDevices;
-   for (DeviceIterator it = devices_.begin(), end = devices_.end(); it != end; ++it)
+   const DeviceList devices = GetDevicesInLoadOrder();
+   for (DeviceConstIterator it = devices.begin(), end = devices.end(); it != end; ++it)
    {
       if (it->second->GetType() == MM::SerialDevice)
       {
@@ -140,8 +158,12 @@ DeviceManager::UnloadAllDevices()
       (*it)->Shutdown();
    }
 
-   deviceRawPtrIndex_.clear();
-   devices_.clear();
+   {
+      std::unique_lock<std::shared_mutex> lock(mutex_);
+      deviceRawPtrIndex_.clear();
+      labelIndex_.clear();
+      devices_.clear();
+   }
 
    // Now the only remaining references to the device objects should be in
    // serialDevices and nonSerialDevices. Release the devices in order.
@@ -156,31 +178,16 @@ DeviceManager::UnloadAllDevices()
 }
 
 
-namespace
-{
-   class DevicePairMatcheslabel
-   {
-      std::string s_;
-   public:
-      DevicePairMatcheslabel(const std::string& s) : s_(s) {}
-      bool operator()(const std::pair< std::string,
-            std::shared_ptr<DeviceInstance> >& p) const
-      { return p.first == s_; }
-   };
-} // anonymous namespace
-
-
 std::shared_ptr<DeviceInstance>
 DeviceManager::GetDevice(const std::string& label) const
 {
-   DeviceConstIterator found =
-      std::find_if(devices_.begin(), devices_.end(),
-            DevicePairMatcheslabel(label));
-   if (found == devices_.end())
    {
-      throw CMMError("No device with label " + ToQuotedString(label));
+      std::shared_lock<std::shared_mutex> lock(mutex_);
+      auto found = labelIndex_.find(label);
+      if (found != labelIndex_.end())
+         return found->second;
    }
-   return found->second;
+   throw CMMError("No device with label " + ToQuotedString(label));
 }
 
 
@@ -199,6 +206,7 @@ std::shared_ptr<DeviceInstance>
 DeviceManager::GetDevice(const MM::Device* rawPtr) const
 {
    typedef std::map< const MM::Device*, std::weak_ptr<DeviceInstance> >::const_iterator Iterator;
+   std::shared_lock<std::shared_mutex> lock(mutex_);
    Iterator it = deviceRawPtrIndex_.find(rawPtr);
    if (it == deviceRawPtrIndex_.end())
       throw CMMError("Invalid device pointer");
@@ -210,7 +218,8 @@ std::vector<std::string>
 DeviceManager::GetDeviceList(MM::DeviceType type) const
 {
    std::vector<std::string> labels;
-   for (DeviceConstIterator it = devices_.begin(), end = devices_.end(); it != end; ++it)
+   const DeviceList devices = GetDevicesInLoadOrder();
+   for (DeviceConstIterator it = devices.begin(), end = devices.end(); it != end; ++it)
    {
       if (type == MM::AnyType || it->second->GetType() == type)
       {
@@ -239,7 +248,8 @@ DeviceManager::GetLoadedPeripherals(const char* label) const
       return labels;
    }
 
-   for (DeviceConstIterator it = devices_.begin(), end = devices_.end(); it != end; ++it)
+   const DeviceList devices = GetDevicesInLoadOrder();
+   for (DeviceConstIterator it = devices.begin(), end = devices.end(); it != end; ++it)
    {
       std::string parentID = it->second->GetParentID();
       if (parentID == label)
@@ -256,6 +266,7 @@ std::shared_ptr<HubInstance>
 DeviceManager::GetParentDevice(std::shared_ptr<DeviceInstance> device) const
 {
    std::string parentLabel = device->GetParentID();
+   const DeviceList devices = GetDevicesInLoadOrder();
 
    if (parentLabel.empty())
    {
@@ -263,7 +274,7 @@ DeviceManager::GetParentDevice(std::shared_ptr<DeviceInstance> device) const
       // TODO So what happens if there is more than one hub in a given device
       // adapter? Answer: bad things.
       std::shared_ptr<HubInstance> parentHub;
-      for (DeviceConstIterator it = devices_.begin(), end = devices_.end(); it != end; ++it)
+      for (DeviceConstIterator it = devices.begin(), end = devices.end(); it != end; ++it)
       {
          if (it->second->GetType() == MM::HubDevice &&
                device->GetAdapterModule() == it->second->GetAdapterModule())
@@ -278,7 +289,7 @@ DeviceManager::GetParentDevice(std::shared_ptr<DeviceInstance> device) const
    }
    else
    {
-      for (DeviceConstIterator it = devices_.begin(), end = devices_.end(); it != end; ++it)
+      for (DeviceConstIterator it = devices.begin(), end = devices.end(); it != end; ++it)
       {
          if (it->first == parentLabel &&
                it->second->GetType() == MM::HubDevice &&
@@ -293,10 +304,49 @@ DeviceManager::GetParentDevice(std::shared_ptr<DeviceInstance> device) const
 }
 
 
+DeviceManager::DeviceList
+DeviceManager::GetDevicesInLoadOrder() const
+{
+   std::shared_lock<std::shared_mutex> lock(mutex_);
+   return devices_;
+}
+
+
 DeviceModuleLockGuard::DeviceModuleLockGuard(std::shared_ptr<DeviceInstance> device) :
-   g_(device->GetAdapterModule()->GetLock())
+   g_(Acquire(device), std::adopt_lock)
 {}
 
 
+std::recursive_mutex&
+DeviceModuleLockGuard::Acquire(const std::shared_ptr<DeviceInstance>& device)
+{
+   std::recursive_mutex& lock = GetLock(device);
+   DeviceCallTracer* tracer = device->GetActiveCallTracer();
+   if (!tracer)
+   {
+      lock.lock();
+      return lock;
+   }
+   if (lock.try_lock())
+      return lock;
+   const auto start = DeviceCallTracer::Clock::now();
+   lock.lock();
+   tracer->Record(DeviceCallTracer::EventKind::LockWait,
+         device->GetTraceLabelId(), "Lock wait", {}, start,
+         DeviceCallTracer::Clock::now());
+   return lock;
+}
+
+
+std::recursive_mutex&
+DeviceModuleLockGuard::GetLock(const std::shared_ptr<DeviceInstance>& device)
+{
+   std::shared_ptr<LoadedDeviceAdapter> module = device->GetAdapterModule();
+   if (module->UsesPerDeviceLocking())
+      return device->GetDeviceLock();
+   return module->GetLock();
+}
+
+
 } // namespace internal
 } // namespace mmcore
@@ -27,7 +27,9 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 class CMMCore;
@@ -41,19 +43,30 @@ class HubInstance;
 
 class DeviceManager /* final */
 {
-   // Store devices in an ordered container. We could use a map or hash map to
-   // retrieve by name, but the number of devices is so small that it is not
-   // known to be worth it.
-   std::vector< std::pair<std::string, std::shared_ptr<DeviceInstance> > > devices_;
-   typedef std::vector< std::pair<std::string, std::shared_ptr<DeviceInstance> > >::const_iterator
-      DeviceConstIterator;
-   typedef std::vector< std::pair<std::string, std::shared_ptr<DeviceInstance> > >::iterator
-      DeviceIterator;
+   // Devices in load order (which determines the order of GetDeviceList()
+   // and of unloading), plus a hash index by label. Labels are looked up on
+   // nearly every core API call, so the lookup should not scale with the
+   // number of loaded devices.
+   typedef std::vector< std::pair<std::string, std::shared_ptr<DeviceInstance> > >
+      DeviceList;
+   typedef DeviceList::const_iterator DeviceConstIterator;
+   typedef DeviceList::iterator DeviceIterator;
+   DeviceList devices_;
+   std::unordered_map< std::string, std::shared_ptr<DeviceInstance> > labelIndex_;
 
    // Map raw device pointers to DeviceInstance objects, for those few places
    // where we need to retrieve device information from raw pointers.
    std::map< const MM::Device*, std::weak_ptr<DeviceInstance> > deviceRawPtrIndex_;
 
+   // Guards the containers above. Lookups take a shared lock, so that they
+   // do not serialize calls from different threads; loading and unloading
+   // take an exclusive lock. Never held while calling into a device (device
+   // code may call back into the core, which looks up devices).
+   mutable std::shared_mutex mutex_;
+
+   // Copy of devices_, for iterating without holding the lock
+   DeviceList GetDevicesInLoadOrder() const;
+
 public:
    ~DeviceManager();
 
@@ -134,12 +147,22 @@ public:
 };
 
 
-// Scoped acquisition of a device's module's lock
+// Scoped acquisition of a device's module's lock (or of the device's own lock
+// if its module uses per-device locking)
 class DeviceModuleLockGuard
 {
    std::lock_guard<std::recursive_mutex> g_;
 public:
    explicit DeviceModuleLockGuard(std::shared_ptr<DeviceInstance> device);
+
+   // The lock that the guard acquires for the device. Devices sharing a lock
+   // cannot be called concurrently.
+   static std::recursive_mutex& GetLock(const std::shared_ptr<DeviceInstance>& device);
+
+private:
+   // Locks, recording the wait in the device's call trace if the lock was
+   // contended and tracing is enabled
+   static std::recursive_mutex& Acquire(const std::shared_ptr<DeviceInstance>& device);
 };
 
 } // namespace internal
@@ -46,6 +46,32 @@ DeviceInstance::LogMessage(const char* msg, bool debugOnly)
    return DEVICE_OK;
 }
 
+unsigned long long
+DeviceInstance::GetBusyChangeCount()
+{
+   std::lock_guard<std::mutex> lock(busyChangeMutex_);
+   return busyChangeCount_;
+}
+
+void
+DeviceInstance::NotifyBusyChanged()
+{
+   {
+      std::lock_guard<std::mutex> lock(busyChangeMutex_);
+      ++busyChangeCount_;
+   }
+   busyChangeCv_.notify_all();
+}
+
+bool
+DeviceInstance::WaitForBusyChange(unsigned long long sinceCount,
+      std::chrono::steady_clock::time_point deadline)
+{
+   std::unique_lock<std::mutex> lock(busyChangeMutex_);
+   return busyChangeCv_.wait_until(lock, deadline,
+         [&] { return busyChangeCount_ != sinceCount; });
+}
+
 
 DeviceInstance::DeviceInstance(CMMCore* core,
       std::shared_ptr<LoadedDeviceAdapter> adapter,
@@ -152,6 +178,38 @@ DeviceInstance::RequireInitialized(const char* operation) const
    }
 }
 
+void
+DeviceInstance::SetCallTracer(std::shared_ptr<DeviceCallTracer> tracer)
+{
+   callTracer_ = tracer;
+   if (callTracer_)
+      traceLabelId_ = callTracer_->InternLabel(label_);
+}
+
+DeviceCallTracer*
+DeviceInstance::GetActiveCallTracer() const
+{
+   if (callTracer_ && callTracer_->IsEnabled())
+      return callTracer_.get();
+   return nullptr;
+}
+
+DeviceCallTracer::Scope
+DeviceInstance::TraceCall(const char* method, std::string_view detail) const
+{
+   DeviceCallTracer* tracer = GetActiveCallTracer();
+   if (!tracer)
+      return {};
+   return DeviceCallTracer::Scope(tracer, traceLabelId_, method, detail);
+}
+
+DeviceCallTracer::Scope
+DeviceInstance::BeginCall(const char* method) const
+{
+   RequireInitialized(method);
+   return TraceCall(method);
+}
+
 void
 DeviceInstance::DeviceStringBuffer::ThrowBufferOverflowError() const
 {
@@ -179,6 +237,7 @@ DeviceInstance::GetNumberOfProperties() const
 std::string
 DeviceInstance::GetProperty(const std::string& name) const
 {
+   const auto trace = TraceCall("GetProperty", name);
    DeviceStringBuffer valueBuf(this, "GetProperty");
    int err = pImpl_->GetProperty(name.c_str(), valueBuf.GetBuffer());
    ThrowIfError(err, "Cannot get value of property " +
@@ -187,8 +246,7 @@ DeviceInstance::GetProperty(const std::string& name) const
 }
 
 void
-DeviceInstance::SetProperty(const std::string& name,
-      const std::string& value) const
+DeviceInstance::CheckPropertySettable(const std::string& name) const
 {
    if (initialized_ && GetPropertyInitStatus(name.c_str())) {
       // Note: Some features (port scanning) may depend on setting serial port
@@ -204,6 +262,14 @@ DeviceInstance::SetProperty(const std::string& name,
             ") not permitted on initialized device (this will be an error in a future version of MMCore; for now we continue with the operation anyway, even though it might not be safe)";
       }
    }
+}
+
+void
+DeviceInstance::SetProperty(const std::string& name,
+      const std::string& value) const
+{
+   const auto trace = TraceCall("SetProperty", name);
+   CheckPropertySettable(name);
 
    LOG_DEBUG(Logger()) << "Will set property \"" << name << "\" to \"" <<
       value << "\"";
@@ -217,6 +283,60 @@ DeviceInstance::SetProperty(const std::string& name,
       value << "\"";
 }
 
+template <typename T>
+std::optional<T>
+DeviceInstance::GetPropertyNumeric(const std::string& name,
+      int (MM::Device::*getter)(const char*, T&) const) const
+{
+   const auto trace = TraceCall("GetProperty", name);
+   T value{};
+   int err = (pImpl_->*getter)(name.c_str(), value);
+   if (err == DEVICE_INVALID_PROPERTY_TYPE)
+      return std::nullopt;
+   ThrowIfError(err, "Cannot get value of property " +
+         ToQuotedString(name));
+   return value;
+}
+
+template <typename T>
+bool
+DeviceInstance::SetPropertyNumeric(const std::string& name, T value,
+      int (MM::Device::*setter)(const char*, T)) const
+{
+   const auto trace = TraceCall("SetProperty", name);
+   CheckPropertySettable(name);
+
+   LOG_DEBUG(Logger()) << "Will set property \"" << name << "\" to " <<
+      value;
+
+   int err = (pImpl_->*setter)(name.c_str(), value);
+   if (err == DEVICE_INVALID_PROPERTY_TYPE)
+      return false;
+
+   ThrowIfError(err, "Cannot set property " + ToQuotedString(name) +
+         " to " + ToString(value));
+
+   LOG_DEBUG(Logger()) << "Did set property \"" << name << "\" to " <<
+      value;
+   return true;
+}
+
+std::optional<double>
+DeviceInstance::GetPropertyDouble(const std::string& name) const
+{ return GetPropertyNumeric(name, &MM::Device::GetPropertyDouble); }
+
+bool
+DeviceInstance::SetPropertyDouble(const std::string& name, double value) const
+{ return SetPropertyNumeric(name, value, &MM::Device::SetPropertyDouble); }
+
+std::optional<long>
+DeviceInstance::GetPropertyLong(const std::string& name) const
+{ return GetPropertyNumeric(name, &MM::Device::GetPropertyLong); }
+
+bool
+DeviceInstance::SetPropertyLong(const std::string& name, long value) const
+{ return SetPropertyNumeric(name, value, &MM::Device::SetPropertyLong); }
+
 bool
 DeviceInstance::HasProperty(const std::string& name) const
 { return pImpl_->HasProperty(name.c_str()); }
@@ -362,10 +482,18 @@ DeviceInstance::GetErrorText(int code) const
 bool
 DeviceInstance::Busy()
 {
-   RequireInitialized(__func__);
+   const auto trace = BeginCall(__func__);
    return pImpl_->Busy();
 }
 
+bool
+DeviceInstance::UsesOnBusyChanged() const
+{
+   bool result = false;
+   ThrowIfError(pImpl_->UsesOnBusyChanged(result));
+   return result;
+}
+
 double
 DeviceInstance::GetDelayMs() const
 { return pImpl_->GetDelayMs(); }
@@ -385,6 +513,7 @@ DeviceInstance::Initialize()
    if (initializeCalled_)
       ThrowError("Device already initialized (or initialization already attempted)");
    initializeCalled_ = true;
+   const auto trace = TraceCall(__func__);
    ThrowIfError(pImpl_->Initialize());
    initialized_ = true;
 }
@@ -394,6 +523,7 @@ DeviceInstance::Shutdown()
 {
    // Note we do not require device to be initialized before calling Shutdown().
    initialized_ = false;
+   const auto trace = TraceCall(__func__);
    ThrowIfError(pImpl_->Shutdown());
 }
 
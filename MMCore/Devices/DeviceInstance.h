@@ -19,14 +19,18 @@
 
 #pragma once
 
+#include "../DeviceCallTracer.h"
 #include "../Error.h"
 #include "../Logging/Logger.h"
 
 #include "MMDeviceConstants.h"
 
+#include <chrono>
+#include <condition_variable>
 #include <cstring>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <vector>
@@ -83,6 +87,15 @@ private:
    bool initializeCalled_ = false;
    bool initialized_ = false;
    std::optional<long> timeoutMsOverride_{};
+   std::shared_ptr<DeviceCallTracer> callTracer_;
+   std::uint32_t traceLabelId_ = 0;
+
+   // Used instead of the module lock if the module uses per-device locking
+   std::recursive_mutex deviceLock_;
+
+   std::mutex busyChangeMutex_;
+   std::condition_variable busyChangeCv_;
+   unsigned long long busyChangeCount_ = 0;
 
 public:
    DeviceInstance(const DeviceInstance&) = delete;
@@ -98,6 +111,14 @@ public:
    // need it for the few CoreCallback methods that return a device pointer.
    MM::Device* GetRawPtr() const /* final */ { return pImpl_; }
 
+   std::recursive_mutex& GetDeviceLock() /* final */ { return deviceLock_; }
+
+   // Should be set before the device is used from multiple threads
+   void SetCallTracer(std::shared_ptr<DeviceCallTracer> tracer) /* final */;
+   // Returns null unless tracing is enabled
+   DeviceCallTracer* GetActiveCallTracer() const /* final */;
+   std::uint32_t GetTraceLabelId() const /* final */ { return traceLabelId_; }
+
    // Callback API
    int LogMessage(const char* msg, bool debugOnly);
 
@@ -108,6 +129,15 @@ public:
    void SetTimeoutMsOverride(long ms) /* final */ { timeoutMsOverride_ = ms; }
    void ClearTimeoutMsOverride() /* final */ { timeoutMsOverride_.reset(); }
 
+   // Busy-changed signaling (see MM::Core::OnBusyChanged()). Waiters should
+   // read the count before checking Busy(), so that a notification arriving
+   // in between is not missed.
+   unsigned long long GetBusyChangeCount();
+   void NotifyBusyChanged();
+   // Returns false if the deadline was reached without a notification.
+   bool WaitForBusyChange(unsigned long long sinceCount,
+         std::chrono::steady_clock::time_point deadline);
+
 protected:
    // The DeviceInstance object owns the raw device pointer (pDevice) as soon
    // as the constructor is called, even if the constructor throws.
@@ -134,6 +164,22 @@ protected:
    void ThrowIfError(int code, const std::string& message) const;
    void RequireInitialized(const char *) const;
 
+   // Call at the start of a device call to trace it until the returned
+   // scope is destroyed. BeginCall() also requires initialization.
+   DeviceCallTracer::Scope TraceCall(const char* method,
+         std::string_view detail = {}) const;
+   DeviceCallTracer::Scope BeginCall(const char* method) const;
+
+private:
+   void CheckPropertySettable(const std::string& name) const;
+   template <typename T>
+   std::optional<T> GetPropertyNumeric(const std::string& name,
+         int (MM::Device::*getter)(const char*, T&) const) const;
+   template <typename T>
+   bool SetPropertyNumeric(const std::string& name, T value,
+         int (MM::Device::*setter)(const char*, T)) const;
+
+protected:
    /// Utility class for getting fixed-length strings from the device interface.
    /**
     * This class should be used in all places where a device member function
@@ -201,6 +247,12 @@ private:
 public:
    std::string GetProperty(const std::string& name) const;
    void SetProperty(const std::string& name, const std::string& value) const;
+   // The numeric accessors return nullopt/false if the property must be
+   // accessed as a string instead.
+   std::optional<double> GetPropertyDouble(const std::string& name) const;
+   bool SetPropertyDouble(const std::string& name, double value) const;
+   std::optional<long> GetPropertyLong(const std::string& name) const;
+   bool SetPropertyLong(const std::string& name, long value) const;
    bool HasProperty(const std::string& name) const;
 private:
    // Exposed through GetPropertyNames() only
@@ -223,6 +275,7 @@ public:
    void SendPropertySequence(const char* propertyName);
    std::string GetErrorText(int code) const;
    bool Busy();
+   bool UsesOnBusyChanged() const;
    double GetDelayMs() const;
    void SetDelayMs(double delay);
    bool UsesDelay();
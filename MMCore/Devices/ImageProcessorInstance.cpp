@@ -25,7 +25,7 @@
 namespace mmcore {
 namespace internal {
 
-int ImageProcessorInstance::Process(unsigned char* buffer, unsigned width, unsigned height, unsigned byteDepth) { RequireInitialized(__func__); return GetImpl()->Process(buffer, width, height, byteDepth); }
+int ImageProcessorInstance::Process(unsigned char* buffer, unsigned width, unsigned height, unsigned byteDepth) { const auto trace = BeginCall(__func__); return GetImpl()->Process(buffer, width, height, byteDepth); }
 
 } // namespace internal
 } // namespace mmcore
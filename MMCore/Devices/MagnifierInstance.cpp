@@ -25,7 +25,7 @@
 namespace mmcore {
 namespace internal {
 
-double MagnifierInstance::GetMagnification() { RequireInitialized(__func__); return GetImpl()->GetMagnification(); }
+double MagnifierInstance::GetMagnification() { const auto trace = BeginCall(__func__); return GetImpl()->GetMagnification(); }
 
 } // namespace internal
 } // namespace mmcore
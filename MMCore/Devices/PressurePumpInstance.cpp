@@ -26,11 +26,11 @@ namespace mmcore {
 namespace internal {
 
 // General pump functions
-int PressurePumpInstance::Stop() { RequireInitialized(__func__); return GetImpl()->Stop(); }
-int PressurePumpInstance::Calibrate() { RequireInitialized(__func__); return GetImpl()->Calibrate(); }
-bool PressurePumpInstance::RequiresCalibration() { RequireInitialized(__func__); return GetImpl()->RequiresCalibration(); }
-int PressurePumpInstance::SetPressureKPa(double pressure) { RequireInitialized(__func__); return GetImpl()->SetPressureKPa(pressure); }
-int PressurePumpInstance::GetPressureKPa(double& pressure) { RequireInitialized(__func__); return GetImpl()->GetPressureKPa(pressure); }
+int PressurePumpInstance::Stop() { const auto trace = BeginCall(__func__); return GetImpl()->Stop(); }
+int PressurePumpInstance::Calibrate() { const auto trace = BeginCall(__func__); return GetImpl()->Calibrate(); }
+bool PressurePumpInstance::RequiresCalibration() { const auto trace = BeginCall(__func__); return GetImpl()->RequiresCalibration(); }
+int PressurePumpInstance::SetPressureKPa(double pressure) { const auto trace = BeginCall(__func__); return GetImpl()->SetPressureKPa(pressure); }
+int PressurePumpInstance::GetPressureKPa(double& pressure) { const auto trace = BeginCall(__func__); return GetImpl()->GetPressureKPa(pressure); }
 
 } // namespace internal
 } // namespace mmcore
\ No newline at end of file
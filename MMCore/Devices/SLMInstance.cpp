@@ -25,29 +25,29 @@
 namespace mmcore {
 namespace internal {
 
-int SLMInstance::SetImage(unsigned char* pixels) { RequireInitialized(__func__); return GetImpl()->SetImage(pixels); }
-int SLMInstance::SetImage(unsigned int* pixels) { RequireInitialized(__func__); return GetImpl()->SetImage(pixels); }
-int SLMInstance::DisplayImage() { RequireInitialized(__func__); return GetImpl()->DisplayImage(); }
-int SLMInstance::SetPixelsTo(unsigned char intensity) { RequireInitialized(__func__); return GetImpl()->SetPixelsTo(intensity); }
-int SLMInstance::SetPixelsTo(unsigned char red, unsigned char green, unsigned char blue) { RequireInitialized(__func__); return GetImpl()->SetPixelsTo(red, green, blue); }
-int SLMInstance::SetExposure(double interval_ms) { RequireInitialized(__func__); return GetImpl()->SetExposure(interval_ms); }
-double SLMInstance::GetExposure() { RequireInitialized(__func__); return GetImpl()->GetExposure(); }
-unsigned SLMInstance::GetWidth() { RequireInitialized(__func__); return GetImpl()->GetWidth(); }
-unsigned SLMInstance::GetHeight() { RequireInitialized(__func__); return GetImpl()->GetHeight(); }
-unsigned SLMInstance::GetNumberOfComponents() { RequireInitialized(__func__); return GetImpl()->GetNumberOfComponents(); }
-unsigned SLMInstance::GetBytesPerPixel() { RequireInitialized(__func__); return GetImpl()->GetBytesPerPixel(); }
+int SLMInstance::SetImage(unsigned char* pixels) { const auto trace = BeginCall(__func__); return GetImpl()->SetImage(pixels); }
+int SLMInstance::SetImage(unsigned int* pixels) { const auto trace = BeginCall(__func__); return GetImpl()->SetImage(pixels); }
+int SLMInstance::DisplayImage() { const auto trace = BeginCall(__func__); return GetImpl()->DisplayImage(); }
+int SLMInstance::SetPixelsTo(unsigned char intensity) { const auto trace = BeginCall(__func__); return GetImpl()->SetPixelsTo(intensity); }
+int SLMInstance::SetPixelsTo(unsigned char red, unsigned char green, unsigned char blue) { const auto trace = BeginCall(__func__); return GetImpl()->SetPixelsTo(red, green, blue); }
+int SLMInstance::SetExposure(double interval_ms) { const auto trace = BeginCall(__func__); return GetImpl()->SetExposure(interval_ms); }
+double SLMInstance::GetExposure() { const auto trace = BeginCall(__func__); return GetImpl()->GetExposure(); }
+unsigned SLMInstance::GetWidth() { const auto trace = BeginCall(__func__); return GetImpl()->GetWidth(); }
+unsigned SLMInstance::GetHeight() { const auto trace = BeginCall(__func__); return GetImpl()->GetHeight(); }
+unsigned SLMInstance::GetNumberOfComponents() { const auto trace = BeginCall(__func__); return GetImpl()->GetNumberOfComponents(); }
+unsigned SLMInstance::GetBytesPerPixel() { const auto trace = BeginCall(__func__); return GetImpl()->GetBytesPerPixel(); }
 int SLMInstance::IsSLMSequenceable(bool& isSequenceable)
-{ RequireInitialized(__func__); return GetImpl()->IsSLMSequenceable(isSequenceable); }
+{ const auto trace = BeginCall(__func__); return GetImpl()->IsSLMSequenceable(isSequenceable); }
 int SLMInstance::GetSLMSequenceMaxLength(long& nrEvents)
-{ RequireInitialized(__func__); return GetImpl()->GetSLMSequenceMaxLength(nrEvents); }
-int SLMInstance::StartSLMSequence() { RequireInitialized(__func__); return GetImpl()->StartSLMSequence(); }
-int SLMInstance::StopSLMSequence() { RequireInitialized(__func__); return GetImpl()->StopSLMSequence(); }
-int SLMInstance::ClearSLMSequence() { RequireInitialized(__func__); return GetImpl()->ClearSLMSequence(); }
+{ const auto trace = BeginCall(__func__); return GetImpl()->GetSLMSequenceMaxLength(nrEvents); }
+int SLMInstance::StartSLMSequence() { const auto trace = BeginCall(__func__); return GetImpl()->StartSLMSequence(); }
+int SLMInstance::StopSLMSequence() { const auto trace = BeginCall(__func__); return GetImpl()->StopSLMSequence(); }
+int SLMInstance::ClearSLMSequence() { const auto trace = BeginCall(__func__); return GetImpl()->ClearSLMSequence(); }
 int SLMInstance::AddToSLMSequence(const unsigned char * pixels)
-{ RequireInitialized(__func__); return GetImpl()->AddToSLMSequence(pixels); }
+{ const auto trace = BeginCall(__func__); return GetImpl()->AddToSLMSequence(pixels); }
 int SLMInstance::AddToSLMSequence(const unsigned int * pixels)
-{ RequireInitialized(__func__); return GetImpl()->AddToSLMSequence(pixels); }
-int SLMInstance::SendSLMSequence() { RequireInitialized(__func__); return GetImpl()->SendSLMSequence(); }
+{ const auto trace = BeginCall(__func__); return GetImpl()->AddToSLMSequence(pixels); }
+int SLMInstance::SendSLMSequence() { const auto trace = BeginCall(__func__); return GetImpl()->SendSLMSequence(); }
 
 } // namespace internal
 } // namespace mmcore
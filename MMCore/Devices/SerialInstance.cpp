@@ -26,11 +26,11 @@ namespace mmcore {
 namespace internal {
 
 MM::PortType SerialInstance::GetPortType() const { return GetImpl()->GetPortType(); }
-int SerialInstance::SetCommand(const char* command, const char* term) { RequireInitialized(__func__); return GetImpl()->SetCommand(command, term); }
-int SerialInstance::GetAnswer(char* txt, unsigned maxChars, const char* term) { RequireInitialized(__func__); return GetImpl()->GetAnswer(txt, maxChars, term); }
-int SerialInstance::Write(const unsigned char* buf, unsigned long bufLen) { RequireInitialized(__func__); return GetImpl()->Write(buf, bufLen); }
-int SerialInstance::Read(unsigned char* buf, unsigned long bufLen, unsigned long& charsRead) { RequireInitialized(__func__); return GetImpl()->Read(buf, bufLen, charsRead); }
-int SerialInstance::Purge() { RequireInitialized(__func__); return GetImpl()->Purge(); }
+int SerialInstance::SetCommand(const char* command, const char* term) { const auto trace = BeginCall(__func__); return GetImpl()->SetCommand(command, term); }
+int SerialInstance::GetAnswer(char* txt, unsigned maxChars, const char* term) { const auto trace = BeginCall(__func__); return GetImpl()->GetAnswer(txt, maxChars, term); }
+int SerialInstance::Write(const unsigned char* buf, unsigned long bufLen) { const auto trace = BeginCall(__func__); return GetImpl()->Write(buf, bufLen); }
+int SerialInstance::Read(unsigned char* buf, unsigned long bufLen, unsigned long& charsRead) { const auto trace = BeginCall(__func__); return GetImpl()->Read(buf, bufLen, charsRead); }
+int SerialInstance::Purge() { const auto trace = BeginCall(__func__); return GetImpl()->Purge(); }
 
 } // namespace internal
 } // namespace mmcore
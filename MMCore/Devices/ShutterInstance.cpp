@@ -25,9 +25,9 @@
 namespace mmcore {
 namespace internal {
 
-int ShutterInstance::SetOpen(bool open) { RequireInitialized(__func__); return GetImpl()->SetOpen(open); }
-int ShutterInstance::GetOpen(bool& open) { RequireInitialized(__func__); return GetImpl()->GetOpen(open); }
-int ShutterInstance::Fire(double deltaT) { RequireInitialized(__func__); return GetImpl()->Fire(deltaT); }
+int ShutterInstance::SetOpen(bool open) { const auto trace = BeginCall(__func__); return GetImpl()->SetOpen(open); }
+int ShutterInstance::GetOpen(bool& open) { const auto trace = BeginCall(__func__); return GetImpl()->GetOpen(open); }
+int ShutterInstance::Fire(double deltaT) { const auto trace = BeginCall(__func__); return GetImpl()->Fire(deltaT); }
 
 } // namespace internal
 } // namespace mmcore
@@ -25,18 +25,18 @@
 namespace mmcore {
 namespace internal {
 
-int SignalIOInstance::SetGateOpen(bool open) { RequireInitialized(__func__); return GetImpl()->SetGateOpen(open); }
-int SignalIOInstance::GetGateOpen(bool& open) { RequireInitialized(__func__); return GetImpl()->GetGateOpen(open); }
-int SignalIOInstance::SetSignal(double volts) { RequireInitialized(__func__); return GetImpl()->SetSignal(volts); }
-int SignalIOInstance::GetSignal(double& volts) { RequireInitialized(__func__); return GetImpl()->GetSignal(volts); }
-int SignalIOInstance::GetLimits(double& minVolts, double& maxVolts) { RequireInitialized(__func__); return GetImpl()->GetLimits(minVolts, maxVolts); }
-int SignalIOInstance::IsDASequenceable(bool& isSequenceable) const { RequireInitialized(__func__); return GetImpl()->IsDASequenceable(isSequenceable); }
-int SignalIOInstance::GetDASequenceMaxLength(long& nrEvents) const { RequireInitialized(__func__); return GetImpl()->GetDASequenceMaxLength(nrEvents); }
-int SignalIOInstance::StartDASequence() { RequireInitialized(__func__); return GetImpl()->StartDASequence(); }
-int SignalIOInstance::StopDASequence() { RequireInitialized(__func__); return GetImpl()->StopDASequence(); }
-int SignalIOInstance::ClearDASequence() { RequireInitialized(__func__); return GetImpl()->ClearDASequence(); }
-int SignalIOInstance::AddToDASequence(double voltage) { RequireInitialized(__func__); return GetImpl()->AddToDASequence(voltage); }
-int SignalIOInstance::SendDASequence() { RequireInitialized(__func__); return GetImpl()->SendDASequence(); }
+int SignalIOInstance::SetGateOpen(bool open) { const auto trace = BeginCall(__func__); return GetImpl()->SetGateOpen(open); }
+int SignalIOInstance::GetGateOpen(bool& open) { const auto trace = BeginCall(__func__); return GetImpl()->GetGateOpen(open); }
+int SignalIOInstance::SetSignal(double volts) { const auto trace = BeginCall(__func__); return GetImpl()->SetSignal(volts); }
+int SignalIOInstance::GetSignal(double& volts) { const auto trace = BeginCall(__func__); return GetImpl()->GetSignal(volts); }
+int SignalIOInstance::GetLimits(double& minVolts, double& maxVolts) { const auto trace = BeginCall(__func__); return GetImpl()->GetLimits(minVolts, maxVolts); }
+int SignalIOInstance::IsDASequenceable(bool& isSequenceable) const { const auto trace = BeginCall(__func__); return GetImpl()->IsDASequenceable(isSequenceable); }
+int SignalIOInstance::GetDASequenceMaxLength(long& nrEvents) const { const auto trace = BeginCall(__func__); return GetImpl()->GetDASequenceMaxLength(nrEvents); }
+int SignalIOInstance::StartDASequence() { const auto trace = BeginCall(__func__); return GetImpl()->StartDASequence(); }
+int SignalIOInstance::StopDASequence() { const auto trace = BeginCall(__func__); return GetImpl()->StopDASequence(); }
+int SignalIOInstance::ClearDASequence() { const auto trace = BeginCall(__func__); return GetImpl()->ClearDASequence(); }
+int SignalIOInstance::AddToDASequence(double voltage) { const auto trace = BeginCall(__func__); return GetImpl()->AddToDASequence(voltage); }
+int SignalIOInstance::SendDASequence() { const auto trace = BeginCall(__func__); return GetImpl()->SendDASequence(); }
 
 } // namespace internal
 } // namespace mmcore
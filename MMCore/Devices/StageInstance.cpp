@@ -25,17 +25,17 @@
 namespace mmcore {
 namespace internal {
 
-int StageInstance::SetPositionUm(double pos) { RequireInitialized(__func__); return GetImpl()->SetPositionUm(pos); }
-int StageInstance::SetRelativePositionUm(double d) { RequireInitialized(__func__); return GetImpl()->SetRelativePositionUm(d); }
-int StageInstance::Move(double velocity) { RequireInitialized(__func__); return GetImpl()->Move(velocity); }
-int StageInstance::Stop() { RequireInitialized(__func__); return GetImpl()->Stop(); }
-int StageInstance::Home() { RequireInitialized(__func__); return GetImpl()->Home(); }
-int StageInstance::SetAdapterOriginUm(double d) { RequireInitialized(__func__); return GetImpl()->SetAdapterOriginUm(d); }
-int StageInstance::GetPositionUm(double& pos) { RequireInitialized(__func__); return GetImpl()->GetPositionUm(pos); }
-int StageInstance::SetPositionSteps(long steps) { RequireInitialized(__func__); return GetImpl()->SetPositionSteps(steps); }
-int StageInstance::GetPositionSteps(long& steps) { RequireInitialized(__func__); return GetImpl()->GetPositionSteps(steps); }
-int StageInstance::SetOrigin() { RequireInitialized(__func__); return GetImpl()->SetOrigin(); }
-int StageInstance::GetLimits(double& lower, double& upper) { RequireInitialized(__func__); return GetImpl()->GetLimits(lower, upper); }
+int StageInstance::SetPositionUm(double pos) { const auto trace = BeginCall(__func__); return GetImpl()->SetPositionUm(pos); }
+int StageInstance::SetRelativePositionUm(double d) { const auto trace = BeginCall(__func__); return GetImpl()->SetRelativePositionUm(d); }
+int StageInstance::Move(double velocity) { const auto trace = BeginCall(__func__); return GetImpl()->Move(velocity); }
+int StageInstance::Stop() { const auto trace = BeginCall(__func__); return GetImpl()->Stop(); }
+int StageInstance::Home() { const auto trace = BeginCall(__func__); return GetImpl()->Home(); }
+int StageInstance::SetAdapterOriginUm(double d) { const auto trace = BeginCall(__func__); return GetImpl()->SetAdapterOriginUm(d); }
+int StageInstance::GetPositionUm(double& pos) { const auto trace = BeginCall(__func__); return GetImpl()->GetPositionUm(pos); }
+int StageInstance::SetPositionSteps(long steps) { const auto trace = BeginCall(__func__); return GetImpl()->SetPositionSteps(steps); }
+int StageInstance::GetPositionSteps(long& steps) { const auto trace = BeginCall(__func__); return GetImpl()->GetPositionSteps(steps); }
+int StageInstance::SetOrigin() { const auto trace = BeginCall(__func__); return GetImpl()->SetOrigin(); }
+int StageInstance::GetLimits(double& lower, double& upper) { const auto trace = BeginCall(__func__); return GetImpl()->GetLimits(lower, upper); }
 
 MM::FocusDirection
 StageInstance::GetFocusDirection()
@@ -60,18 +60,18 @@ StageInstance::SetFocusDirection(MM::FocusDirection direction)
    focusDirectionHasBeenSet_ = true;
 }
 
-int StageInstance::UsesOnStagePositionChanged(bool& result) const { RequireInitialized(__func__); return GetImpl()->UsesOnStagePositionChanged(result); }
-int StageInstance::IsStageSequenceable(bool& isSequenceable) const { RequireInitialized(__func__); return GetImpl()->IsStageSequenceable(isSequenceable); }
-int StageInstance::IsStageLinearSequenceable(bool& isSequenceable) const { RequireInitialized(__func__); return GetImpl()->IsStageLinearSequenceable(isSequenceable); }
-bool StageInstance::IsContinuousFocusDrive() const { RequireInitialized(__func__); return GetImpl()->IsContinuousFocusDrive(); }
-int StageInstance::GetStageSequenceMaxLength(long& nrEvents) const { RequireInitialized(__func__); return GetImpl()->GetStageSequenceMaxLength(nrEvents); }
-int StageInstance::StartStageSequence() { RequireInitialized(__func__); return GetImpl()->StartStageSequence(); }
-int StageInstance::StopStageSequence() { RequireInitialized(__func__); return GetImpl()->StopStageSequence(); }
-int StageInstance::ClearStageSequence() { RequireInitialized(__func__); return GetImpl()->ClearStageSequence(); }
-int StageInstance::AddToStageSequence(double position) { RequireInitialized(__func__); return GetImpl()->AddToStageSequence(position); }
-int StageInstance::SendStageSequence() { RequireInitialized(__func__); return GetImpl()->SendStageSequence(); }
+int StageInstance::UsesOnStagePositionChanged(bool& result) const { const auto trace = BeginCall(__func__); return GetImpl()->UsesOnStagePositionChanged(result); }
+int StageInstance::IsStageSequenceable(bool& isSequenceable) const { const auto trace = BeginCall(__func__); return GetImpl()->IsStageSequenceable(isSequenceable); }
+int StageInstance::IsStageLinearSequenceable(bool& isSequenceable) const { const auto trace = BeginCall(__func__); return GetImpl()->IsStageLinearSequenceable(isSequenceable); }
+bool StageInstance::IsContinuousFocusDrive() const { const auto trace = BeginCall(__func__); return GetImpl()->IsContinuousFocusDrive(); }
+int StageInstance::GetStageSequenceMaxLength(long& nrEvents) const { const auto trace = BeginCall(__func__); return GetImpl()->GetStageSequenceMaxLength(nrEvents); }
+int StageInstance::StartStageSequence() { const auto trace = BeginCall(__func__); return GetImpl()->StartStageSequence(); }
+int StageInstance::StopStageSequence() { const auto trace = BeginCall(__func__); return GetImpl()->StopStageSequence(); }
+int StageInstance::ClearStageSequence() { const auto trace = BeginCall(__func__); return GetImpl()->ClearStageSequence(); }
+int StageInstance::AddToStageSequence(double position) { const auto trace = BeginCall(__func__); return GetImpl()->AddToStageSequence(position); }
+int StageInstance::SendStageSequence() { const auto trace = BeginCall(__func__); return GetImpl()->SendStageSequence(); }
 int StageInstance::SetStageLinearSequence(double dZ_um, long nSlices)
-{ RequireInitialized(__func__); return GetImpl()->SetStageLinearSequence(dZ_um, nSlices); }
+{ const auto trace = BeginCall(__func__); return GetImpl()->SetStageLinearSequence(dZ_um, nSlices); }
 
 } // namespace internal
 } // namespace mmcore
\ No newline at end of file
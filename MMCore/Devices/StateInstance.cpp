@@ -25,13 +25,13 @@
 namespace mmcore {
 namespace internal {
 
-int StateInstance::SetPosition(long pos) { RequireInitialized(__func__); return GetImpl()->SetPosition(pos); }
-int StateInstance::SetPosition(const char* label) { RequireInitialized(__func__); return GetImpl()->SetPosition(label); }
-int StateInstance::GetPosition(long& pos) const { RequireInitialized(__func__); return GetImpl()->GetPosition(pos); }
+int StateInstance::SetPosition(long pos) { const auto trace = BeginCall(__func__); return GetImpl()->SetPosition(pos); }
+int StateInstance::SetPosition(const char* label) { const auto trace = BeginCall(__func__); return GetImpl()->SetPosition(label); }
+int StateInstance::GetPosition(long& pos) const { const auto trace = BeginCall(__func__); return GetImpl()->GetPosition(pos); }
 
 std::string StateInstance::GetPositionLabel() const
 {
-   RequireInitialized(__func__);
+   const auto trace = BeginCall(__func__);
    DeviceStringBuffer labelBuf(this, "GetPosition");
    int err = GetImpl()->GetPosition(labelBuf.GetBuffer());
    ThrowIfError(err, "Cannot get current position label");
@@ -40,18 +40,18 @@ std::string StateInstance::GetPositionLabel() const
 
 std::string StateInstance::GetPositionLabel(long pos) const
 {
-   RequireInitialized(__func__);
+   const auto trace = BeginCall(__func__);
    DeviceStringBuffer labelBuf(this, "GetPositionLabel");
    int err = GetImpl()->GetPositionLabel(pos, labelBuf.GetBuffer());
    ThrowIfError(err, "Cannot get position label at index " + ToString(pos));
    return labelBuf.Get();
 }
 
-int StateInstance::GetLabelPosition(const char* label, long& pos) const { RequireInitialized(__func__); return GetImpl()->GetLabelPosition(label, pos); }
-int StateInstance::SetPositionLabel(long pos, const char* label) { RequireInitialized(__func__); return GetImpl()->SetPositionLabel(pos, label); }
-unsigned long StateInstance::GetNumberOfPositions() const { RequireInitialized(__func__); return GetImpl()->GetNumberOfPositions(); }
-int StateInstance::SetGateOpen(bool open) { RequireInitialized(__func__); return GetImpl()->SetGateOpen(open); }
-int StateInstance::GetGateOpen(bool& open) { RequireInitialized(__func__); return GetImpl()->GetGateOpen(open); }
+int StateInstance::GetLabelPosition(const char* label, long& pos) const { const auto trace = BeginCall(__func__); return GetImpl()->GetLabelPosition(label, pos); }
+int StateInstance::SetPositionLabel(long pos, const char* label) { const auto trace = BeginCall(__func__); return GetImpl()->SetPositionLabel(pos, label); }
+unsigned long StateInstance::GetNumberOfPositions() const { const auto trace = BeginCall(__func__); return GetImpl()->GetNumberOfPositions(); }
+int StateInstance::SetGateOpen(bool open) { const auto trace = BeginCall(__func__); return GetImpl()->SetGateOpen(open); }
+int StateInstance::GetGateOpen(bool& open) { const auto trace = BeginCall(__func__); return GetImpl()->GetGateOpen(open); }
 
 } // namespace internal
 } // namespace mmcore
@@ -26,20 +26,20 @@ namespace mmcore {
 namespace internal {
 
 // Volume controlled pump functions
-int VolumetricPumpInstance::Home() { RequireInitialized(__func__); return GetImpl()->Home(); }
-int VolumetricPumpInstance::Stop() { RequireInitialized(__func__); return GetImpl()->Stop(); }
-bool VolumetricPumpInstance::RequiresHoming() { RequireInitialized(__func__); return GetImpl()->RequiresHoming(); }
-int VolumetricPumpInstance::InvertDirection(bool state) { RequireInitialized(__func__); return GetImpl()->InvertDirection(state); }
-int VolumetricPumpInstance::IsDirectionInverted(bool& state) { RequireInitialized(__func__); return GetImpl()->IsDirectionInverted(state); }
-int VolumetricPumpInstance::SetVolumeUl(double volume) { RequireInitialized(__func__); return GetImpl()->SetVolumeUl(volume); }
-int VolumetricPumpInstance::GetVolumeUl(double& volume) { RequireInitialized(__func__); return GetImpl()->GetVolumeUl(volume); }
-int VolumetricPumpInstance::SetMaxVolumeUl(double volume) { RequireInitialized(__func__); return GetImpl()->SetMaxVolumeUl(volume); }
-int VolumetricPumpInstance::GetMaxVolumeUl(double& volume) { RequireInitialized(__func__); return GetImpl()->GetMaxVolumeUl(volume); }
-int VolumetricPumpInstance::SetFlowrateUlPerSecond(double flowrate) { RequireInitialized(__func__); return GetImpl()->SetFlowrateUlPerSecond(flowrate); }
-int VolumetricPumpInstance::GetFlowrateUlPerSecond(double& flowrate) { RequireInitialized(__func__); return GetImpl()->GetFlowrateUlPerSecond(flowrate); }
-int VolumetricPumpInstance::Start() { RequireInitialized(__func__); return GetImpl()->Start(); }
-int VolumetricPumpInstance::DispenseDurationSeconds(double durSec) { RequireInitialized(__func__); return GetImpl()->DispenseDurationSeconds(durSec); }
-int VolumetricPumpInstance::DispenseVolumeUl(double volUl) { RequireInitialized(__func__); return GetImpl()->DispenseVolumeUl(volUl); }
+int VolumetricPumpInstance::Home() { const auto trace = BeginCall(__func__); return GetImpl()->Home(); }
+int VolumetricPumpInstance::Stop() { const auto trace = BeginCall(__func__); return GetImpl()->Stop(); }
+bool VolumetricPumpInstance::RequiresHoming() { const auto trace = BeginCall(__func__); return GetImpl()->RequiresHoming(); }
+int VolumetricPumpInstance::InvertDirection(bool state) { const auto trace = BeginCall(__func__); return GetImpl()->InvertDirection(state); }
+int VolumetricPumpInstance::IsDirectionInverted(bool& state) { const auto trace = BeginCall(__func__); return GetImpl()->IsDirectionInverted(state); }
+int VolumetricPumpInstance::SetVolumeUl(double volume) { const auto trace = BeginCall(__func__); return GetImpl()->SetVolumeUl(volume); }
+int VolumetricPumpInstance::GetVolumeUl(double& volume) { const auto trace = BeginCall(__func__); return GetImpl()->GetVolumeUl(volume); }
+int VolumetricPumpInstance::SetMaxVolumeUl(double volume) { const auto trace = BeginCall(__func__); return GetImpl()->SetMaxVolumeUl(volume); }
+int VolumetricPumpInstance::GetMaxVolumeUl(double& volume) { const auto trace = BeginCall(__func__); return GetImpl()->GetMaxVolumeUl(volume); }
+int VolumetricPumpInstance::SetFlowrateUlPerSecond(double flowrate) { const auto trace = BeginCall(__func__); return GetImpl()->SetFlowrateUlPerSecond(flowrate); }
+int VolumetricPumpInstance::GetFlowrateUlPerSecond(double& flowrate) { const auto trace = BeginCall(__func__); return GetImpl()->GetFlowrateUlPerSecond(flowrate); }
+int VolumetricPumpInstance::Start() { const auto trace = BeginCall(__func__); return GetImpl()->Start(); }
+int VolumetricPumpInstance::DispenseDurationSeconds(double durSec) { const auto trace = BeginCall(__func__); return GetImpl()->DispenseDurationSeconds(durSec); }
+int VolumetricPumpInstance::DispenseVolumeUl(double volUl) { const auto trace = BeginCall(__func__); return GetImpl()->DispenseVolumeUl(volUl); }
 
 } // namespace internal
 } // namespace mmcore
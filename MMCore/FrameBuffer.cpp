@@ -51,6 +51,18 @@ void FrameBuffer::Resize(std::size_t size)
    }
 }
 
+void FrameBuffer::ResizeRaw(std::size_t size)
+{
+   if (size != rawSize_)
+   {
+      rawPixels_.reset();
+      if (size > 0)
+         rawPixels_.reset(new unsigned char[size]());
+      rawSize_ = size;
+   }
+   hasRawPixels_ = false;
+}
+
 void FrameBuffer::SetSerializedMetadata(std::string_view serialized)
 {
    serializedMetadata_.assign(serialized);
@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include "FrameLatencyStats.h"
+
 #include <cstddef>
 #include <memory>
 #include <string>
@@ -30,7 +32,13 @@ class FrameBuffer
 {
    std::size_t size_ = 0;
    std::unique_ptr<unsigned char[]> pixels_;
+   // Optional second plane, holding the frame as received when the stored
+   // pixels were converted from it (e.g. demosaiced)
+   std::size_t rawSize_ = 0;
+   std::unique_ptr<unsigned char[]> rawPixels_;
+   bool hasRawPixels_ = false;
    std::string serializedMetadata_;
+   FrameTiming timing_;
 
 public:
    FrameBuffer() = default;
@@ -43,13 +51,26 @@ public:
 
    void SetPixels(const void* pixArray);
    const unsigned char* GetPixels() const;
+   unsigned char* GetPixelsRW() { return pixels_.get(); }
 
    void Resize(std::size_t size);
 
+   // The raw plane is allocated separately from the pixels, and is only
+   // meaningful while HasRawPixels() (set by the inserting code)
+   void ResizeRaw(std::size_t size);
+   std::size_t GetRawSize() const { return rawSize_; }
+   const unsigned char* GetRawPixels() const { return rawPixels_.get(); }
+   unsigned char* GetRawPixelsRW() { return rawPixels_.get(); }
+   void SetHasRawPixels(bool hasRaw) { hasRawPixels_ = hasRaw; }
+   bool HasRawPixels() const { return hasRawPixels_; }
+
    void SetSerializedMetadata(std::string_view serialized);
    const std::string& GetSerializedMetadata() const {
       return serializedMetadata_;
    }
+
+   void SetTiming(const FrameTiming& timing) { timing_ = timing; }
+   const FrameTiming& GetTiming() const { return timing_; }
 };
 
 } // namespace internal
@@ -0,0 +1,195 @@
+// DESCRIPTION:   Per-camera latency histograms for the path of sequence
+//                images through the Core
+//
+// LICENSE:       This file is distributed under the "Lesser GPL" (LGPL) license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#include "FrameLatencyStats.h"
+
+#include "Error.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+namespace mmcore {
+namespace internal {
+
+namespace {
+
+int FloorLog2(std::uint64_t v)
+{
+   int result = 0;
+   for (int shift = 32; shift > 0; shift /= 2)
+   {
+      if (v >> shift)
+      {
+         v >>= shift;
+         result += shift;
+      }
+   }
+   return result;
+}
+
+} // namespace
+
+LatencyHistogram::LatencyHistogram()
+{
+   Reset();
+}
+
+std::size_t LatencyHistogram::BucketIndex(std::uint64_t ns)
+{
+   if (ns < subBucketCount)
+      return static_cast<std::size_t>(ns);
+   const int shift = FloorLog2(ns) - subBucketBits;
+   const std::size_t sub = static_cast<std::size_t>(ns >> shift) - subBucketCount;
+   return (shift + 1) * subBucketCount + sub;
+}
+
+std::uint64_t LatencyHistogram::BucketUpperBound(std::size_t index)
+{
+   if (index < subBucketCount)
+      return index;
+   const std::size_t shift = index / subBucketCount - 1;
+   const std::uint64_t sub = index % subBucketCount;
+   const std::uint64_t lower = (subBucketCount + sub) << shift;
+   return lower + ((std::uint64_t(1) << shift) - 1);
+}
+
+void LatencyHistogram::Record(std::chrono::nanoseconds duration)
+{
+   const std::uint64_t ns = duration.count() > 0 ?
+      static_cast<std::uint64_t>(duration.count()) : 0;
+   buckets_[BucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+   sumNs_.fetch_add(ns, std::memory_order_relaxed);
+   std::uint64_t prevMax = maxNs_.load(std::memory_order_relaxed);
+   while (ns > prevMax &&
+         !maxNs_.compare_exchange_weak(prevMax, ns, std::memory_order_relaxed))
+      ;
+   count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::Reset()
+{
+   for (auto& bucket : buckets_)
+      bucket.store(0, std::memory_order_relaxed);
+   count_.store(0, std::memory_order_relaxed);
+   sumNs_.store(0, std::memory_order_relaxed);
+   maxNs_.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::GetPercentileUs(double percentile) const
+{
+   // Sum the buckets rather than trusting count_, which may lag behind (or
+   // run ahead of) the buckets while recording is in progress
+   std::uint64_t total = 0;
+   for (const auto& bucket : buckets_)
+      total += bucket.load(std::memory_order_relaxed);
+   if (total == 0)
+      return 0.0;
+
+   const std::uint64_t maxNs = maxNs_.load(std::memory_order_relaxed);
+   const double clamped = std::min(100.0, std::max(0.0, percentile));
+   const std::uint64_t rank = std::max<std::uint64_t>(1,
+      static_cast<std::uint64_t>(std::ceil(clamped / 100.0 * total)));
+   std::uint64_t seen = 0;
+   for (std::size_t i = 0; i < bucketCount; ++i)
+   {
+      seen += buckets_[i].load(std::memory_order_relaxed);
+      if (seen >= rank)
+         return std::min(BucketUpperBound(i), maxNs) / 1000.0;
+   }
+   return maxNs / 1000.0;
+}
+
+double LatencyHistogram::GetMeanUs() const
+{
+   const std::uint64_t count = GetCount();
+   if (count == 0)
+      return 0.0;
+   return sumNs_.load(std::memory_order_relaxed) / 1000.0 / count;
+}
+
+void CameraLatencyStats::RecordInserted(const FrameTiming& timing)
+{
+   Get(LatencyStage::Process).Record(timing.processed - timing.received);
+   Get(LatencyStage::Copy).Record(timing.copied - timing.processed);
+}
+
+void CameraLatencyStats::RecordPopped(const FrameTiming& timing,
+      FrameTiming::TimePoint popped)
+{
+   Get(LatencyStage::Queue).Record(popped - timing.copied);
+   Get(LatencyStage::Total).Record(popped - timing.received);
+}
+
+void CameraLatencyStats::Reset()
+{
+   for (auto& histogram : histograms_)
+      histogram.Reset();
+}
+
+CameraLatencyStats* FrameLatencyStats::GetCamera(std::string_view label)
+{
+   {
+      std::shared_lock<std::shared_mutex> lock(mutex_);
+      auto it = cameras_.find(label);
+      if (it != cameras_.end())
+         return it->second.get();
+   }
+   std::unique_lock<std::shared_mutex> lock(mutex_);
+   auto& stats = cameras_[std::string(label)];
+   if (!stats)
+      stats = std::make_unique<CameraLatencyStats>();
+   return stats.get();
+}
+
+const CameraLatencyStats* FrameLatencyStats::FindCamera(std::string_view label) const
+{
+   std::shared_lock<std::shared_mutex> lock(mutex_);
+   auto it = cameras_.find(label);
+   return it == cameras_.end() ? nullptr : it->second.get();
+}
+
+std::vector<std::string> FrameLatencyStats::GetCameraLabels() const
+{
+   std::shared_lock<std::shared_mutex> lock(mutex_);
+   std::vector<std::string> labels;
+   for (const auto& entry : cameras_)
+      labels.push_back(entry.first);
+   return labels;
+}
+
+void FrameLatencyStats::Reset()
+{
+   // Keep the per-camera objects, which frames in the buffer may point to
+   std::shared_lock<std::shared_mutex> lock(mutex_);
+   for (auto& entry : cameras_)
+      entry.second->Reset();
+}
+
+LatencyStage FrameLatencyStats::ParseStage(const std::string& name)
+{
+   if (name == "Process")
+      return LatencyStage::Process;
+   if (name == "Copy")
+      return LatencyStage::Copy;
+   if (name == "Queue")
+      return LatencyStage::Queue;
+   if (name == "Total")
+      return LatencyStage::Total;
+   throw CMMError("Unknown frame latency stage: " + name +
+      " (expected Process, Copy, Queue or Total)");
+}
+
+} // namespace internal
+} // namespace mmcore
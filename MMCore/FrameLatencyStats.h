@@ -0,0 +1,132 @@
+// DESCRIPTION:   Per-camera latency histograms for the path of sequence
+//                images through the Core
+//
+// LICENSE:       This file is distributed under the "Lesser GPL" (LGPL) license.
+//                License text is included with the source distribution.
+//
+//                This file is distributed in the hope that it will be useful,
+//                but WITHOUT ANY WARRANTY; without even the implied warranty
+//                of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//                IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//                CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//                INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mmcore {
+namespace internal {
+
+// Histogram of durations with logarithmically spaced buckets, each power of
+// two being split into 2^subBucketBits linear buckets (as in HdrHistogram),
+// so that percentiles are accurate to about 3% over the whole range.
+// Recording is lock-free and may happen concurrently with reading.
+class LatencyHistogram
+{
+public:
+   LatencyHistogram();
+
+   void Record(std::chrono::nanoseconds duration);
+   void Reset();
+
+   std::uint64_t GetCount() const { return count_.load(std::memory_order_relaxed); }
+   // Returns 0 when empty. Percentile is in [0, 100]; 100 gives the maximum.
+   double GetPercentileUs(double percentile) const;
+   double GetMeanUs() const;
+
+private:
+   static constexpr int subBucketBits = 5;
+   static constexpr std::size_t subBucketCount = std::size_t(1) << subBucketBits;
+   static constexpr std::size_t bucketCount = (64 - subBucketBits + 1) * subBucketCount;
+
+   static std::size_t BucketIndex(std::uint64_t ns);
+   static std::uint64_t BucketUpperBound(std::size_t index);
+
+   std::array<std::atomic<std::uint64_t>, bucketCount> buckets_;
+   std::atomic<std::uint64_t> count_;
+   std::atomic<std::uint64_t> sumNs_;
+   std::atomic<std::uint64_t> maxNs_;
+};
+
+class CameraLatencyStats;
+
+// Monotonic timestamps of a sequence image on its way through the Core
+struct FrameTiming
+{
+   using TimePoint = std::chrono::steady_clock::time_point;
+
+   TimePoint received; // Entry to CoreCallback::InsertImage()
+   TimePoint processed; // After metadata and image processor
+   TimePoint copied; // After copying into the circular buffer
+   bool timed = false;
+   CameraLatencyStats* stats = nullptr; // Null unless recording stats
+};
+
+enum class LatencyStage
+{
+   Process, // received -> processed
+   Copy, // processed -> copied
+   Queue, // copied -> popped
+   Total, // received -> popped
+};
+
+class CameraLatencyStats
+{
+public:
+   static constexpr std::size_t stageCount = 4;
+
+   LatencyHistogram& Get(LatencyStage stage)
+   { return histograms_[static_cast<std::size_t>(stage)]; }
+   const LatencyHistogram& Get(LatencyStage stage) const
+   { return histograms_[static_cast<std::size_t>(stage)]; }
+
+   void RecordInserted(const FrameTiming& timing);
+   void RecordPopped(const FrameTiming& timing,
+         FrameTiming::TimePoint popped);
+   void Reset();
+
+private:
+   std::array<LatencyHistogram, stageCount> histograms_;
+};
+
+// Latency statistics of all cameras, collected while enabled
+class FrameLatencyStats
+{
+public:
+   void Enable(bool enable) { enabled_.store(enable, std::memory_order_relaxed); }
+   bool IsEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+   void EnableTags(bool enable) { tagsEnabled_.store(enable, std::memory_order_relaxed); }
+   bool AreTagsEnabled() const { return tagsEnabled_.load(std::memory_order_relaxed); }
+
+   // Whether images need to be timed at all
+   bool IsTiming() const { return IsEnabled() || AreTagsEnabled(); }
+
+   // Created on first use; the returned object lives as long as this one
+   CameraLatencyStats* GetCamera(std::string_view label);
+   const CameraLatencyStats* FindCamera(std::string_view label) const;
+   std::vector<std::string> GetCameraLabels() const;
+   void Reset();
+
+   // Throws CMMError if the name is not one of Process, Copy, Queue, Total
+   static LatencyStage ParseStage(const std::string& name);
+
+private:
+   std::atomic<bool> enabled_{false};
+   std::atomic<bool> tagsEnabled_{false};
+   mutable std::shared_mutex mutex_;
+   std::map<std::string, std::unique_ptr<CameraLatencyStats>, std::less<>> cameras_;
+};
+
+} // namespace internal
+} // namespace mmcore
@@ -39,6 +39,7 @@ LoadedDeviceAdapter::LoadedDeviceAdapter(const std::string& name,
 {
    CheckInterfaceVersion();
    impl_->InitializeModuleData();
+   perDeviceLocking_ = impl_->GetPerDeviceLocking();
 }
 
 
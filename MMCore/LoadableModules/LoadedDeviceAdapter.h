@@ -58,6 +58,10 @@ public:
    // adapter.
    std::recursive_mutex& GetLock();
 
+   // Whether the module declared that its devices may be called
+   // concurrently, each under its own lock instead of the module lock.
+   bool UsesPerDeviceLocking() const { return perDeviceLocking_; }
+
    std::vector<std::string> GetAvailableDeviceNames() const;
    std::string GetDeviceDescription(const std::string& deviceName) const;
    MM::DeviceType GetAdvertisedDeviceType(const std::string& deviceName) const;
@@ -101,6 +105,7 @@ private:
 
    const std::string name_;
    std::recursive_mutex lock_;
+   bool perDeviceLocking_ = false;
    std::unique_ptr<LoadedDeviceAdapterImpl> impl_;
 };
 
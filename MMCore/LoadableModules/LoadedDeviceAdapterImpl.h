@@ -43,6 +43,7 @@ public:
    virtual bool GetDeviceType(const char* deviceName, int* type) const = 0;
    virtual MM::Device* CreateDevice(const char* deviceName) = 0;
    virtual void DeleteDevice(MM::Device* device) = 0;
+   virtual bool GetPerDeviceLocking() const = 0;
 };
 
 } // namespace internal
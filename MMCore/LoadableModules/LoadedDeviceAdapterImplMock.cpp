@@ -83,5 +83,11 @@ void LoadedDeviceAdapterImplMock::DeleteDevice(MM::Device* device)
    return impl_->DeleteDevice(device);
 }
 
+
+bool LoadedDeviceAdapterImplMock::GetPerDeviceLocking() const
+{
+   return impl_->GetPerDeviceLocking();
+}
+
 } // namespace internal
 } // namespace mmcore
@@ -47,6 +47,7 @@ public:
    bool GetDeviceType(const char* deviceName, int* type) const override;
    MM::Device* CreateDevice(const char* deviceName) override;
    void DeleteDevice(MM::Device* device) override;
+   bool GetPerDeviceLocking() const override;
 
 private:
    MockDeviceAdapter* impl_;
@@ -98,5 +98,15 @@ void LoadedDeviceAdapterImplRegular::DeleteDevice(MM::Device* device)
    DeleteDevice_(device);
 }
 
+
+bool LoadedDeviceAdapterImplRegular::GetPerDeviceLocking() const
+{
+   // Looked up on first use (after the interface version has been checked),
+   // so that older modules get a version mismatch error rather than a
+   // missing function error.
+   auto fn = reinterpret_cast<fnGetPerDeviceLocking>(module_->GetFunction("GetPerDeviceLocking"));
+   return fn();
+}
+
 } // namespace internal
 } // namespace mmcore
@@ -49,6 +49,7 @@ public:
    bool GetDeviceType(const char* deviceName, int* type) const override;
    MM::Device* CreateDevice(const char* deviceName) override;
    void DeleteDevice(MM::Device* device) override;
+   bool GetPerDeviceLocking() const override;
 
 private:
    std::unique_ptr<LoadedModule> module_;
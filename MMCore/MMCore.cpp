@@ -44,7 +44,11 @@
 #include "CoreFeatures.h"
 #include "CoreProperty.h"
 #include "CoreUtils.h"
+#include "DemosaicStage.h"
+#include "DependencyScheduler.h"
+#include "DeviceCallTracer.h"
 #include "DeviceManager.h"
+#include "FrameLatencyStats.h"
 #include "Devices/DeviceInstances.h"
 #include "LogManager.h"
 #include "MMCore.h"
@@ -58,16 +62,21 @@
 #include "ModuleInterface.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
+#include <cstdlib>
 #include <cstring>
 #include <deque>
 #include <fstream>
 #include <future>
+#include <limits>
 #include <map>
+#include <optional>
 #include <set>
 #include <sstream>
 #include <thread>
+#include <type_traits>
 #include <vector>
 
 namespace mmi = mmcore::internal;
@@ -108,7 +117,7 @@ namespace notif = mmcore::internal::notification;
  * (Keep the 3 numbers on one line to make it easier to look at diffs when
  * merging/rebasing.)
  */
-const int MMCore_versionMajor = 12, MMCore_versionMinor = 5, MMCore_versionPatch = 0;
+const int MMCore_versionMajor = 12, MMCore_versionMinor = 14, MMCore_versionPatch = 0;
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -131,11 +140,14 @@ CMMCore::CMMCore() :
    nullAffine_(6, 0.0),
    configGroups_(std::make_unique<mmi::ConfigGroupCollection>()),
    pixelSizeGroup_(std::make_unique<PixelSizeConfigGroup>()),
+   latencyStats_(std::make_unique<mmi::FrameLatencyStats>()),
+   demosaicStage_(std::make_unique<mmi::DemosaicStage>()),
    cbuf_(std::make_unique<mmi::CircularBuffer>(
       (sizeof(void*) > 4) ? 250u : 25u)),
    callback_(std::make_unique<mmi::CoreCallback>(this)),
    pluginManager_(std::make_shared<mmi::CPluginManager>()),
    deviceManager_(std::make_shared<mmi::DeviceManager>()),
+   callTracer_(std::make_shared<mmi::DeviceCallTracer>()),
    stateCache_(std::make_unique<SynchronizedConfiguration>())
 {
    InitializeErrorMessages();
@@ -185,11 +197,31 @@ CMMCore::~CMMCore()
  *   attempted on a device that is not successfully initialized. When disabled,
  *   no exception is thrown and a warning is logged (and the operation may
  *   potentially cause incorrect behavior or a crash).
- * - "ParallelDeviceInitialization" (default: enabled) When enabled, serial ports
- *   are initialized in serial order, and all other devices are in parallel, using 
- *   multiple threads, one per device module.  Early testing shows this to be 
- *   reliable, but switch this off when issues are encountered during 
- *   device initialization.
+ * - "ParallelDeviceInitialization" (default: enabled) When enabled, devices
+ *   are initialized concurrently on a bounded number of threads. A device is
+ *   initialized after the serial port named by its "Port" property and after
+ *   its parent hub; devices of the same module are initialized one at a time,
+ *   in load order, unless the module uses per-device locking. The start time
+ *   and duration of each initialization, and the critical path, are logged.
+ *   Early testing shows this to be reliable, but switch this off when issues
+ *   are encountered during device initialization.
+ * - "ParallelConfigApply" (default: disabled) When enabled, applying a
+ *   configuration preset (setConfig(), setPixelSizeConfig()) skips settings
+ *   whose value in the system state cache already matches, and applies the
+ *   remaining settings concurrently, one thread per device module (or per
+ *   device, for modules that enable per-device locking). Settings belonging
+ *   to the same module are applied in preset order. Failed settings are
+ *   retried as when the feature is disabled.
+ * - "ConfigTransitionPlans" (default: disabled) When enabled, setConfig()
+ *   sends only the settings that differ from the preset previously applied
+ *   to the same group (see getConfigTransitionData()), provided that the
+ *   system state cache confirms that the skipped settings are still in
+ *   effect. Otherwise, all settings of the preset are sent.
+ * - "ParallelConfigLoad" (default: disabled) When enabled,
+ *   loadSystemConfiguration() applies consecutive Property lines for
+ *   initialized devices together, setting devices that do not share a lock
+ *   concurrently. Loading still stops at the first failing line (in file
+ *   order), which is reported in the error.
  *
  * Permanently enabled features:
  * - None so far.
@@ -462,55 +494,54 @@ int CMMCore::getMMCoreVersionPatch() { return MMCore_versionPatch; }
 
 /**
  * Get available devices from the specified device library.
+ *
+ * If a device adapter index file is in use (see setDeviceAdapterIndexFile()),
+ * the library is not loaded unless the index lacks a current entry for it.
  */
 std::vector<std::string>
 CMMCore::getAvailableDevices(const char* moduleName) MMCORE_LEGACY_THROW(CMMError)
 {
-   std::shared_ptr<mmi::LoadedDeviceAdapter> module =
-      pluginManager_->GetDeviceAdapter(moduleName);
-   return module->GetAvailableDeviceNames();
+   mmi::AdapterMetadata metadata = pluginManager_->GetAdapterMetadata(moduleName);
+   std::vector<std::string> names;
+   names.reserve(metadata.devices.size());
+   for (const auto& device : metadata.devices)
+      names.push_back(device.name);
+   return names;
 }
 
 /**
  * Get descriptions for available devices from the specified library.
+ *
+ * See getAvailableDevices() regarding when the library is loaded.
  */
 std::vector<std::string>
 CMMCore::getAvailableDeviceDescriptions(const char* moduleName) MMCORE_LEGACY_THROW(CMMError)
 {
    // XXX It is a little silly that we return the list of descriptions, rather
    // than provide access to the description of each device.
-   std::shared_ptr<mmi::LoadedDeviceAdapter> module =
-      pluginManager_->GetDeviceAdapter(moduleName);
-   std::vector<std::string> names = module->GetAvailableDeviceNames();
+   mmi::AdapterMetadata metadata = pluginManager_->GetAdapterMetadata(moduleName);
    std::vector<std::string> descriptions;
-   descriptions.reserve(names.size());
-   for (std::vector<std::string>::const_iterator
-         it = names.begin(), end = names.end(); it != end; ++it)
-   {
-      descriptions.push_back(module->GetDeviceDescription(*it));
-   }
+   descriptions.reserve(metadata.devices.size());
+   for (const auto& device : metadata.devices)
+      descriptions.push_back(device.description);
    return descriptions;
 }
 
 /**
  * Get type information for available devices from the specified library.
+ *
+ * See getAvailableDevices() regarding when the library is loaded.
  */
 std::vector<long>
 CMMCore::getAvailableDeviceTypes(const char* moduleName) MMCORE_LEGACY_THROW(CMMError)
 {
    // XXX It is a little silly that we return the list of types, rather than
    // provide access to the type of each device.
-   std::shared_ptr<mmi::LoadedDeviceAdapter> module =
-      pluginManager_->GetDeviceAdapter(moduleName);
-   std::vector<std::string> names = module->GetAvailableDeviceNames();
+   mmi::AdapterMetadata metadata = pluginManager_->GetAdapterMetadata(moduleName);
    std::vector<long> types;
-   types.reserve(names.size());
-   for (std::vector<std::string>::const_iterator
-         it = names.begin(), end = names.end(); it != end; ++it)
-   {
-      MM::DeviceType devType = module->GetAdvertisedDeviceType(*it);
-      types.push_back(static_cast<long>(devType));
-   }
+   types.reserve(metadata.devices.size());
+   for (const auto& device : metadata.devices)
+      types.push_back(static_cast<long>(device.type));
    return types;
 }
 
@@ -754,6 +785,58 @@ std::vector<std::string> CMMCore::getDeviceAdapterNames() MMCORE_LEGACY_THROW(CM
    return pluginManager_->GetAvailableDeviceAdapters();
 }
 
+/**
+ * Use an index file listing the devices provided by each device adapter
+ * library.
+ *
+ * Loading a library can be slow (many libraries load vendor SDKs). While the
+ * index has a current entry for a library (recorded for the same file size
+ * and modification time, and the same interface versions), the device listing
+ * functions (getAvailableDevices(), getAvailableDeviceDescriptions(),
+ * getAvailableDeviceTypes()) answer from the index without loading the
+ * library. Libraries loaded for these functions are added to the index.
+ *
+ * @param path   the index file (created if it does not exist), or an empty
+ *               string to stop using an index
+ */
+void CMMCore::setDeviceAdapterIndexFile(const char* path) MMCORE_LEGACY_THROW(CMMError)
+{
+   if (!path)
+      throw CMMError("Null device adapter index file path", MMERR_NullPointerException);
+   pluginManager_->SetMetadataIndexFile(path);
+}
+
+/**
+ * Return the device adapter index file (see setDeviceAdapterIndexFile()), or
+ * an empty string if none is in use.
+ */
+std::string CMMCore::getDeviceAdapterIndexFile()
+{
+   return pluginManager_->GetMetadataIndexFile();
+}
+
+/**
+ * Bring the device adapter index up to date for all device adapters in the
+ * search paths.
+ *
+ * Libraries without a current index entry are loaded concurrently. Libraries
+ * that fail to load are logged and left out of the index.
+ */
+void CMMCore::updateDeviceAdapterIndex() MMCORE_LEGACY_THROW(CMMError)
+{
+   const auto start = std::chrono::steady_clock::now();
+   std::map<std::string, std::string> errors = pluginManager_->UpdateMetadataIndex();
+   for (const auto& moduleAndError : errors)
+   {
+      LOG_WARNING(coreLogger_) << "Device adapter " << moduleAndError.first <<
+         " not indexed: " << moduleAndError.second;
+   }
+   LOG_INFO(coreLogger_) << "Updated device adapter index " <<
+      ToQuotedString(pluginManager_->GetMetadataIndexFile()) << " in " <<
+      std::chrono::duration<double, std::milli>(
+         std::chrono::steady_clock::now() - start).count() << " ms";
+}
+
 /**
  * Loads a device from the plugin library.
  * @param label    assigned name for the device during the core session
@@ -785,6 +868,7 @@ void CMMCore::loadDevice(const char* label, const char* moduleName, const char*
       deviceManager_->LoadDevice(module, deviceName, label, this,
             deviceLogger, coreLogger);
    pDevice->SetCallback(callback_.get());
+   pDevice->SetCallTracer(callTracer_);
 
    LOG_INFO(coreLogger_) << "Did load device " << deviceName <<
       " from " << moduleName << "; label = " << label;
@@ -894,6 +978,9 @@ void CMMCore::unloadDevice(const char* label///< the name of the device to unloa
       LOG_DEBUG(coreLogger_) << "Will unload device " << label;
       deviceManager_->UnloadDevice(pDevice);
       LOG_DEBUG(coreLogger_) << "Did unload device " << label;
+
+      // A device later loaded with the same label starts without settings
+      demosaicStage_->Remove(label);
    }
    catch (CMMError& err) {
       logError("MMCore::unloadDevice", err.getMsg().c_str());
@@ -931,6 +1018,8 @@ void CMMCore::unloadAllDevices() MMCORE_LEGACY_THROW(CMMError)
       deviceManager_->UnloadAllDevices();
       LOG_INFO(coreLogger_) << "Did unload all devices";
 
+      demosaicStage_->Clear();
+
       // The system config has "changed" (to "(none)").
       // But don't notify if we will proceed to load a new config.
       if (!isLoadingSystemConfiguration_)
@@ -1028,115 +1117,156 @@ void CMMCore::initializeAllDevicesSerial() MMCORE_LEGACY_THROW(CMMError)
 }
 
 
+/**
+ * Builds the initialization dependencies between devices: a device is
+ * initialized after its parent hub and after any serial port named by one of
+ * its pre-initialization properties (not only "Port": adapters use names such
+ * as "COM Port" or "ComPort"). Devices that share a lock (all devices of
+ * a module, unless the module uses per-device locking) are initialized one
+ * after another, in load order as far as the other dependencies allow.
+ */
+static void
+AddInitializationDependencies(const std::vector<std::shared_ptr<mmi::DeviceInstance>>& devices,
+      mmi::DependencyScheduler& schedule)
+{
+   std::map<std::string, size_t> indexOfLabel;
+   for (size_t i = 0; i < devices.size(); ++i)
+      indexOfLabel[devices[i]->GetLabel()] = i;
+
+   for (size_t i = 0; i < devices.size(); ++i)
+   {
+      const std::shared_ptr<mmi::DeviceInstance>& pDevice = devices[i];
+      mmi::DeviceModuleLockGuard guard(pDevice);
+
+      auto parent = indexOfLabel.find(pDevice->GetParentID());
+      if (parent != indexOfLabel.end())
+         schedule.AddDependency(parent->second, i);
+
+      for (const std::string& name : pDevice->GetPropertyNames())
+      {
+         if (!pDevice->GetPropertyInitStatus(name.c_str()))
+            continue;
+         auto port = indexOfLabel.find(pDevice->GetProperty(name.c_str()));
+         if (port != indexOfLabel.end() && port->second != i &&
+               devices[port->second]->GetType() == MM::SerialDevice)
+            schedule.AddDependency(port->second, i);
+      }
+   }
+
+   // Order consistent with the dependencies so far (and otherwise with the
+   // load order), so that chaining devices that share a lock cannot create a
+   // cycle
+   std::vector<size_t> order;
+   std::vector<bool> placed(devices.size(), false);
+   while (order.size() < devices.size())
+   {
+      size_t before = order.size();
+      for (size_t i = 0; i < devices.size(); ++i)
+      {
+         if (placed[i])
+            continue;
+         const auto& deps = schedule.GetDependencies(i);
+         if (std::all_of(deps.begin(), deps.end(), [&](size_t d) { return placed[d]; }))
+         {
+            placed[i] = true;
+            order.push_back(i);
+            break;
+         }
+      }
+      if (order.size() == before)
+         return; // Circular; reported when the schedule is run
+   }
+
+   std::map<const std::recursive_mutex*, size_t> lastOfLock;
+   for (size_t i : order)
+   {
+      auto inserted = lastOfLock.insert(
+            { &mmi::DeviceModuleLockGuard::GetLock(devices[i]), i });
+      if (!inserted.second)
+      {
+         schedule.AddDependency(inserted.first->second, i);
+         inserted.first->second = i;
+      }
+   }
+}
+
+
 /**
  * Calls Initialize() method for each loaded device.
- * This implementation initializes devices on separate threads, one per device module (adapter).
+ * This implementation initializes devices concurrently on a bounded number of
+ * threads, respecting the dependencies between devices (see
+ * AddInitializationDependencies()), and logs how long each device took.
  * This method also initializes allowed values for core properties, based
  * on the collection of loaded devices.
  */
 void CMMCore::initializeAllDevicesParallel() MMCORE_LEGACY_THROW(CMMError)
 {
-   std::vector<std::string> devices = deviceManager_->GetDeviceList();
-   LOG_INFO(coreLogger_) << "Will initialize " << devices.size() << " devices (in parallel)";
-   
-   std::map<std::shared_ptr<mmi::LoadedDeviceAdapter>, std::vector<std::pair<std::shared_ptr<mmi::DeviceInstance>, std::string>>> moduleMap;
-   std::vector<std::shared_ptr<mmi::DeviceInstance>> ports;
+   std::vector<std::string> labels = deviceManager_->GetDeviceList();
+   LOG_INFO(coreLogger_) << "Will initialize " << labels.size() << " devices (in parallel)";
 
-   // first round, collect all DeviceAdapters
-   for (size_t i = 0; i < devices.size(); i++)
+   std::vector<std::shared_ptr<mmi::DeviceInstance>> devices;
+   for (const std::string& label : labels)
    {
-      std::shared_ptr<mmi::DeviceInstance> pDevice;
       try {
-         pDevice = deviceManager_->GetDevice(devices[i]);
+         devices.push_back(deviceManager_->GetDevice(label));
       }
       catch (CMMError& err) {
-         logError(devices[i].c_str(), err.getMsg().c_str());
+         logError(label.c_str(), err.getMsg().c_str());
          throw;
       }
-      if (pDevice->GetType() == MM::SerialDevice)
-      {
-         ports.push_back(pDevice);
-      }
-      else {
-         std::shared_ptr<mmi::LoadedDeviceAdapter> pAdapter;
-         pAdapter = pDevice->GetAdapterModule();
+   }
 
-         if (moduleMap.find(pAdapter) == moduleMap.end())
-         {
-            std::vector<std::pair<std::shared_ptr<mmi::DeviceInstance>, std::string>> pDevices;
-            pDevices.push_back(make_pair(pDevice, devices[i]));
-            moduleMap.insert({ pAdapter, pDevices });
-         }
-         else
-         {
-            moduleMap.find(pAdapter)->second.push_back(make_pair(pDevice, devices[i]));
-         }
-      }
+   mmi::DependencyScheduler schedule(devices.size());
+   AddInitializationDependencies(devices, schedule);
+
+   // Initialization is mostly spent waiting for hardware, so use more
+   // threads than there are cores
+   const size_t maxThreads = std::max<size_t>(8, 2 * std::thread::hardware_concurrency());
+
+   std::exception_ptr pex;
+   try {
+      schedule.Run([&](size_t i) {
+         mmi::DeviceModuleLockGuard guard(devices[i]);
+         LOG_INFO(coreLogger_) << "Will initialize device " << labels[i];
+         devices[i]->Initialize();
+         LOG_INFO(coreLogger_) << "Did initialize device " << labels[i];
+      }, maxThreads);
+   }
+   catch (...) {
+      pex = std::current_exception();
    }
 
-   // Initialize ports first.  This should be fast, so no need to go parallel (also could not hurt really)
-   for (std::shared_ptr<mmi::DeviceInstance> pPort : ports)
+   const auto& timings = schedule.GetTimings();
+   std::ostringstream report;
+   report << "Device initialization times (start + duration, ms):";
+   for (size_t i = 0; i < devices.size(); ++i)
    {
-      mmi::DeviceModuleLockGuard guard(pPort);
-      LOG_INFO(coreLogger_) << "Will initialize device " << pPort->GetLabel();
-      pPort->Initialize();
-      LOG_INFO(coreLogger_) << "Did initialize device " << pPort->GetLabel();
+      if (timings[i].ran)
+         report << "\n   " << labels[i] << ": " << timings[i].startMs <<
+            " + " << timings[i].durationMs;
    }
-
-   // second round, spin up threads to initialize non-port devices, one thread per module
-   std::vector<std::future<int>> futures;
-   for (auto& moduleDevices : moduleMap) {
-      auto f = std::async(std::launch::async, &CMMCore::initializeVectorOfDevices, this, moduleDevices.second);
-      futures.push_back(std::move(f));
+   const std::vector<size_t> criticalPath = schedule.GetCriticalPath();
+   if (!criticalPath.empty())
+   {
+      const auto& last = timings[criticalPath.back()];
+      report << "\nCritical path (" << last.startMs + last.durationMs << " ms):";
+      for (size_t i : criticalPath)
+         report << "\n   " << labels[i] << ": " << timings[i].durationMs;
    }
+   LOG_INFO(coreLogger_) << report.str();
 
-   // Make sure we wait for all futures even if one or more fails, so that we
-   // handle all exceptions. Otherwise futures return by std::async may try to
-   // throw from their destructor, which will call std::terminate().
-   std::exception_ptr pex;
-   for (auto& fut : futures) {
-      try {
-         fut.get();
-      } catch (const std::exception&) {
-         if (pex) {
-            // Ignore second and subsequent exceptions
-         } else {
-            pex = std::current_exception();
-         }
-      }
-   }
    if (pex) {
       std::rethrow_exception(pex);
    }
 
    // assign default roles syncronously
-   for (auto& moduleDevices : moduleMap) {
-      for (auto& deviceLabel : moduleDevices.second) {
-         assignDefaultRole(deviceLabel.first);
-      }
+   for (const auto& pDevice : devices) {
+      assignDefaultRole(pDevice);
    }
    LOG_INFO(coreLogger_) << "Finished initializing " << devices.size() << " devices";
-
-   // not sure if this cleanup is needed, but should not hurt:
-   moduleMap.clear();
-   ports.clear();
 }
 
 
-/**
- * This helper function is executed by a single thread, allowing initializeAllDevices to operate multi-threaded.
- * All devices are supposed to originate from the same device adapter
- */
-int CMMCore::initializeVectorOfDevices(std::vector<std::pair<std::shared_ptr<mmi::DeviceInstance>, std::string>> devicesLabels) {
-   for (auto& deviceLabel : devicesLabels) {
-      mmi::DeviceModuleLockGuard guard(deviceLabel.first);
-      LOG_INFO(coreLogger_) << "Will initialize device " << deviceLabel.second;
-      deviceLabel.first->Initialize();
-      LOG_INFO(coreLogger_) << "Did initialize device " << deviceLabel.second;
-   }
-   return DEVICE_OK;
-}
-
 /**
  * Update the allowed values for the Core device role properties.
  * 
@@ -1324,6 +1454,43 @@ std::string CMMCore::getDeviceDescription(const char* label) MMCORE_LEGACY_THROW
    return pDevice->GetDescription();
 }
 
+/**
+ * Returns a handle to a loaded device.
+ *
+ * The handle can be passed instead of the label to the frequently called
+ * methods (such as setPosition(), getProperty(), and setState()), which then
+ * skip looking up the device by label. It remains valid until the device is
+ * unloaded.
+ *
+ * @param label    the device label
+ * @return the device handle
+ */
+DeviceHandle CMMCore::getDeviceHandle(const char* label) MMCORE_LEGACY_THROW(CMMError)
+{
+   if (IsCoreDeviceLabel(label))
+      throw CMMError("Device handles are not available for the Core device");
+   std::shared_ptr<mmi::DeviceInstance> pDevice = deviceManager_->GetDevice(label);
+   return DeviceHandle(pDevice, pDevice->GetLabel());
+}
+
+template <class TDeviceInstance>
+std::shared_ptr<TDeviceInstance>
+CMMCore::resolveDeviceHandle(const DeviceHandle& handle) const MMCORE_LEGACY_THROW(CMMError)
+{
+   std::shared_ptr<mmi::DeviceInstance> pDevice = handle.device_.lock();
+   if (!pDevice)
+   {
+      if (handle.label_.empty())
+         throw CMMError("Invalid device handle");
+      throw CMMError("Invalid device handle: device " +
+            ToQuotedString(handle.label_) + " has been unloaded");
+   }
+   if constexpr (std::is_same_v<TDeviceInstance, mmi::DeviceInstance>)
+      return pDevice;
+   else
+      return deviceManager_->GetDeviceOfType<TDeviceInstance>(pDevice);
+}
+
 
 /**
  * Reports action delay in milliseconds for the specific device.
@@ -1389,8 +1556,21 @@ bool CMMCore::deviceBusy(const char* label) MMCORE_LEGACY_THROW(CMMError)
 {
    if (IsCoreDeviceLabel(label))
       return false;
-   std::shared_ptr<mmi::DeviceInstance> pDevice = deviceManager_->GetDevice(label);
+   return deviceBusy(deviceManager_->GetDevice(label));
+}
 
+/**
+ * Checks the busy status of the specific device.
+ * @param device the device handle
+ * @return true if the device is busy
+ */
+bool CMMCore::deviceBusy(const DeviceHandle& device) MMCORE_LEGACY_THROW(CMMError)
+{
+   return deviceBusy(resolveDeviceHandle<mmi::DeviceInstance>(device));
+}
+
+bool CMMCore::deviceBusy(std::shared_ptr<mmi::DeviceInstance> pDevice) MMCORE_LEGACY_THROW(CMMError)
+{
    mmi::DeviceModuleLockGuard guard(pDevice);
    return pDevice->Busy();
 }
@@ -1511,6 +1691,16 @@ void CMMCore::waitForDevice(const char* label) MMCORE_LEGACY_THROW(CMMError)
    waitForDevice(pDevice);
 }
 
+/**
+ * Waits (blocks the calling thread) until the specified device becomes
+ * non-busy.
+ * @param device   the device handle
+ */
+void CMMCore::waitForDevice(const DeviceHandle& device) MMCORE_LEGACY_THROW(CMMError)
+{
+   waitForDevice(resolveDeviceHandle<mmi::DeviceInstance>(device));
+}
+
 
 /**
  * Waits (blocks the calling thread) until the specified device becomes
@@ -1526,16 +1716,30 @@ void CMMCore::waitForDevice(std::shared_ptr<mmcore::internal::DeviceInstance> pD
    auto timeout = std::chrono::duration<long long, std::milli>(effectiveTimeoutMs);
    auto deadline = now + timeout;
 
-   while (true)
+   // Devices that call OnBusyChanged() are re-checked when they signal a
+   // change, and otherwise only occasionally in case a signal was missed.
+   // Other devices are polled with an interval starting at 1 ms and doubling
+   // up to pollingIntervalMs_, so that short operations are detected promptly
+   // without adding traffic during long ones.
+   constexpr auto busyCallbackRecheckInterval = std::chrono::milliseconds(100);
+   long backoffMs = std::min(1L, pollingIntervalMs_);
+
+   // Read the change count before calling Busy(), so that a change signaled
+   // in between ends the subsequent wait immediately.
+   unsigned long long busyChangeCount = pDev->GetBusyChangeCount();
+   bool usesBusyCallback;
    {
+      mmi::DeviceModuleLockGuard guard(pDev);
+      usesBusyCallback = pDev->UsesOnBusyChanged();
+      if (!pDev->Busy())
       {
-         mmi::DeviceModuleLockGuard guard(pDev);
-         if (!pDev->Busy())
-         {
-            break;
-         }
+         LOG_DEBUG(coreLogger_) << "Finished waiting for device " << pDev->GetLabel();
+         return;
       }
+   }
 
+   while (true)
+   {
       if (std::chrono::steady_clock::now() > deadline)
       {
          std::string label = pDev->GetLabel();
@@ -1547,11 +1751,54 @@ void CMMCore::waitForDevice(std::shared_ptr<mmcore::internal::DeviceInstance> pD
                MMERR_DevicePollingTimeout);
       }
 
-     sleep(pollingIntervalMs_);
+      if (usesBusyCallback)
+      {
+         std::chrono::steady_clock::time_point until = deadline;
+         auto recheck = std::chrono::steady_clock::now() + busyCallbackRecheckInterval;
+         if (recheck < until)
+            until = recheck;
+         pDev->WaitForBusyChange(busyChangeCount, until);
+      }
+      else
+      {
+         sleep(backoffMs);
+         backoffMs = std::min(2 * backoffMs, pollingIntervalMs_);
+      }
+
+      busyChangeCount = pDev->GetBusyChangeCount();
+      {
+         mmi::DeviceModuleLockGuard guard(pDev);
+         if (!pDev->Busy())
+         {
+            break;
+         }
+      }
    }
    LOG_DEBUG(coreLogger_) << "Finished waiting for device " << pDev->GetLabel();
 }
 
+/*
+ * Splits devices into groups that share a lock (the module lock, or the
+ * device's own lock for modules with per-device locking), preserving the
+ * order of first appearance.
+ */
+static std::vector<std::vector<std::shared_ptr<mmi::DeviceInstance>>>
+GroupDevicesByLock(const std::vector<std::shared_ptr<mmi::DeviceInstance>>& devices)
+{
+   std::vector<std::vector<std::shared_ptr<mmi::DeviceInstance>>> groups;
+   std::map<const std::recursive_mutex*, size_t> groupIndex;
+   for (const auto& pDevice : devices)
+   {
+      auto inserted = groupIndex.insert(
+            { &mmi::DeviceModuleLockGuard::GetLock(pDevice), groups.size() });
+      if (inserted.second)
+         groups.emplace_back();
+      groups[inserted.first->second].push_back(pDevice);
+   }
+   return groups;
+}
+
+
 /**
  * Checks the busy status of the entire system. The system will report busy if any
  * of the devices is busy.
@@ -1581,34 +1828,61 @@ void CMMCore::waitForSystem() MMCORE_LEGACY_THROW(CMMError)
  */
 bool CMMCore::deviceTypeBusy(MM::DeviceType devType) MMCORE_LEGACY_THROW(CMMError)
 {
-   std::vector<std::string> devices = deviceManager_->GetDeviceList(devType);
-   for (size_t i=0; i<devices.size(); i++)
+   auto groups = GroupDevicesByLock(getDevicesOfType(devType));
+
+   // Groups are queried concurrently; within a group, stop at the first busy
+   // device.
+   auto groupBusy = [](const std::vector<std::shared_ptr<mmi::DeviceInstance>>& group)
    {
-      try {
-         std::shared_ptr<mmi::DeviceInstance> pDevice =
-            deviceManager_->GetDevice(devices[i]);
-         mmi::DeviceModuleLockGuard guard(pDevice);
-         if (pDevice->Busy())
-            return true;
-      }
-      catch (...) {
-         // trap all exceptions
-         assert(!"Plugin manager can't access device it reported as available.");
+      for (const auto& pDevice : group)
+      {
+         try {
+            mmi::DeviceModuleLockGuard guard(pDevice);
+            if (pDevice->Busy())
+               return true;
+         }
+         catch (...) {
+            // trap all exceptions
+            assert(!"Plugin manager can't access device it reported as available.");
+         }
       }
+      return false;
+   };
+
+   if (groups.size() <= 1)
+   {
+      return !groups.empty() && groupBusy(groups.front());
    }
-   return false;
+
+   std::vector<std::future<bool>> futures;
+   for (const auto& group : groups)
+   {
+      futures.push_back(std::async(std::launch::async,
+            groupBusy, std::cref(group)));
+   }
+
+   bool busy = false;
+   for (auto& fut : futures)
+   {
+      if (fut.get())
+         busy = true;
+   }
+   return busy;
 }
 
 
 /**
  * Blocks until all devices of the specific type become ready (not-busy).
+ *
+ * Devices belonging to different device adapter modules are waited for
+ * concurrently, and each device is no longer queried once it has become
+ * ready.
+ *
  * @param devType    a constant specifying the device type
  */
 void CMMCore::waitForDeviceType(MM::DeviceType devType) MMCORE_LEGACY_THROW(CMMError)
 {
-   std::vector<std::string> devices = deviceManager_->GetDeviceList(devType);
-   for (size_t i=0; i<devices.size(); i++)
-      waitForDevice(devices[i].c_str());
+   waitForDevices(getDevicesOfType(devType));
 }
 
 /**
@@ -1638,10 +1912,22 @@ void CMMCore::waitForConfig(const char* group, const char* configName) MMCORE_LE
  */
 void CMMCore::setPosition(const char* label, double position) MMCORE_LEGACY_THROW(CMMError)
 {
-   std::shared_ptr<mmi::StageInstance> pStage =
-      deviceManager_->GetDeviceOfType<mmi::StageInstance>(label);
+   setPosition(deviceManager_->GetDeviceOfType<mmi::StageInstance>(label), position);
+}
 
-   LOG_DEBUG(coreLogger_) << "Will start absolute move of " << label <<
+/**
+ * Sets the position of the stage in microns.
+ * @param stage     the stage device handle
+ * @param position  the desired stage position, in microns
+ */
+void CMMCore::setPosition(const DeviceHandle& stage, double position) MMCORE_LEGACY_THROW(CMMError)
+{
+   setPosition(resolveDeviceHandle<mmi::StageInstance>(stage), position);
+}
+
+void CMMCore::setPosition(std::shared_ptr<mmi::StageInstance> pStage, double position) MMCORE_LEGACY_THROW(CMMError)
+{
+   LOG_DEBUG(coreLogger_) << "Will start absolute move of " << pStage->GetLabel() <<
       " to position " << std::fixed << std::setprecision(5) << position <<
       " um";
 
@@ -1653,6 +1939,7 @@ void CMMCore::setPosition(const char* label, double position) MMCORE_LEGACY_THRO
       throw CMMError(getDeviceErrorText(ret, pStage).c_str(), MMERR_DEVICE_GENERIC);
    }
 }
+
 /**
  * Sets the position of the stage in microns. Uses the current Z positioner
  * (focus) device.
@@ -1670,10 +1957,22 @@ void CMMCore::setPosition(double position) MMCORE_LEGACY_THROW(CMMError)
  */
 void CMMCore::setRelativePosition(const char* label, double d) MMCORE_LEGACY_THROW(CMMError)
 {
-   std::shared_ptr<mmi::StageInstance> pStage =
-      deviceManager_->GetDeviceOfType<mmi::StageInstance>(label);
+   setRelativePosition(deviceManager_->GetDeviceOfType<mmi::StageInstance>(label), d);
+}
+
+/**
+ * Sets the relative position of the stage in microns.
+ * @param stage    the single-axis drive device handle
+ * @param d        the amount to move the stage, in microns (positive or negative)
+ */
+void CMMCore::setRelativePosition(const DeviceHandle& stage, double d) MMCORE_LEGACY_THROW(CMMError)
+{
+   setRelativePosition(resolveDeviceHandle<mmi::StageInstance>(stage), d);
+}
 
-   LOG_DEBUG(coreLogger_) << "Will start relative move of " << label <<
+void CMMCore::setRelativePosition(std::shared_ptr<mmi::StageInstance> pStage, double d) MMCORE_LEGACY_THROW(CMMError)
+{
+   LOG_DEBUG(coreLogger_) << "Will start relative move of " << pStage->GetLabel() <<
       " by offset " << std::fixed << std::setprecision(5) << d << " um";
 
    mmi::DeviceModuleLockGuard guard(pStage);
@@ -1703,9 +2002,21 @@ void CMMCore::setRelativePosition(double d) MMCORE_LEGACY_THROW(CMMError)
  */
 double CMMCore::getPosition(const char* label) MMCORE_LEGACY_THROW(CMMError)
 {
-   std::shared_ptr<mmi::StageInstance> pStage =
-      deviceManager_->GetDeviceOfType<mmi::StageInstance>(label);
+   return getPosition(deviceManager_->GetDeviceOfType<mmi::StageInstance>(label));
+}
+
+/**
+ * Returns the current position of the stage in microns.
+ * @return the position in microns
+ * @param stage     the single-axis drive device handle
+ */
+double CMMCore::getPosition(const DeviceHandle& stage) MMCORE_LEGACY_THROW(CMMError)
+{
+   return getPosition(resolveDeviceHandle<mmi::StageInstance>(stage));
+}
 
+double CMMCore::getPosition(std::shared_ptr<mmi::StageInstance> pStage) MMCORE_LEGACY_THROW(CMMError)
+{
    mmi::DeviceModuleLockGuard guard(pStage);
    double pos;
    int ret = pStage->GetPositionUm(pos);
@@ -1735,10 +2046,23 @@ double CMMCore::getPosition() MMCORE_LEGACY_THROW(CMMError)
  */
 void CMMCore::setXYPosition(const char* label, double x, double y) MMCORE_LEGACY_THROW(CMMError)
 {
-   std::shared_ptr<mmi::XYStageInstance> pXYStage =
-      deviceManager_->GetDeviceOfType<mmi::XYStageInstance>(label);
+   setXYPosition(deviceManager_->GetDeviceOfType<mmi::XYStageInstance>(label), x, y);
+}
+
+/**
+ * Sets the position of the XY stage in microns.
+ * @param xyStage  the XY stage device handle
+ * @param x        the X axis position in microns
+ * @param y        the Y axis position in microns
+ */
+void CMMCore::setXYPosition(const DeviceHandle& xyStage, double x, double y) MMCORE_LEGACY_THROW(CMMError)
+{
+   setXYPosition(resolveDeviceHandle<mmi::XYStageInstance>(xyStage), x, y);
+}
 
-   LOG_DEBUG(coreLogger_) << "Will start absolute move of " << label <<
+void CMMCore::setXYPosition(std::shared_ptr<mmi::XYStageInstance> pXYStage, double x, double y) MMCORE_LEGACY_THROW(CMMError)
+{
+   LOG_DEBUG(coreLogger_) << "Will start absolute move of " << pXYStage->GetLabel() <<
       " to position (" << std::fixed << std::setprecision(3) << x << ", " <<
       y << ") um";
 
@@ -1770,10 +2094,23 @@ void CMMCore::setXYPosition(double x, double y) MMCORE_LEGACY_THROW(CMMError)
  */
 void CMMCore::setRelativeXYPosition(const char* label, double dx, double dy) MMCORE_LEGACY_THROW(CMMError)
 {
-   std::shared_ptr<mmi::XYStageInstance> pXYStage =
-      deviceManager_->GetDeviceOfType<mmi::XYStageInstance>(label);
+   setRelativeXYPosition(deviceManager_->GetDeviceOfType<mmi::XYStageInstance>(label), dx, dy);
+}
+
+/**
+ * Sets the relative position of the XY stage in microns.
+ * @param xyStage  the xy stage device handle
+ * @param dx       the distance to move in X (positive or negative)
+ * @param dy       the distance to move in Y (positive or negative)
+ */
+void CMMCore::setRelativeXYPosition(const DeviceHandle& xyStage, double dx, double dy) MMCORE_LEGACY_THROW(CMMError)
+{
+   setRelativeXYPosition(resolveDeviceHandle<mmi::XYStageInstance>(xyStage), dx, dy);
+}
 
-   LOG_DEBUG(coreLogger_) << "Will start relative move of " << label <<
+void CMMCore::setRelativeXYPosition(std::shared_ptr<mmi::XYStageInstance> pXYStage, double dx, double dy) MMCORE_LEGACY_THROW(CMMError)
+{
+   LOG_DEBUG(coreLogger_) << "Will start relative move of " << pXYStage->GetLabel() <<
       " by (" << std::fixed << std::setprecision(3) << dx << ", " << dy <<
       ") um";
 
@@ -1804,9 +2141,22 @@ void CMMCore::setRelativeXYPosition(double dx, double dy) MMCORE_LEGACY_THROW(CM
  */
 void CMMCore::getXYPosition(const char* label, double& x, double& y) MMCORE_LEGACY_THROW(CMMError)
 {
-   std::shared_ptr<mmi::XYStageInstance> pXYStage =
-      deviceManager_->GetDeviceOfType<mmi::XYStageInstance>(label);
+   getXYPosition(deviceManager_->GetDeviceOfType<mmi::XYStageInstance>(label), x, y);
+}
+
+/**
+ * Obtains the current position of the XY stage in microns.
+ * @param xyStage the XY stage device handle
+ * @param x       a return parameter yielding the X position in microns
+ * @param y       a return parameter yielding the Y position in microns
+ */
+void CMMCore::getXYPosition(const DeviceHandle& xyStage, double& x, double& y) MMCORE_LEGACY_THROW(CMMError)
+{
+   getXYPosition(resolveDeviceHandle<mmi::XYStageInstance>(xyStage), x, y);
+}
 
+void CMMCore::getXYPosition(std::shared_ptr<mmi::XYStageInstance> pXYStage, double& x, double& y) MMCORE_LEGACY_THROW(CMMError)
+{
    mmi::DeviceModuleLockGuard guard(pXYStage);
    int ret = pXYStage->GetPositionUm(x, y);
    if (ret != DEVICE_OK)
@@ -1834,18 +2184,8 @@ void CMMCore::getXYPosition(double& x, double& y) MMCORE_LEGACY_THROW(CMMError)
  */
 double CMMCore::getXPosition(const char* label) MMCORE_LEGACY_THROW(CMMError)
 {
-   std::shared_ptr<mmi::XYStageInstance> pXYStage =
-      deviceManager_->GetDeviceOfType<mmi::XYStageInstance>(label);
-
-   mmi::DeviceModuleLockGuard guard(pXYStage);
    double x, y;
-   int ret = pXYStage->GetPositionUm(x, y);
-   if (ret != DEVICE_OK)
-   {
-      logError(pXYStage->GetName().c_str(), getDeviceErrorText(ret, pXYStage).c_str());
-      throw CMMError(getDeviceErrorText(ret, pXYStage).c_str(), MMERR_DEVICE_GENERIC);
-   }
-
+   getXYPosition(deviceManager_->GetDeviceOfType<mmi::XYStageInstance>(label), x, y);
    return x;
 }
 
@@ -1866,18 +2206,8 @@ double CMMCore::getXPosition() MMCORE_LEGACY_THROW(CMMError)
  */
 double CMMCore::getYPosition(const char* label) MMCORE_LEGACY_THROW(CMMError)
 {
-   std::shared_ptr<mmi::XYStageInstance> pXYStage =
-      deviceManager_->GetDeviceOfType<mmi::XYStageInstance>(label);
-
-   mmi::DeviceModuleLockGuard guard(pXYStage);
    double x, y;
-   int ret = pXYStage->GetPositionUm(x, y);
-   if (ret != DEVICE_OK)
-   {
-      logError(pXYStage->GetName().c_str(), getDeviceErrorText(ret, pXYStage).c_str());
-      throw CMMError(getDeviceErrorText(ret, pXYStage).c_str(), MMERR_DEVICE_GENERIC);
-   }
-
+   getXYPosition(deviceManager_->GetDeviceOfType<mmi::XYStageInstance>(label), x, y);
    return y;
 }
 
@@ -2905,6 +3235,9 @@ bool CMMCore::getShutterOpen() MMCORE_LEGACY_THROW(CMMError)
  * on little endian the format is BGRA888 
  * (see: https://en.wikipedia.org/wiki/RGBA_color_model).
  *
+ * If the camera's images are demosaiced by the Core (see setCameraDemosaic()),
+ * the image is demosaiced on the calling thread and returned as RGB_32.
+ *
  * @return a pointer to the internal image buffer.
  * @throws CMMError   when the camera returns no data
  */
@@ -2932,6 +3265,8 @@ void* CMMCore::getImage() MMCORE_LEGACY_THROW(CMMError)
 	      {
             imageProcessor->Process((unsigned char*)pBuf, camera->GetImageWidth(),  camera->GetImageHeight(), camera->GetImageBytesPerPixel() );
 	      }
+         if (pBuf != 0)
+            pBuf = demosaicSnappedImage(camera, static_cast<unsigned char*>(pBuf));
 		} catch( CMMError& e){
 			throw e;
 		} catch (...) {
@@ -2979,6 +3314,8 @@ void* CMMCore::getImage(unsigned channelNr) MMCORE_LEGACY_THROW(CMMError)
 	      {
             imageProcessor->Process((unsigned char*)pBuf, camera->GetImageWidth(),  camera->GetImageHeight(), camera->GetImageBytesPerPixel() );
 	      }
+         if (pBuf != 0)
+            pBuf = demosaicSnappedImage(camera, static_cast<unsigned char*>(pBuf));
 		} catch( CMMError& e){
 			throw e;
 		} catch (...) {
@@ -2999,6 +3336,9 @@ void* CMMCore::getImage(unsigned channelNr) MMCORE_LEGACY_THROW(CMMError)
 /**
 * Returns the size of the internal image buffer.
 *
+* For a camera whose images are demosaiced (see setCameraDemosaic()), this
+* is the size of the RGB32 image.
+*
 * @return buffer size
 */
 long CMMCore::getImageBufferSize()
@@ -3008,6 +3348,9 @@ long CMMCore::getImageBufferSize()
       try
       {
          mmi::DeviceModuleLockGuard guard(camera);
+         if (getCameraDemosaic(camera))
+            return static_cast<long>(camera->GetImageWidth()) *
+               camera->GetImageHeight() * 4;
          return camera->GetImageBufferSize();
       }
       catch (const CMMError&) // Possibly uninitialized camera
@@ -3046,10 +3389,7 @@ void CMMCore::startSequenceAcquisition(long numImages, double unused, bool stopO
 
       try
       {
-         if (!cbuf_->Initialize(
-               static_cast<std::size_t>(camera->GetImageWidth()) *
-               camera->GetImageHeight() *
-               camera->GetImageBytesPerPixel()))
+         if (!initializeCircularBufferFor(camera))
          {
             logError(getDeviceName(camera).c_str(), getCoreErrorText(MMERR_CircularBufferFailedToInitialize).c_str());
             throw CMMError(getCoreErrorText(MMERR_CircularBufferFailedToInitialize).c_str(), MMERR_CircularBufferFailedToInitialize);
@@ -3108,10 +3448,7 @@ void CMMCore::startSequenceAcquisition(const char* label, long numImages, double
       throw CMMError(getCoreErrorText(MMERR_NotAllowedDuringSequenceAcquisition).c_str(),
                      MMERR_NotAllowedDuringSequenceAcquisition);
 
-   if (!cbuf_->Initialize(
-         static_cast<std::size_t>(pCam->GetImageWidth()) *
-         pCam->GetImageHeight() *
-         pCam->GetImageBytesPerPixel()))
+   if (!initializeCircularBufferFor(pCam))
    {
       logError(getDeviceName(pCam).c_str(), getCoreErrorText(MMERR_CircularBufferFailedToInitialize).c_str());
       throw CMMError(getCoreErrorText(MMERR_CircularBufferFailedToInitialize).c_str(), MMERR_CircularBufferFailedToInitialize);
@@ -3163,10 +3500,7 @@ void CMMCore::initializeCircularBuffer() MMCORE_LEGACY_THROW(CMMError)
    if (camera)
    {
       mmi::DeviceModuleLockGuard guard(camera);
-      if (!cbuf_->Initialize(
-            static_cast<std::size_t>(camera->GetImageWidth()) *
-            camera->GetImageHeight() *
-            camera->GetImageBytesPerPixel()))
+      if (!initializeCircularBufferFor(camera))
       {
          logError(getDeviceName(camera).c_str(), getCoreErrorText(MMERR_CircularBufferFailedToInitialize).c_str());
          throw CMMError(getCoreErrorText(MMERR_CircularBufferFailedToInitialize).c_str(), MMERR_CircularBufferFailedToInitialize);
@@ -3223,10 +3557,7 @@ void CMMCore::startContinuousSequenceAcquisition(double unused) MMCORE_LEGACY_TH
             ,MMERR_NotAllowedDuringSequenceAcquisition);
       }
 
-      if (!cbuf_->Initialize(
-            static_cast<std::size_t>(camera->GetImageWidth()) *
-            camera->GetImageHeight() *
-            camera->GetImageBytesPerPixel()))
+      if (!initializeCircularBufferFor(camera))
       {
          logError(getDeviceName(camera).c_str(), getCoreErrorText(MMERR_CircularBufferFailedToInitialize).c_str());
          throw CMMError(getCoreErrorText(MMERR_CircularBufferFailedToInitialize).c_str(), MMERR_CircularBufferFailedToInitialize);
@@ -3389,6 +3720,28 @@ void* CMMCore::getNBeforeLastImageMD(unsigned long n, Metadata& md) const MMCORE
       throw CMMError(getCoreErrorText(MMERR_CircularBufferEmpty).c_str(), MMERR_CircularBufferEmpty);
 }
 
+// Completes the latency measurement of a frame that has just been popped
+// from the circular buffer, adding the timings as tags to md if requested.
+static void RecordPoppedFrame(mmi::FrameLatencyStats& latencyStats,
+   const mmi::FrameBuffer& frame, Metadata* md)
+{
+   const mmi::FrameTiming& timing = frame.GetTiming();
+   if (!timing.timed)
+      return;
+   const auto popped = std::chrono::steady_clock::now();
+   if (timing.stats && latencyStats.IsEnabled())
+      timing.stats->RecordPopped(timing, popped);
+   if (md && latencyStats.AreTagsEnabled())
+   {
+      using namespace std::chrono;
+      const auto us = [](steady_clock::duration d)
+      { return duration_cast<duration<double, std::micro>>(d).count(); };
+      md->PutImageTag("CoreProcessTime-us", us(timing.processed - timing.received));
+      md->PutImageTag("CoreCopyTime-us", us(timing.copied - timing.processed));
+      md->PutImageTag("CoreQueueTime-us", us(popped - timing.copied));
+   }
+}
+
 /**
  * Gets and removes the next image from the circular buffer.
  * Returns 0 if the buffer is empty.
@@ -3403,9 +3756,12 @@ void* CMMCore::getNBeforeLastImageMD(unsigned long n, Metadata& md) const MMCORE
  */
 void* CMMCore::popNextImage() MMCORE_LEGACY_THROW(CMMError)
 {
-   unsigned char* pBuf = const_cast<unsigned char*>(cbuf_->GetNextImage());
+   const mmi::FrameBuffer* pBuf = cbuf_->GetNextImageBuffer();
    if (pBuf != 0)
-      return pBuf;
+   {
+      RecordPoppedFrame(*latencyStats_, *pBuf, nullptr);
+      return const_cast<unsigned char*>(pBuf->GetPixels());
+   }
    else
       throw CMMError(getCoreErrorText(MMERR_CircularBufferEmpty).c_str(), MMERR_CircularBufferEmpty);
 }
@@ -3428,6 +3784,7 @@ void* CMMCore::popNextImageMD(unsigned channel, unsigned slice, Metadata& md) MM
    if (pBuf != 0)
    {
       md.Restore(pBuf->GetSerializedMetadata().c_str());
+      RecordPoppedFrame(*latencyStats_, *pBuf, &md);
       return const_cast<unsigned char*>(pBuf->GetPixels());
    }
    else
@@ -3442,6 +3799,59 @@ void* CMMCore::popNextImageMD(Metadata& md) MMCORE_LEGACY_THROW(CMMError)
    return popNextImageMD(0, 0, md);
 }
 
+// Returns the pixels of a frame as received from the camera, describing them
+// in md (which must hold the frame's metadata)
+static void* RawPixels(const mmi::FrameBuffer& frame, Metadata& md)
+{
+   if (!frame.HasRawPixels())
+      return const_cast<unsigned char*>(frame.GetPixels());
+   if (md.HasTag("RawPixelType"))
+   {
+      md.PutImageTag(MM::g_Keyword_PixelType,
+            md.GetSingleTag("RawPixelType").GetValue());
+   }
+   return const_cast<unsigned char*>(frame.GetRawPixels());
+}
+
+/**
+ * Returns the image that was last inserted into the circular buffer, as it
+ * was received from the camera, and its metadata.
+ *
+ * For images demosaiced by the Core (see setCameraDemosaic()), this gives the
+ * raw (Bayer mosaic) pixels, and the PixelType tag of md gives their type
+ * (GRAY8 or GRAY16); other images are the same as from getLastImageMD().
+ */
+void* CMMCore::getLastRawImageMD(Metadata& md) const MMCORE_LEGACY_THROW(CMMError)
+{
+   const mmi::FrameBuffer* pBuf = cbuf_->GetTopImageBuffer();
+   if (pBuf != 0)
+   {
+      md.Restore(pBuf->GetSerializedMetadata().c_str());
+      return RawPixels(*pBuf, md);
+   }
+   else
+      throw CMMError(getCoreErrorText(MMERR_CircularBufferEmpty).c_str(), MMERR_CircularBufferEmpty);
+}
+
+/**
+ * Gets and removes the next image from the circular buffer, returning it as
+ * it was received from the camera, with its metadata.
+ *
+ * See getLastRawImageMD() for the pixels returned.
+ */
+void* CMMCore::popNextRawImageMD(Metadata& md) MMCORE_LEGACY_THROW(CMMError)
+{
+   const mmi::FrameBuffer* pBuf = cbuf_->GetNextImageBuffer();
+   if (pBuf != 0)
+   {
+      md.Restore(pBuf->GetSerializedMetadata().c_str());
+      RecordPoppedFrame(*latencyStats_, *pBuf, &md);
+      return RawPixels(*pBuf, md);
+   }
+   else
+      throw CMMError(getCoreErrorText(MMERR_CircularBufferEmpty).c_str(), MMERR_CircularBufferEmpty);
+}
+
 /**
  * Removes all images from the circular buffer.
  *
@@ -3483,10 +3893,7 @@ void CMMCore::setCircularBufferMemoryFootprint(unsigned sizeMB ///< n megabytes
       if (camera)
 		{
          mmi::DeviceModuleLockGuard guard(camera);
-         if (!cbuf_->Initialize(
-               static_cast<std::size_t>(camera->GetImageWidth()) *
-               camera->GetImageHeight() *
-               camera->GetImageBytesPerPixel()))
+         if (!initializeCircularBufferFor(camera))
 				throw CMMError(getCoreErrorText(MMERR_CircularBufferFailedToInitialize).c_str(), MMERR_CircularBufferFailedToInitialize);
          callback_->ResetImageInsertionState();
 		}
@@ -3554,6 +3961,338 @@ long CMMCore::getBufferFreeCapacity()
    return 0;
 }
 
+/**
+ * Returns the largest number of images that have been waiting in the circular
+ * buffer at any one time since the buffer was last initialized (e.g. at the
+ * start of a sequence acquisition) or resetFrameLatencyStats() was called.
+ */
+long CMMCore::getBufferHighWaterMark()
+{
+   if (cbuf_)
+   {
+      return static_cast<long>(cbuf_->GetHighWaterMark());
+   }
+   return 0;
+}
+
+/**
+ * Enables or disables the collection of per-camera latency statistics for
+ * sequence images.
+ *
+ * While enabled, each image inserted into the circular buffer is timestamped
+ * on arrival from the camera, after metadata generation and image
+ * processing, after being copied into the buffer, and when it is popped.
+ * The resulting durations are accumulated in histograms for each camera and
+ * for each of the stages "Process" (arrival to processed), "Copy" (processed
+ * to copied), "Queue" (copied to popped) and "Total" (arrival to popped).
+ *
+ * Only images popped with popNextImage() or popNextImageMD() contribute to
+ * the Queue and Total stages. Disabling does not discard the statistics
+ * collected so far.
+ */
+void CMMCore::enableFrameLatencyStats(bool enable)
+{
+   latencyStats_->Enable(enable);
+}
+
+/**
+ * Returns whether latency statistics for sequence images are being collected.
+ */
+bool CMMCore::isFrameLatencyStatsEnabled()
+{
+   return latencyStats_->IsEnabled();
+}
+
+/**
+ * Enables or disables latency tags in the metadata of sequence images.
+ *
+ * When enabled, images returned by popNextImageMD() carry the tags
+ * CoreProcessTime-us, CoreCopyTime-us and CoreQueueTime-us, giving the
+ * duration of each stage (see enableFrameLatencyStats()) in microseconds.
+ * Only images inserted while tags or statistics were enabled are tagged.
+ */
+void CMMCore::enableFrameLatencyTags(bool enable)
+{
+   latencyStats_->EnableTags(enable);
+}
+
+/**
+ * Returns whether latency tags are added to the metadata of sequence images.
+ */
+bool CMMCore::isFrameLatencyTagsEnabled()
+{
+   return latencyStats_->AreTagsEnabled();
+}
+
+/**
+ * Returns the labels of the cameras for which latency statistics have been
+ * collected.
+ */
+std::vector<std::string> CMMCore::getFrameLatencyStatsCameras()
+{
+   return latencyStats_->GetCameraLabels();
+}
+
+/**
+ * Returns a percentile of the latency of a stage, in microseconds.
+ *
+ * The value is accurate to about 3%. Returns 0 if no images have been
+ * recorded for the camera.
+ *
+ * @param cameraLabel the camera label
+ * @param stage one of "Process", "Copy", "Queue" or "Total"
+ * @param percentile the percentile, from 0 to 100 (100 gives the maximum)
+ */
+double CMMCore::getFrameLatencyPercentileUs(const char* cameraLabel,
+   const char* stage, double percentile) MMCORE_LEGACY_THROW(CMMError)
+{
+   CheckDeviceLabel(cameraLabel);
+   const mmi::LatencyStage s = mmi::FrameLatencyStats::ParseStage(stage ? stage : "");
+   const mmi::CameraLatencyStats* stats = latencyStats_->FindCamera(cameraLabel);
+   return stats ? stats->Get(s).GetPercentileUs(percentile) : 0.0;
+}
+
+/**
+ * Returns the mean latency of a stage, in microseconds.
+ *
+ * Returns 0 if no images have been recorded for the camera.
+ *
+ * @param cameraLabel the camera label
+ * @param stage one of "Process", "Copy", "Queue" or "Total"
+ */
+double CMMCore::getFrameLatencyMeanUs(const char* cameraLabel,
+   const char* stage) MMCORE_LEGACY_THROW(CMMError)
+{
+   CheckDeviceLabel(cameraLabel);
+   const mmi::LatencyStage s = mmi::FrameLatencyStats::ParseStage(stage ? stage : "");
+   const mmi::CameraLatencyStats* stats = latencyStats_->FindCamera(cameraLabel);
+   return stats ? stats->Get(s).GetMeanUs() : 0.0;
+}
+
+/**
+ * Returns the number of images recorded for a stage.
+ *
+ * @param cameraLabel the camera label
+ * @param stage one of "Process", "Copy", "Queue" or "Total"
+ */
+long CMMCore::getFrameLatencyCount(const char* cameraLabel,
+   const char* stage) MMCORE_LEGACY_THROW(CMMError)
+{
+   CheckDeviceLabel(cameraLabel);
+   const mmi::LatencyStage s = mmi::FrameLatencyStats::ParseStage(stage ? stage : "");
+   const mmi::CameraLatencyStats* stats = latencyStats_->FindCamera(cameraLabel);
+   return stats ? static_cast<long>(stats->Get(s).GetCount()) : 0;
+}
+
+/**
+ * Discards the frame latency statistics of all cameras and resets the
+ * circular buffer high-water mark to the current number of images.
+ */
+void CMMCore::resetFrameLatencyStats()
+{
+   latencyStats_->Reset();
+   if (cbuf_)
+      cbuf_->ResetHighWaterMark();
+}
+
+/**
+ * Demosaics the raw Bayer images of a camera in the Core.
+ *
+ * Sequence images of 8 or 16 bits per pixel (and 1 component) from the
+ * camera are copied into the circular buffer as received, then demosaiced on
+ * the Core's worker threads rather than on the camera's acquisition thread.
+ * Images become available to popNextImage() and the like, in the order they
+ * were inserted, once demosaiced; they are RGB_32, with the tags
+ * DemosaicPattern, DemosaicAlgorithm and RawPixelType. The raw pixels remain
+ * available from getLastRawImageMD() and popNextRawImageMD().
+ *
+ * While this camera is the current camera, snapped images (getImage()) are
+ * demosaiced too, and getBytesPerPixel(), getNumberOfComponents(),
+ * getImageBitDepth() and getImageBufferSize() describe RGB_32 images.
+ *
+ * Takes effect when the circular buffer is next initialized (e.g. when a
+ * sequence acquisition is started), and only if it is initialized for this
+ * camera. The settings apply to every image inserted into that buffer,
+ * whichever camera inserts it: the images of the physical cameras of a Multi
+ * Camera are demosaiced according to the settings of the Multi Camera, and
+ * their own settings are ignored.
+ *
+ * @param cameraLabel the camera label
+ * @param cfaPattern the color filter array pattern, named by the colors of
+ *                   the top-left 2x2 pixels (see getDemosaicPatterns())
+ * @param algorithm the algorithm (see getDemosaicAlgorithms())
+ * @param bitDepth the number of significant bits in the raw pixels, scaled
+ *                 to 8 bits per component; 0 to use the full pixel range
+ * @throws CMMError if the camera is acquiring a sequence or a parameter is
+ *                  invalid
+ */
+void CMMCore::setCameraDemosaic(const char* cameraLabel, const char* cfaPattern,
+   const char* algorithm, unsigned bitDepth) MMCORE_LEGACY_THROW(CMMError)
+{
+   CheckDeviceLabel(cameraLabel);
+   std::shared_ptr<mmi::CameraInstance> pCam =
+      deviceManager_->GetDeviceOfType<mmi::CameraInstance>(cameraLabel);
+   auto config = std::make_shared<const mmi::DemosaicConfig>(
+         cfaPattern ? cfaPattern : "", algorithm ? algorithm : "", bitDepth);
+
+   mmi::DeviceModuleLockGuard guard(pCam);
+   if (pCam->IsCapturing())
+      throw CMMError(getCoreErrorText(MMERR_NotAllowedDuringSequenceAcquisition).c_str(),
+                     MMERR_NotAllowedDuringSequenceAcquisition);
+   demosaicStage_->Set(cameraLabel, std::move(config));
+   LOG_DEBUG(coreLogger_) << "Will demosaic images from camera " << cameraLabel <<
+      " (" << cfaPattern << ", " << algorithm << ")";
+}
+
+/**
+ * Stops demosaicing the images of a camera (see setCameraDemosaic()).
+ *
+ * @param cameraLabel the camera label
+ * @throws CMMError if the camera is acquiring a sequence
+ */
+void CMMCore::clearCameraDemosaic(const char* cameraLabel) MMCORE_LEGACY_THROW(CMMError)
+{
+   CheckDeviceLabel(cameraLabel);
+   std::shared_ptr<mmi::CameraInstance> pCam =
+      deviceManager_->GetDeviceOfType<mmi::CameraInstance>(cameraLabel);
+
+   mmi::DeviceModuleLockGuard guard(pCam);
+   if (pCam->IsCapturing())
+      throw CMMError(getCoreErrorText(MMERR_NotAllowedDuringSequenceAcquisition).c_str(),
+                     MMERR_NotAllowedDuringSequenceAcquisition);
+   demosaicStage_->Remove(cameraLabel);
+}
+
+/**
+ * Returns whether the images of a camera are demosaiced by the Core.
+ *
+ * @param cameraLabel the camera label
+ */
+bool CMMCore::isCameraDemosaicEnabled(const char* cameraLabel) MMCORE_LEGACY_THROW(CMMError)
+{
+   CheckDeviceLabel(cameraLabel);
+   return demosaicStage_->Get(cameraLabel) != nullptr;
+}
+
+/**
+ * Returns the color filter array patterns accepted by setCameraDemosaic().
+ */
+std::vector<std::string> CMMCore::getDemosaicPatterns()
+{
+   return mmi::DemosaicStage::GetPatterns();
+}
+
+/**
+ * Returns the algorithms accepted by setCameraDemosaic().
+ */
+std::vector<std::string> CMMCore::getDemosaicAlgorithms()
+{
+   return mmi::DemosaicStage::GetAlgorithms();
+}
+
+std::shared_ptr<const mmi::DemosaicConfig>
+CMMCore::getCameraDemosaic(std::shared_ptr<mmi::CameraInstance> pCamera)
+{
+   if (!demosaicStage_->IsActive())
+      return nullptr;
+   return demosaicStage_->Find(pCamera->GetLabel(),
+         pCamera->GetImageBytesPerPixel(), pCamera->GetNumberOfComponents());
+}
+
+bool CMMCore::initializeCircularBufferFor(std::shared_ptr<mmi::CameraInstance> pCamera)
+{
+   const auto sizes = demosaicStage_->InitializeBuffer(pCamera->GetLabel(),
+         pCamera->GetImageWidth(), pCamera->GetImageHeight(),
+         pCamera->GetImageBytesPerPixel(), pCamera->GetNumberOfComponents());
+   return cbuf_->Initialize(sizes.first, sizes.second);
+}
+
+// Returns pBuf, or the demosaiced image if the camera's images are demosaiced
+void* CMMCore::demosaicSnappedImage(std::shared_ptr<mmi::CameraInstance> pCamera,
+   const unsigned char* pBuf)
+{
+   std::shared_ptr<const mmi::DemosaicConfig> demosaic = getCameraDemosaic(pCamera);
+   if (!demosaic)
+      return const_cast<unsigned char*>(pBuf);
+   const unsigned width = pCamera->GetImageWidth();
+   const unsigned height = pCamera->GetImageHeight();
+   demosaicedImage_.resize(static_cast<std::size_t>(width) * height * 4);
+   demosaic->Convert(pBuf, width, height, pCamera->GetImageBytesPerPixel(),
+         demosaicedImage_.data(), 0);
+   return demosaicedImage_.data();
+}
+
+/**
+ * Enables or disables tracing of calls into devices.
+ *
+ * While enabled, each call the Core makes into a device is recorded with the
+ * device label, the method, its start and end times and the calling thread.
+ * Waits for a device (module) lock that is held by another thread are
+ * recorded as separate "Lock wait" events. Calls are recorded on each thread
+ * without locking, into a buffer of fixed capacity; further calls on a
+ * thread whose buffer is full are dropped.
+ *
+ * The trace can be written to a file with saveDeviceCallTrace(). Disabling
+ * tracing keeps the events recorded so far.
+ */
+void CMMCore::enableDeviceCallTracing(bool enable)
+{
+   callTracer_->Enable(enable);
+}
+
+/**
+ * Returns whether calls into devices are being traced.
+ */
+bool CMMCore::isDeviceCallTracingEnabled()
+{
+   return callTracer_->IsEnabled();
+}
+
+/**
+ * Discards all recorded device call events.
+ */
+void CMMCore::clearDeviceCallTrace()
+{
+   callTracer_->Clear();
+}
+
+/**
+ * Returns the number of recorded device call events (including lock waits,
+ * but not dropped events).
+ */
+long CMMCore::getDeviceCallTraceEventCount()
+{
+   return static_cast<long>(callTracer_->GetEventCount());
+}
+
+/**
+ * Writes the recorded device call events to a file in the Chrome trace event
+ * (JSON) format, which can be opened in Perfetto (https://ui.perfetto.dev)
+ * or chrome://tracing.
+ *
+ * Each thread that called into devices appears as a track. Events are
+ * timestamped relative to the creation of the Core.
+ *
+ * @param fileName the file to write (overwritten if it exists)
+ */
+void CMMCore::saveDeviceCallTrace(const char* fileName) MMCORE_LEGACY_THROW(CMMError)
+{
+   if (!fileName)
+      throw CMMError("Null filename");
+
+   std::ofstream os;
+   os.open(fileName, std::ios_base::out | std::ios_base::trunc);
+   if (!os.is_open())
+   {
+      throw CMMError(ToQuotedString(fileName) + ": " + getCoreErrorText(MMERR_FileOpenFailed),
+            MMERR_FileOpenFailed);
+   }
+   callTracer_->WriteChromeTrace(os);
+   os.close();
+   if (os.fail())
+      throw CMMError(ToQuotedString(fileName) + ": write failed");
+}
+
 /**
  * Indicates whether the circular buffer is overflowed
  */
@@ -3855,6 +4594,19 @@ std::vector<std::string> CMMCore::getAllowedPropertyValues(const char* label, co
    return valueList;
 }
 
+static double
+ParsePropertyDouble(const std::string& strValue, const char* propName,
+      const std::string& label)
+{
+   char* end = nullptr;
+   double value = std::strtod(strValue.c_str(), &end);
+   if (strValue.empty() || *end != '\0')
+      throw CMMError("Value " + ToQuotedString(strValue) + " of property " +
+            ToQuotedString(propName) + " of device " + ToQuotedString(label) +
+            " is not a number");
+   return value;
+}
+
 /**
  * Returns the property value for the specified device.
 
@@ -3866,7 +4618,23 @@ std::string CMMCore::getProperty(const char* label, const char* propName) MMCORE
 {
    if (IsCoreDeviceLabel(label))
       return properties_->Get(propName);
-   std::shared_ptr<mmi::DeviceInstance> pDevice = deviceManager_->GetDevice(label);
+   return getProperty(deviceManager_->GetDevice(label), propName);
+}
+
+/**
+ * Returns the property value for the specified device.
+
+ * @return the property value
+ * @param device     the device handle
+ * @param propName   the property name
+ */
+std::string CMMCore::getProperty(const DeviceHandle& device, const char* propName) MMCORE_LEGACY_THROW(CMMError)
+{
+   return getProperty(resolveDeviceHandle<mmi::DeviceInstance>(device), propName);
+}
+
+std::string CMMCore::getProperty(std::shared_ptr<mmi::DeviceInstance> pDevice, const char* propName) MMCORE_LEGACY_THROW(CMMError)
+{
    CheckPropertyName(propName);
 
    mmi::DeviceModuleLockGuard guard(pDevice);
@@ -3874,42 +4642,87 @@ std::string CMMCore::getProperty(const char* label, const char* propName) MMCORE
 
    // use the opportunity to update the cache
    // Note, stateCache is mutable so that we can update it from this const function
-   stateCache_->addSetting(PropertySetting(label, propName, value.c_str()));
+   stateCache_->addSetting(PropertySetting(pDevice->GetLabel().c_str(), propName, value.c_str()));
 
    return value;
 }
 
 /**
- * Returns the cached property value for the specified device.
-
+ * Returns the property value for the specified device, as a number.
+ *
+ * For Float and Integer properties, the value is obtained from the device
+ * without conversion to and from a string. Unlike getProperty(), this does not
+ * update the system state cache in that case.
+ *
  * @return the property value
  * @param label       the device label
  * @param propName    the property name
  */
-std::string CMMCore::getPropertyFromCache(const char* label, const char* propName) const MMCORE_LEGACY_THROW(CMMError)
+double CMMCore::getPropertyAsDouble(const char* label, const char* propName) MMCORE_LEGACY_THROW(CMMError)
 {
-   if (IsCoreDeviceLabel(label))
-      return properties_->Get(propName);
-   CheckDeviceLabel(label);
-   CheckPropertyName(propName);
-
-   auto s = stateCache_->getSetting(label, propName);
-   if (!s)
-      throw CMMError("Property " + ToQuotedString(propName) + " of device " +
-            ToQuotedString(label) + " not found in cache",
-            MMERR_PropertyNotInCache);
-   return s->getPropertyValue();
+   if (!IsCoreDeviceLabel(label))
+      return getPropertyAsDouble(deviceManager_->GetDevice(label), propName);
+   return ParsePropertyDouble(getProperty(label, propName), propName, label);
 }
 
 /**
- * Changes the value of the device property.
+ * Returns the property value for the specified device, as a number.
  *
- * @param label       the device label
+ * @return the property value
+ * @param device      the device handle
  * @param propName    the property name
- * @param propValue   the new property value
+ * @see getPropertyAsDouble(const char*, const char*)
  */
-void CMMCore::setProperty(const char* label, const char* propName,
-                          const char* propValue) MMCORE_LEGACY_THROW(CMMError)
+double CMMCore::getPropertyAsDouble(const DeviceHandle& device, const char* propName) MMCORE_LEGACY_THROW(CMMError)
+{
+   return getPropertyAsDouble(resolveDeviceHandle<mmi::DeviceInstance>(device), propName);
+}
+
+double CMMCore::getPropertyAsDouble(std::shared_ptr<mmi::DeviceInstance> pDevice, const char* propName) MMCORE_LEGACY_THROW(CMMError)
+{
+   CheckPropertyName(propName);
+   {
+      mmi::DeviceModuleLockGuard guard(pDevice);
+      std::optional<double> value = pDevice->GetPropertyDouble(propName);
+      if (value)
+         return *value;
+   }
+
+   return ParsePropertyDouble(getProperty(pDevice, propName), propName,
+         pDevice->GetLabel());
+}
+
+/**
+ * Returns the cached property value for the specified device.
+
+ * @return the property value
+ * @param label       the device label
+ * @param propName    the property name
+ */
+std::string CMMCore::getPropertyFromCache(const char* label, const char* propName) const MMCORE_LEGACY_THROW(CMMError)
+{
+   if (IsCoreDeviceLabel(label))
+      return properties_->Get(propName);
+   CheckDeviceLabel(label);
+   CheckPropertyName(propName);
+
+   auto s = stateCache_->getSetting(label, propName);
+   if (!s)
+      throw CMMError("Property " + ToQuotedString(propName) + " of device " +
+            ToQuotedString(label) + " not found in cache",
+            MMERR_PropertyNotInCache);
+   return s->getPropertyValue();
+}
+
+/**
+ * Changes the value of the device property.
+ *
+ * @param label       the device label
+ * @param propName    the property name
+ * @param propValue   the new property value
+ */
+void CMMCore::setProperty(const char* label, const char* propName,
+                          const char* propValue) MMCORE_LEGACY_THROW(CMMError)
 {
    CheckDeviceLabel(label);
    CheckPropertyName(propName);
@@ -3929,14 +4742,34 @@ void CMMCore::setProperty(const char* label, const char* propName,
    }
    else
    {
-      std::shared_ptr<mmi::DeviceInstance> pDevice = deviceManager_->GetDevice(label);
+      setProperty(deviceManager_->GetDevice(label), propName, propValue);
+   }
+}
 
-      mmi::DeviceModuleLockGuard guard(pDevice);
+/**
+ * Changes the value of the device property.
+ *
+ * @param device      the device handle
+ * @param propName    the property name
+ * @param propValue   the new property value
+ */
+void CMMCore::setProperty(const DeviceHandle& device, const char* propName,
+                          const char* propValue) MMCORE_LEGACY_THROW(CMMError)
+{
+   setProperty(resolveDeviceHandle<mmi::DeviceInstance>(device), propName, propValue);
+}
 
-      pDevice->SetProperty(propName, propValue);
+void CMMCore::setProperty(std::shared_ptr<mmi::DeviceInstance> pDevice,
+      const char* propName, const char* propValue) MMCORE_LEGACY_THROW(CMMError)
+{
+   CheckPropertyName(propName);
+   CheckPropertyValue(propValue);
 
-      stateCache_->addSetting(PropertySetting(label, propName, propValue));
-   }
+   mmi::DeviceModuleLockGuard guard(pDevice);
+
+   pDevice->SetProperty(propName, propValue);
+
+   stateCache_->addSetting(PropertySetting(pDevice->GetLabel().c_str(), propName, propValue));
 }
 
 /**
@@ -3955,6 +4788,61 @@ void CMMCore::setProperty(const char* label, const char* propName,
 /**
  * Changes the value of the device property.
  *
+ * @param device       the device handle
+ * @param propName     property name
+ * @param propValue    the new property value
+ */
+void CMMCore::setProperty(const DeviceHandle& device, const char* propName,
+                          const bool propValue) MMCORE_LEGACY_THROW(CMMError)
+{
+   setProperty(device, propName, (propValue ? "1" : "0"));
+}
+
+/*
+ * Sets a Float or Integer device property without string conversion if the
+ * device supports it, otherwise falls back to the string version.
+ */
+template <typename T>
+void CMMCore::setPropertyNumeric(const char* label, const char* propName, T propValue,
+      bool (mmi::DeviceInstance::*setter)(const std::string&, T) const) MMCORE_LEGACY_THROW(CMMError)
+{
+   CheckDeviceLabel(label);
+   CheckPropertyName(propName);
+
+   if (!IsCoreDeviceLabel(label))
+   {
+      setPropertyNumeric(deviceManager_->GetDevice(label), propName, propValue, setter);
+      return;
+   }
+
+   setProperty(label, propName, ToString(propValue).c_str());
+}
+
+template <typename T>
+void CMMCore::setPropertyNumeric(std::shared_ptr<mmi::DeviceInstance> pDevice,
+      const char* propName, T propValue,
+      bool (mmi::DeviceInstance::*setter)(const std::string&, T) const) MMCORE_LEGACY_THROW(CMMError)
+{
+   CheckPropertyName(propName);
+
+   {
+      mmi::DeviceModuleLockGuard guard(pDevice);
+      if (((*pDevice).*setter)(propName, propValue))
+      {
+         stateCache_->addSetting(PropertySetting(pDevice->GetLabel().c_str(), propName, ToString(propValue).c_str()));
+         return;
+      }
+   }
+
+   setProperty(pDevice, propName, ToString(propValue).c_str());
+}
+
+/**
+ * Changes the value of the device property.
+ *
+ * For Float and Integer properties, the value is passed to the device
+ * without conversion to a string.
+ *
  * @param label      the device label
  * @param propName   the property name
  * @param propValue  the new property value
@@ -3962,12 +4850,32 @@ void CMMCore::setProperty(const char* label, const char* propName,
 void CMMCore::setProperty(const char* label, const char* propName,
                           const long propValue) MMCORE_LEGACY_THROW(CMMError)
 {
-   setProperty(label, propName, ToString(propValue).c_str());
+   setPropertyNumeric(label, propName, propValue, &mmi::DeviceInstance::SetPropertyLong);
+}
+
+/**
+ * Changes the value of the device property.
+ *
+ * For Float and Integer properties, the value is passed to the device
+ * without conversion to a string.
+ *
+ * @param device     the device handle
+ * @param propName   the property name
+ * @param propValue  the new property value
+ */
+void CMMCore::setProperty(const DeviceHandle& device, const char* propName,
+                          const long propValue) MMCORE_LEGACY_THROW(CMMError)
+{
+   setPropertyNumeric(resolveDeviceHandle<mmi::DeviceInstance>(device), propName,
+         propValue, &mmi::DeviceInstance::SetPropertyLong);
 }
 
 /**
  * Changes the value of the device property.
  *
+ * For Float and Integer properties, the value is passed to the device
+ * without conversion to a string.
+ *
  * @param label      the device label
  * @param propName   the property name
  * @param propValue  the new property value
@@ -3975,12 +4883,33 @@ void CMMCore::setProperty(const char* label, const char* propName,
 void CMMCore::setProperty(const char* label, const char* propName,
                           const float propValue) MMCORE_LEGACY_THROW(CMMError)
 {
-   setProperty(label, propName, ToString(propValue).c_str());
+   setPropertyNumeric(label, propName, static_cast<double>(propValue),
+         &mmi::DeviceInstance::SetPropertyDouble);
 }
 
 /**
  * Changes the value of the device property.
  *
+ * For Float and Integer properties, the value is passed to the device
+ * without conversion to a string.
+ *
+ * @param device     the device handle
+ * @param propName   the property name
+ * @param propValue  the new property value
+ */
+void CMMCore::setProperty(const DeviceHandle& device, const char* propName,
+                          const float propValue) MMCORE_LEGACY_THROW(CMMError)
+{
+   setPropertyNumeric(resolveDeviceHandle<mmi::DeviceInstance>(device), propName,
+         static_cast<double>(propValue), &mmi::DeviceInstance::SetPropertyDouble);
+}
+
+/**
+ * Changes the value of the device property.
+ *
+ * For Float and Integer properties, the value is passed to the device
+ * without conversion to a string.
+ *
  * @param label          the device label
  * @param propName       the property name
  * @param propValue      the new property value
@@ -3988,7 +4917,322 @@ void CMMCore::setProperty(const char* label, const char* propName,
 void CMMCore::setProperty(const char* label, const char* propName,
                           const double propValue) MMCORE_LEGACY_THROW(CMMError)
 {
-   setProperty(label, propName, ToString(propValue).c_str());
+   setPropertyNumeric(label, propName, propValue, &mmi::DeviceInstance::SetPropertyDouble);
+}
+
+/**
+ * Changes the value of the device property.
+ *
+ * For Float and Integer properties, the value is passed to the device
+ * without conversion to a string.
+ *
+ * @param device         the device handle
+ * @param propName       the property name
+ * @param propValue      the new property value
+ */
+void CMMCore::setProperty(const DeviceHandle& device, const char* propName,
+                          const double propValue) MMCORE_LEGACY_THROW(CMMError)
+{
+   setPropertyNumeric(resolveDeviceHandle<mmi::DeviceInstance>(device), propName,
+         propValue, &mmi::DeviceInstance::SetPropertyDouble);
+}
+
+
+/**
+ * Returns the values of several properties of a device.
+ *
+ * The device adapter module is locked once for all the properties, and
+ * errors are reported per property rather than thrown.
+ *
+ * @return the property values (empty where an error occurred)
+ * @param label       the device label
+ * @param propNames   the property names
+ * @param errors      set to one entry per property: empty on success,
+ *                    otherwise the error message
+ */
+std::vector<std::string> CMMCore::getProperties(const char* label,
+      const std::vector<std::string>& propNames,
+      std::vector<std::string>& errors) MMCORE_LEGACY_THROW(CMMError)
+{
+   CheckDeviceLabel(label);
+   std::vector<std::string> labels(propNames.size(), label);
+   return getProperties(labels, propNames, errors);
+}
+
+/**
+ * Returns the values of properties of several devices.
+ *
+ * Request i is for property propNames[i] of device labels[i]. Each device
+ * adapter module is locked once for all of its requests, and errors are
+ * reported per request rather than thrown.
+ *
+ * @return the property values (empty where an error occurred)
+ * @param labels      the device labels
+ * @param propNames   the property names
+ * @param errors      set to one entry per request: empty on success,
+ *                    otherwise the error message
+ */
+std::vector<std::string> CMMCore::getProperties(const std::vector<std::string>& labels,
+      const std::vector<std::string>& propNames,
+      std::vector<std::string>& errors) MMCORE_LEGACY_THROW(CMMError)
+{
+   if (labels.size() != propNames.size())
+      throw CMMError("Number of device labels (" + ToString(labels.size()) +
+            ") does not match number of property names (" +
+            ToString(propNames.size()) + ")");
+
+   std::vector<std::string> values(labels.size());
+   errors.assign(labels.size(), std::string());
+
+   std::vector<size_t> coreRequests;
+   auto groups = groupPropertyRequests(labels, propNames, coreRequests, errors);
+
+   for (size_t i : coreRequests)
+   {
+      try
+      {
+         values[i] = properties_->Get(propNames[i].c_str());
+      }
+      catch (const CMMError& e)
+      {
+         errors[i] = e.getFullMsg();
+      }
+   }
+
+   std::vector<PropertySetting> obtained;
+   for (const auto& group : groups)
+   {
+      mmi::DeviceModuleLockGuard guard(group.front().first);
+      for (const auto& request : group)
+      {
+         const size_t i = request.second;
+         try
+         {
+            values[i] = request.first->GetProperty(propNames[i]);
+            obtained.push_back(PropertySetting(labels[i].c_str(),
+                  propNames[i].c_str(), values[i].c_str()));
+         }
+         catch (const CMMError& e)
+         {
+            errors[i] = e.getFullMsg();
+         }
+      }
+   }
+
+   stateCache_->addSettings(obtained);
+   return values;
+}
+
+/**
+ * Changes the values of several properties of a device.
+ *
+ * The device adapter module is locked once for all the properties, and
+ * errors are reported per property rather than thrown. Properties are set in
+ * the order given.
+ *
+ * @return one entry per property: empty on success, otherwise the error
+ *         message
+ * @param label       the device label
+ * @param propNames   the property names
+ * @param propValues  the new property values
+ */
+std::vector<std::string> CMMCore::setProperties(const char* label,
+      const std::vector<std::string>& propNames,
+      const std::vector<std::string>& propValues) MMCORE_LEGACY_THROW(CMMError)
+{
+   CheckDeviceLabel(label);
+   std::vector<std::string> labels(propNames.size(), label);
+   return setPropertyBatch(labels, propNames, propValues, false);
+}
+
+/**
+ * Changes the values of properties of several devices.
+ *
+ * Each device adapter module is locked once for all of its settings, and
+ * errors are reported per setting rather than thrown. Within a module,
+ * settings are applied in the order given.
+ *
+ * @return one entry per setting: empty on success, otherwise the error
+ *         message
+ * @param settings    the property settings to apply
+ */
+std::vector<std::string> CMMCore::setProperties(const Configuration& settings) MMCORE_LEGACY_THROW(CMMError)
+{
+   std::vector<std::string> labels, propNames, propValues;
+   for (size_t i = 0; i < settings.size(); ++i)
+   {
+      PropertySetting setting = settings.getSetting(i);
+      labels.push_back(setting.getDeviceLabel());
+      propNames.push_back(setting.getPropertyName());
+      propValues.push_back(setting.getPropertyValue());
+   }
+   return setPropertyBatch(labels, propNames, propValues, false);
+}
+
+/*
+ * Applies property settings given as parallel vectors; see setProperties().
+ * If concurrently is true, the groups of settings for devices that do not
+ * share a lock are applied on separate threads.
+ * If stopAtFirstError is true, settings after the first failed one (in the
+ * given order) are not applied, except those that another thread has already
+ * applied. The settings before it are all attempted, so the first error is
+ * the same as if the settings had been applied one at a time.
+ */
+std::vector<std::string> CMMCore::setPropertyBatch(const std::vector<std::string>& labels,
+      const std::vector<std::string>& propNames,
+      const std::vector<std::string>& propValues,
+      bool concurrently, bool stopAtFirstError) MMCORE_LEGACY_THROW(CMMError)
+{
+   if (labels.size() != propNames.size() || labels.size() != propValues.size())
+      throw CMMError("Numbers of device labels, property names, and property values do not match");
+
+   std::vector<std::string> errors(labels.size());
+   for (size_t i = 0; i < propValues.size(); ++i)
+   {
+      try
+      {
+         CheckPropertyValue(propValues[i].c_str());
+      }
+      catch (const CMMError& e)
+      {
+         errors[i] = e.getFullMsg();
+      }
+   }
+
+   std::vector<size_t> coreRequests;
+   auto groups = groupPropertyRequests(labels, propNames, coreRequests, errors);
+
+   // Index of the first failed setting known so far (only if stopAtFirstError)
+   std::atomic<size_t> firstFailed{ std::numeric_limits<size_t>::max() };
+   auto recordFailure = [&](size_t i)
+   {
+      size_t prev = firstFailed.load();
+      while (i < prev && !firstFailed.compare_exchange_weak(prev, i)) {}
+   };
+   auto skip = [&](size_t i)
+   {
+      return !errors[i].empty() || (stopAtFirstError && i > firstFailed.load());
+   };
+   if (stopAtFirstError)
+   {
+      auto firstError = std::find_if(errors.begin(), errors.end(),
+            [](const std::string& e) { return !e.empty(); });
+      if (firstError != errors.end())
+         recordFailure(static_cast<size_t>(firstError - errors.begin()));
+   }
+
+   std::vector<PropertySetting> applied;
+   for (size_t i : coreRequests)
+   {
+      if (skip(i))
+         continue;
+      try
+      {
+         properties_->Set(propNames[i].c_str(), propValues[i].c_str());
+         std::string actual = properties_->Get(propNames[i].c_str());
+         applied.push_back(PropertySetting(MM::g_Keyword_CoreDevice,
+               propNames[i].c_str(), actual.c_str()));
+      }
+      catch (const CMMError& e)
+      {
+         errors[i] = e.getFullMsg();
+         recordFailure(i);
+      }
+   }
+
+   // Each group only writes to the errors of its own requests
+   auto applyGroup = [&](const std::vector<std::pair<std::shared_ptr<mmi::DeviceInstance>, size_t>>& group)
+   {
+      std::vector<PropertySetting> groupApplied;
+      mmi::DeviceModuleLockGuard guard(group.front().first);
+      for (const auto& request : group)
+      {
+         const size_t i = request.second;
+         if (skip(i))
+            continue;
+         try
+         {
+            request.first->SetProperty(propNames[i], propValues[i]);
+            groupApplied.push_back(PropertySetting(labels[i].c_str(),
+                  propNames[i].c_str(), propValues[i].c_str()));
+         }
+         catch (const CMMError& e)
+         {
+            errors[i] = e.getFullMsg();
+            recordFailure(i);
+         }
+      }
+      return groupApplied;
+   };
+
+   std::vector<std::vector<PropertySetting>> groupsApplied;
+   if (concurrently && groups.size() > 1)
+   {
+      std::vector<std::future<std::vector<PropertySetting>>> futures;
+      for (const auto& group : groups)
+      {
+         futures.push_back(std::async(std::launch::async,
+               applyGroup, std::cref(group)));
+      }
+      for (auto& fut : futures)
+         groupsApplied.push_back(fut.get());
+   }
+   else
+   {
+      for (const auto& group : groups)
+         groupsApplied.push_back(applyGroup(group));
+   }
+
+   for (const auto& groupApplied : groupsApplied)
+      applied.insert(applied.end(), groupApplied.begin(), groupApplied.end());
+   stateCache_->addSettings(applied);
+   return errors;
+}
+
+/*
+ * Resolves the devices of a batch of property requests and groups the request
+ * indices by device lock (see GroupDevicesByLock()), in order of first
+ * appearance. Requests
+ * for the Core are returned in coreRequests. Requests with an invalid label
+ * or property name are left out, with the message stored in errors.
+ */
+std::vector<std::vector<std::pair<std::shared_ptr<mmi::DeviceInstance>, size_t>>>
+CMMCore::groupPropertyRequests(const std::vector<std::string>& labels,
+      const std::vector<std::string>& propNames,
+      std::vector<size_t>& coreRequests,
+      std::vector<std::string>& errors) MMCORE_LEGACY_THROW(CMMError)
+{
+   std::vector<std::vector<std::pair<std::shared_ptr<mmi::DeviceInstance>, size_t>>> groups;
+   std::map<const std::recursive_mutex*, size_t> groupIndex;
+   std::map<std::string, std::shared_ptr<mmi::DeviceInstance>> devices;
+   for (size_t i = 0; i < labels.size(); ++i)
+   {
+      try
+      {
+         CheckDeviceLabel(labels[i].c_str());
+         CheckPropertyName(propNames[i].c_str());
+         if (IsCoreDeviceLabel(labels[i].c_str()))
+         {
+            coreRequests.push_back(i);
+            continue;
+         }
+
+         auto it = devices.find(labels[i]);
+         if (it == devices.end())
+            it = devices.insert({ labels[i], deviceManager_->GetDevice(labels[i]) }).first;
+
+         auto inserted = groupIndex.insert(
+               { &mmi::DeviceModuleLockGuard::GetLock(it->second), groups.size() });
+         if (inserted.second)
+            groups.emplace_back();
+         groups[inserted.first->second].push_back({ it->second, i });
+      }
+      catch (const CMMError& e)
+      {
+         errors[i] = e.getFullMsg();
+      }
+   }
+   return groups;
 }
 
 
@@ -4250,6 +5494,8 @@ unsigned CMMCore::getImageHeight()
 /**
  * How many bytes for each pixel. This value does not necessarily reflect the
  * capabilities of the particular camera A/D converter.
+ * Images demosaiced by the Core (see setCameraDemosaic()) have 4 bytes per
+ * pixel.
  * @return the number of bytes
  */
 unsigned CMMCore::getBytesPerPixel()
@@ -4260,6 +5506,8 @@ unsigned CMMCore::getBytesPerPixel()
       try
       {
          mmi::DeviceModuleLockGuard guard(camera);
+         if (getCameraDemosaic(camera))
+            return 4;
          return camera->GetImageBytesPerPixel();
       }
       catch (const CMMError&) // Possibly uninitialized camera
@@ -4274,6 +5522,8 @@ unsigned CMMCore::getBytesPerPixel()
  * How many bits of dynamic range are to be expected from the camera. This value should
  * be used only as a guideline - it does not guarantee that image buffer will contain
  * only values from the returned dynamic range.
+ * Images demosaiced by the Core (see setCameraDemosaic()) have 8 bits per
+ * component.
  *
  * @return the number of bits
  */
@@ -4285,6 +5535,8 @@ unsigned CMMCore::getImageBitDepth()
       try
       {
          mmi::DeviceModuleLockGuard guard(camera);
+         if (getCameraDemosaic(camera))
+            return 8;
          return camera->GetBitDepth();
       }
       catch (const CMMError&) // Possibly uninitialized camera
@@ -4297,7 +5549,8 @@ unsigned CMMCore::getImageBitDepth()
 
 /**
  * Returns the number of components the default camera is returning.
- * For example color camera will return 4 components (RGBA) on each snap.
+ * For example color camera will return 4 components (RGBA) on each snap, as
+ * do cameras whose images are demosaiced by the Core (see setCameraDemosaic()).
  */
 unsigned CMMCore::getNumberOfComponents()
 {
@@ -4307,6 +5560,8 @@ unsigned CMMCore::getNumberOfComponents()
       try
       {
          mmi::DeviceModuleLockGuard guard(camera);
+         if (getCameraDemosaic(camera))
+            return 4;
          return camera->GetNumberOfComponents();
       }
       catch (const CMMError&) // Possibly uninitialized camera
@@ -4388,9 +5643,22 @@ void CMMCore::setExposure(double dExp) MMCORE_LEGACY_THROW(CMMError)
  */
 void CMMCore::setExposure(const char* label, double dExp) MMCORE_LEGACY_THROW(CMMError)
 {
-   std::shared_ptr<mmi::CameraInstance> pCamera =
-      deviceManager_->GetDeviceOfType<mmi::CameraInstance>(label);
+   setExposure(deviceManager_->GetDeviceOfType<mmi::CameraInstance>(label), dExp);
+}
+
+/**
+ * Sets the exposure setting of the specified camera in milliseconds.
+ * @param camera the camera device handle
+ * @param dExp   the exposure in milliseconds
+ */
+void CMMCore::setExposure(const DeviceHandle& camera, double dExp) MMCORE_LEGACY_THROW(CMMError)
+{
+   setExposure(resolveDeviceHandle<mmi::CameraInstance>(camera), dExp);
+}
 
+void CMMCore::setExposure(std::shared_ptr<mmi::CameraInstance> pCamera, double dExp) MMCORE_LEGACY_THROW(CMMError)
+{
+   const std::string label = pCamera->GetLabel();
    {
       mmi::DeviceModuleLockGuard guard(pCamera);
       LOG_DEBUG(coreLogger_) << "Will set camera " << label <<
@@ -4400,7 +5668,7 @@ void CMMCore::setExposure(const char* label, double dExp) MMCORE_LEGACY_THROW(CM
       pCamera->SetExposure(dExp);
       if (pCamera->HasProperty(MM::g_Keyword_Exposure))
       {
-         stateCache_->addSetting(PropertySetting(label, MM::g_Keyword_Exposure, CDeviceUtils::ConvertToString(dExp)));
+         stateCache_->addSetting(PropertySetting(label.c_str(), MM::g_Keyword_Exposure, CDeviceUtils::ConvertToString(dExp)));
       }
    }
 
@@ -4433,15 +5701,23 @@ double CMMCore::getExposure() MMCORE_LEGACY_THROW(CMMError)
 */
 double CMMCore::getExposure(const char* label) MMCORE_LEGACY_THROW(CMMError)
 {
-  std::shared_ptr<mmi::CameraInstance> pCamera =
-        deviceManager_->GetDeviceOfType<mmi::CameraInstance>(label);
-  if (pCamera)
-  {
-     mmi::DeviceModuleLockGuard guard(pCamera);
-     return pCamera->GetExposure();
-  }
-  else
-     return 0.0;
+   return getExposure(deviceManager_->GetDeviceOfType<mmi::CameraInstance>(label));
+}
+
+/**
+ * Returns the current exposure setting of the specified camera in milliseconds.
+ * @param camera the camera device handle
+ * @return the exposure time in milliseconds
+ */
+double CMMCore::getExposure(const DeviceHandle& camera) MMCORE_LEGACY_THROW(CMMError)
+{
+   return getExposure(resolveDeviceHandle<mmi::CameraInstance>(camera));
+}
+
+double CMMCore::getExposure(std::shared_ptr<mmi::CameraInstance> pCamera) MMCORE_LEGACY_THROW(CMMError)
+{
+   mmi::DeviceModuleLockGuard guard(pCamera);
+   return pCamera->GetExposure();
 }
 
 /**
@@ -5018,8 +6294,24 @@ void CMMCore::getMultiROI(std::vector<unsigned>& xs, std::vector<unsigned>& ys,
  */
 void CMMCore::setState(const char* deviceLabel, long state) MMCORE_LEGACY_THROW(CMMError)
 {
-   std::shared_ptr<mmi::StateInstance> pStateDev =
-      deviceManager_->GetDeviceOfType<mmi::StateInstance>(deviceLabel);
+   setState(deviceManager_->GetDeviceOfType<mmi::StateInstance>(deviceLabel), state);
+}
+
+/**
+ * Sets the state (position) on the specific device. The command will fail if
+ * the device does not support states.
+ *
+ * @param stateDevice  the device handle
+ * @param state        the new state
+ */
+void CMMCore::setState(const DeviceHandle& stateDevice, long state) MMCORE_LEGACY_THROW(CMMError)
+{
+   setState(resolveDeviceHandle<mmi::StateInstance>(stateDevice), state);
+}
+
+void CMMCore::setState(std::shared_ptr<mmi::StateInstance> pStateDev, long state) MMCORE_LEGACY_THROW(CMMError)
+{
+   const std::string deviceLabel = pStateDev->GetLabel();
    mmi::DeviceModuleLockGuard guard(pStateDev);
 
    LOG_DEBUG(coreLogger_) << "Will set " << deviceLabel << " to state " << state;
@@ -5029,12 +6321,12 @@ void CMMCore::setState(const char* deviceLabel, long state) MMCORE_LEGACY_THROW(
 
    if (pStateDev->HasProperty(MM::g_Keyword_State))
    {
-      stateCache_->addSetting(PropertySetting(deviceLabel, MM::g_Keyword_State, CDeviceUtils::ConvertToString(state)));
+      stateCache_->addSetting(PropertySetting(deviceLabel.c_str(), MM::g_Keyword_State, CDeviceUtils::ConvertToString(state)));
    }
    if (pStateDev->HasProperty(MM::g_Keyword_Label))
    {
       std::string posLbl = pStateDev->GetPositionLabel(state);
-      stateCache_->addSetting(PropertySetting(deviceLabel, MM::g_Keyword_Label, posLbl.c_str()));
+      stateCache_->addSetting(PropertySetting(deviceLabel.c_str(), MM::g_Keyword_Label, posLbl.c_str()));
    }
 
    LOG_DEBUG(coreLogger_) << "Did set " << deviceLabel << " to state " << state;
@@ -5049,8 +6341,23 @@ void CMMCore::setState(const char* deviceLabel, long state) MMCORE_LEGACY_THROW(
  */
 long CMMCore::getState(const char* deviceLabel) MMCORE_LEGACY_THROW(CMMError)
 {
-   std::shared_ptr<mmi::StateInstance> pStateDev =
-      deviceManager_->GetDeviceOfType<mmi::StateInstance>(deviceLabel);
+   return getState(deviceManager_->GetDeviceOfType<mmi::StateInstance>(deviceLabel));
+}
+
+/**
+ * Returns the current state (position) on the specific device. The command will fail if
+ * the device does not support states.
+ *
+ * @return                the current state
+ * @param stateDevice     the device handle
+ */
+long CMMCore::getState(const DeviceHandle& stateDevice) MMCORE_LEGACY_THROW(CMMError)
+{
+   return getState(resolveDeviceHandle<mmi::StateInstance>(stateDevice));
+}
+
+long CMMCore::getState(std::shared_ptr<mmi::StateInstance> pStateDev) MMCORE_LEGACY_THROW(CMMError)
+{
    mmi::DeviceModuleLockGuard guard(pStateDev);
 
    long state;
@@ -5549,13 +6856,33 @@ void CMMCore::setPixelSizeConfig(const char* resolutionID) MMCORE_LEGACY_THROW(C
  * @param configName  the configuration preset name
  */
 void CMMCore::setConfig(const char* groupName, const char* configName) MMCORE_LEGACY_THROW(CMMError)
+{
+   setConfig(groupName, configName, false);
+}
+
+/**
+ * Applies a configuration to a group, optionally waiting for the affected
+ * devices. The command will fail if the configuration was not previously
+ * defined.
+ *
+ * When wait is true, this function returns only after all devices
+ * to which a property was sent have become non-busy. The devices are waited
+ * for concurrently, so the wait lasts roughly as long as the slowest device.
+ * With the ParallelConfigApply feature enabled, devices whose settings were
+ * all skipped (because they already matched the system state cache) are not
+ * waited for.
+ *
+ * @param groupName   the configuration group name
+ * @param configName  the configuration preset name
+ * @param wait        whether to wait for the affected devices
+ */
+void CMMCore::setConfig(const char* groupName, const char* configName,
+      bool wait) MMCORE_LEGACY_THROW(CMMError)
 {
    CheckConfigGroupName(groupName);
    CheckConfigPresetName(configName);
 
    Configuration* pCfg = configGroups_->Find(groupName, configName);
-   std::ostringstream os;
-   os << groupName << "/" << configName;
    if (!pCfg)
    {
       throw CMMError("Preset " + ToQuotedString(configName) +
@@ -5564,17 +6891,46 @@ void CMMCore::setConfig(const char* groupName, const char* configName) MMCORE_LE
             MMERR_NoConfiguration);
    }
 
+   // The recorded source preset is only maintained while the feature is
+   // enabled; a stale one is caught by the cache check below.
+   const bool useTransitionPlans = mmi::features::flags().configTransitionPlans;
+   const Configuration* pSettings = pCfg;
+   std::shared_ptr<const mmi::ConfigTransition> pTransition;
+   if (useTransitionPlans)
+   {
+      const std::string fromConfig = configGroups_->GetLastApplied(groupName);
+      if (!fromConfig.empty())
+      {
+         pTransition =
+            configGroups_->FindTransition(groupName, fromConfig.c_str(), configName);
+         if (pTransition && isConfigurationInCache(pTransition->assumed))
+         {
+            pSettings = &pTransition->settings;
+            LOG_DEBUG(coreLogger_) << "Config group " << groupName <<
+               ": transition from preset " << fromConfig << " needs " <<
+               pSettings->size() << " of " << pCfg->size() << " settings";
+         }
+      }
+   }
+
    LOG_DEBUG(coreLogger_) << "Config group " << groupName <<
       ": will apply preset " << configName;
 
-   try {
-      applyConfiguration(*pCfg);
-   } catch (CMMError&) {
-      throw;
-   }
+   // Forget the current preset until we know it was applied completely
+   if (useTransitionPlans)
+      configGroups_->SetLastApplied(groupName, "");
+   std::vector<std::shared_ptr<mmi::DeviceInstance>> touchedDevices =
+      applyConfiguration(*pSettings);
+   if (useTransitionPlans)
+      configGroups_->SetLastApplied(groupName, configName);
 
    LOG_DEBUG(coreLogger_) << "Config group " << groupName <<
       ": did apply preset " << configName;
+
+   if (wait && !touchedDevices.empty())
+   {
+      waitForDevices(touchedDevices);
+   }
 }
 
 /**
@@ -5779,6 +7135,38 @@ Configuration CMMCore::getConfigData(const char* groupName, const char* configNa
    return *pCfg;
 }
 
+/**
+ * Returns the settings that setConfig() would send when switching a group
+ * from one preset to another, with the ConfigTransitionPlans feature enabled.
+ *
+ * The result is a measure of the cost of the transition: it contains only
+ * the settings of devices whose settings differ between the two presets (and
+ * any Core settings), in the order in which they would be applied.
+ *
+ * @param groupName       the configuration group name
+ * @param fromConfigName  the preset the group is switched from
+ * @param toConfigName    the preset the group is switched to
+ * @return The settings that would be applied
+ */
+Configuration CMMCore::getConfigTransitionData(const char* groupName,
+      const char* fromConfigName, const char* toConfigName) MMCORE_LEGACY_THROW(CMMError)
+{
+   CheckConfigGroupName(groupName);
+   CheckConfigPresetName(fromConfigName);
+   CheckConfigPresetName(toConfigName);
+
+   std::shared_ptr<const mmi::ConfigTransition> pTransition =
+      configGroups_->FindTransition(groupName, fromConfigName, toConfigName);
+   if (!pTransition)
+   {
+      throw CMMError("Configuration group " + ToQuotedString(groupName) +
+            " or its preset " + ToQuotedString(fromConfigName) + " or " +
+            ToQuotedString(toConfigName) + " does not exist",
+            MMERR_NoConfiguration);
+   }
+   return pTransition->settings;
+}
+
 /**
  * Returns the configuration object for a give pixel size preset.
  * @return The configuration object
@@ -7621,8 +9009,11 @@ void CMMCore::saveSystemConfiguration(const char* fileName) MMCORE_LEGACY_THROW(
  * Format specification:
  * Each line consists of a number of string fields separated by "," (comma) characters.
  * Lines beginning with "#" are ignored (can be used for comments).
- * Each line in the file will be parsed by the system and as a result a corresponding command
- * will be immediately executed.
+ * The whole file is parsed first, and the commands are then executed in file
+ * order. If the "ParallelConfigLoad" feature is enabled, consecutive Property
+ * lines for devices that have already been initialized are applied together:
+ * devices that do not share a lock (see setProperties()) are set
+ * concurrently, and the settings of each device are applied in file order.
  * The first field in the line always specifies the command from the following set of values:
  *    Device - executes loadDevice()
  *    Label - executes defineStateLabel() command
@@ -7688,230 +9079,320 @@ void CMMCore::loadSystemConfigurationImpl(const char* fileName) MMCORE_LEGACY_TH
             MMERR_FileOpenFailed);
    }
 
+   // Read the whole file before executing anything, so that consecutive
+   // settings of initialized devices' properties can be applied together
+   struct ConfigLine
+   {
+      int number;
+      std::string text;
+      std::vector<std::string> tokens;
+   };
+   std::vector<ConfigLine> plan;
+   {
+      const int maxLineLength = 4 * MM::MaxStrLength + 4; // accommodate up to 4 strings and delimiters
+      char line[maxLineLength+1];
+      int lineCount = 0;
+
+      while(is.getline(line, maxLineLength, '\n'))
+      {
+         // strip a potential Windows/dos CR
+         std::istringstream il(line);
+         il.getline(line, maxLineLength, '\r');
+
+         lineCount++;
+         if (strlen(line) == 0 || line[0] == '#') // skip comments
+            continue;
+
+         ConfigLine entry{ lineCount, line, {} };
+         CDeviceUtils::Tokenize(line, entry.tokens, MM::g_FieldDelimiters);
+         plan.push_back(std::move(entry));
+      }
+   }
+
+   auto lineError = [](const ConfigLine& entry, const std::string& msg)
+   {
+      std::ostringstream errorText;
+      errorText << "Line " << entry.number << ": " << entry.text << '\n';
+      errorText << msg << "\n\n";
+      return CMMError(errorText.str().c_str(), MMERR_InvalidConfigurationFile);
+   };
+
+   typedef std::chrono::steady_clock Clock;
+   auto elapsedMs = [](Clock::time_point since) {
+      return std::chrono::duration<double, std::milli>(Clock::now() - since).count();
+   };
+   const Clock::time_point loadStart = Clock::now();
+   double loadDevicesMs = 0.0, preInitMs = 0.0, initializeMs = 0.0,
+          postInitMs = 0.0, otherMs = 0.0, startupMs = 0.0;
+   size_t postInitCount = 0, postInitBatches = 0;
+
+   // With ParallelConfigLoad, settings of properties of initialized devices
+   // are collected here and applied when the next other command (or the end
+   // of the file) is reached. Modules are handled concurrently, in file order
+   // within each module.
+   std::vector<size_t> pending;
+   const bool batchPostInit = mmi::features::flags().parallelConfigLoad;
+   auto isDeferred = [this, batchPostInit](const std::vector<std::string>& tokens)
+   {
+      if (!batchPostInit || tokens.empty() || tokens[0].compare(MM::g_CFGCommand_Property) != 0 ||
+            (tokens.size() != 3 && tokens.size() != 4) ||
+            IsCoreDeviceLabel(tokens[1].c_str()))
+         return false;
+      try
+      {
+         return deviceManager_->GetDevice(tokens[1])->IsInitialized();
+      }
+      catch (const CMMError&)
+      {
+         return false; // Reported when the line is executed
+      }
+   };
+   auto applyPending = [&]()
+   {
+      if (pending.empty())
+         return;
+      const Clock::time_point start = Clock::now();
+      std::vector<std::string> labels, propNames, propValues;
+      for (size_t n : pending)
+      {
+         const std::vector<std::string>& tokens = plan[n].tokens;
+         labels.push_back(tokens[1]);
+         propNames.push_back(tokens[2]);
+         // ...assuming here that the last missing token represents an empty string
+         propValues.push_back(tokens.size() == 4 ? tokens[3] : "");
+      }
+      std::vector<std::string> errors =
+         setPropertyBatch(labels, propNames, propValues, true, true);
+      postInitMs += elapsedMs(start);
+      postInitCount += pending.size();
+      ++postInitBatches;
+      for (size_t i = 0; i < pending.size(); ++i)
+      {
+         if (!errors[i].empty())
+            throw lineError(plan[pending[i]], errors[i]);
+      }
+      pending.clear();
+   };
+
    // Process commands
-   const int maxLineLength = 4 * MM::MaxStrLength + 4; // accommodate up to 4 strings and delimiters
-   char line[maxLineLength+1];
-   std::vector<std::string> tokens;
-
-   int lineCount = 0;
-
-   while(is.getline(line, maxLineLength, '\n'))
+   for (size_t n = 0; n < plan.size(); ++n)
    {
-      // strip a potential Windows/dos CR
-      std::istringstream il(line);
-      il.getline(line, maxLineLength, '\r');
+      const ConfigLine& entry = plan[n];
+      const char* line = entry.text.c_str();
+      const std::vector<std::string>& tokens = entry.tokens;
 
-      lineCount++;
-      if (strlen(line) > 0)
+      if (isDeferred(tokens))
       {
-         if (line[0] == '#')
-         {
-            // comment, so skip processing
-            continue;
-         }
+         pending.push_back(n);
+         continue;
+      }
+      applyPending();
 
-         // parse tokens
-         tokens.clear();
-         CDeviceUtils::Tokenize(line, tokens, MM::g_FieldDelimiters);
+      const Clock::time_point start = Clock::now();
+      double* category = &otherMs;
+      try
+      {
 
-         try
-         {
+         // non-empty and non-comment lines mush have at least one token
+         if (tokens.size() < 1)
+            throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                  ToQuotedString(line) + ")",
+                  MMERR_InvalidCFGEntry);
 
-            // non-empty and non-comment lines mush have at least one token
-            if (tokens.size() < 1)
+         if(tokens[0].compare(MM::g_CFGCommand_Device) == 0)
+         {
+            // load device command
+            // -------------------
+            if (tokens.size() != 4)
                throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
                      ToQuotedString(line) + ")",
                      MMERR_InvalidCFGEntry);
-
-            if(tokens[0].compare(MM::g_CFGCommand_Device) == 0)
-            {
-               // load device command
-               // -------------------
-               if (tokens.size() != 4)
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
-               loadDevice(tokens[1].c_str(), tokens[2].c_str(), tokens[3].c_str());
-            }
-            else if(tokens[0].compare(MM::g_CFGCommand_Property) == 0)
-            {
-               // set property command
-               // --------------------
-               if (tokens.size() == 4)
-                  setProperty(tokens[1].c_str(), tokens[2].c_str(), tokens[3].c_str());
-               else if (tokens.size() == 3)
-                  // ...assuming here that the last missing toke represents an empty string
-                  setProperty(tokens[1].c_str(), tokens[2].c_str(), "");
-               else
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
-            }
-            else if(tokens[0].compare(MM::g_CFGCommand_Delay) == 0)
-            {
-               // set delay command
-               // -----------------
-               if (tokens.size() != 3)
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
-               setDeviceDelayMs(tokens[1].c_str(), atof(tokens[2].c_str()));
-            }
-            else if(tokens[0].compare(MM::g_CFGCommand_FocusDirection) == 0)
-            {
-               // set focus direction command
-               // ---------------------------
-               if (tokens.size() != 3)
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
-               setFocusDirection(tokens[1].c_str(), atol(tokens[2].c_str()));
-            }
-            else if(tokens[0].compare(MM::g_CFGCommand_Label) == 0)
-            {
-               // define label command
-               // --------------------
-               if (tokens.size() != 4)
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
-               defineStateLabel(tokens[1].c_str(), atol(tokens[2].c_str()), tokens[3].c_str());
-            }
-            else if(tokens[0].compare(MM::g_CFGCommand_Configuration) == 0)
-            {
-               // define configuration command
-               // ----------------------------
-               if (tokens.size() != 5)
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
-               LOG_WARNING(coreLogger_) << "Obsolete command " << tokens[0] <<
-                  " ignored in configuration file";
-            }
-            else if(tokens[0].compare(MM::g_CFGCommand_ConfigGroup) == 0)
-            {
-               // define grouped configuration command
-               // ------------------------------------
-               if (tokens.size() == 6)
-                  defineConfig(tokens[1].c_str(), tokens[2].c_str(), tokens[3].c_str(), tokens[4].c_str(), tokens[5].c_str());
-               else if (tokens.size() == 5)
-               {
-                  // we will assume here that the last (missing) token is representing an empty string
-                  defineConfig(tokens[1].c_str(), tokens[2].c_str(), tokens[3].c_str(), tokens[4].c_str(), "");
-               }
-               else if (tokens.size() == 2)
-                  defineConfigGroup(tokens[1].c_str());
-               else
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
-            }
-            else if(tokens[0].compare(MM::g_CFGCommand_ConfigPixelSize) == 0)
-            {
-               // define pixel size configuration command
-               // ---------------------------------------
-               if (tokens.size() == 5)
-                  definePixelSizeConfig(tokens[1].c_str(), tokens[2].c_str(), tokens[3].c_str(), tokens[4].c_str());
-               else
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
-            }
-            else if(tokens[0].compare(MM::g_CFGCommand_PixelSize_um) == 0)
+            category = &loadDevicesMs;
+            loadDevice(tokens[1].c_str(), tokens[2].c_str(), tokens[3].c_str());
+         }
+         else if(tokens[0].compare(MM::g_CFGCommand_Property) == 0)
+         {
+            // set property command
+            // --------------------
+            if (tokens.size() > 1 && !IsCoreDeviceLabel(tokens[1].c_str()))
+               category = &preInitMs;
+            else if (tokens.size() > 2 &&
+                  tokens[2].compare(MM::g_Keyword_CoreInitialize) == 0)
+               category = &initializeMs;
+            if (tokens.size() == 4)
+               setProperty(tokens[1].c_str(), tokens[2].c_str(), tokens[3].c_str());
+            else if (tokens.size() == 3)
+               // ...assuming here that the last missing toke represents an empty string
+               setProperty(tokens[1].c_str(), tokens[2].c_str(), "");
+            else
+               throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                     ToQuotedString(line) + ")",
+                     MMERR_InvalidCFGEntry);
+         }
+         else if(tokens[0].compare(MM::g_CFGCommand_Delay) == 0)
+         {
+            // set delay command
+            // -----------------
+            if (tokens.size() != 3)
+               throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                     ToQuotedString(line) + ")",
+                     MMERR_InvalidCFGEntry);
+            setDeviceDelayMs(tokens[1].c_str(), atof(tokens[2].c_str()));
+         }
+         else if(tokens[0].compare(MM::g_CFGCommand_FocusDirection) == 0)
+         {
+            // set focus direction command
+            // ---------------------------
+            if (tokens.size() != 3)
+               throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                     ToQuotedString(line) + ")",
+                     MMERR_InvalidCFGEntry);
+            setFocusDirection(tokens[1].c_str(), atol(tokens[2].c_str()));
+         }
+         else if(tokens[0].compare(MM::g_CFGCommand_Label) == 0)
+         {
+            // define label command
+            // --------------------
+            if (tokens.size() != 4)
+               throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                     ToQuotedString(line) + ")",
+                     MMERR_InvalidCFGEntry);
+            defineStateLabel(tokens[1].c_str(), atol(tokens[2].c_str()), tokens[3].c_str());
+         }
+         else if(tokens[0].compare(MM::g_CFGCommand_Configuration) == 0)
+         {
+            // define configuration command
+            // ----------------------------
+            if (tokens.size() != 5)
+               throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                     ToQuotedString(line) + ")",
+                     MMERR_InvalidCFGEntry);
+            LOG_WARNING(coreLogger_) << "Obsolete command " << tokens[0] <<
+               " ignored in configuration file";
+         }
+         else if(tokens[0].compare(MM::g_CFGCommand_ConfigGroup) == 0)
+         {
+            // define grouped configuration command
+            // ------------------------------------
+            if (tokens.size() == 6)
+               defineConfig(tokens[1].c_str(), tokens[2].c_str(), tokens[3].c_str(), tokens[4].c_str(), tokens[5].c_str());
+            else if (tokens.size() == 5)
             {
-               // set pixel size
-               // --------------
-               if (tokens.size() == 3)
-                  setPixelSizeUm(tokens[1].c_str(), atof(tokens[2].c_str()));
-               else
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
+               // we will assume here that the last (missing) token is representing an empty string
+               defineConfig(tokens[1].c_str(), tokens[2].c_str(), tokens[3].c_str(), tokens[4].c_str(), "");
             }
-            else if(tokens[0].compare(MM::g_CFGCommand_PixelSizeAffine) == 0)
+            else if (tokens.size() == 2)
+               defineConfigGroup(tokens[1].c_str());
+            else
+               throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                     ToQuotedString(line) + ")",
+                     MMERR_InvalidCFGEntry);
+         }
+         else if(tokens[0].compare(MM::g_CFGCommand_ConfigPixelSize) == 0)
+         {
+            // define pixel size configuration command
+            // ---------------------------------------
+            if (tokens.size() == 5)
+               definePixelSizeConfig(tokens[1].c_str(), tokens[2].c_str(), tokens[3].c_str(), tokens[4].c_str());
+            else
+               throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                     ToQuotedString(line) + ")",
+                     MMERR_InvalidCFGEntry);
+         }
+         else if(tokens[0].compare(MM::g_CFGCommand_PixelSize_um) == 0)
+         {
+            // set pixel size
+            // --------------
+            if (tokens.size() == 3)
+               setPixelSizeUm(tokens[1].c_str(), atof(tokens[2].c_str()));
+            else
+               throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                     ToQuotedString(line) + ")",
+                     MMERR_InvalidCFGEntry);
+         }
+         else if(tokens[0].compare(MM::g_CFGCommand_PixelSizeAffine) == 0)
+         {
+            // set affine transform
+            // --------------
+            //
+            if (tokens.size() == 8)
             {
-               // set affine transform
-               // --------------
-               //
-               if (tokens.size() == 8)
+               std::vector<double> affineT(6);
+               for (int i = 0; i < 6; i++)
                {
-                  std::vector<double> affineT(6);
-                  for (int i = 0; i < 6; i++)
-                  {
-                     affineT[i] = std::atof(tokens[i + 2].c_str());
-                  }
-                  setPixelSizeAffine(tokens[1].c_str(), affineT);
+                  affineT[i] = std::atof(tokens[i + 2].c_str());
                }
-               else
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
-            }
-            else if (tokens[0].compare(MM::g_CFGCommand_PixelSizedxdz) == 0)
-            {
-               if (tokens.size() == 3)
-                  setPixelSizedxdz(tokens[1].c_str(), atof(tokens[2].c_str()));
-               else
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
-            }
-            else if (tokens[0].compare(MM::g_CFGCommand_PixelSizedydz) == 0)
-            {
-               if (tokens.size() == 3)
-                  setPixelSizedydz(tokens[1].c_str(), atof(tokens[2].c_str()));
-               else
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
-            }
-            else if (tokens[0].compare(MM::g_CFGCommand_PixelSizeOptimalZUm) == 0)
-            {
-               if (tokens.size() == 3)
-                  setPixelSizeOptimalZUm(tokens[1].c_str(), atof(tokens[2].c_str()));
-               else
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
-            }
-            else if(tokens[0].compare(MM::g_CFGCommand_Equipment) == 0)
-            {
-              // Property blocks have been removed
-              throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                    ToQuotedString(line) + ")",
-                    MMERR_InvalidCFGEntry);
+               setPixelSizeAffine(tokens[1].c_str(), affineT);
             }
-            else if(tokens[0].compare(MM::g_CFGCommand_ImageSynchro) == 0)
-            {
-               // ImageSynchro has been removed
+            else
                throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
                      ToQuotedString(line) + ")",
                      MMERR_InvalidCFGEntry);
-            }
-            else if(tokens[0].compare(MM::g_CFGCommand_ParentID) == 0)
-            {
-               // set parent ID
-               // -------------
-               if (tokens.size() != 3)
-                  throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
-                        ToQuotedString(line) + ")",
-                        MMERR_InvalidCFGEntry);
-
-               setParentLabel(tokens[1].c_str(), tokens[2].c_str());
-            }
-
          }
-         catch (CMMError& err)
+         else if (tokens[0].compare(MM::g_CFGCommand_PixelSizedxdz) == 0)
+         {
+            if (tokens.size() == 3)
+               setPixelSizedxdz(tokens[1].c_str(), atof(tokens[2].c_str()));
+            else
+               throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                     ToQuotedString(line) + ")",
+                     MMERR_InvalidCFGEntry);
+         }
+         else if (tokens[0].compare(MM::g_CFGCommand_PixelSizedydz) == 0)
+         {
+            if (tokens.size() == 3)
+               setPixelSizedydz(tokens[1].c_str(), atof(tokens[2].c_str()));
+            else
+               throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                     ToQuotedString(line) + ")",
+                     MMERR_InvalidCFGEntry);
+         }
+         else if (tokens[0].compare(MM::g_CFGCommand_PixelSizeOptimalZUm) == 0)
+         {
+            if (tokens.size() == 3)
+               setPixelSizeOptimalZUm(tokens[1].c_str(), atof(tokens[2].c_str()));
+            else
+               throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                     ToQuotedString(line) + ")",
+                     MMERR_InvalidCFGEntry);
+         }
+         else if(tokens[0].compare(MM::g_CFGCommand_Equipment) == 0)
+         {
+           // Property blocks have been removed
+           throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                 ToQuotedString(line) + ")",
+                 MMERR_InvalidCFGEntry);
+         }
+         else if(tokens[0].compare(MM::g_CFGCommand_ImageSynchro) == 0)
+         {
+            // ImageSynchro has been removed
+            throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                  ToQuotedString(line) + ")",
+                  MMERR_InvalidCFGEntry);
+         }
+         else if(tokens[0].compare(MM::g_CFGCommand_ParentID) == 0)
          {
-            std::ostringstream errorText;
-            errorText << "Line " << lineCount << ": " << line << '\n';
-            errorText << err.getFullMsg() << "\n\n";
-            throw CMMError(errorText.str().c_str(), MMERR_InvalidConfigurationFile);
+            // set parent ID
+            // -------------
+            if (tokens.size() != 3)
+               throw CMMError(getCoreErrorText(MMERR_InvalidCFGEntry) + " (" +
+                     ToQuotedString(line) + ")",
+                     MMERR_InvalidCFGEntry);
+
+            setParentLabel(tokens[1].c_str(), tokens[2].c_str());
          }
+
+      }
+      catch (CMMError& err)
+      {
+         throw lineError(entry, err.getFullMsg());
       }
+      *category += elapsedMs(start);
    }
+   applyPending();
 
    // file parsing finished, try to set startup configuration
+   Clock::time_point start = Clock::now();
    if (isConfigDefined(MM::g_CFGGroup_System, MM::g_CFGGroup_System_Startup))
    {
       // We need to build the system state cache once here because setConfig()
@@ -7921,9 +9402,23 @@ void CMMCore::loadSystemConfigurationImpl(const char* fileName) MMCORE_LEGACY_TH
 
       this->setConfig(MM::g_CFGGroup_System, MM::g_CFGGroup_System_Startup);
    }
+   startupMs = elapsedMs(start);
 
+   start = Clock::now();
    waitForSystem();
    updateSystemStateCache();
+   const double finalWaitMs = elapsedMs(start);
+
+   LOG_INFO(coreLogger_) << "Loaded system configuration in " <<
+      elapsedMs(loadStart) << " ms (ms spent):" <<
+      "\n   loading devices: " << loadDevicesMs <<
+      "\n   pre-initialization properties: " << preInitMs <<
+      "\n   initializing devices: " << initializeMs <<
+      "\n   post-initialization properties: " << postInitMs <<
+         " (" << postInitCount << " settings in " << postInitBatches << " batches)" <<
+      "\n   other commands: " << otherMs <<
+      "\n   startup configuration: " << startupMs <<
+      "\n   waiting for devices and updating state cache: " << finalWaitMs;
 }
 
 
@@ -8617,10 +10112,17 @@ bool CMMCore::IsCoreDeviceLabel(const char* label) const MMCORE_LEGACY_THROW(CMM
  * Upon error, don't stop, but try to set all failed properties again
  * until all success or no more change takes place
  * If errors remain, throw an error
+ *
+ * Returns the devices that had at least one property set (successfully or
+ * not), in the order they first appear in the configuration.
  */
-void CMMCore::applyConfiguration(const Configuration& config) MMCORE_LEGACY_THROW(CMMError)
+std::vector<std::shared_ptr<mmi::DeviceInstance>>
+CMMCore::applyConfiguration(const Configuration& config) MMCORE_LEGACY_THROW(CMMError)
 {
-   std::ostringstream sall;
+   if (mmi::features::flags().parallelConfigApply)
+      return applyConfigurationParallel(config);
+
+   std::vector<std::shared_ptr<mmi::DeviceInstance>> touchedDevices;
    bool error = false;
    std::vector<PropertySetting> failedProps;
    for (size_t i=0; i<config.size(); i++)
@@ -8639,6 +10141,9 @@ void CMMCore::applyConfiguration(const Configuration& config) MMCORE_LEGACY_THRO
          // normal processing
          std::shared_ptr<mmi::DeviceInstance> pDevice =
             deviceManager_->GetDevice(setting.getDeviceLabel());
+         if (std::find(touchedDevices.begin(), touchedDevices.end(), pDevice) ==
+               touchedDevices.end())
+            touchedDevices.push_back(pDevice);
          mmi::DeviceModuleLockGuard guard(pDevice);
          try
          {
@@ -8655,16 +10160,244 @@ void CMMCore::applyConfiguration(const Configuration& config) MMCORE_LEGACY_THRO
       }
    }
    if (error)
+      retryFailedProperties(failedProps);
+   return touchedDevices;
+}
+
+/*
+ * Parallel variant of applyConfiguration(), used when the
+ * ParallelConfigApply feature is enabled.
+ *
+ * Settings whose value already matches the system state cache are skipped.
+ * Core settings divide the remaining settings into batches, and are applied
+ * on the calling thread where they appear in the configuration: after the
+ * device settings before them, and before those after them. Within a batch,
+ * settings are grouped by device lock (the module lock, or the device's own
+ * lock for modules with per-device locking) and each group is applied on its
+ * own thread, in configuration order. Settings that fail are retried
+ * serially at the end, exactly as in applyConfiguration().
+ */
+std::vector<std::shared_ptr<mmi::DeviceInstance>>
+CMMCore::applyConfigurationParallel(const Configuration& config) MMCORE_LEGACY_THROW(CMMError)
+{
+   typedef std::vector<std::pair<std::shared_ptr<mmi::DeviceInstance>, PropertySetting>>
+      ModuleSettings;
+   struct Batch
+   {
+      std::vector<const std::recursive_mutex*> moduleOrder;
+      std::map<const std::recursive_mutex*, ModuleSettings> moduleMap;
+      std::vector<PropertySetting> coreSettings; // Applied after the others
+   };
+   std::vector<Batch> batches(1);
+   std::vector<std::shared_ptr<mmi::DeviceInstance>> touchedDevices;
+   size_t skipped = 0;
+   size_t lockGroups = 0;
+
+   for (size_t i = 0; i < config.size(); i++)
+   {
+      PropertySetting setting = config.getSetting(i);
+
+      if (setting.getDeviceLabel().compare(MM::g_Keyword_CoreDevice) == 0)
+      {
+         batches.back().coreSettings.push_back(setting);
+         continue;
+      }
+
+      std::shared_ptr<mmi::DeviceInstance> pDevice =
+         deviceManager_->GetDevice(setting.getDeviceLabel());
+
+      auto cached = stateCache_->getSetting(setting.getDeviceLabel().c_str(),
+            setting.getPropertyName().c_str());
+      if (cached && cached->getPropertyValue() == setting.getPropertyValue())
+      {
+         ++skipped;
+         continue;
+      }
+
+      if (std::find(touchedDevices.begin(), touchedDevices.end(), pDevice) ==
+            touchedDevices.end())
+         touchedDevices.push_back(pDevice);
+
+      if (!batches.back().coreSettings.empty())
+         batches.emplace_back();
+      Batch& batch = batches.back();
+      const std::recursive_mutex* pLock = &mmi::DeviceModuleLockGuard::GetLock(pDevice);
+      auto it = batch.moduleMap.find(pLock);
+      if (it == batch.moduleMap.end())
+      {
+         batch.moduleOrder.push_back(pLock);
+         it = batch.moduleMap.insert({ pLock, ModuleSettings() }).first;
+         ++lockGroups;
+      }
+      it->second.push_back(std::make_pair(pDevice, setting));
+   }
+
+   LOG_DEBUG(coreLogger_) << "Will apply " <<
+      (config.size() - skipped) << " of " << config.size() <<
+      " settings (" << skipped << " unchanged) across " <<
+      lockGroups << " lock groups in " << batches.size() << " batches";
+
+   auto applyModuleSettings = [this](const ModuleSettings& settings)
+   {
+      std::vector<PropertySetting> failed;
+      for (const auto& deviceSetting : settings)
+      {
+         mmi::DeviceModuleLockGuard guard(deviceSetting.first);
+         try
+         {
+            deviceSetting.first->SetProperty(
+                  deviceSetting.second.getPropertyName(),
+                  deviceSetting.second.getPropertyValue());
+            stateCache_->addSetting(deviceSetting.second);
+         }
+         catch (const CMMError&)
+         {
+            failed.push_back(deviceSetting.second);
+         }
+      }
+      return failed;
+   };
+
+   std::vector<PropertySetting> failedProps;
+   for (Batch& batch : batches)
    {
-      std::string errorString;
-      while (failedProps.size() > (unsigned) applyProperties(failedProps, errorString) )
+      if (batch.moduleOrder.size() == 1)
+      {
+         std::vector<PropertySetting> failed =
+            applyModuleSettings(batch.moduleMap[batch.moduleOrder.front()]);
+         failedProps.insert(failedProps.end(), failed.begin(), failed.end());
+      }
+      else if (batch.moduleOrder.size() > 1)
+      {
+         std::vector<std::future<std::vector<PropertySetting>>> futures;
+         for (const auto& pLock : batch.moduleOrder)
+         {
+            futures.push_back(std::async(std::launch::async,
+                  applyModuleSettings, std::cref(batch.moduleMap[pLock])));
+         }
+
+         // Wait for all futures even if one throws (see
+         // initializeAllDevicesParallel()).
+         std::exception_ptr pex;
+         for (auto& fut : futures)
+         {
+            try
+            {
+               std::vector<PropertySetting> failed = fut.get();
+               failedProps.insert(failedProps.end(), failed.begin(), failed.end());
+            }
+            catch (const std::exception&)
+            {
+               if (!pex)
+                  pex = std::current_exception();
+            }
+         }
+         if (pex)
+            std::rethrow_exception(pex);
+      }
+
+      for (const auto& setting : batch.coreSettings)
       {
-         if (failedProps.size() == 0)
-            return;
+         properties_->Set(setting.getPropertyName().c_str(), setting.getPropertyValue());
+         std::string actual = properties_->Get(setting.getPropertyName().c_str());
+         stateCache_->addSetting(PropertySetting(MM::g_Keyword_CoreDevice, setting.getPropertyName().c_str(), actual.c_str()));
       }
+   }
+
+   if (!failedProps.empty())
+      retryFailedProperties(failedProps);
+   return touchedDevices;
+}
+
+/*
+ * Returns true if every setting in config matches the system state cache.
+ */
+bool CMMCore::isConfigurationInCache(const Configuration& config) const
+{
+   for (size_t i = 0; i < config.size(); i++)
+   {
+      PropertySetting setting = config.getSetting(i);
+      auto cached = stateCache_->getSetting(setting.getDeviceLabel().c_str(),
+            setting.getPropertyName().c_str());
+      if (!cached || cached->getPropertyValue() != setting.getPropertyValue())
+         return false;
+   }
+   return true;
+}
+
+/*
+ * Helper function for applyConfiguration
+ * Retries the given failed settings until all succeed or a round makes no
+ * progress, in which case the last error is thrown.
+ */
+void CMMCore::retryFailedProperties(std::vector<PropertySetting>& failedProps) MMCORE_LEGACY_THROW(CMMError)
+{
+   std::string errorString;
+   while (failedProps.size() > (unsigned) applyProperties(failedProps, errorString) )
+   {
+      if (failedProps.size() == 0)
+         return;
+   }
+
+   throw CMMError(errorString.c_str(), MMERR_DEVICE_GENERIC);
+}
+
+/*
+ * Returns the loaded devices of the given type (all devices for AnyType).
+ */
+std::vector<std::shared_ptr<mmi::DeviceInstance>> CMMCore::getDevicesOfType(MM::DeviceType devType) const
+{
+   std::vector<std::shared_ptr<mmi::DeviceInstance>> devices;
+   for (const auto& label : deviceManager_->GetDeviceList(devType))
+      devices.push_back(deviceManager_->GetDevice(label));
+   return devices;
+}
+
+/*
+ * Waits until all the given devices are no longer busy. Devices that do not
+ * share a lock (see GroupDevicesByLock()) are waited for concurrently; devices
+ * sharing a lock one after another, since their Busy() calls would be
+ * serialized anyway. Throws the first error encountered after all waits have finished.
+ */
+void CMMCore::waitForDevices(const std::vector<std::shared_ptr<mmi::DeviceInstance>>& devices) MMCORE_LEGACY_THROW(CMMError)
+{
+   auto groups = GroupDevicesByLock(devices);
+
+   auto waitForGroup = [this](const std::vector<std::shared_ptr<mmi::DeviceInstance>>& group)
+   {
+      for (const auto& pDevice : group)
+         waitForDevice(pDevice);
+   };
+
+   if (groups.size() <= 1)
+   {
+      for (const auto& group : groups)
+         waitForGroup(group);
+      return;
+   }
+
+   std::vector<std::future<void>> futures;
+   for (const auto& group : groups)
+   {
+      futures.push_back(std::async(std::launch::async,
+            waitForGroup, std::cref(group)));
+   }
 
-      throw CMMError(errorString.c_str(), MMERR_DEVICE_GENERIC);
+   std::exception_ptr pex;
+   for (auto& fut : futures)
+   {
+      try
+      {
+         fut.get();
+      }
+      catch (const std::exception&)
+      {
+         if (!pex)
+            pex = std::current_exception();
+      }
    }
+   if (pex)
+      std::rethrow_exception(pex);
 }
 
 /*
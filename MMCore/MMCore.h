@@ -47,6 +47,7 @@
 
 #include "CoreDeclHelpers.h"
 #include "Configuration.h"
+#include "DeviceHandle.h"
 #include "Error.h"
 #include "ErrorCodes.h"
 #include "LogLevel.h"
@@ -83,6 +84,7 @@ namespace internal {
    class SLMInstance;
    class ShutterInstance;
    class StageInstance;
+   class StateInstance;
    class XYStageInstance;
    class PressurePumpInstance;
    class VolumetricPumpInstance;
@@ -92,7 +94,11 @@ namespace internal {
    class CoreCallback;
    class CorePropertyCollection;
    class CPluginManager;
+   class DemosaicConfig;
+   class DemosaicStage;
+   class DeviceCallTracer;
    class DeviceManager;
+   class FrameLatencyStats;
    class LogManager;
    class NotificationQueue;
 } // namespace internal
@@ -214,6 +220,9 @@ public:
    void setDeviceAdapterSearchPaths(const std::vector<std::string>& paths);
 
    std::vector<std::string> getDeviceAdapterNames() MMCORE_LEGACY_THROW(CMMError);
+   void setDeviceAdapterIndexFile(const char* path) MMCORE_LEGACY_THROW(CMMError);
+   std::string getDeviceAdapterIndexFile();
+   void updateDeviceAdapterIndex() MMCORE_LEGACY_THROW(CMMError);
 
    std::vector<std::string> getAvailableDevices(const char* library) MMCORE_LEGACY_THROW(CMMError);
    std::vector<std::string> getAvailableDeviceDescriptions(const char* library) MMCORE_LEGACY_THROW(CMMError);
@@ -231,15 +240,34 @@ public:
    std::string getDeviceLibrary(const char* label) MMCORE_LEGACY_THROW(CMMError);
    std::string getDeviceName(const char* label) MMCORE_LEGACY_THROW(CMMError);
    std::string getDeviceDescription(const char* label) MMCORE_LEGACY_THROW(CMMError);
+   DeviceHandle getDeviceHandle(const char* label) MMCORE_LEGACY_THROW(CMMError);
 
    std::vector<std::string> getDevicePropertyNames(const char* label) MMCORE_LEGACY_THROW(CMMError);
    bool hasProperty(const char* label, const char* propName) MMCORE_LEGACY_THROW(CMMError);
    std::string getProperty(const char* label, const char* propName) MMCORE_LEGACY_THROW(CMMError);
+   double getPropertyAsDouble(const char* label, const char* propName) MMCORE_LEGACY_THROW(CMMError);
    void setProperty(const char* label, const char* propName, const char* propValue) MMCORE_LEGACY_THROW(CMMError);
    void setProperty(const char* label, const char* propName, const bool propValue) MMCORE_LEGACY_THROW(CMMError);
    void setProperty(const char* label, const char* propName, const long propValue) MMCORE_LEGACY_THROW(CMMError);
    void setProperty(const char* label, const char* propName, const float propValue) MMCORE_LEGACY_THROW(CMMError);
    void setProperty(const char* label, const char* propName, const double propValue) MMCORE_LEGACY_THROW(CMMError);
+   std::string getProperty(const DeviceHandle& device, const char* propName) MMCORE_LEGACY_THROW(CMMError);
+   double getPropertyAsDouble(const DeviceHandle& device, const char* propName) MMCORE_LEGACY_THROW(CMMError);
+   void setProperty(const DeviceHandle& device, const char* propName, const char* propValue) MMCORE_LEGACY_THROW(CMMError);
+   void setProperty(const DeviceHandle& device, const char* propName, const bool propValue) MMCORE_LEGACY_THROW(CMMError);
+   void setProperty(const DeviceHandle& device, const char* propName, const long propValue) MMCORE_LEGACY_THROW(CMMError);
+   void setProperty(const DeviceHandle& device, const char* propName, const float propValue) MMCORE_LEGACY_THROW(CMMError);
+   void setProperty(const DeviceHandle& device, const char* propName, const double propValue) MMCORE_LEGACY_THROW(CMMError);
+   std::vector<std::string> getProperties(const char* label,
+         const std::vector<std::string>& propNames,
+         std::vector<std::string>& errors) MMCORE_LEGACY_THROW(CMMError);
+   std::vector<std::string> getProperties(const std::vector<std::string>& labels,
+         const std::vector<std::string>& propNames,
+         std::vector<std::string>& errors) MMCORE_LEGACY_THROW(CMMError);
+   std::vector<std::string> setProperties(const char* label,
+         const std::vector<std::string>& propNames,
+         const std::vector<std::string>& propValues) MMCORE_LEGACY_THROW(CMMError);
+   std::vector<std::string> setProperties(const Configuration& settings) MMCORE_LEGACY_THROW(CMMError);
 
    std::vector<std::string> getAllowedPropertyValues(const char* label, const char* propName) MMCORE_LEGACY_THROW(CMMError);
    bool isPropertyReadOnly(const char* label, const char* propName) MMCORE_LEGACY_THROW(CMMError);
@@ -256,7 +284,9 @@ public:
    void loadPropertySequence(const char* label, const char* propName, std::vector<std::string> eventSequence) MMCORE_LEGACY_THROW(CMMError);
 
    bool deviceBusy(const char* label) MMCORE_LEGACY_THROW(CMMError);
+   bool deviceBusy(const DeviceHandle& device) MMCORE_LEGACY_THROW(CMMError);
    void waitForDevice(const char* label) MMCORE_LEGACY_THROW(CMMError);
+   void waitForDevice(const DeviceHandle& device) MMCORE_LEGACY_THROW(CMMError);
    void waitForConfig(const char* group, const char* configName) MMCORE_LEGACY_THROW(CMMError);
    bool systemBusy() MMCORE_LEGACY_THROW(CMMError);
    void waitForSystem() MMCORE_LEGACY_THROW(CMMError);
@@ -326,6 +356,8 @@ public:
    bool isGroupDefined(const char* groupName);
    bool isConfigDefined(const char* groupName, const char* configName);
    void setConfig(const char* groupName, const char* configName) MMCORE_LEGACY_THROW(CMMError);
+   void setConfig(const char* groupName, const char* configName,
+         bool wait) MMCORE_LEGACY_THROW(CMMError);
    void deleteConfig(const char* groupName, const char* configName) MMCORE_LEGACY_THROW(CMMError);
    void deleteConfig(const char* groupName, const char* configName,
          const char* deviceLabel, const char* propName) MMCORE_LEGACY_THROW(CMMError);
@@ -336,6 +368,9 @@ public:
    std::string getCurrentConfig(const char* groupName) MMCORE_LEGACY_THROW(CMMError);
    Configuration getConfigData(const char* configGroup,
          const char* configName) MMCORE_LEGACY_THROW(CMMError);
+   Configuration getConfigTransitionData(const char* configGroup,
+         const char* fromConfigName,
+         const char* toConfigName) MMCORE_LEGACY_THROW(CMMError);
    ///@}
 
    /** \name The pixel size configuration group. */
@@ -397,6 +432,8 @@ public:
    void setExposure(const char* cameraLabel, double dExp) MMCORE_LEGACY_THROW(CMMError);
    double getExposure() MMCORE_LEGACY_THROW(CMMError);
    double getExposure(const char* label) MMCORE_LEGACY_THROW(CMMError);
+   void setExposure(const DeviceHandle& camera, double dExp) MMCORE_LEGACY_THROW(CMMError);
+   double getExposure(const DeviceHandle& camera) MMCORE_LEGACY_THROW(CMMError);
 
    long getBinning() MMCORE_LEGACY_THROW(CMMError);
    long getBinning(const char* label) MMCORE_LEGACY_THROW(CMMError);
@@ -446,6 +483,8 @@ public:
    void* getNBeforeLastImageMD(unsigned long n, Metadata& md)
       const MMCORE_LEGACY_THROW(CMMError);
    void* popNextImageMD(Metadata& md) MMCORE_LEGACY_THROW(CMMError);
+   void* getLastRawImageMD(Metadata& md) const MMCORE_LEGACY_THROW(CMMError);
+   void* popNextRawImageMD(Metadata& md) MMCORE_LEGACY_THROW(CMMError);
 
    long getRemainingImageCount();
    long getBufferTotalCapacity();
@@ -455,6 +494,7 @@ public:
    unsigned getCircularBufferMemoryFootprint();
    void initializeCircularBuffer() MMCORE_LEGACY_THROW(CMMError);
    void clearCircularBuffer() MMCORE_LEGACY_THROW(CMMError);
+   long getBufferHighWaterMark();
 
    bool isExposureSequenceable(const char* cameraLabel) MMCORE_LEGACY_THROW(CMMError);
    void startExposureSequence(const char* cameraLabel) MMCORE_LEGACY_THROW(CMMError);
@@ -464,6 +504,41 @@ public:
          std::vector<double> exposureSequence_ms) MMCORE_LEGACY_THROW(CMMError);
    ///@}
 
+   /** \name Frame latency statistics. */
+   ///@{
+   void enableFrameLatencyStats(bool enable);
+   bool isFrameLatencyStatsEnabled();
+   void enableFrameLatencyTags(bool enable);
+   bool isFrameLatencyTagsEnabled();
+   std::vector<std::string> getFrameLatencyStatsCameras();
+   double getFrameLatencyPercentileUs(const char* cameraLabel,
+         const char* stage, double percentile) MMCORE_LEGACY_THROW(CMMError);
+   double getFrameLatencyMeanUs(const char* cameraLabel,
+         const char* stage) MMCORE_LEGACY_THROW(CMMError);
+   long getFrameLatencyCount(const char* cameraLabel,
+         const char* stage) MMCORE_LEGACY_THROW(CMMError);
+   void resetFrameLatencyStats();
+   ///@}
+
+   /** \name Demosaicing of raw Bayer images. */
+   ///@{
+   void setCameraDemosaic(const char* cameraLabel, const char* cfaPattern,
+         const char* algorithm, unsigned bitDepth) MMCORE_LEGACY_THROW(CMMError);
+   void clearCameraDemosaic(const char* cameraLabel) MMCORE_LEGACY_THROW(CMMError);
+   bool isCameraDemosaicEnabled(const char* cameraLabel) MMCORE_LEGACY_THROW(CMMError);
+   std::vector<std::string> getDemosaicPatterns();
+   std::vector<std::string> getDemosaicAlgorithms();
+   ///@}
+
+   /** \name Device call tracing. */
+   ///@{
+   void enableDeviceCallTracing(bool enable);
+   bool isDeviceCallTracingEnabled();
+   void clearDeviceCallTrace();
+   long getDeviceCallTraceEventCount();
+   void saveDeviceCallTrace(const char* fileName) MMCORE_LEGACY_THROW(CMMError);
+   ///@}
+
    /** \name Autofocus control. */
    ///@{
    double getLastFocusScore();
@@ -482,6 +557,8 @@ public:
    ///@{
    void setState(const char* stateDeviceLabel, long state) MMCORE_LEGACY_THROW(CMMError);
    long getState(const char* stateDeviceLabel) MMCORE_LEGACY_THROW(CMMError);
+   void setState(const DeviceHandle& stateDevice, long state) MMCORE_LEGACY_THROW(CMMError);
+   long getState(const DeviceHandle& stateDevice) MMCORE_LEGACY_THROW(CMMError);
    long getNumberOfStates(const char* stateDeviceLabel);
    void setStateLabel(const char* stateDeviceLabel,
          const char* stateLabel) MMCORE_LEGACY_THROW(CMMError);
@@ -502,6 +579,9 @@ public:
    double getPosition() MMCORE_LEGACY_THROW(CMMError);
    void setRelativePosition(const char* stageLabel, double d) MMCORE_LEGACY_THROW(CMMError);
    void setRelativePosition(double d) MMCORE_LEGACY_THROW(CMMError);
+   void setPosition(const DeviceHandle& stage, double position) MMCORE_LEGACY_THROW(CMMError);
+   double getPosition(const DeviceHandle& stage) MMCORE_LEGACY_THROW(CMMError);
+   void setRelativePosition(const DeviceHandle& stage, double d) MMCORE_LEGACY_THROW(CMMError);
    void setOrigin(const char* stageLabel) MMCORE_LEGACY_THROW(CMMError);
    void setOrigin() MMCORE_LEGACY_THROW(CMMError);
    void setAdapterOrigin(const char* stageLabel, double newZUm) MMCORE_LEGACY_THROW(CMMError);
@@ -532,6 +612,12 @@ public:
    void getXYPosition(const char* xyStageLabel,
          double &x_stage, double &y_stage) MMCORE_LEGACY_THROW(CMMError);
    void getXYPosition(double &x_stage, double &y_stage) MMCORE_LEGACY_THROW(CMMError);
+   void setXYPosition(const DeviceHandle& xyStage,
+         double x, double y) MMCORE_LEGACY_THROW(CMMError);
+   void setRelativeXYPosition(const DeviceHandle& xyStage,
+         double dx, double dy) MMCORE_LEGACY_THROW(CMMError);
+   void getXYPosition(const DeviceHandle& xyStage,
+         double &x_stage, double &y_stage) MMCORE_LEGACY_THROW(CMMError);
    double getXPosition(const char* xyStageLabel) MMCORE_LEGACY_THROW(CMMError);
    double getYPosition(const char* xyStageLabel) MMCORE_LEGACY_THROW(CMMError);
    double getXPosition() MMCORE_LEGACY_THROW(CMMError);
@@ -729,11 +815,15 @@ private:
    std::unique_ptr<mmcore::internal::ConfigGroupCollection> configGroups_;
    std::unique_ptr<PixelSizeConfigGroup> pixelSizeGroup_;
    std::unique_ptr<mmcore::internal::CorePropertyCollection> properties_;
+   std::unique_ptr<mmcore::internal::FrameLatencyStats> latencyStats_;
+   std::unique_ptr<mmcore::internal::DemosaicStage> demosaicStage_;
+   std::vector<unsigned char> demosaicedImage_; // Returned by getImage()
    std::unique_ptr<mmcore::internal::CircularBuffer> cbuf_;
    std::unique_ptr<mmcore::internal::CoreCallback> callback_;
 
    std::shared_ptr<mmcore::internal::CPluginManager> pluginManager_;
    std::shared_ptr<mmcore::internal::DeviceManager> deviceManager_;
+   std::shared_ptr<mmcore::internal::DeviceCallTracer> callTracer_;
    std::map<int, std::string> errorText_;
 
    std::unique_ptr<SynchronizedConfiguration> stateCache_;
@@ -761,9 +851,53 @@ private:
    static void CheckConfigPresetName(const char* presetName) MMCORE_LEGACY_THROW(CMMError);
    bool IsCoreDeviceLabel(const char* label) const MMCORE_LEGACY_THROW(CMMError);
 
-   void applyConfiguration(const Configuration& config) MMCORE_LEGACY_THROW(CMMError);
+   std::vector<std::shared_ptr<mmcore::internal::DeviceInstance>>
+      applyConfiguration(const Configuration& config) MMCORE_LEGACY_THROW(CMMError);
+   std::vector<std::shared_ptr<mmcore::internal::DeviceInstance>>
+      applyConfigurationParallel(const Configuration& config) MMCORE_LEGACY_THROW(CMMError);
+   void retryFailedProperties(std::vector<PropertySetting>& failedProps) MMCORE_LEGACY_THROW(CMMError);
    int applyProperties(std::vector<PropertySetting>& props, std::string& lastError);
    void waitForDevice(std::shared_ptr<mmcore::internal::DeviceInstance> pDev) MMCORE_LEGACY_THROW(CMMError);
+   void waitForDevices(const std::vector<std::shared_ptr<mmcore::internal::DeviceInstance>>& devices) MMCORE_LEGACY_THROW(CMMError);
+   std::vector<std::shared_ptr<mmcore::internal::DeviceInstance>> getDevicesOfType(MM::DeviceType devType) const;
+   std::vector<std::string> setPropertyBatch(const std::vector<std::string>& labels,
+         const std::vector<std::string>& propNames,
+         const std::vector<std::string>& propValues,
+         bool concurrently, bool stopAtFirstError = false) MMCORE_LEGACY_THROW(CMMError);
+   std::vector<std::vector<std::pair<std::shared_ptr<mmcore::internal::DeviceInstance>, size_t>>>
+      groupPropertyRequests(const std::vector<std::string>& labels,
+            const std::vector<std::string>& propNames,
+            std::vector<size_t>& coreRequests,
+            std::vector<std::string>& errors) MMCORE_LEGACY_THROW(CMMError);
+   template <typename T>
+   void setPropertyNumeric(const char* label, const char* propName, T propValue,
+         bool (mmcore::internal::DeviceInstance::*setter)(const std::string&, T) const) MMCORE_LEGACY_THROW(CMMError);
+   template <typename T>
+   void setPropertyNumeric(std::shared_ptr<mmcore::internal::DeviceInstance> pDevice,
+         const char* propName, T propValue,
+         bool (mmcore::internal::DeviceInstance::*setter)(const std::string&, T) const) MMCORE_LEGACY_THROW(CMMError);
+
+   // Resolve a device handle, throwing if the device has been unloaded (or
+   // is of the wrong type)
+   template <class TDeviceInstance>
+   std::shared_ptr<TDeviceInstance> resolveDeviceHandle(const DeviceHandle& handle) const MMCORE_LEGACY_THROW(CMMError);
+
+   // Implementations shared by the label and handle overloads
+   std::string getProperty(std::shared_ptr<mmcore::internal::DeviceInstance> pDevice, const char* propName) MMCORE_LEGACY_THROW(CMMError);
+   double getPropertyAsDouble(std::shared_ptr<mmcore::internal::DeviceInstance> pDevice, const char* propName) MMCORE_LEGACY_THROW(CMMError);
+   void setProperty(std::shared_ptr<mmcore::internal::DeviceInstance> pDevice, const char* propName, const char* propValue) MMCORE_LEGACY_THROW(CMMError);
+   bool deviceBusy(std::shared_ptr<mmcore::internal::DeviceInstance> pDevice) MMCORE_LEGACY_THROW(CMMError);
+   void setExposure(std::shared_ptr<mmcore::internal::CameraInstance> pCamera, double dExp) MMCORE_LEGACY_THROW(CMMError);
+   double getExposure(std::shared_ptr<mmcore::internal::CameraInstance> pCamera) MMCORE_LEGACY_THROW(CMMError);
+   void setState(std::shared_ptr<mmcore::internal::StateInstance> pStateDev, long state) MMCORE_LEGACY_THROW(CMMError);
+   long getState(std::shared_ptr<mmcore::internal::StateInstance> pStateDev) MMCORE_LEGACY_THROW(CMMError);
+   void setPosition(std::shared_ptr<mmcore::internal::StageInstance> pStage, double position) MMCORE_LEGACY_THROW(CMMError);
+   double getPosition(std::shared_ptr<mmcore::internal::StageInstance> pStage) MMCORE_LEGACY_THROW(CMMError);
+   void setRelativePosition(std::shared_ptr<mmcore::internal::StageInstance> pStage, double d) MMCORE_LEGACY_THROW(CMMError);
+   void setXYPosition(std::shared_ptr<mmcore::internal::XYStageInstance> pXYStage, double x, double y) MMCORE_LEGACY_THROW(CMMError);
+   void setRelativeXYPosition(std::shared_ptr<mmcore::internal::XYStageInstance> pXYStage, double dx, double dy) MMCORE_LEGACY_THROW(CMMError);
+   void getXYPosition(std::shared_ptr<mmcore::internal::XYStageInstance> pXYStage, double& x, double& y) MMCORE_LEGACY_THROW(CMMError);
+   bool isConfigurationInCache(const Configuration& config) const;
    Configuration getConfigGroupState(const char* group, bool fromCache) MMCORE_LEGACY_THROW(CMMError);
    std::string getDeviceErrorText(int deviceCode, std::shared_ptr<mmcore::internal::DeviceInstance> pDevice);
    std::string getDeviceName(std::shared_ptr<mmcore::internal::DeviceInstance> pDev);
@@ -772,6 +906,12 @@ private:
    void removeDeviceRole(std::shared_ptr<mmcore::internal::DeviceInstance> pDev);
    void removeAllDeviceRoles();
    void loadSystemConfigurationImpl(const char* fileName) MMCORE_LEGACY_THROW(CMMError);
+   // Call with the camera's module locked
+   std::shared_ptr<const mmcore::internal::DemosaicConfig> getCameraDemosaic(
+         std::shared_ptr<mmcore::internal::CameraInstance> pCamera);
+   bool initializeCircularBufferFor(std::shared_ptr<mmcore::internal::CameraInstance> pCamera);
+   void* demosaicSnappedImage(std::shared_ptr<mmcore::internal::CameraInstance> pCamera,
+         const unsigned char* pBuf);
 
    void setCameraInternal(const std::string& label);
    void setShutterInternal(const std::string& label);
@@ -788,7 +928,6 @@ private:
 
    void initializeAllDevicesSerial() MMCORE_LEGACY_THROW(CMMError);
    void initializeAllDevicesParallel() MMCORE_LEGACY_THROW(CMMError);
-   int initializeVectorOfDevices(std::vector<std::pair<std::shared_ptr<mmcore::internal::DeviceInstance>, std::string> > pDevices);
 
    void postNotification(
       mmcore::internal::Notification notification);
@@ -30,4 +30,5 @@ struct MockDeviceAdapter {
    virtual void InitializeModuleData(RegisterDeviceFunc registerDevice) = 0;
    virtual MM::Device* CreateDevice(const char* name) = 0;
    virtual void DeleteDevice(MM::Device* device) = 0;
+   virtual bool GetPerDeviceLocking() { return false; }
 };
@@ -33,11 +33,13 @@
 #include "ModuleInterface.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <fstream>
 #include <memory>
 #include <set>
 #include <string>
+#include <thread>
 #include <vector>
 
 #ifdef _WIN32
@@ -139,24 +141,31 @@ CPluginManager::GetDeviceAdapter(const std::string& moduleName)
       return it->second;
    }
 
+   auto module = LoadModule(moduleName, GetLibraryPath(moduleName));
+   moduleMap_[moduleName] = module;
+   return module;
+}
+
+std::string
+CPluginManager::GetLibraryPath(const std::string& moduleName)
+{
    std::string filename(LIB_NAME_PREFIX);
    filename += moduleName;
    filename += LIB_NAME_SUFFIX;
-   filename = FindInSearchPath(filename);
-
-   auto module = [&] {
-      try {
-         auto impl = std::make_unique<LoadedDeviceAdapterImplRegular>(filename);
-         return std::make_shared<LoadedDeviceAdapter>(moduleName, std::move(impl));
-      }
-      catch (const CMMError& e) {
-         throw CMMError("Failed to load device adapter " + ToQuotedString(moduleName) +
-            " from " + ToQuotedString(filename), e);
-      }
-   }();
+   return FindInSearchPath(filename);
+}
 
-   moduleMap_[moduleName] = module;
-   return module;
+std::shared_ptr<LoadedDeviceAdapter>
+CPluginManager::LoadModule(const std::string& moduleName, const std::string& filename)
+{
+   try {
+      auto impl = std::make_unique<LoadedDeviceAdapterImplRegular>(filename);
+      return std::make_shared<LoadedDeviceAdapter>(moduleName, std::move(impl));
+   }
+   catch (const CMMError& e) {
+      throw CMMError("Failed to load device adapter " + ToQuotedString(moduleName) +
+         " from " + ToQuotedString(filename), e);
+   }
 }
 
 std::shared_ptr<LoadedDeviceAdapter>
@@ -188,6 +197,121 @@ CPluginManager::LoadMockAdapter(const std::string& name, MockDeviceAdapter* impl
 }
 
 
+void
+CPluginManager::SetMetadataIndexFile(const std::string& indexFile)
+{
+   if (indexFile.empty())
+      metadataIndex_.reset();
+   else
+      metadataIndex_ = std::make_unique<AdapterMetadataIndex>(indexFile);
+}
+
+std::string
+CPluginManager::GetMetadataIndexFile() const
+{
+   return metadataIndex_ ? metadataIndex_->GetIndexFile() : std::string();
+}
+
+AdapterMetadata
+CPluginManager::GetAdapterMetadata(const std::string& moduleName)
+{
+   if (moduleName.empty())
+   {
+      throw CMMError("Empty device adapter module name");
+   }
+
+   // Modules that are already loaded (including mock adapters) are asked
+   // directly
+   if (!metadataIndex_ || moduleMap_.count(moduleName))
+      return AdapterMetadata::FromModule(*GetDeviceAdapter(moduleName));
+
+   const std::string path = GetLibraryPath(moduleName);
+   AdapterMetadata metadata;
+   if (metadataIndex_->Lookup(path, metadata))
+      return metadata;
+
+   metadata = AdapterMetadata::FromModule(*GetDeviceAdapter(moduleName));
+   metadataIndex_->Store(path, metadata);
+   metadataIndex_->Save(); // The index is only an optimization
+   return metadata;
+}
+
+AdapterMetadata
+CPluginManager::GetAdapterMetadata(const char* moduleName)
+{
+   if (!moduleName)
+   {
+      throw CMMError("Null device adapter module name");
+   }
+   return GetAdapterMetadata(std::string(moduleName));
+}
+
+std::map<std::string, std::string>
+CPluginManager::UpdateMetadataIndex()
+{
+   if (!metadataIndex_)
+      throw CMMError("No device adapter index file has been set");
+
+   struct Job
+   {
+      std::string moduleName;
+      std::string path;
+      std::shared_ptr<LoadedDeviceAdapter> module;
+      std::string error;
+   };
+   std::vector<Job> jobs;
+   for (const std::string& moduleName : GetAvailableDeviceAdapters())
+   {
+      if (moduleMap_.count(moduleName))
+         continue;
+      const std::string path = GetLibraryPath(moduleName);
+      AdapterMetadata metadata;
+      if (!metadataIndex_->Lookup(path, metadata))
+         jobs.push_back(Job{ moduleName, path, nullptr, std::string() });
+   }
+
+   // Loading a library is mostly spent reading it and in the vendor SDK's
+   // static initialization, so use more threads than there are cores
+   std::atomic<std::size_t> next{ 0 };
+   auto worker = [&] {
+      for (std::size_t i = next++; i < jobs.size(); i = next++)
+      {
+         Job& job = jobs[i];
+         try {
+            job.module = LoadModule(job.moduleName, job.path);
+            metadataIndex_->Store(job.path, AdapterMetadata::FromModule(*job.module));
+         }
+         catch (const CMMError& e) {
+            job.error = e.getFullMsg();
+         }
+      }
+   };
+   const std::size_t threadCount = std::min<std::size_t>(jobs.size(),
+         std::max<std::size_t>(8, 2 * std::thread::hardware_concurrency()));
+   std::vector<std::thread> threads;
+   for (std::size_t i = 1; i < threadCount; ++i)
+      threads.emplace_back(worker);
+   worker();
+   for (std::thread& th : threads)
+      th.join();
+
+   // Keep the modules loaded, as GetDeviceAdapter() would
+   std::map<std::string, std::string> errors;
+   for (const Job& job : jobs)
+   {
+      if (job.module)
+         moduleMap_[job.moduleName] = job.module;
+      if (!job.error.empty())
+         errors[job.moduleName] = job.error;
+   }
+
+   if (!metadataIndex_->Save())
+      throw CMMError("Cannot write device adapter index file " +
+            ToQuotedString(metadataIndex_->GetIndexFile()));
+   return errors;
+}
+
+
 /** 
  * Unload a module.
  */
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "AdapterMetadataIndex.h"
 #include "MockDeviceAdapter.h"
 
 #include <map>
@@ -60,12 +61,34 @@ public:
 
    void LoadMockAdapter(const std::string& name, MockDeviceAdapter* impl);
 
+   // Device adapter metadata index (none if the file is empty)
+   void SetMetadataIndexFile(const std::string& indexFile);
+   std::string GetMetadataIndexFile() const;
+
+   /**
+    * Return the devices provided by a device adapter module, from the
+    * metadata index if it is current, otherwise loading the module
+    */
+   AdapterMetadata GetAdapterMetadata(const std::string& moduleName);
+   AdapterMetadata GetAdapterMetadata(const char* moduleName);
+
+   /**
+    * Load (concurrently) the modules in the search paths that have no current
+    * index entry, and save the index. Returns the error message for each
+    * module that failed to load.
+    */
+   std::map<std::string, std::string> UpdateMetadataIndex();
+
 private:
    static std::vector<std::string> GetDefaultSearchPaths();
    static void GetModules(std::vector<std::string> &modules, const char *path);
    std::string FindInSearchPath(std::string filename);
+   std::string GetLibraryPath(const std::string& moduleName);
+   static std::shared_ptr<LoadedDeviceAdapter>
+   LoadModule(const std::string& moduleName, const std::string& filename);
 
    std::vector<std::string> searchPaths_;
+   std::unique_ptr<AdapterMetadataIndex> metadataIndex_;
 
    std::map< std::string, std::shared_ptr<LoadedDeviceAdapter> > moduleMap_;
 };
@@ -10,6 +10,7 @@
 
 #include <mutex>
 #include <optional>
+#include <vector>
 
 class SynchronizedConfiguration {
 public:
@@ -18,6 +19,12 @@ public:
       config_.addSetting(setting);
    }
 
+   void addSettings(const std::vector<PropertySetting>& settings) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (const auto& setting : settings)
+         config_.addSetting(setting);
+   }
+
    std::optional<PropertySetting> getSetting(const char* device,
          const char* prop) {
       std::lock_guard<std::mutex> lock(mutex_);
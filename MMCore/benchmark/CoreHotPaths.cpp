@@ -0,0 +1,444 @@
+// Measures frequently executed MMCore code paths against mock devices and
+// reports the results as JSON on stdout, so that runs can be compared across
+// commits. No hardware or device adapters are needed; this is run by
+// `meson test --benchmark`.
+//
+// Cases: image insertion throughput by frame size and number of inserting
+// threads, pop latency, camera metadata build and parse, property get/set
+// round trips, config group apply, and device notification throughput.
+//
+// Usage:
+//    core_hot_paths [<minimum seconds per case>]
+
+#include "CameraImageMetadata.h"
+#include "DeviceBase.h"
+#include "ImageMetadata.h"
+#include "MMCore.h"
+#include "MMEventCallback.h"
+#include "MockDeviceUtils.h"
+#include "SerializedMetadata.h"
+#include "StubDevices.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double Seconds(Clock::duration d) {
+   return std::chrono::duration<double>(d).count();
+}
+
+double Percentile(const std::vector<double>& sorted, double p) {
+   size_t i = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+   return sorted[i];
+}
+
+// One JSON object per case: its name, parameters and measured values
+class Results {
+public:
+   using Fields = std::vector<std::pair<std::string, double>>;
+
+   void Add(const std::string& name, const Fields& params,
+         const Fields& values) {
+      std::ostringstream out;
+      out << "    {\"name\": \"" << name << "\"";
+      for (const auto& f : params)
+         out << ", \"" << f.first << "\": " << f.second;
+      for (const auto& f : values)
+         out << ", \"" << f.first << "\": " << f.second;
+      out << "}";
+      entries_.push_back(out.str());
+   }
+
+   void WriteJson(std::ostream& out, double minSeconds) const {
+      out << "{\n"
+         << "  \"min_seconds_per_case\": " << minSeconds << ",\n"
+         << "  \"hardware_threads\": " << std::thread::hardware_concurrency()
+         << ",\n  \"results\": [";
+      for (size_t i = 0; i < entries_.size(); ++i)
+         out << (i ? ",\n" : "\n") << entries_[i];
+      out << "\n  ]\n}\n";
+   }
+
+private:
+   std::vector<std::string> entries_;
+};
+
+// Run op(n) with growing n until it takes at least minSeconds; return the
+// number of operations and the time taken by the last run
+template <typename F>
+std::pair<long, double> RunFor(double minSeconds, F op) {
+   long n = 1;
+   for (;;) {
+      auto start = Clock::now();
+      op(n);
+      double s = Seconds(Clock::now() - start);
+      if (s >= minSeconds || n >= (1L << 30))
+         return {n, s};
+      n = s > 0.0 ?
+         static_cast<long>(n * std::min(10.0, 1.2 * minSeconds / s)) + 1 :
+         n * 10;
+   }
+}
+
+void AddRate(Results& results, const std::string& name,
+      const Results::Fields& params, std::pair<long, double> run) {
+   results.Add(name, params, {
+      {"ops", static_cast<double>(run.first)},
+      {"ns_per_op", 1e9 * run.second / run.first},
+   });
+}
+
+struct PropertyDevice : CGenericBase<PropertyDevice> {
+   std::string name;
+   std::string value = "A";
+   using CGenericBase::OnPropertyChanged;
+
+   explicit PropertyDevice(std::string n = "PropertyDevice") :
+      name(std::move(n)) { EnableDirectNumericPropertyAccess(); }
+
+   int Initialize() override {
+      CreateStringProperty("Plain", "A", false);
+      CreateFloatProperty("Number", 0.0, false);
+      return CreateStringProperty("WithAction", "A", false,
+         new CPropertyAction(this, &PropertyDevice::OnWithAction));
+   }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override { return false; }
+   void GetName(char* buf) const override {
+      CDeviceUtils::CopyLimitedString(buf, name.c_str());
+   }
+
+   int OnWithAction(MM::PropertyBase* pProp, MM::ActionType eAct) {
+      if (eAct == MM::BeforeGet)
+         pProp->Set(value.c_str());
+      else if (eAct == MM::AfterSet)
+         pProp->Get(value);
+      return DEVICE_OK;
+   }
+};
+
+class CountingCallback : public MMEventCallback {
+public:
+   void onPropertiesChanged() override {}
+   void onConfigGroupChanged(const char*, const char*) override {}
+   void onPropertyChanged(const char*, const char*, const char*) override {
+      {
+         std::lock_guard<std::mutex> lock(mutex_);
+         ++count_;
+      }
+      cv_.notify_all();
+   }
+
+   void WaitForCount(long count) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [&] { return count_ >= count; });
+   }
+
+   void Reset() {
+      std::lock_guard<std::mutex> lock(mutex_);
+      count_ = 0;
+   }
+
+private:
+   std::mutex mutex_;
+   std::condition_variable cv_;
+   long count_ = 0;
+};
+
+MM::CameraImageMetadata MakeCameraMetadata(long frame) {
+   MM::CameraImageMetadata md;
+   md.AddTag(MM::g_Keyword_Metadata_CameraLabel, "cam");
+   md.AddTag(MM::g_Keyword_Metadata_ImageNumber, frame);
+   md.AddTag(MM::g_Keyword_Elapsed_Time_ms, 12.5 * frame);
+   md.AddTag(MM::g_Keyword_Metadata_ROI_X, 0);
+   md.AddTag(MM::g_Keyword_Metadata_ROI_Y, 0);
+   md.AddTag(MM::g_Keyword_Binning, 1);
+   return md;
+}
+
+void BenchmarkInsert(Results& results, double minSeconds) {
+   struct Size { unsigned width, height, bytesPerPixel; };
+   const Size sizes[] = { {64, 64, 1}, {512, 512, 2}, {2048, 2048, 2} };
+   const unsigned threadCounts[] = { 1, 2, 4 };
+
+   for (const Size& size : sizes) {
+      StubCamera cam;
+      cam.width = size.width;
+      cam.height = size.height;
+      cam.bytesPerPixel = size.bytesPerPixel;
+      cam.bitDepth = 8 * size.bytesPerPixel;
+      MockAdapterWithDevices adapter{{"cam", &cam}};
+      CMMCore c;
+      c.enableStderrLog(false);
+      adapter.LoadIntoCore(c);
+      c.setCameraDevice("cam");
+      c.setCircularBufferMemoryFootprint(256);
+      c.initializeCircularBuffer();
+      const long capacity = c.getBufferTotalCapacity();
+      const size_t frameBytes = static_cast<size_t>(size.width) *
+         size.height * size.bytesPerPixel;
+      const std::vector<unsigned char> pixels(frameBytes, 1);
+      const MM::CameraImageMetadata md = MakeCameraMetadata(0);
+
+      for (unsigned nThreads : threadCounts) {
+         // Fill the buffer (to just below capacity, so that no insert
+         // overflows), clear it untimed, and repeat
+         const long perThread = std::max(1L, (capacity - 1) / nThreads);
+         long frames = 0;
+         long failures = 0;
+         double seconds = 0.0;
+         while (seconds < minSeconds) {
+            c.clearCircularBuffer();
+            std::vector<std::thread> threads;
+            std::atomic<long> failed{0};
+            auto start = Clock::now();
+            for (unsigned t = 0; t < nThreads; ++t) {
+               threads.emplace_back([&] {
+                  for (long i = 0; i < perThread; ++i)
+                     if (cam.InsertTestImage(md, pixels.data()) != DEVICE_OK)
+                        ++failed;
+               });
+            }
+            for (auto& th : threads)
+               th.join();
+            seconds += Seconds(Clock::now() - start);
+            frames += perThread * nThreads;
+            failures += failed;
+         }
+         results.Add("insert_image", {
+            {"width", size.width},
+            {"height", size.height},
+            {"bytes_per_pixel", size.bytesPerPixel},
+            {"threads", nThreads},
+         }, {
+            {"frames", static_cast<double>(frames)},
+            {"failed", static_cast<double>(failures)},
+            {"frames_per_s", frames / seconds},
+            {"mb_per_s", frames * frameBytes / seconds / 1e6},
+         });
+      }
+   }
+}
+
+void BenchmarkPop(Results& results, double minSeconds) {
+   StubCamera cam;
+   cam.bytesPerPixel = 2;
+   cam.bitDepth = 16;
+   MockAdapterWithDevices adapter{{"cam", &cam}};
+   CMMCore c;
+   c.enableStderrLog(false);
+   adapter.LoadIntoCore(c);
+   c.setCameraDevice("cam");
+   c.setCircularBufferMemoryFootprint(256);
+   c.initializeCircularBuffer();
+   const long capacity = c.getBufferTotalCapacity();
+   const std::vector<unsigned char> pixels(
+      static_cast<size_t>(cam.width) * cam.height * cam.bytesPerPixel, 1);
+
+   std::vector<double> popUs;
+   std::vector<double> popWithMetadataUs;
+   double seconds = 0.0;
+   while (seconds < minSeconds) {
+      c.clearCircularBuffer();
+      for (long i = 0; i < capacity - 1; ++i)
+         cam.InsertTestImage(MakeCameraMetadata(i), pixels.data());
+      auto start = Clock::now();
+      while (c.getRemainingImageCount() > 0) {
+         auto t0 = Clock::now();
+         if (popUs.size() <= popWithMetadataUs.size()) {
+            c.popNextImage();
+            popUs.push_back(1e6 * Seconds(Clock::now() - t0));
+         } else {
+            Metadata md;
+            c.popNextImageMD(md);
+            popWithMetadataUs.push_back(1e6 * Seconds(Clock::now() - t0));
+         }
+      }
+      seconds += Seconds(Clock::now() - start);
+   }
+
+   for (auto* times : { &popUs, &popWithMetadataUs }) {
+      std::sort(times->begin(), times->end());
+      double sum = 0.0;
+      for (double t : *times)
+         sum += t;
+      results.Add(times == &popUs ? "pop_image" : "pop_image_metadata", {
+         {"width", cam.width},
+         {"height", cam.height},
+         {"bytes_per_pixel", cam.bytesPerPixel},
+      }, {
+         {"count", static_cast<double>(times->size())},
+         {"mean_us", sum / times->size()},
+         {"median_us", Percentile(*times, 0.5)},
+         {"p99_us", Percentile(*times, 0.99)},
+         {"max_us", times->back()},
+      });
+   }
+}
+
+void BenchmarkMetadata(Results& results, double minSeconds) {
+   AddRate(results, "metadata_build", {}, RunFor(minSeconds, [](long n) {
+      size_t total = 0;
+      for (long i = 0; i < n; ++i)
+         total += std::strlen(MakeCameraMetadata(i).Serialize());
+      if (total == 0)
+         std::abort();
+   }));
+
+   // What the Core does for each inserted image: wrap the camera's blob and
+   // add the Core's own tags
+   const std::string cameraBlob = MakeCameraMetadata(1).Serialize();
+   AddRate(results, "metadata_add_core_tags", {},
+         RunFor(minSeconds, [&](long n) {
+      size_t total = 0;
+      for (long i = 0; i < n; ++i) {
+         mmcore::internal::SerializedMetadata sm(cameraBlob.c_str());
+         sm.AddTag(MM::g_Keyword_Metadata_Width, 512);
+         sm.AddTag(MM::g_Keyword_Metadata_Height, 512);
+         sm.AddTag(MM::g_Keyword_Metadata_TimeInCore, "2024-01-01 00:00:00.000000");
+         total += sm.View().size();
+      }
+      if (total == 0)
+         std::abort();
+   }));
+
+   mmcore::internal::SerializedMetadata sm(cameraBlob.c_str());
+   sm.AddTag(MM::g_Keyword_Metadata_Width, 512);
+   sm.AddTag(MM::g_Keyword_Metadata_Height, 512);
+   const std::string fullBlob(sm.View());
+   AddRate(results, "metadata_restore", {}, RunFor(minSeconds, [&](long n) {
+      for (long i = 0; i < n; ++i) {
+         Metadata md;
+         if (!md.Restore(fullBlob.c_str()))
+            std::abort();
+      }
+   }));
+}
+
+void BenchmarkProperties(Results& results, double minSeconds) {
+   PropertyDevice dev;
+   MockAdapterWithDevices adapter{{"dev", &dev}};
+   CMMCore c;
+   c.enableStderrLog(false);
+   adapter.LoadIntoCore(c);
+
+   for (const char* prop : { "Plain", "WithAction" }) {
+      const Results::Fields params;
+      AddRate(results, std::string("get_property_") + prop, params,
+            RunFor(minSeconds, [&](long n) {
+         for (long i = 0; i < n; ++i)
+            c.getProperty("dev", prop);
+      }));
+      AddRate(results, std::string("set_property_") + prop, params,
+            RunFor(minSeconds, [&](long n) {
+         for (long i = 0; i < n; ++i)
+            c.setProperty("dev", prop, (i & 1) ? "A" : "B");
+      }));
+   }
+   AddRate(results, "set_property_numeric", {},
+         RunFor(minSeconds, [&](long n) {
+      for (long i = 0; i < n; ++i)
+         c.setProperty("dev", "Number", 0.5 * (i & 7));
+   }));
+   AddRate(results, "get_property_from_cache", {},
+         RunFor(minSeconds, [&](long n) {
+      for (long i = 0; i < n; ++i)
+         c.getPropertyFromCache("dev", "Plain");
+   }));
+}
+
+void BenchmarkConfigApply(Results& results, double minSeconds) {
+   const int nDevices = 8;
+   PropertyDevice devs[nDevices];
+   MockAdapterWithDevices adapter{{"dev0", &devs[0]}, {"dev1", &devs[1]},
+      {"dev2", &devs[2]}, {"dev3", &devs[3]}, {"dev4", &devs[4]},
+      {"dev5", &devs[5]}, {"dev6", &devs[6]}, {"dev7", &devs[7]}};
+   CMMCore c;
+   c.enableStderrLog(false);
+   adapter.LoadIntoCore(c);
+   for (int i = 0; i < nDevices; ++i) {
+      const std::string label = "dev" + std::to_string(i);
+      c.defineConfig("G", "P1", label.c_str(), "WithAction", "A");
+      c.defineConfig("G", "P1", label.c_str(), "Plain", "A");
+      c.defineConfig("G", "P2", label.c_str(), "WithAction", "B");
+      c.defineConfig("G", "P2", label.c_str(), "Plain", "B");
+   }
+
+   AddRate(results, "set_config", {
+      {"devices", nDevices},
+      {"properties", 2 * nDevices},
+   }, RunFor(minSeconds, [&](long n) {
+      for (long i = 0; i < n; ++i) {
+         const char* preset = (i & 1) ? "P1" : "P2";
+         c.setConfig("G", preset);
+         c.waitForConfig("G", preset);
+      }
+   }));
+   AddRate(results, "get_current_config", {}, RunFor(minSeconds, [&](long n) {
+      for (long i = 0; i < n; ++i)
+         c.getCurrentConfig("G");
+   }));
+}
+
+void BenchmarkNotifications(Results& results, double minSeconds) {
+   PropertyDevice dev;
+   MockAdapterWithDevices adapter{{"dev", &dev}};
+   CountingCallback cb;
+   CMMCore c;
+   c.enableStderrLog(false);
+   adapter.LoadIntoCore(c);
+   c.registerCallback(&cb);
+
+   // From the device reporting a change to the callback having seen it
+   auto run = RunFor(minSeconds, [&](long n) {
+      cb.Reset();
+      for (long i = 0; i < n; ++i)
+         dev.OnPropertyChanged("Plain", (i & 1) ? "A" : "B");
+      cb.WaitForCount(n);
+   });
+   c.registerCallback(nullptr);
+   results.Add("property_changed_notification", {}, {
+      {"ops", static_cast<double>(run.first)},
+      {"ns_per_op", 1e9 * run.second / run.first},
+      {"per_s", run.first / run.second},
+   });
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+   if (argc > 2) {
+      std::cerr << "Usage: " << argv[0] << " [<minimum seconds per case>]\n";
+      return 2;
+   }
+   const double minSeconds = argc > 1 ? std::atof(argv[1]) : 0.25;
+
+   Results results;
+   try {
+      BenchmarkInsert(results, minSeconds);
+      BenchmarkPop(results, minSeconds);
+      BenchmarkMetadata(results, minSeconds);
+      BenchmarkProperties(results, minSeconds);
+      BenchmarkConfigApply(results, minSeconds);
+      BenchmarkNotifications(results, minSeconds);
+   } catch (const CMMError& e) {
+      std::cerr << e.getFullMsg() << '\n';
+      return 1;
+   }
+   results.WriteJson(std::cout, minSeconds);
+   return 0;
+}
@@ -0,0 +1,133 @@
+// Drives the XY stage of a hardware configuration through a serpentine tile
+// scan and reports the latency of each Core call as JSON on stdout.
+//
+// Together with the SerialReplay device adapter this measures the host-side
+// cost of a stage adapter without the hardware: record a tile scan once with
+// the SerialReplayPort in Record mode (between the stage and its real port),
+// then run the same scan against a configuration in which the port replays
+// the recording.
+//
+// Usage:
+//    replay_tile_scan <config file> [<columns> <rows> <step um>
+//                     [<adapter search path>]]
+
+#include "MMCore.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+class CallTimes {
+public:
+   template <typename F>
+   void Time(const std::string& name, F f) {
+      auto start = std::chrono::steady_clock::now();
+      f();
+      auto end = std::chrono::steady_clock::now();
+      times_[name].push_back(
+         std::chrono::duration<double, std::micro>(end - start).count());
+   }
+
+   void WriteJson(std::ostream& out) {
+      out << "  \"calls\": {";
+      bool first = true;
+      for (auto& entry : times_) {
+         std::vector<double>& t = entry.second;
+         std::sort(t.begin(), t.end());
+         double sum = 0.0;
+         for (double v : t)
+            sum += v;
+         out << (first ? "\n" : ",\n");
+         first = false;
+         out << "    \"" << entry.first << "\": {"
+             << "\"count\": " << t.size()
+             << ", \"mean_us\": " << sum / t.size()
+             << ", \"median_us\": " << Percentile(t, 0.5)
+             << ", \"p99_us\": " << Percentile(t, 0.99)
+             << ", \"max_us\": " << t.back() << "}";
+      }
+      out << "\n  }\n";
+   }
+
+private:
+   static double Percentile(const std::vector<double>& sorted, double p) {
+      size_t i = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+      return sorted[i];
+   }
+
+   std::map<std::string, std::vector<double>> times_;
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+   if (argc != 2 && argc != 5 && argc != 6) {
+      std::cerr << "Usage: " << argv[0] << " <config file> "
+         "[<columns> <rows> <step um> [<adapter search path>]]\n";
+      return 2;
+   }
+   const std::string configFile = argv[1];
+   const int columns = argc > 2 ? std::atoi(argv[2]) : 10;
+   const int rows = argc > 3 ? std::atoi(argv[3]) : 10;
+   const double step = argc > 4 ? std::atof(argv[4]) : 100.0;
+
+   CMMCore core;
+   core.enableStderrLog(false);
+   if (argc > 5)
+      core.setDeviceAdapterSearchPaths({argv[5]});
+
+   try {
+      auto loadStart = std::chrono::steady_clock::now();
+      core.loadSystemConfiguration(configFile.c_str());
+      auto loadEnd = std::chrono::steady_clock::now();
+
+      const std::string stage = core.getXYStageDevice();
+      if (stage.empty()) {
+         std::cerr << "Configuration has no default XY stage\n";
+         return 1;
+      }
+
+      CallTimes times;
+      double x0 = 0.0, y0 = 0.0;
+      times.Time("getXYPosition", [&] { core.getXYPosition(stage.c_str(), x0, y0); });
+
+      auto scanStart = std::chrono::steady_clock::now();
+      for (int row = 0; row < rows; ++row) {
+         for (int i = 0; i < columns; ++i) {
+            const int col = (row % 2 == 0) ? i : columns - 1 - i;
+            const double x = x0 + col * step;
+            const double y = y0 + row * step;
+            times.Time("setXYPosition", [&] { core.setXYPosition(stage.c_str(), x, y); });
+            times.Time("waitForDevice", [&] { core.waitForDevice(stage.c_str()); });
+            double xr, yr;
+            times.Time("getXYPosition", [&] { core.getXYPosition(stage.c_str(), xr, yr); });
+         }
+      }
+      auto scanEnd = std::chrono::steady_clock::now();
+
+      core.setXYPosition(stage.c_str(), x0, y0);
+      core.waitForDevice(stage.c_str());
+
+      std::cout << "{\n"
+         << "  \"stage\": \"" << stage << "\",\n"
+         << "  \"tiles\": " << columns * rows << ",\n"
+         << "  \"load_ms\": " << std::chrono::duration<double, std::milli>(
+               loadEnd - loadStart).count() << ",\n"
+         << "  \"scan_ms\": " << std::chrono::duration<double, std::milli>(
+               scanEnd - scanStart).count() << ",\n";
+      times.WriteJson(std::cout);
+      std::cout << "}\n";
+
+      core.unloadAllDevices();
+   } catch (const CMMError& e) {
+      std::cerr << e.getFullMsg() << '\n';
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,138 @@
+#include <catch2/catch_all.hpp>
+
+#include "AdapterMetadataIndex.h"
+#include "MMCore.h"
+#include "MockDeviceUtils.h"
+#include "StubDevices.h"
+#include "TempFile.h"
+
+#include "MMDevice.h"
+#include "ModuleInterface.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+using mmcore::internal::AdapterMetadata;
+using mmcore::internal::AdapterMetadataIndex;
+
+namespace {
+
+AdapterMetadata MakeMetadata() {
+   AdapterMetadata metadata;
+   metadata.moduleInterfaceVersion = MODULE_INTERFACE_VERSION;
+   metadata.deviceInterfaceVersion = DEVICE_INTERFACE_VERSION;
+   metadata.devices.push_back({"Cam", "A camera", MM::CameraDevice});
+   metadata.devices.push_back({"Odd\tName\\", "Line 1\nLine 2", MM::StageDevice});
+   return metadata;
+}
+
+void Append(const std::string& path, const std::string& text) {
+   std::ofstream ofs(path, std::ios::app | std::ios::binary);
+   ofs << text;
+}
+
+} // namespace
+
+TEST_CASE("Adapter metadata index entries survive a save and reload",
+      "[AdapterMetadataIndex]") {
+   TempFile library("library contents");
+   TempFile indexFile("");
+
+   {
+      AdapterMetadataIndex index(indexFile.getPath());
+      AdapterMetadata metadata;
+      CHECK_FALSE(index.Lookup(library.getPath(), metadata));
+      index.Store(library.getPath(), MakeMetadata());
+      CHECK(index.Save());
+   }
+
+   AdapterMetadataIndex index(indexFile.getPath());
+   AdapterMetadata metadata;
+   REQUIRE(index.Lookup(library.getPath(), metadata));
+   REQUIRE(metadata.devices.size() == 2);
+   CHECK(metadata.devices[0].name == "Cam");
+   CHECK(metadata.devices[0].description == "A camera");
+   CHECK(metadata.devices[0].type == MM::CameraDevice);
+   CHECK(metadata.devices[1].name == "Odd\tName\\");
+   CHECK(metadata.devices[1].description == "Line 1\nLine 2");
+   CHECK(metadata.devices[1].type == MM::StageDevice);
+}
+
+TEST_CASE("Adapter metadata index entries go stale", "[AdapterMetadataIndex]") {
+   TempFile library("library contents");
+   TempFile indexFile("");
+   AdapterMetadataIndex index(indexFile.getPath());
+   AdapterMetadata metadata;
+
+   SECTION("when the library changes") {
+      index.Store(library.getPath(), MakeMetadata());
+      REQUIRE(index.Lookup(library.getPath(), metadata));
+      Append(library.getPath(), " rebuilt");
+      CHECK_FALSE(index.Lookup(library.getPath(), metadata));
+   }
+
+   SECTION("when the interface version differs") {
+      AdapterMetadata old = MakeMetadata();
+      old.deviceInterfaceVersion = DEVICE_INTERFACE_VERSION - 1;
+      index.Store(library.getPath(), old);
+      CHECK_FALSE(index.Lookup(library.getPath(), metadata));
+   }
+
+   SECTION("when the library is gone") {
+      index.Store("/no/such/library", MakeMetadata());
+      CHECK_FALSE(index.Lookup("/no/such/library", metadata));
+   }
+}
+
+TEST_CASE("Malformed adapter metadata index is ignored",
+      "[AdapterMetadataIndex]") {
+   TempFile library("library contents");
+   TempFile indexFile("");
+   {
+      AdapterMetadataIndex index(indexFile.getPath());
+      index.Store(library.getPath(), MakeMetadata());
+      REQUIRE(index.Save());
+   }
+   Append(indexFile.getPath(), "A\tgarbage\n");
+
+   AdapterMetadataIndex index(indexFile.getPath());
+   AdapterMetadata metadata;
+   CHECK_FALSE(index.Lookup(library.getPath(), metadata));
+}
+
+TEST_CASE("Device listing with an adapter index file",
+      "[AdapterMetadataIndex]") {
+   StubCamera cam;
+   MockAdapterWithDevices adapter{"indexed_adapter", {{"cam", &cam}}};
+   TempFile indexFile("");
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   CHECK(c.getDeviceAdapterIndexFile().empty());
+   c.setDeviceAdapterIndexFile(indexFile.getPath().c_str());
+   CHECK(c.getDeviceAdapterIndexFile() == indexFile.getPath());
+
+   // Loaded (here, mock) adapters are asked directly
+   auto names = c.getAvailableDevices("indexed_adapter");
+   REQUIRE(names.size() == 1);
+   CHECK(names[0] == "cam");
+   auto types = c.getAvailableDeviceTypes("indexed_adapter");
+   REQUIRE(types.size() == 1);
+   CHECK(types[0] == MM::CameraDevice);
+   auto descriptions = c.getAvailableDeviceDescriptions("indexed_adapter");
+   REQUIRE(descriptions.size() == 1);
+   CHECK(descriptions[0] == "description for cam");
+
+   // No adapters in the search path
+   c.setDeviceAdapterSearchPaths({});
+   c.updateDeviceAdapterIndex();
+   std::ifstream ifs(indexFile.getPath());
+   std::string header;
+   std::getline(ifs, header);
+   CHECK_FALSE(header.empty());
+
+   c.setDeviceAdapterIndexFile("");
+   CHECK(c.getDeviceAdapterIndexFile().empty());
+   CHECK_THROWS_AS(c.updateDeviceAdapterIndex(), CMMError);
+}
@@ -0,0 +1,122 @@
+#include <catch2/catch_all.hpp>
+
+#include "DeviceBase.h"
+#include "MMCore.h"
+#include "MockDeviceUtils.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+namespace {
+
+// Generic device whose busy state is controlled by the test, counting how
+// many times Busy() was called.
+struct BusySignalingDevice : CGenericBase<BusySignalingDevice> {
+   bool usesCallback;
+   std::atomic<bool> busy{false};
+   std::atomic<int> busyCalls{0};
+
+   explicit BusySignalingDevice(bool usesCallback) :
+      usesCallback(usesCallback) {}
+
+   int Initialize() override { return DEVICE_OK; }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override {
+      ++busyCalls;
+      return busy;
+   }
+   void GetName(char* buf) const override {
+      CDeviceUtils::CopyLimitedString(buf, "BusySignalingDevice");
+   }
+   int UsesOnBusyChanged(bool& result) const override {
+      result = usesCallback;
+      return DEVICE_OK;
+   }
+
+   std::thread FinishLater(std::chrono::milliseconds delay, bool signal) {
+      return std::thread([this, delay, signal] {
+         std::this_thread::sleep_for(delay);
+         busy = false;
+         if (signal)
+            OnBusyChanged(false);
+      });
+   }
+};
+
+} // namespace
+
+TEST_CASE("waitForDevice returns when device signals idle",
+      "[BusyCallback]") {
+   BusySignalingDevice dev(true);
+   MockAdapterWithDevices adapter{{"dev", &dev}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   dev.busy = true;
+   std::thread finisher =
+      dev.FinishLater(std::chrono::milliseconds(50), true);
+   c.waitForDevice("dev");
+   finisher.join();
+   CHECK_FALSE(dev.busy);
+   // Checked at least once before waiting; how often the Core re-checks
+   // after the signal depends on thread scheduling
+   CHECK(dev.busyCalls >= 1);
+}
+
+TEST_CASE("waitForDevice re-checks device that fails to signal",
+      "[BusyCallback]") {
+   BusySignalingDevice dev(true);
+   MockAdapterWithDevices adapter{{"dev", &dev}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   dev.busy = true;
+   std::thread finisher =
+      dev.FinishLater(std::chrono::milliseconds(20), false);
+   c.waitForDevice("dev");
+   finisher.join();
+   CHECK_FALSE(dev.busy);
+}
+
+TEST_CASE("waitForDevice times out on busy device",
+      "[BusyCallback]") {
+   bool usesCallback = GENERATE(false, true);
+   BusySignalingDevice dev(usesCallback);
+   MockAdapterWithDevices adapter{{"dev", &dev}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   dev.busy = true;
+   c.setDeviceTimeoutMs("dev", 30);
+   try {
+      c.waitForDevice("dev");
+      FAIL("expected timeout");
+   } catch (const CMMError& e) {
+      CHECK(e.getCode() == MMERR_DevicePollingTimeout);
+   }
+}
+
+TEST_CASE("waitForDevice polls device without busy callbacks",
+      "[BusyCallback]") {
+   BusySignalingDevice dev(false);
+   MockAdapterWithDevices adapter{{"dev", &dev}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   SECTION("idle device is checked once") {
+      c.waitForDevice("dev");
+      CHECK(dev.busyCalls == 1);
+   }
+
+   SECTION("busy device is polled until idle") {
+      dev.busy = true;
+      std::thread finisher =
+         dev.FinishLater(std::chrono::milliseconds(30), false);
+      c.waitForDevice("dev");
+      finisher.join();
+      CHECK_FALSE(dev.busy);
+      CHECK(dev.busyCalls > 1);
+   }
+}
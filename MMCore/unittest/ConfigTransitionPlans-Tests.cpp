@@ -0,0 +1,167 @@
+#include <catch2/catch_all.hpp>
+
+#include "DeviceBase.h"
+#include "MMCore.h"
+#include "MockDeviceUtils.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Generic device with two string properties that count how many times they
+// have been set.
+struct TwoPropDevice : CGenericBase<TwoPropDevice> {
+   std::string name;
+   int setCountA = 0;
+   int setCountB = 0;
+
+   explicit TwoPropDevice(std::string n) : name(std::move(n)) {}
+
+   int Initialize() override {
+      CreateStringProperty("A", "0", false,
+         new CPropertyAction(this, &TwoPropDevice::OnA));
+      CreateStringProperty("B", "0", false,
+         new CPropertyAction(this, &TwoPropDevice::OnB));
+      return DEVICE_OK;
+   }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override { return false; }
+   void GetName(char* buf) const override {
+      CDeviceUtils::CopyLimitedString(buf, name.c_str());
+   }
+
+   int OnA(MM::PropertyBase*, MM::ActionType eAct) {
+      if (eAct == MM::AfterSet)
+         ++setCountA;
+      return DEVICE_OK;
+   }
+   int OnB(MM::PropertyBase*, MM::ActionType eAct) {
+      if (eAct == MM::AfterSet)
+         ++setCountB;
+      return DEVICE_OK;
+   }
+};
+
+// Channel-like group: "filter" differs between presets, "laser" only in A
+void DefinePresets(CMMCore& c) {
+   c.defineConfig("Channel", "DAPI", "filter", "A", "1");
+   c.defineConfig("Channel", "DAPI", "filter", "B", "x");
+   c.defineConfig("Channel", "DAPI", "laser", "A", "405");
+   c.defineConfig("Channel", "DAPI", "laser", "B", "on");
+   c.defineConfig("Channel", "GFP", "filter", "A", "2");
+   c.defineConfig("Channel", "GFP", "filter", "B", "x");
+   c.defineConfig("Channel", "GFP", "laser", "A", "405");
+   c.defineConfig("Channel", "GFP", "laser", "B", "on");
+}
+
+} // namespace
+
+TEST_CASE("getConfigTransitionData contains only differing devices",
+      "[ConfigTransitionPlans]") {
+   TwoPropDevice filter("filter");
+   TwoPropDevice laser("laser");
+   MockAdapterWithDevices adapter{{"filter", &filter}, {"laser", &laser}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   DefinePresets(c);
+
+   Configuration t = c.getConfigTransitionData("Channel", "DAPI", "GFP");
+   REQUIRE(t.size() == 2);
+   // Once a device differs, its later settings are kept, in preset order
+   CHECK(t.getSetting(0).getVerbose() == "filter:A=2");
+   CHECK(t.getSetting(1).getVerbose() == "filter:B=x");
+
+   CHECK(c.getConfigTransitionData("Channel", "GFP", "GFP").size() == 0);
+
+   SECTION("redefining a preset invalidates the transition") {
+      c.defineConfig("Channel", "GFP", "laser", "A", "488");
+      CHECK(c.getConfigTransitionData("Channel", "DAPI", "GFP").size() == 4);
+   }
+
+   SECTION("unknown presets throw") {
+      CHECK_THROWS(c.getConfigTransitionData("Channel", "DAPI", "Cy5"));
+      CHECK_THROWS(c.getConfigTransitionData("NoGroup", "DAPI", "GFP"));
+   }
+}
+
+TEST_CASE("setConfig uses transition plans when enabled",
+      "[ConfigTransitionPlans]") {
+   FeatureGuard feature("ConfigTransitionPlans", true);
+   TwoPropDevice filter("filter");
+   TwoPropDevice laser("laser");
+   MockAdapterWithDevices adapter{{"filter", &filter}, {"laser", &laser}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   DefinePresets(c);
+
+   // First application has no known source preset
+   c.setConfig("Channel", "DAPI");
+   CHECK(laser.setCountA == 1);
+   CHECK(filter.setCountA == 1);
+
+   c.setConfig("Channel", "GFP");
+   c.setConfig("Channel", "DAPI");
+   CHECK(laser.setCountA == 1);
+   CHECK(laser.setCountB == 1);
+   CHECK(filter.setCountA == 3);
+   CHECK(filter.setCountB == 3);
+   CHECK(c.getProperty("filter", "A") == "1");
+
+   SECTION("stale cache falls back to applying all settings") {
+      c.setProperty("laser", "A", "561");
+      c.setConfig("Channel", "GFP");
+      CHECK(laser.setCountA == 3);
+      CHECK(c.getProperty("laser", "A") == "405");
+   }
+}
+
+TEST_CASE("setConfig applies all settings when transition plans disabled",
+      "[ConfigTransitionPlans]") {
+   FeatureGuard feature("ConfigTransitionPlans", false);
+   TwoPropDevice filter("filter");
+   TwoPropDevice laser("laser");
+   MockAdapterWithDevices adapter{{"filter", &filter}, {"laser", &laser}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   DefinePresets(c);
+
+   c.setConfig("Channel", "DAPI");
+   c.setConfig("Channel", "GFP");
+   CHECK(laser.setCountA == 2);
+   CHECK(filter.setCountA == 2);
+}
+
+TEST_CASE("setConfig can be called concurrently",
+      "[ConfigTransitionPlans]") {
+   bool enable = GENERATE(false, true);
+   FeatureGuard feature("ConfigTransitionPlans", enable);
+   TwoPropDevice filter("filter");
+   TwoPropDevice laser("laser");
+   MockAdapterWithDevices adapter{{"filter", &filter}, {"laser", &laser}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   DefinePresets(c);
+   c.defineConfig("Laser", "On", "laser", "B", "on");
+   c.defineConfig("Laser", "Off", "laser", "B", "off");
+
+   std::vector<std::thread> threads;
+   for (int t = 0; t < 4; ++t) {
+      threads.emplace_back([&c, t] {
+         for (int i = 0; i < 200; ++i) {
+            if (t % 2 == 0)
+               c.setConfig("Channel", (i + t) % 2 ? "GFP" : "DAPI");
+            else
+               c.setConfig("Laser", (i + t) % 2 ? "On" : "Off");
+         }
+      });
+   }
+   for (auto& th : threads)
+      th.join();
+
+   c.setConfig("Channel", "GFP");
+   CHECK(c.getProperty("filter", "A") == "2");
+   CHECK(c.getProperty("laser", "B") == "on");
+   CHECK(c.getConfigTransitionData("Channel", "DAPI", "GFP").size() == 2);
+}
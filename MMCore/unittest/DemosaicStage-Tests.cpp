@@ -0,0 +1,294 @@
+#include <catch2/catch_all.hpp>
+
+#include "ImageMetadata.h"
+#include "MMCore.h"
+#include "MockDeviceUtils.h"
+#include "StubDevices.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Uniform color, laid out with red at the top left (RGGB)
+std::vector<unsigned char> MakeRGGB(unsigned width, unsigned height,
+      unsigned char r, unsigned char g, unsigned char b) {
+   std::vector<unsigned char> pixels(width * height);
+   for (unsigned y = 0; y < height; ++y)
+      for (unsigned x = 0; x < width; ++x)
+         pixels[y * width + x] = (x & 1) == (y & 1) ? (y & 1 ? b : r) : g;
+   return pixels;
+}
+
+// Images are published once demosaiced on the worker threads
+void WaitForImages(CMMCore& c, long count) {
+   const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+   while (c.getRemainingImageCount() < count &&
+         std::chrono::steady_clock::now() < deadline)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+   REQUIRE(c.getRemainingImageCount() == count);
+}
+
+} // namespace
+
+TEST_CASE("Demosaic settings are validated", "[DemosaicStage]") {
+   StubCamera cam;
+   MockAdapterWithDevices adapter{{"cam", &cam}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   CHECK(c.getDemosaicPatterns().size() == 4);
+   const auto algorithms = c.getDemosaicAlgorithms();
+   CHECK(std::find(algorithms.begin(), algorithms.end(), "Malvar-He-Cutler") !=
+         algorithms.end());
+   CHECK(std::find(algorithms.begin(), algorithms.end(), "Adaptive-Smooth-Hue") ==
+         algorithms.end());
+
+   CHECK_THROWS_AS(c.setCameraDemosaic("cam", "RGBG", "Bilinear", 0), CMMError);
+   CHECK_THROWS_AS(c.setCameraDemosaic("cam", "RGGB", "Nope", 0), CMMError);
+   CHECK_THROWS_AS(c.setCameraDemosaic("cam", "RGGB", "Bilinear", 17), CMMError);
+   CHECK_THROWS_AS(c.setCameraDemosaic("cam", nullptr, "Bilinear", 0), CMMError);
+   CHECK_THROWS_AS(c.setCameraDemosaic("nope", "RGGB", "Bilinear", 0), CMMError);
+   CHECK_FALSE(c.isCameraDemosaicEnabled("cam"));
+
+   cam.capturing = true;
+   CHECK_THROWS_AS(c.setCameraDemosaic("cam", "RGGB", "Bilinear", 0), CMMError);
+   cam.capturing = false;
+   c.setCameraDemosaic("cam", "RGGB", "Bilinear", 0);
+   CHECK(c.isCameraDemosaicEnabled("cam"));
+   c.clearCameraDemosaic("cam");
+   CHECK_FALSE(c.isCameraDemosaicEnabled("cam"));
+}
+
+TEST_CASE("Demosaic settings are removed with their camera", "[DemosaicStage]") {
+   StubCamera cam1, cam2;
+   MockAdapterWithDevices adapter{{"cam1", &cam1}, {"cam2", &cam2}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   c.setCameraDemosaic("cam1", "RGGB", "Bilinear", 0);
+   c.setCameraDemosaic("cam2", "RGGB", "Bilinear", 0);
+
+   c.unloadDevice("cam1");
+   c.loadDevice("cam1", "mock_adapter", "cam1");
+   c.initializeDevice("cam1");
+   CHECK_FALSE(c.isCameraDemosaicEnabled("cam1"));
+   CHECK(c.isCameraDemosaicEnabled("cam2"));
+
+   c.unloadAllDevices();
+   c.loadDevice("cam2", "mock_adapter", "cam2");
+   c.initializeDevice("cam2");
+   CHECK_FALSE(c.isCameraDemosaicEnabled("cam2"));
+}
+
+TEST_CASE("Sequence images are demosaiced and keep their raw pixels",
+          "[DemosaicStage]") {
+   StubCamera cam;
+   cam.width = 8;
+   cam.height = 6;
+   MockAdapterWithDevices adapter{{"cam", &cam}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   c.setCameraDevice("cam");
+   c.setCameraDemosaic("cam", "RGGB", "Bilinear", 0);
+   c.initializeCircularBuffer();
+
+   CHECK(c.getBytesPerPixel() == 4);
+   CHECK(c.getNumberOfComponents() == 4);
+   CHECK(c.getImageBitDepth() == 8);
+   CHECK(c.getImageBufferSize() == 8 * 6 * 4);
+
+   const auto raw = MakeRGGB(8, 6, 200, 100, 50);
+   REQUIRE(cam.InsertTestImage(MM::CameraImageMetadata{}, raw.data()) == DEVICE_OK);
+   WaitForImages(c, 1);
+
+   Metadata md;
+   const auto* rawOut = static_cast<const unsigned char*>(c.getLastRawImageMD(md));
+   CHECK(std::memcmp(rawOut, raw.data(), raw.size()) == 0);
+   CHECK(md.GetSingleTag(MM::g_Keyword_PixelType).GetValue() ==
+         MM::g_Keyword_PixelType_GRAY8);
+
+   const auto* rgb = static_cast<const unsigned char*>(c.popNextImageMD(md));
+   CHECK(md.GetSingleTag(MM::g_Keyword_PixelType).GetValue() ==
+         MM::g_Keyword_PixelType_RGB32);
+   CHECK(md.GetSingleTag("DemosaicPattern").GetValue() == "RGGB");
+   CHECK(md.GetSingleTag("DemosaicAlgorithm").GetValue() == "Bilinear");
+   for (unsigned i = 0; i < 8 * 6; ++i) {
+      CAPTURE(i);
+      REQUIRE(rgb[4 * i + 0] == 50);
+      REQUIRE(rgb[4 * i + 1] == 100);
+      REQUIRE(rgb[4 * i + 2] == 200);
+   }
+}
+
+TEST_CASE("Demosaiced images are published in insertion order",
+          "[DemosaicStage]") {
+   StubCamera cam;
+   cam.width = 64;
+   cam.height = 32;
+   MockAdapterWithDevices adapter{{"cam", &cam}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   c.setCameraDevice("cam");
+   c.setCameraDemosaic("cam", "GRBG", "Malvar-He-Cutler", 0);
+   c.initializeCircularBuffer();
+
+   const int count = 40;
+   for (int i = 0; i < count; ++i) {
+      const std::vector<unsigned char> raw(64 * 32, static_cast<unsigned char>(i));
+      REQUIRE(cam.InsertTestImage(MM::CameraImageMetadata{}, raw.data()) == DEVICE_OK);
+   }
+   WaitForImages(c, count);
+
+   for (int i = 0; i < count; ++i) {
+      CAPTURE(i);
+      Metadata md;
+      const auto* rgb = static_cast<const unsigned char*>(c.popNextImageMD(md));
+      CHECK(md.GetSingleTag(MM::g_Keyword_Metadata_ImageNumber).GetValue() ==
+            std::to_string(i));
+      CHECK(rgb[4 * (64 * 32) - 2] == i);
+   }
+}
+
+TEST_CASE("Demosaicing scales 16-bit images by the bit depth",
+          "[DemosaicStage]") {
+   StubCamera cam;
+   cam.width = 4;
+   cam.height = 4;
+   cam.bytesPerPixel = 2;
+   MockAdapterWithDevices adapter{{"cam", &cam}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   c.setCameraDevice("cam");
+   c.setCameraDemosaic("cam", "BGGR", "Bilinear", 12);
+   c.initializeCircularBuffer();
+
+   const std::vector<unsigned short> raw(16, 4000);
+   REQUIRE(cam.InsertTestImage(MM::CameraImageMetadata{},
+         reinterpret_cast<const unsigned char*>(raw.data())) == DEVICE_OK);
+   WaitForImages(c, 1);
+
+   Metadata md;
+   const auto* rawOut = static_cast<const unsigned short*>(c.getLastRawImageMD(md));
+   CHECK(rawOut[5] == 4000);
+   CHECK(md.GetSingleTag(MM::g_Keyword_PixelType).GetValue() ==
+         MM::g_Keyword_PixelType_GRAY16);
+   const auto* rgb = static_cast<const unsigned char*>(c.popNextImage());
+   CHECK(rgb[0] == 4000 >> 4);
+   CHECK(rgb[1] == 4000 >> 4);
+   CHECK(rgb[2] == 4000 >> 4);
+}
+
+TEST_CASE("Images are stored as is without demosaicing", "[DemosaicStage]") {
+   StubCamera cam;
+   cam.width = 8;
+   cam.height = 6;
+   MockAdapterWithDevices adapter{{"cam", &cam}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   c.setCameraDevice("cam");
+   c.setCameraDemosaic("cam", "RGGB", "Replication", 0);
+   c.clearCameraDemosaic("cam");
+   c.initializeCircularBuffer();
+   CHECK(c.getBytesPerPixel() == 1);
+
+   const auto raw = MakeRGGB(8, 6, 200, 100, 50);
+   REQUIRE(cam.InsertTestImage(MM::CameraImageMetadata{}, raw.data()) == DEVICE_OK);
+   CHECK(c.getRemainingImageCount() == 1);
+   Metadata md;
+   const void* rawOut = c.getLastRawImageMD(md);
+   CHECK(rawOut == c.getLastImage());
+   CHECK(std::memcmp(rawOut, raw.data(), raw.size()) == 0);
+   CHECK_FALSE(md.HasTag("DemosaicPattern"));
+}
+
+TEST_CASE("Images from a camera the buffer was not sized for are stored as is",
+          "[DemosaicStage]") {
+   StubCamera cam1, cam2;
+   cam1.width = cam2.width = 8;
+   cam1.height = cam2.height = 6;
+   MockAdapterWithDevices adapter{{"cam1", &cam1}, {"cam2", &cam2}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   c.setCameraDevice("cam1");
+   c.setCameraDemosaic("cam2", "RGGB", "Bilinear", 0);
+   c.initializeCircularBuffer();
+
+   const auto raw = MakeRGGB(8, 6, 200, 100, 50);
+   REQUIRE(cam2.InsertTestImage(MM::CameraImageMetadata{}, raw.data()) == DEVICE_OK);
+   REQUIRE(c.getRemainingImageCount() == 1);
+   Metadata md;
+   const void* img = c.popNextImageMD(md);
+   CHECK(std::memcmp(img, raw.data(), raw.size()) == 0);
+   CHECK_FALSE(md.HasTag("DemosaicPattern"));
+}
+
+TEST_CASE("Images are demosaiced as the buffer was sized for",
+          "[DemosaicStage]") {
+   // As with the physical cameras of a Multi Camera
+   StubCamera cam1, cam2;
+   cam1.width = cam2.width = 8;
+   cam1.height = cam2.height = 6;
+   MockAdapterWithDevices adapter{{"cam1", &cam1}, {"cam2", &cam2}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   c.setCameraDevice("cam1");
+   c.setCameraDemosaic("cam1", "RGGB", "Bilinear", 0);
+   c.initializeCircularBuffer();
+
+   const auto raw = MakeRGGB(8, 6, 200, 100, 50);
+   REQUIRE(cam2.InsertTestImage(MM::CameraImageMetadata{}, raw.data()) == DEVICE_OK);
+   WaitForImages(c, 1);
+   Metadata md;
+   const auto* rgb = static_cast<const unsigned char*>(c.popNextImageMD(md));
+   CHECK(md.GetSingleTag(MM::g_Keyword_Metadata_CameraLabel).GetValue() == "cam2");
+   CHECK(md.GetSingleTag("DemosaicPattern").GetValue() == "RGGB");
+   CHECK(rgb[0] == 50);
+   CHECK(rgb[2] == 200);
+
+   // Settings made since the buffer was initialized take effect only when
+   // it is next initialized
+   c.clearCameraDemosaic("cam1");
+   REQUIRE(cam1.InsertTestImage(MM::CameraImageMetadata{}, raw.data()) == DEVICE_OK);
+   WaitForImages(c, 1);
+   c.popNextImageMD(md);
+   CHECK(md.GetSingleTag("DemosaicPattern").GetValue() == "RGGB");
+}
+
+TEST_CASE("Clearing the buffer waits for conversions", "[DemosaicStage]") {
+   StubCamera cam;
+   cam.width = 256;
+   cam.height = 256;
+   MockAdapterWithDevices adapter{{"cam", &cam}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   c.setCameraDevice("cam");
+   c.setCameraDemosaic("cam", "RGGB", "Smooth-Hue", 0);
+   c.initializeCircularBuffer();
+
+   for (int i = 0; i < 10; ++i)
+      REQUIRE(cam.InsertTestImage() == DEVICE_OK);
+   c.clearCircularBuffer();
+   CHECK(c.getRemainingImageCount() == 0);
+   REQUIRE(cam.InsertTestImage() == DEVICE_OK);
+   WaitForImages(c, 1);
+}
+
+TEST_CASE("Snapped images are demosaiced", "[DemosaicStage]") {
+   StubCamera cam;
+   cam.width = 8;
+   cam.height = 6;
+   MockAdapterWithDevices adapter{{"cam", &cam}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   c.setCameraDevice("cam");
+   c.setCameraDemosaic("cam", "RGGB", "Bilinear", 0);
+
+   c.snapImage();
+   const auto* rgb = static_cast<const unsigned char*>(c.getImage());
+   CHECK(rgb != cam.GetImageBuffer());
+   CHECK(rgb[4 * (8 * 6) - 1] == 0);
+}
@@ -0,0 +1,239 @@
+#include <catch2/catch_all.hpp>
+
+#include "DeviceBase.h"
+#include "DeviceCallTracer.h"
+#include "MMCore.h"
+#include "MockDeviceUtils.h"
+#include "StubDevices.h"
+#include "TempFile.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using mmcore::internal::DeviceCallTracer;
+
+namespace {
+
+std::string ReadFile(const std::string& path) {
+   std::ifstream ifs(path);
+   std::ostringstream oss;
+   oss << ifs.rdbuf();
+   return oss.str();
+}
+
+struct CallbackGeneric : CGenericBase<CallbackGeneric> {
+   std::string name;
+   std::function<void()> onBusy;
+
+   explicit CallbackGeneric(std::string n) : name(std::move(n)) {}
+
+   int Initialize() override {
+      return CreateIntegerProperty("Value", 0, false);
+   }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override {
+      if (onBusy)
+         onBusy();
+      return false;
+   }
+   void GetName(char* buf) const override {
+      CDeviceUtils::CopyLimitedString(buf, name.c_str());
+   }
+};
+
+} // namespace
+
+TEST_CASE("Device calls are not traced by default", "[DeviceCallTracer]") {
+   StubStage stage;
+   MockAdapterWithDevices adapter{{"Z", &stage}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   CHECK_FALSE(c.isDeviceCallTracingEnabled());
+   c.setPosition("Z", 5.0);
+   CHECK(c.getDeviceCallTraceEventCount() == 0);
+}
+
+TEST_CASE("Traced device calls are written as a Chrome trace",
+          "[DeviceCallTracer]") {
+   StubStage stage;
+   MockAdapterWithDevices adapter{{"Z", &stage}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   c.enableDeviceCallTracing(true);
+   c.setPosition("Z", 5.0);
+   c.getPosition("Z");
+   c.enableDeviceCallTracing(false);
+   c.setPosition("Z", 6.0);
+   CHECK(c.getDeviceCallTraceEventCount() >= 2);
+
+   TempFile file("");
+   c.saveDeviceCallTrace(file.getPath().c_str());
+   const std::string json = ReadFile(file.getPath());
+   CHECK(json.rfind("{\"traceEvents\":[", 0) == 0);
+   CHECK(json.find("\"name\":\"SetPositionUm\"") != std::string::npos);
+   CHECK(json.find("\"name\":\"GetPositionUm\"") != std::string::npos);
+   CHECK(json.find("\"device\":\"Z\"") != std::string::npos);
+   CHECK(json.find("\"ph\":\"X\"") != std::string::npos);
+
+   c.clearDeviceCallTrace();
+   CHECK(c.getDeviceCallTraceEventCount() == 0);
+}
+
+TEST_CASE("Property calls are traced with the property name",
+          "[DeviceCallTracer]") {
+   CallbackGeneric dev("dev");
+   MockAdapterWithDevices adapter{{"dev", &dev}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   c.enableDeviceCallTracing(true);
+   c.getProperty("dev", "Value");
+   TempFile file("");
+   c.saveDeviceCallTrace(file.getPath().c_str());
+   const std::string json = ReadFile(file.getPath());
+   CHECK(json.find("\"name\":\"GetProperty\"") != std::string::npos);
+   CHECK(json.find("\"detail\":\"Value\"") != std::string::npos);
+}
+
+TEST_CASE("Waits for a contended module lock are traced",
+          "[DeviceCallTracer]") {
+   CallbackGeneric dev1("dev1");
+   CallbackGeneric dev2("dev2");
+   MockAdapterWithDevices adapter{{"dev1", &dev1}, {"dev2", &dev2}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   c.enableDeviceCallTracing(true);
+
+   std::atomic<bool> entered{false};
+   dev1.onBusy = [&] {
+      entered = true;
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+   };
+   std::thread t([&] { c.deviceBusy("dev1"); });
+   while (!entered)
+      std::this_thread::yield();
+   c.deviceBusy("dev2");
+   t.join();
+
+   TempFile file("");
+   c.saveDeviceCallTrace(file.getPath().c_str());
+   const std::string json = ReadFile(file.getPath());
+   CHECK(json.find("\"name\":\"Lock wait\",\"cat\":\"lock\"") != std::string::npos);
+}
+
+TEST_CASE("Saving a device call trace to a bad path throws",
+          "[DeviceCallTracer]") {
+   CMMCore c;
+   CHECK_THROWS_AS(c.saveDeviceCallTrace(nullptr), CMMError);
+   CHECK_THROWS_AS(c.saveDeviceCallTrace("/nonexistent-dir/trace.json"),
+         CMMError);
+}
+
+TEST_CASE("Full thread buffers drop events", "[DeviceCallTracer]") {
+   DeviceCallTracer tracer(2);
+   const auto label = tracer.InternLabel("cam");
+   CHECK(tracer.InternLabel("stage") == label + 1);
+   CHECK(tracer.InternLabel("cam") == label);
+
+   const auto now = DeviceCallTracer::Clock::now();
+   for (int i = 0; i < 3; ++i)
+      tracer.Record(DeviceCallTracer::EventKind::Call, label, "SnapImage",
+            "a \"quoted\"\nname", now, now + std::chrono::microseconds(5));
+   CHECK(tracer.GetEventCount() == 2);
+   CHECK(tracer.GetDroppedEventCount() == 1);
+
+   std::ostringstream oss;
+   tracer.WriteChromeTrace(oss);
+   const std::string json = oss.str();
+   CHECK(json.find("\"dur\":5.000") != std::string::npos);
+   CHECK(json.find("\"detail\":\"a \\\"quoted\\\"\\nname\"") != std::string::npos);
+   CHECK(json.find("\"droppedEvents\":1") != std::string::npos);
+
+   tracer.Clear();
+   CHECK(tracer.GetEventCount() == 0);
+   CHECK(tracer.GetDroppedEventCount() == 0);
+}
+
+TEST_CASE("Buffers of exited threads are reused and freed",
+          "[DeviceCallTracer]") {
+   DeviceCallTracer tracer(16);
+   const auto label = tracer.InternLabel("cam");
+   auto record = [&] {
+      const auto now = DeviceCallTracer::Clock::now();
+      tracer.Record(DeviceCallTracer::EventKind::Call, label, "SnapImage",
+            "", now, now);
+   };
+
+   for (int i = 0; i < 10; ++i)
+      std::thread(record).join();
+   CHECK(tracer.GetThreadBufferCount() == 1);
+   CHECK(tracer.GetEventCount() == 10);
+
+   // Buffers in use are not handed on
+   Rendezvous rendezvous(2);
+   auto recordTogether = [&] {
+      record();
+      rendezvous.Arrive();
+   };
+   std::thread t1(recordTogether);
+   std::thread t2(recordTogether);
+   t1.join();
+   t2.join();
+   CHECK(rendezvous.ok);
+   CHECK(tracer.GetThreadBufferCount() == 2);
+   CHECK(tracer.GetEventCount() == 12);
+
+   record();
+   CHECK(tracer.GetThreadBufferCount() == 2);
+   tracer.Clear();
+   CHECK(tracer.GetThreadBufferCount() == 1);
+   record();
+   CHECK(tracer.GetEventCount() == 1);
+}
+
+TEST_CASE("Clearing the trace while recording does not bring back old events",
+          "[DeviceCallTracer]") {
+   DeviceCallTracer tracer(1024);
+   const auto label = tracer.InternLabel("cam");
+
+   // Each event's detail is its sequence number
+   std::atomic<long> started{0};
+   std::atomic<bool> stop{false};
+   std::thread recorder([&] {
+      for (long i = 0; !stop; ++i) {
+         // Keep the buffer from filling up, which would drop all events
+         while (tracer.GetEventCount() > 512 && !stop)
+            std::this_thread::yield();
+         started = i;
+         const auto now = DeviceCallTracer::Clock::now();
+         tracer.Record(DeviceCallTracer::EventKind::Call, label, "SnapImage",
+               std::to_string(i), now, now);
+      }
+   });
+
+   long staleEvents = 0;
+   for (int j = 0; j < 2000; ++j) {
+      // Events before the one in progress have been recorded before Clear()
+      const long oldest = started - 1;
+      tracer.Clear();
+      std::ostringstream oss;
+      tracer.WriteChromeTrace(oss);
+      const std::string json = oss.str();
+      const std::string key = "\"detail\":\"";
+      for (auto pos = json.find(key); pos != std::string::npos;
+            pos = json.find(key, pos + 1)) {
+         if (std::stol(json.substr(pos + key.size())) < oldest)
+            ++staleEvents;
+      }
+   }
+   stop = true;
+   recorder.join();
+   CHECK(staleEvents == 0);
+}
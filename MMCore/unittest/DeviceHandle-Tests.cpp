@@ -0,0 +1,122 @@
+#include <catch2/catch_all.hpp>
+
+#include "DeviceBase.h"
+#include "MMCore.h"
+#include "MockDeviceUtils.h"
+#include "StubDevices.h"
+
+namespace {
+
+struct HandleStateDevice : StubStateDevice {
+   int Initialize() override {
+      return CreateIntegerProperty(MM::g_Keyword_State, 0, false);
+   }
+};
+
+struct HandlePropertyDevice : CGenericBase<HandlePropertyDevice> {
+   int Initialize() override {
+      CreateFloatProperty("Float", 0.0, false);
+      CreateIntegerProperty("Integer", 0, false);
+      CreateStringProperty("String", "", false);
+      return DEVICE_OK;
+   }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override { return false; }
+   void GetName(char* buf) const override {
+      CDeviceUtils::CopyLimitedString(buf, "HandlePropertyDevice");
+   }
+};
+
+} // namespace
+
+TEST_CASE("Device handles control stages and state devices",
+      "[DeviceHandle]") {
+   StubStage stage;
+   StubXYStage xyStage;
+   HandleStateDevice stateDev;
+   StubCamera cam;
+   MockAdapterWithDevices adapter{{"z", &stage}, {"xy", &xyStage},
+      {"wheel", &stateDev}, {"cam", &cam}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   DeviceHandle z = c.getDeviceHandle("z");
+   CHECK(z.isValid());
+   CHECK(z.getLabel() == "z");
+   c.setPosition(z, 12.5);
+   CHECK(stage.positionUm == 12.5);
+   c.setRelativePosition(z, 1.0);
+   CHECK(c.getPosition(z) == 13.5);
+   CHECK(c.getPosition("z") == 13.5);
+
+   DeviceHandle xy = c.getDeviceHandle("xy");
+   c.setXYPosition(xy, 3.0, 4.0);
+   c.setRelativeXYPosition(xy, 1.0, 1.0);
+   double x, y;
+   c.getXYPosition(xy, x, y);
+   CHECK(x == 4.0);
+   CHECK(y == 5.0);
+
+   DeviceHandle wheel = c.getDeviceHandle("wheel");
+   c.setState(wheel, 3);
+   CHECK(c.getState(wheel) == 3);
+   CHECK(c.getPropertyFromCache("wheel", MM::g_Keyword_State) == "3");
+
+   DeviceHandle camera = c.getDeviceHandle("cam");
+   c.setExposure(camera, 25.0);
+   CHECK(c.getExposure(camera) == 25.0);
+   CHECK_FALSE(c.deviceBusy(camera));
+   c.waitForDevice(camera);
+
+   // The handle carries the device, but operations still check its type
+   CHECK_THROWS_AS(c.setPosition(xy, 1.0), CMMError);
+   CHECK_THROWS_AS(c.getState(z), CMMError);
+}
+
+TEST_CASE("Device handles get and set properties", "[DeviceHandle]") {
+   HandlePropertyDevice dev;
+   MockAdapterWithDevices adapter{{"dev", &dev}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   DeviceHandle h = c.getDeviceHandle("dev");
+   c.setProperty(h, "String", "abc");
+   CHECK(c.getProperty(h, "String") == "abc");
+   c.setProperty(h, "Float", 2.5);
+   CHECK(c.getPropertyAsDouble(h, "Float") == 2.5);
+   c.setProperty(h, "Integer", 7L);
+   CHECK(c.getProperty("dev", "Integer") == "7");
+   CHECK(c.getPropertyFromCache("dev", "Integer") == "7");
+   CHECK_THROWS_AS(c.getPropertyAsDouble(h, "String"), CMMError);
+   CHECK_THROWS_AS(c.getProperty(h, "NoSuchProperty"), CMMError);
+}
+
+TEST_CASE("Device handles are invalidated by unloading", "[DeviceHandle]") {
+   StubStage stage;
+   MockAdapterWithDevices adapter{{"z", &stage}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   DeviceHandle h = c.getDeviceHandle("z");
+   c.unloadDevice("z");
+   CHECK_FALSE(h.isValid());
+   CHECK(h.getLabel() == "z");
+   CHECK_THROWS_AS(c.getPosition(h), CMMError);
+
+   // Reloading under the same label does not revive the old handle
+   c.loadDevice("z", "mock_adapter", "z");
+   c.initializeDevice("z");
+   CHECK_THROWS_AS(c.setPosition(h, 1.0), CMMError);
+   DeviceHandle h2 = c.getDeviceHandle("z");
+   c.setPosition(h2, 1.0);
+   CHECK(stage.positionUm == 1.0);
+}
+
+TEST_CASE("Invalid device handles are rejected", "[DeviceHandle]") {
+   CMMCore c;
+   DeviceHandle h;
+   CHECK_FALSE(h.isValid());
+   CHECK_THROWS_AS(c.getProperty(h, "Prop"), CMMError);
+   CHECK_THROWS_AS(c.getDeviceHandle("nonexistent"), CMMError);
+   CHECK_THROWS_AS(c.getDeviceHandle("Core"), CMMError);
+}
@@ -0,0 +1,150 @@
+#include <catch2/catch_all.hpp>
+
+#include "FrameLatencyStats.h"
+#include "ImageMetadata.h"
+#include "MMCore.h"
+#include "MockDeviceUtils.h"
+#include "StubDevices.h"
+
+#include <chrono>
+
+using namespace mmcore::internal;
+using namespace std::chrono_literals;
+
+TEST_CASE("Empty latency histogram reports zero", "[FrameLatencyStats]") {
+   LatencyHistogram h;
+   CHECK(h.GetCount() == 0);
+   CHECK(h.GetPercentileUs(50.0) == 0.0);
+   CHECK(h.GetMeanUs() == 0.0);
+}
+
+TEST_CASE("Latency histogram percentiles are accurate to a few percent",
+          "[FrameLatencyStats]") {
+   LatencyHistogram h;
+   for (int us = 1; us <= 1000; ++us)
+      h.Record(std::chrono::microseconds(us));
+   CHECK(h.GetCount() == 1000);
+   CHECK(h.GetPercentileUs(50.0) == Catch::Approx(500.0).epsilon(0.04));
+   CHECK(h.GetPercentileUs(99.0) == Catch::Approx(990.0).epsilon(0.04));
+   CHECK(h.GetPercentileUs(100.0) == 1000.0);
+   CHECK(h.GetMeanUs() == Catch::Approx(500.5));
+}
+
+TEST_CASE("Latency histogram covers small and large durations",
+          "[FrameLatencyStats]") {
+   LatencyHistogram h;
+   h.Record(0ns);
+   h.Record(-5ns);
+   h.Record(7ns);
+   h.Record(3600s);
+   CHECK(h.GetPercentileUs(25.0) == 0.0);
+   CHECK(h.GetPercentileUs(75.0) == Catch::Approx(0.007));
+   CHECK(h.GetPercentileUs(100.0) == Catch::Approx(3600e6));
+
+   h.Reset();
+   CHECK(h.GetCount() == 0);
+   CHECK(h.GetPercentileUs(100.0) == 0.0);
+}
+
+TEST_CASE("Unknown latency stage throws", "[FrameLatencyStats]") {
+   CHECK(FrameLatencyStats::ParseStage("Queue") == LatencyStage::Queue);
+   CHECK_THROWS_AS(FrameLatencyStats::ParseStage("queue"), CMMError);
+
+   CMMCore c;
+   CHECK_THROWS_AS(c.getFrameLatencyCount("cam", "Nope"), CMMError);
+   CHECK_THROWS_AS(c.getFrameLatencyCount("cam", nullptr), CMMError);
+}
+
+TEST_CASE("Frame latency is not recorded by default", "[FrameLatencyStats]") {
+   StubCamera cam;
+   MockAdapterWithDevices adapter{{"cam", &cam}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   c.setCameraDevice("cam");
+   c.initializeCircularBuffer();
+
+   CHECK_FALSE(c.isFrameLatencyStatsEnabled());
+   REQUIRE(cam.InsertTestImage() == DEVICE_OK);
+   Metadata md;
+   c.popNextImageMD(md);
+   CHECK(c.getFrameLatencyStatsCameras().empty());
+   CHECK(c.getFrameLatencyCount("cam", "Total") == 0);
+   CHECK_FALSE(md.HasTag("CoreQueueTime-us"));
+}
+
+TEST_CASE("Frame latency is recorded for every stage", "[FrameLatencyStats]") {
+   StubCamera cam;
+   MockAdapterWithDevices adapter{{"cam", &cam}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   c.setCameraDevice("cam");
+   c.initializeCircularBuffer();
+   c.enableFrameLatencyStats(true);
+
+   REQUIRE(cam.InsertTestImage() == DEVICE_OK);
+   REQUIRE(cam.InsertTestImage() == DEVICE_OK);
+   CHECK(c.getFrameLatencyCount("cam", "Process") == 2);
+   CHECK(c.getFrameLatencyCount("cam", "Copy") == 2);
+   CHECK(c.getFrameLatencyCount("cam", "Queue") == 0);
+
+   Metadata md;
+   c.popNextImageMD(md);
+   c.popNextImage();
+   CHECK(c.getFrameLatencyCount("cam", "Queue") == 2);
+   CHECK(c.getFrameLatencyCount("cam", "Total") == 2);
+   CHECK(c.getFrameLatencyPercentileUs("cam", "Total", 100.0) >=
+         c.getFrameLatencyPercentileUs("cam", "Queue", 100.0));
+   CHECK(c.getFrameLatencyMeanUs("cam", "Total") > 0.0);
+   CHECK_FALSE(md.HasTag("CoreQueueTime-us"));
+
+   auto cameras = c.getFrameLatencyStatsCameras();
+   REQUIRE(cameras.size() == 1);
+   CHECK(cameras[0] == "cam");
+
+   c.resetFrameLatencyStats();
+   CHECK(c.getFrameLatencyCount("cam", "Total") == 0);
+}
+
+TEST_CASE("Frame latency tags are added to popped metadata",
+          "[FrameLatencyStats]") {
+   StubCamera cam;
+   MockAdapterWithDevices adapter{{"cam", &cam}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   c.setCameraDevice("cam");
+   c.initializeCircularBuffer();
+   c.enableFrameLatencyTags(true);
+
+   REQUIRE(cam.InsertTestImage() == DEVICE_OK);
+   Metadata md;
+   c.popNextImageMD(md);
+   CHECK(md.HasTag("CoreProcessTime-us"));
+   CHECK(md.HasTag("CoreCopyTime-us"));
+   CHECK(md.HasTag("CoreQueueTime-us"));
+   // Tags alone do not collect statistics
+   CHECK(c.getFrameLatencyCount("cam", "Total") == 0);
+}
+
+TEST_CASE("Buffer high-water mark tracks the largest backlog",
+          "[FrameLatencyStats]") {
+   StubCamera cam;
+   MockAdapterWithDevices adapter{{"cam", &cam}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   c.setCameraDevice("cam");
+   c.initializeCircularBuffer();
+   CHECK(c.getBufferHighWaterMark() == 0);
+
+   for (int i = 0; i < 3; ++i)
+      REQUIRE(cam.InsertTestImage() == DEVICE_OK);
+   c.popNextImage();
+   c.popNextImage();
+   REQUIRE(cam.InsertTestImage() == DEVICE_OK);
+   CHECK(c.getBufferHighWaterMark() == 3);
+
+   c.resetFrameLatencyStats();
+   CHECK(c.getBufferHighWaterMark() == 2);
+
+   c.initializeCircularBuffer();
+   CHECK(c.getBufferHighWaterMark() == 0);
+}
@@ -0,0 +1,188 @@
+#include <catch2/catch_all.hpp>
+
+#include "DeviceBase.h"
+#include "ImgBuffer.h"
+#include "MMCore.h"
+#include "MockDeviceUtils.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// A snap-based camera whose images carry the frame number in the first pixel.
+// Optionally, inserting each frame (but the last) waits, up to a timeout, for
+// the exposure of the following frame to start, which only happens in time if
+// capture and insertion run concurrently.
+struct LegacyCamera : CLegacyCameraBase<LegacyCamera> {
+   bool pipelined = false;
+   bool waitForNextExposure = false;
+   int numFrames = 0;
+   unsigned width = 16;
+   unsigned height = 8;
+
+   std::mutex mut;
+   std::condition_variable cv;
+   int exposuresStarted = 0;
+   int framesInserted = 0;
+   bool overlapped = true;
+   bool exiting = false;
+   bool exited = false;
+   std::chrono::milliseconds exitDelay{0};
+
+   int Initialize() override { return DEVICE_OK; }
+   int Shutdown() override { return DEVICE_OK; }
+   void GetName(char* buf) const override {
+      CDeviceUtils::CopyLimitedString(buf, "LegacyCamera");
+   }
+
+   int SnapImage() override {
+      int frameNumber;
+      {
+         std::lock_guard<std::mutex> lock(mut);
+         frameNumber = exposuresStarted++;
+      }
+      cv.notify_all();
+      img_.assign(static_cast<size_t>(width) * height, 0);
+      img_[0] = static_cast<unsigned char>(frameNumber);
+      return DEVICE_OK;
+   }
+   const unsigned char* GetImageBuffer() override { return img_.data(); }
+   long GetImageBufferSize() const override {
+      return static_cast<long>(width) * height;
+   }
+   unsigned GetImageWidth() const override { return width; }
+   unsigned GetImageHeight() const override { return height; }
+   unsigned GetImageBytesPerPixel() const override { return 1; }
+   unsigned GetBitDepth() const override { return 8; }
+   int GetBinning() const override { return 1; }
+   int SetBinning(int) override { return DEVICE_OK; }
+   void SetExposure(double) override {}
+   double GetExposure() const override { return 1.0; }
+   int SetROI(unsigned, unsigned, unsigned, unsigned) override {
+      return DEVICE_OK;
+   }
+   int GetROI(unsigned& x, unsigned& y, unsigned& w, unsigned& h) override {
+      x = 0; y = 0; w = width; h = height;
+      return DEVICE_OK;
+   }
+   int ClearROI() override { return DEVICE_OK; }
+   int IsExposureSequenceable(bool& seq) const override {
+      seq = false;
+      return DEVICE_OK;
+   }
+
+   bool UsesPipelinedSequence() override { return pipelined; }
+
+   int InsertFrame(const ImgBuffer& frame) override {
+      std::unique_lock<std::mutex> lock(mut);
+      const int next = ++framesInserted + 1;
+      if (waitForNextExposure && next <= numFrames &&
+            !cv.wait_for(lock, std::chrono::seconds(2),
+               [&] { return exposuresStarted >= next; }))
+         overlapped = false;
+      lock.unlock();
+      return CLegacyCameraBase::InsertFrame(frame);
+   }
+
+   void OnThreadExiting() override {
+      {
+         std::lock_guard<std::mutex> lock(mut);
+         exiting = true;
+      }
+      cv.notify_all();
+      std::this_thread::sleep_for(exitDelay);
+      CLegacyCameraBase::OnThreadExiting();
+      std::lock_guard<std::mutex> lock(mut);
+      exited = true;
+   }
+
+private:
+   std::vector<unsigned char> img_;
+};
+
+void WaitForSequenceEnd(CMMCore& c) {
+   auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+   while (c.isSequenceRunning() && std::chrono::steady_clock::now() < deadline)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+   REQUIRE_FALSE(c.isSequenceRunning());
+}
+
+std::vector<int> PopFrameNumbers(CMMCore& c) {
+   std::vector<int> numbers;
+   while (c.getRemainingImageCount() > 0)
+      numbers.push_back(static_cast<const unsigned char*>(c.popNextImage())[0]);
+   return numbers;
+}
+
+} // namespace
+
+TEST_CASE("Legacy camera sequence inserts every snapped frame in order",
+      "[LegacyCameraSequence]") {
+   LegacyCamera cam;
+   MockAdapterWithDevices adapter{{"cam", &cam}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   c.setCameraDevice("cam");
+
+   SECTION("serial") {
+      cam.pipelined = false;
+   }
+   SECTION("pipelined") {
+      cam.pipelined = true;
+   }
+
+   c.startSequenceAcquisition(6, 0.0, true);
+   WaitForSequenceEnd(c);
+   CHECK(PopFrameNumbers(c) == std::vector<int>{0, 1, 2, 3, 4, 5});
+}
+
+TEST_CASE("Pipelined legacy camera sequence overlaps capture and insertion",
+      "[LegacyCameraSequence]") {
+   LegacyCamera cam;
+   cam.pipelined = true;
+   cam.waitForNextExposure = true;
+   cam.numFrames = 10;
+   MockAdapterWithDevices adapter{{"cam", &cam}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   c.setCameraDevice("cam");
+
+   c.startSequenceAcquisition(cam.numFrames, 0.0, true);
+   WaitForSequenceEnd(c);
+   CHECK(cam.overlapped);
+   CHECK(cam.exposuresStarted == cam.numFrames);
+   CHECK(cam.framesInserted == cam.numFrames);
+   CHECK(PopFrameNumbers(c) == std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
+}
+
+TEST_CASE("Stopping a legacy camera sequence waits for the thread to exit",
+      "[LegacyCameraSequence]") {
+   LegacyCamera cam;
+   cam.exitDelay = std::chrono::milliseconds(100);
+   MockAdapterWithDevices adapter{{"cam", &cam}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   c.setCameraDevice("cam");
+
+   SECTION("serial") {
+      cam.pipelined = false;
+   }
+   SECTION("pipelined") {
+      cam.pipelined = true;
+   }
+
+   // The sequence has ended on its own, but the thread is still exiting
+   c.startSequenceAcquisition(1, 0.0, true);
+   {
+      std::unique_lock<std::mutex> lock(cam.mut);
+      REQUIRE(cam.cv.wait_for(lock, std::chrono::seconds(10),
+         [&] { return cam.exiting; }));
+   }
+   c.stopSequenceAcquisition();
+   std::lock_guard<std::mutex> lock(cam.mut);
+   CHECK(cam.exited);
+}
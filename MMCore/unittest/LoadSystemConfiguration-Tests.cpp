@@ -0,0 +1,161 @@
+#include <catch2/catch_all.hpp>
+
+#include "DeviceBase.h"
+#include "MMCore.h"
+#include "MockDeviceUtils.h"
+#include "TempFile.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Has a pre-init property "Setup", a property "A" that records the values it
+// is set to (also in callLog, if set, which is not synchronized), and a
+// property "Meet" that waits at the rendezvous when set.
+struct ConfigDevice : CGenericBase<ConfigDevice> {
+   std::string name;
+   Rendezvous& rendezvous;
+   std::string setupAtInit;
+   std::vector<std::string> valuesOfA;
+   std::vector<std::string>* callLog = nullptr;
+
+   ConfigDevice(std::string n, Rendezvous& r) :
+      name(std::move(n)), rendezvous(r) {
+      CreateStringProperty("Setup", "", false, nullptr, true);
+   }
+
+   int Initialize() override {
+      char setup[MM::MaxStrLength];
+      GetProperty("Setup", setup);
+      setupAtInit = setup;
+      CreateStringProperty("A", "", false,
+         new CPropertyAction(this, &ConfigDevice::OnA));
+      CreateStringProperty("Meet", "", false,
+         new CPropertyAction(this, &ConfigDevice::OnMeet));
+      return DEVICE_OK;
+   }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override { return false; }
+   void GetName(char* buf) const override {
+      CDeviceUtils::CopyLimitedString(buf, name.c_str());
+   }
+
+   int OnA(MM::PropertyBase* pProp, MM::ActionType eAct) {
+      if (eAct == MM::AfterSet) {
+         std::string value;
+         pProp->Get(value);
+         valuesOfA.push_back(value);
+         if (callLog)
+            callLog->push_back(name + "=" + value);
+      }
+      return DEVICE_OK;
+   }
+
+   int OnMeet(MM::PropertyBase*, MM::ActionType eAct) {
+      if (eAct == MM::AfterSet)
+         rendezvous.Arrive(std::chrono::seconds(2));
+      return DEVICE_OK;
+   }
+};
+
+} // namespace
+
+TEST_CASE("Post-initialization properties are set concurrently across modules",
+      "[LoadSystemConfiguration]") {
+   Rendezvous rendezvous(2);
+   ConfigDevice dev1("dev1", rendezvous);
+   ConfigDevice dev2("dev2", rendezvous);
+   MockAdapterWithDevices adapter1{"adapter1", {{"dev1", &dev1}}};
+   MockAdapterWithDevices adapter2{"adapter2", {{"dev2", &dev2}}};
+   CMMCore c;
+   c.loadMockDeviceAdapter("adapter1", &adapter1);
+   c.loadMockDeviceAdapter("adapter2", &adapter2);
+   FeatureGuard parallel("ParallelConfigLoad", true);
+
+   TempFile tmp(
+      "# Test configuration\n"
+      "Device,dev1,adapter1,dev1\n"
+      "Device,dev2,adapter2,dev2\n"
+      "Property,dev1,Setup,s1\n"
+      "Property,Core,Initialize,1\n"
+      "Property,dev1,A,first\n"
+      "Property,dev2,Meet,now\n"
+      "Property,dev1,Meet,now\n"
+      "Property,dev1,A,second\n"
+      "Property,dev2,A\n");
+   c.loadSystemConfiguration(tmp.getPath().c_str());
+
+   CHECK(dev1.setupAtInit == "s1");
+   CHECK(rendezvous.ok);
+   CHECK(dev1.valuesOfA == std::vector<std::string>{"first", "second"});
+   CHECK(dev2.valuesOfA == std::vector<std::string>{""});
+   CHECK(c.getPropertyFromCache("dev1", "A") == "second");
+}
+
+TEST_CASE("Post-initialization properties are set in file order by default",
+      "[LoadSystemConfiguration]") {
+   Rendezvous rendezvous(2);
+   ConfigDevice dev1("dev1", rendezvous);
+   ConfigDevice dev2("dev2", rendezvous);
+   MockAdapterWithDevices adapter1{"adapter1", {{"dev1", &dev1}}};
+   MockAdapterWithDevices adapter2{"adapter2", {{"dev2", &dev2}}};
+   CMMCore c;
+   c.loadMockDeviceAdapter("adapter1", &adapter1);
+   c.loadMockDeviceAdapter("adapter2", &adapter2);
+   REQUIRE_FALSE(CMMCore::isFeatureEnabled("ParallelConfigLoad"));
+   std::vector<std::string> callLog;
+   dev1.callLog = &callLog;
+   dev2.callLog = &callLog;
+
+   TempFile tmp(
+      "Device,dev1,adapter1,dev1\n"
+      "Device,dev2,adapter2,dev2\n"
+      "Property,Core,Initialize,1\n"
+      "Property,dev2,A,1\n"
+      "Property,dev1,A,2\n"
+      "Property,dev2,A,3\n"
+      "Property,dev1,A,4\n");
+   c.loadSystemConfiguration(tmp.getPath().c_str());
+   CHECK(callLog ==
+      std::vector<std::string>{"dev2=1", "dev1=2", "dev2=3", "dev1=4"});
+}
+
+TEST_CASE("Failed post-initialization property reports its line",
+      "[LoadSystemConfiguration]") {
+   Rendezvous rendezvous(1);
+   ConfigDevice dev1("dev1", rendezvous);
+   ConfigDevice dev2("dev2", rendezvous);
+   MockAdapterWithDevices adapter1{"adapter1", {{"dev1", &dev1}}};
+   MockAdapterWithDevices adapter2{"adapter2", {{"dev2", &dev2}}};
+   CMMCore c;
+   c.loadMockDeviceAdapter("adapter1", &adapter1);
+   c.loadMockDeviceAdapter("adapter2", &adapter2);
+
+   bool parallelLoad = GENERATE(false, true);
+   FeatureGuard parallel("ParallelConfigLoad", parallelLoad);
+
+   TempFile tmp(
+      "Device,dev1,adapter1,dev1\n"
+      "Device,dev2,adapter2,dev2\n"
+      "Property,Core,Initialize,1\n"
+      "Property,dev2,A,first\n"
+      "Property,dev1,A,first\n"
+      "Property,dev1,NoSuchProperty,1\n"
+      "Property,dev1,A,second\n"
+      "Property,dev2,NoSuchProperty,1\n");
+   try {
+      c.loadSystemConfiguration(tmp.getPath().c_str());
+      FAIL("Expected an exception");
+   }
+   catch (const CMMError& e) {
+      CHECK(e.getCode() == MMERR_InvalidConfigurationFile);
+      CHECK(e.getFullMsg().find("Line 6: Property,dev1,NoSuchProperty,1") !=
+         std::string::npos);
+   }
+   // Loading stopped at the failed line
+   CHECK(dev1.valuesOfA == std::vector<std::string>{"first"});
+   CHECK(dev2.valuesOfA == std::vector<std::string>{"first"});
+   CHECK(c.getLoadedDevices() == std::vector<std::string>{"Core"});
+}
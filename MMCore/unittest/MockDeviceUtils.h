@@ -1,6 +1,9 @@
 #include "MMCore.h"
 
+#include <chrono>
+#include <condition_variable>
 #include <initializer_list>
+#include <mutex>
 #include <utility>
 #include <string>
 
@@ -12,12 +15,19 @@
 class MockAdapterWithDevices : public MockDeviceAdapter {
    std::string adapter_name = "mock_adapter";
    std::vector<std::pair<std::string, MM::Device*>> devices;
+   bool perDeviceLocking = false;
 
 public:
    explicit MockAdapterWithDevices(
       std::initializer_list<std::pair<std::string, MM::Device*>> il)
       : devices(il) {}
 
+   // Use a distinct adapter name when loading more than one adapter into the
+   // same core.
+   MockAdapterWithDevices(std::string adapterName,
+      std::initializer_list<std::pair<std::string, MM::Device*>> il)
+      : adapter_name(std::move(adapterName)), devices(il) {}
+
    void InitializeModuleData(RegisterDeviceFunc registerDevice) override {
       for (auto name_device : devices) {
          const auto name = name_device.first;
@@ -38,6 +48,10 @@ public:
 
    void DeleteDevice(MM::Device *device) override { (void)device; }
 
+   // Must be called before loading into the core
+   void EnablePerDeviceLocking() { perDeviceLocking = true; }
+   bool GetPerDeviceLocking() override { return perDeviceLocking; }
+
    // Convenience for loading all the devices
    void LoadIntoCore(CMMCore &core) {
       core.loadMockDeviceAdapter(adapter_name.c_str(), this);
@@ -50,4 +64,42 @@ public:
          core.initializeDevice(name.c_str());
       }
    }
-};
\ No newline at end of file
+};
+
+// Blocks each caller of Arrive() until the expected number of callers have
+// arrived, so that tests can check that calls are made concurrently. If the
+// wait times out, ok is cleared (and the caller proceeds).
+struct Rendezvous {
+   std::mutex mut;
+   std::condition_variable cv;
+   int arrived = 0;
+   int expected;
+   bool ok = true;
+
+   explicit Rendezvous(int n) : expected(n) {}
+
+   void Arrive(std::chrono::milliseconds timeout = std::chrono::seconds(5)) {
+      std::unique_lock<std::mutex> lock(mut);
+      ++arrived;
+      cv.notify_all();
+      if (!cv.wait_for(lock, timeout, [&] { return arrived >= expected; }))
+         ok = false;
+   }
+};
+
+// Sets a Core feature for the lifetime of the guard and restores its previous
+// state afterwards.
+class FeatureGuard {
+   std::string name_;
+   bool previous_;
+
+public:
+   FeatureGuard(const char* name, bool enable) :
+      name_(name), previous_(CMMCore::isFeatureEnabled(name)) {
+      CMMCore::enableFeature(name, enable);
+   }
+   ~FeatureGuard() { CMMCore::enableFeature(name_.c_str(), previous_); }
+
+   FeatureGuard(const FeatureGuard&) = delete;
+   FeatureGuard& operator=(const FeatureGuard&) = delete;
+};
@@ -0,0 +1,155 @@
+#include <catch2/catch_all.hpp>
+
+#include "DeviceBase.h"
+#include "MMCore.h"
+#include "MockDeviceUtils.h"
+
+#include <string>
+
+namespace {
+
+// Generic device with numeric and string properties, counting the string
+// accesses made by the Core. Its overrides only count, so it lets numeric
+// access bypass them.
+struct NumericPropDevice : CGenericBase<NumericPropDevice> {
+   int stringGets = 0;
+   int stringSets = 0;
+
+   NumericPropDevice() { EnableDirectNumericPropertyAccess(); }
+
+   int Initialize() override {
+      CreateFloatProperty("Pos", 0.0, false);
+      SetPropertyLimits("Pos", -100.0, 100.0);
+      CreateIntegerProperty("Count", 0, false);
+      CreateIntegerProperty("Mode", 0, false);
+      AddAllowedValue("Mode", "0");
+      AddAllowedValue("Mode", "1");
+      CreateStringProperty("Name", "abc", false);
+      CreateStringProperty("Text", "2.5", false);
+      return DEVICE_OK;
+   }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override { return false; }
+   void GetName(char* buf) const override {
+      CDeviceUtils::CopyLimitedString(buf, "NumericPropDevice");
+   }
+
+   int GetProperty(const char* name, char* value) const override {
+      ++const_cast<NumericPropDevice*>(this)->stringGets;
+      return CGenericBase::GetProperty(name, value);
+   }
+   int SetProperty(const char* name, const char* value) override {
+      ++stringSets;
+      return CGenericBase::SetProperty(name, value);
+   }
+};
+
+// Generic device that forwards its "Pos" property to (simulated) hardware by
+// overriding GetProperty()/SetProperty(), as some adapters do.
+struct ForwardingDevice : CGenericBase<ForwardingDevice> {
+   std::string hardwarePos = "0";
+
+   int Initialize() override {
+      CreateFloatProperty("Pos", 0.0, false);
+      return DEVICE_OK;
+   }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override { return false; }
+   void GetName(char* buf) const override {
+      CDeviceUtils::CopyLimitedString(buf, "ForwardingDevice");
+   }
+
+   int GetProperty(const char* name, char* value) const override {
+      if (std::string(name) == "Pos") {
+         CDeviceUtils::CopyLimitedString(value, hardwarePos.c_str());
+         return DEVICE_OK;
+      }
+      return CGenericBase::GetProperty(name, value);
+   }
+   int SetProperty(const char* name, const char* value) override {
+      if (std::string(name) == "Pos") {
+         hardwarePos = value;
+         return DEVICE_OK;
+      }
+      return CGenericBase::SetProperty(name, value);
+   }
+};
+
+} // namespace
+
+TEST_CASE("Numeric properties are set and read without strings",
+      "[NumericProperty]") {
+   NumericPropDevice dev;
+   MockAdapterWithDevices adapter{{"dev", &dev}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   dev.stringGets = dev.stringSets = 0;
+
+   c.setProperty("dev", "Pos", 12.345678);
+   CHECK(c.getPropertyAsDouble("dev", "Pos") == 12.3457);
+   c.setProperty("dev", "Count", 42L);
+   CHECK(c.getPropertyAsDouble("dev", "Count") == 42.0);
+   c.setProperty("dev", "Pos", 1.5f);
+   CHECK(c.getPropertyAsDouble("dev", "Pos") == 1.5);
+   CHECK(dev.stringGets == 0);
+   CHECK(dev.stringSets == 0);
+
+   CHECK(c.getProperty("dev", "Pos") == "1.5000");
+   CHECK_NOTHROW(c.getPropertyFromCache("dev", "Count"));
+
+   SECTION("out-of-range value throws") {
+      CHECK_THROWS_AS(c.setProperty("dev", "Pos", 200.0), CMMError);
+      CHECK(c.getPropertyAsDouble("dev", "Pos") == 1.5);
+   }
+}
+
+TEST_CASE("Numeric access falls back to strings when needed",
+      "[NumericProperty]") {
+   NumericPropDevice dev;
+   MockAdapterWithDevices adapter{{"dev", &dev}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   dev.stringGets = dev.stringSets = 0;
+
+   SECTION("property with allowed values") {
+      c.setProperty("dev", "Mode", 1L);
+      CHECK(dev.stringSets == 1);
+      CHECK(c.getProperty("dev", "Mode") == "1");
+      CHECK_THROWS_AS(c.setProperty("dev", "Mode", 2L), CMMError);
+   }
+
+   SECTION("string property") {
+      CHECK(c.getPropertyAsDouble("dev", "Text") == 2.5);
+      CHECK(dev.stringGets == 1);
+      CHECK_THROWS_AS(c.getPropertyAsDouble("dev", "Name"), CMMError);
+      c.setProperty("dev", "Name", 3L);
+      CHECK(c.getProperty("dev", "Name") == "3");
+   }
+
+   SECTION("Core property") {
+      CHECK(c.getPropertyAsDouble("Core", "TimeoutMs") == 5000.0);
+      c.setProperty("Core", "TimeoutMs", 2000L);
+      CHECK(c.getTimeoutMs() == 2000);
+   }
+
+   SECTION("unknown property throws") {
+      CHECK_THROWS_AS(c.getPropertyAsDouble("dev", "Missing"), CMMError);
+      CHECK_THROWS_AS(c.setProperty("dev", "Missing", 1.0), CMMError);
+   }
+}
+
+TEST_CASE("Numeric access goes through overridden string accessors",
+      "[NumericProperty]") {
+   ForwardingDevice dev;
+   MockAdapterWithDevices adapter{{"dev", &dev}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   c.setProperty("dev", "Pos", 12.5);
+   CHECK(std::stod(dev.hardwarePos) == 12.5);
+   c.setProperty("dev", "Pos", 3L);
+   CHECK(std::stod(dev.hardwarePos) == 3.0);
+
+   dev.hardwarePos = "7.25";
+   CHECK(c.getPropertyAsDouble("dev", "Pos") == 7.25);
+}
@@ -0,0 +1,202 @@
+#include <catch2/catch_all.hpp>
+
+#include "DeviceBase.h"
+#include "MMCore.h"
+#include "MockDeviceUtils.h"
+
+#include <atomic>
+#include <functional>
+#include <string>
+
+namespace {
+
+// Generic device with a single string property "Value" that counts how many
+// times it has been set, and allows tests to hook into the setting.
+struct CountingDevice : CGenericBase<CountingDevice> {
+   std::string name;
+   std::atomic<int> setCount{0};
+   std::function<int(const std::string&)> onSet;
+   std::atomic<int> busyPolls{0};
+
+   explicit CountingDevice(std::string n) : name(std::move(n)) {}
+
+   int Initialize() override {
+      return CreateStringProperty("Value", "A", false,
+         new CPropertyAction(this, &CountingDevice::OnValue));
+   }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override { return busyPolls.load() > 0 && busyPolls-- > 0; }
+   void GetName(char* buf) const override {
+      CDeviceUtils::CopyLimitedString(buf, name.c_str());
+   }
+
+   int OnValue(MM::PropertyBase* pProp, MM::ActionType eAct) {
+      if (eAct == MM::AfterSet) {
+         ++setCount;
+         if (onSet) {
+            std::string v;
+            pProp->Get(v);
+            return onSet(v);
+         }
+      }
+      return DEVICE_OK;
+   }
+};
+
+void DefineTwoDevicePresets(CMMCore& c) {
+   c.defineConfig("G", "P1", "dev1", "Value", "B");
+   c.defineConfig("G", "P1", "dev2", "Value", "B");
+   c.defineConfig("G", "P2", "dev1", "Value", "B");
+   c.defineConfig("G", "P2", "dev2", "Value", "C");
+}
+
+} // namespace
+
+TEST_CASE("ParallelConfigApply is disabled by default", "[ParallelConfigApply]") {
+   CHECK_FALSE(CMMCore::isFeatureEnabled("ParallelConfigApply"));
+}
+
+TEST_CASE("setConfig re-sends unchanged settings when feature disabled",
+      "[ParallelConfigApply]") {
+   FeatureGuard feature("ParallelConfigApply", false);
+   CountingDevice dev1("dev1");
+   CountingDevice dev2("dev2");
+   MockAdapterWithDevices adapter{{"dev1", &dev1}, {"dev2", &dev2}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   DefineTwoDevicePresets(c);
+
+   c.setConfig("G", "P1");
+   c.setConfig("G", "P2");
+   CHECK(dev1.setCount == 2);
+   CHECK(dev2.setCount == 2);
+   CHECK(c.getProperty("dev2", "Value") == "C");
+}
+
+TEST_CASE("setConfig skips settings matching the cache when feature enabled",
+      "[ParallelConfigApply]") {
+   FeatureGuard feature("ParallelConfigApply", true);
+   CountingDevice dev1("dev1");
+   CountingDevice dev2("dev2");
+   MockAdapterWithDevices adapter{{"dev1", &dev1}, {"dev2", &dev2}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+   DefineTwoDevicePresets(c);
+
+   c.setConfig("G", "P1");
+   CHECK(dev1.setCount == 1);
+   CHECK(dev2.setCount == 1);
+
+   c.setConfig("G", "P2");
+   CHECK(dev1.setCount == 1);
+   CHECK(dev2.setCount == 2);
+   CHECK(c.getCurrentConfigFromCache("G") == "P2");
+   CHECK(c.getProperty("dev2", "Value") == "C");
+}
+
+TEST_CASE("setConfig applies settings of different modules concurrently",
+      "[ParallelConfigApply]") {
+   FeatureGuard feature("ParallelConfigApply", true);
+   CountingDevice dev1("dev1");
+   CountingDevice dev2("dev2");
+   MockAdapterWithDevices adapter1{"adapter1", {{"dev1", &dev1}}};
+   MockAdapterWithDevices adapter2{"adapter2", {{"dev2", &dev2}}};
+   CMMCore c;
+   adapter1.LoadIntoCore(c);
+   adapter2.LoadIntoCore(c);
+   DefineTwoDevicePresets(c);
+
+   // Each device waits until the other has started its set; this can only
+   // succeed if the two modules are handled on different threads.
+   Rendezvous rendezvous(2);
+   auto meet = [&](const std::string&) {
+      rendezvous.Arrive();
+      return DEVICE_OK;
+   };
+   dev1.onSet = meet;
+   dev2.onSet = meet;
+
+   c.setConfig("G", "P1");
+   CHECK(rendezvous.ok);
+   CHECK(c.getProperty("dev1", "Value") == "B");
+   CHECK(c.getProperty("dev2", "Value") == "B");
+}
+
+TEST_CASE("setConfig applies Core settings in preset order when feature enabled",
+      "[ParallelConfigApply]") {
+   FeatureGuard feature("ParallelConfigApply", true);
+   CountingDevice dev1("dev1");
+   CountingDevice dev2("dev2");
+   MockAdapterWithDevices adapter1{"adapter1", {{"dev1", &dev1}}};
+   MockAdapterWithDevices adapter2{"adapter2", {{"dev2", &dev2}}};
+   CMMCore c;
+   adapter1.LoadIntoCore(c);
+   adapter2.LoadIntoCore(c);
+   c.defineConfig("G", "P", "dev1", "Value", "B");
+   c.defineConfig("G", "P", "Core", "AutoShutter", "0");
+   c.defineConfig("G", "P", "dev2", "Value", "B");
+   REQUIRE(c.getAutoShutter());
+
+   std::string seenByDev1, seenByDev2;
+   dev1.onSet = [&](const std::string&) {
+      seenByDev1 = c.getProperty("Core", "AutoShutter");
+      return DEVICE_OK;
+   };
+   dev2.onSet = [&](const std::string&) {
+      seenByDev2 = c.getProperty("Core", "AutoShutter");
+      return DEVICE_OK;
+   };
+
+   c.setConfig("G", "P");
+   CHECK(seenByDev1 == "1");
+   CHECK(seenByDev2 == "0");
+   CHECK_FALSE(c.getAutoShutter());
+}
+
+TEST_CASE("setConfig retries failed settings when feature enabled",
+      "[ParallelConfigApply]") {
+   FeatureGuard feature("ParallelConfigApply", true);
+   CountingDevice dev1("dev1");
+   CountingDevice dev2("dev2");
+   MockAdapterWithDevices adapter1{"adapter1", {{"dev1", &dev1}}};
+   MockAdapterWithDevices adapter2{"adapter2", {{"dev2", &dev2}}};
+   CMMCore c;
+   adapter1.LoadIntoCore(c);
+   adapter2.LoadIntoCore(c);
+   DefineTwoDevicePresets(c);
+
+   SECTION("transient failure succeeds on retry") {
+      int failuresLeft = 1;
+      dev2.onSet = [&](const std::string&) {
+         return failuresLeft-- > 0 ? DEVICE_ERR : DEVICE_OK;
+      };
+      CHECK_NOTHROW(c.setConfig("G", "P1"));
+      CHECK(dev2.setCount == 2);
+   }
+
+   SECTION("persistent failure throws after other settings applied") {
+      dev2.onSet = [](const std::string&) { return DEVICE_ERR; };
+      CHECK_THROWS_AS(c.setConfig("G", "P1"), CMMError);
+      CHECK(c.getProperty("dev1", "Value") == "B");
+   }
+}
+
+TEST_CASE("setConfig with wait blocks until touched devices are idle",
+      "[ParallelConfigApply]") {
+   bool enable = GENERATE(false, true);
+   FeatureGuard feature("ParallelConfigApply", enable);
+   CountingDevice dev1("dev1");
+   CountingDevice dev2("dev2");
+   MockAdapterWithDevices adapter1{"adapter1", {{"dev1", &dev1}}};
+   MockAdapterWithDevices adapter2{"adapter2", {{"dev2", &dev2}}};
+   CMMCore c;
+   adapter1.LoadIntoCore(c);
+   adapter2.LoadIntoCore(c);
+   DefineTwoDevicePresets(c);
+
+   dev1.busyPolls = 3;
+   dev2.busyPolls = 3;
+   c.setConfig("G", "P1", true);
+   CHECK(dev1.busyPolls <= 0);
+   CHECK(dev2.busyPolls <= 0);
+}
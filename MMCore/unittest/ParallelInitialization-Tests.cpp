@@ -0,0 +1,242 @@
+#include <catch2/catch_all.hpp>
+
+#include "DependencyScheduler.h"
+#include "DeviceBase.h"
+#include "MMCore.h"
+#include "MockDeviceUtils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using mmcore::internal::DependencyScheduler;
+
+namespace {
+
+// Records the start and end of each initialization, in order
+struct InitLog {
+   std::mutex mut;
+   std::vector<std::string> events;
+   std::atomic<int> active{0};
+   std::atomic<int> maxActive{0};
+
+   void Add(const std::string& event) {
+      std::lock_guard<std::mutex> lock(mut);
+      events.push_back(event);
+   }
+
+   size_t IndexOf(const std::string& event) {
+      std::lock_guard<std::mutex> lock(mut);
+      return static_cast<size_t>(
+         std::find(events.begin(), events.end(), event) - events.begin());
+   }
+
+   void Enter(const std::string& name) {
+      Add("start " + name);
+      int n = ++active;
+      int prev = maxActive;
+      while (n > prev && !maxActive.compare_exchange_weak(prev, n)) {}
+   }
+
+   void Leave(const std::string& name) {
+      --active;
+      Add("end " + name);
+   }
+};
+
+struct LoggedDevice : CGenericBase<LoggedDevice> {
+   std::string name;
+   InitLog& log;
+   Rendezvous* rendezvous = nullptr;
+
+   // portProperty: name of a pre-init property holding a port label
+   LoggedDevice(std::string n, InitLog& l, const char* portProperty = nullptr) :
+      name(std::move(n)), log(l) {
+      if (portProperty)
+         CreateStringProperty(portProperty, "Undefined", false, nullptr, true);
+   }
+
+   int Initialize() override {
+      log.Enter(name);
+      if (rendezvous)
+         rendezvous->Arrive(std::chrono::seconds(2));
+      else
+         std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      log.Leave(name);
+      return DEVICE_OK;
+   }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override { return false; }
+   void GetName(char* buf) const override {
+      CDeviceUtils::CopyLimitedString(buf, name.c_str());
+   }
+};
+
+struct LoggedPort : CSerialBase<LoggedPort> {
+   std::string name;
+   InitLog& log;
+
+   LoggedPort(std::string n, InitLog& l) : name(std::move(n)), log(l) {}
+
+   int Initialize() override {
+      log.Enter(name);
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      log.Leave(name);
+      return DEVICE_OK;
+   }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override { return false; }
+   void GetName(char* buf) const override {
+      CDeviceUtils::CopyLimitedString(buf, name.c_str());
+   }
+   MM::PortType GetPortType() const override { return MM::SerialPort; }
+   int SetCommand(const char*, const char*) override { return DEVICE_OK; }
+   int GetAnswer(char*, unsigned, const char*) override { return DEVICE_OK; }
+   int Write(const unsigned char*, unsigned long) override { return DEVICE_OK; }
+   int Read(unsigned char*, unsigned long, unsigned long& read) override {
+      read = 0;
+      return DEVICE_OK;
+   }
+   int Purge() override { return DEVICE_OK; }
+};
+
+} // namespace
+
+TEST_CASE("Scheduled tasks wait for their dependencies",
+      "[ParallelInitialization]") {
+   InitLog log;
+   DependencyScheduler schedule(5);
+   schedule.AddDependency(0, 2);
+   schedule.AddDependency(1, 2);
+   schedule.AddDependency(2, 3);
+
+   schedule.Run([&](size_t i) {
+      const std::string name = std::to_string(i);
+      log.Enter(name);
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      log.Leave(name);
+   }, 2);
+
+   CHECK(log.maxActive <= 2);
+   CHECK(log.IndexOf("end 0") < log.IndexOf("start 2"));
+   CHECK(log.IndexOf("end 1") < log.IndexOf("start 2"));
+   CHECK(log.IndexOf("end 2") < log.IndexOf("start 3"));
+   for (const auto& timing : schedule.GetTimings())
+      CHECK(timing.ran);
+}
+
+TEST_CASE("Scheduler starts no tasks after a failure",
+      "[ParallelInitialization]") {
+   DependencyScheduler schedule(3);
+   schedule.AddDependency(0, 1);
+   schedule.AddDependency(1, 2);
+   CHECK_THROWS_AS(schedule.Run([](size_t i) {
+      if (i == 1)
+         throw std::runtime_error("failed");
+   }, 4), std::runtime_error);
+   CHECK(schedule.GetTimings()[0].ran);
+   CHECK(schedule.GetTimings()[1].ran);
+   CHECK_FALSE(schedule.GetTimings()[2].ran);
+}
+
+TEST_CASE("Circular dependencies are rejected", "[ParallelInitialization]") {
+   DependencyScheduler schedule(3);
+   schedule.AddDependency(0, 1);
+   schedule.AddDependency(1, 2);
+   schedule.AddDependency(2, 1);
+   bool ran = false;
+   CHECK_THROWS_AS(schedule.Run([&](size_t) { ran = true; }, 4), CMMError);
+   CHECK_FALSE(ran);
+}
+
+TEST_CASE("Critical path follows the dependencies that finished last",
+      "[ParallelInitialization]") {
+   DependencyScheduler schedule(4);
+   schedule.AddDependency(0, 2);
+   schedule.AddDependency(1, 2);
+   schedule.Run([](size_t i) {
+      const int ms[] = { 40, 5, 10, 1 };
+      std::this_thread::sleep_for(std::chrono::milliseconds(ms[i]));
+   }, 4);
+   CHECK(schedule.GetCriticalPath() == std::vector<size_t>{ 0, 2 });
+}
+
+TEST_CASE("Devices are initialized after their port and hub",
+      "[ParallelInitialization]") {
+   InitLog log;
+
+   LoggedPort port("port", log);
+   MockAdapterWithDevices portAdapter("port_adapter", {{"port", &port}});
+
+   // Peripherals of a hub in a module with per-device locking are initialized
+   // concurrently, but only after the hub
+   Rendezvous rendezvous(2);
+   LoggedDevice hub("hub", log);
+   LoggedDevice periph1("periph1", log);
+   LoggedDevice periph2("periph2", log);
+   periph1.rendezvous = &rendezvous;
+   periph2.rendezvous = &rendezvous;
+   MockAdapterWithDevices hubAdapter("hub_adapter",
+      {{"hub", &hub}, {"periph1", &periph1}, {"periph2", &periph2}});
+   hubAdapter.EnablePerDeviceLocking();
+
+   // Devices of a module without per-device locking are initialized one at a
+   // time
+   LoggedDevice stage("stage", log, MM::g_Keyword_Port);
+   LoggedDevice other("other", log);
+   MockAdapterWithDevices stageAdapter("stage_adapter",
+      {{"stage", &stage}, {"other", &other}});
+
+   CMMCore c;
+   c.loadMockDeviceAdapter("port_adapter", &portAdapter);
+   c.loadMockDeviceAdapter("hub_adapter", &hubAdapter);
+   c.loadMockDeviceAdapter("stage_adapter", &stageAdapter);
+   // Loaded before the port and hub they depend on
+   c.loadDevice("stage", "stage_adapter", "stage");
+   c.loadDevice("other", "stage_adapter", "other");
+   c.loadDevice("periph1", "hub_adapter", "periph1");
+   c.loadDevice("periph2", "hub_adapter", "periph2");
+   c.loadDevice("hub", "hub_adapter", "hub");
+   c.loadDevice("port", "port_adapter", "port");
+   c.setParentLabel("periph1", "hub");
+   c.setParentLabel("periph2", "hub");
+   c.setProperty("stage", MM::g_Keyword_Port, "port");
+
+   c.initializeAllDevices();
+
+   CHECK(log.IndexOf("end port") < log.IndexOf("start stage"));
+   CHECK((log.IndexOf("end stage") < log.IndexOf("start other") ||
+      log.IndexOf("end other") < log.IndexOf("start stage")));
+   CHECK(log.IndexOf("end hub") < log.IndexOf("start periph1"));
+   CHECK(log.IndexOf("end hub") < log.IndexOf("start periph2"));
+   CHECK(rendezvous.ok);
+   CHECK(log.maxActive >= 2);
+   CHECK(c.getDeviceInitializationState("other") ==
+      DeviceInitializationState::InitializedSuccessfully);
+}
+
+TEST_CASE("Devices are initialized after ports named by any pre-init property",
+      "[ParallelInitialization]") {
+   InitLog log;
+
+   LoggedPort port("port", log);
+   MockAdapterWithDevices portAdapter("port_adapter", {{"port", &port}});
+   LoggedDevice dev("dev", log, "COM Port");
+   MockAdapterWithDevices devAdapter("dev_adapter", {{"dev", &dev}});
+
+   CMMCore c;
+   c.loadMockDeviceAdapter("port_adapter", &portAdapter);
+   c.loadMockDeviceAdapter("dev_adapter", &devAdapter);
+   c.loadDevice("dev", "dev_adapter", "dev");
+   c.loadDevice("port", "port_adapter", "port");
+   c.setProperty("dev", "COM Port", "port");
+
+   c.initializeAllDevices();
+
+   CHECK(log.IndexOf("end port") < log.IndexOf("start dev"));
+}
@@ -0,0 +1,156 @@
+#include <catch2/catch_all.hpp>
+
+#include "DeviceBase.h"
+#include "MMCore.h"
+#include "MockDeviceUtils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// State shared by all devices of an adapter, guarded by its own mutex (like
+// the global mutex of a hub adapter that uses per-device locking).
+struct SharedHubState {
+   std::mutex mut;
+   long totalSets = 0;
+   std::atomic<int> inCalls{0};
+   std::atomic<int> maxInCalls{0};
+};
+
+// Generic device that records whether the Core ever enters it from more than
+// one thread at a time.
+struct HubPeripheral : CGenericBase<HubPeripheral> {
+   std::string name;
+   SharedHubState& hub;
+   std::atomic<int> inCall{0};
+   std::atomic<bool> reentered{false};
+   std::function<void()> onBusy;
+
+   HubPeripheral(std::string n, SharedHubState& h) :
+      name(std::move(n)), hub(h) {}
+
+   int Initialize() override {
+      return CreateIntegerProperty("Value", 0, false,
+         new CPropertyAction(this, &HubPeripheral::OnValue));
+   }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override {
+      Enter();
+      if (onBusy)
+         onBusy();
+      Leave();
+      return false;
+   }
+   void GetName(char* buf) const override {
+      CDeviceUtils::CopyLimitedString(buf, name.c_str());
+   }
+
+   int OnValue(MM::PropertyBase*, MM::ActionType eAct) {
+      if (eAct == MM::AfterSet) {
+         Enter();
+         {
+            std::lock_guard<std::mutex> lock(hub.mut);
+            ++hub.totalSets;
+         }
+         std::this_thread::yield();
+         Leave();
+      }
+      return DEVICE_OK;
+   }
+
+   void Enter() {
+      if (inCall++ > 0)
+         reentered = true;
+      int n = ++hub.inCalls;
+      int prev = hub.maxInCalls;
+      while (n > prev && !hub.maxInCalls.compare_exchange_weak(prev, n)) {}
+   }
+   void Leave() {
+      --hub.inCalls;
+      --inCall;
+   }
+};
+
+} // namespace
+
+TEST_CASE("Devices of a module are serialized by default",
+      "[PerDeviceLocking]") {
+   SharedHubState hub;
+   HubPeripheral dev1("dev1", hub);
+   HubPeripheral dev2("dev2", hub);
+   MockAdapterWithDevices adapter{{"dev1", &dev1}, {"dev2", &dev2}};
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   // The rendezvous cannot complete, because the second device is not
+   // entered until the first one has returned.
+   Rendezvous rendezvous(2);
+   dev1.onBusy = [&] { rendezvous.Arrive(std::chrono::milliseconds(50)); };
+   dev2.onBusy = [&] { rendezvous.Arrive(std::chrono::milliseconds(50)); };
+   c.waitForSystem();
+   CHECK_FALSE(rendezvous.ok);
+   CHECK(hub.maxInCalls == 1);
+}
+
+TEST_CASE("Devices of a module with per-device locking run concurrently",
+      "[PerDeviceLocking]") {
+   SharedHubState hub;
+   HubPeripheral dev1("dev1", hub);
+   HubPeripheral dev2("dev2", hub);
+   MockAdapterWithDevices adapter{{"dev1", &dev1}, {"dev2", &dev2}};
+   adapter.EnablePerDeviceLocking();
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   Rendezvous rendezvous(2);
+   dev1.onBusy = [&] { rendezvous.Arrive(std::chrono::seconds(5)); };
+   dev2.onBusy = [&] { rendezvous.Arrive(std::chrono::seconds(5)); };
+   c.waitForSystem();
+   CHECK(rendezvous.ok);
+   CHECK(hub.maxInCalls == 2);
+}
+
+TEST_CASE("Per-device locking never enters a device concurrently",
+      "[PerDeviceLocking]") {
+   bool perDevice = GENERATE(false, true);
+   SharedHubState hub;
+   HubPeripheral dev1("dev1", hub);
+   HubPeripheral dev2("dev2", hub);
+   HubPeripheral dev3("dev3", hub);
+   MockAdapterWithDevices adapter{
+      {"dev1", &dev1}, {"dev2", &dev2}, {"dev3", &dev3}};
+   if (perDevice)
+      adapter.EnablePerDeviceLocking();
+   CMMCore c;
+   adapter.LoadIntoCore(c);
+
+   const std::vector<std::string> labels{"dev1", "dev2", "dev3"};
+   const int threadCount = 4;
+   const int iterations = 200;
+   std::vector<std::thread> threads;
+   for (int t = 0; t < threadCount; ++t) {
+      threads.emplace_back([&, t] {
+         for (int i = 0; i < iterations; ++i) {
+            const std::string& label = labels[(t + i) % labels.size()];
+            c.setProperty(label.c_str(), "Value", static_cast<long>(i));
+            c.deviceBusy(label.c_str());
+         }
+      });
+   }
+   for (auto& th : threads)
+      th.join();
+
+   CHECK_FALSE(dev1.reentered);
+   CHECK_FALSE(dev2.reentered);
+   CHECK_FALSE(dev3.reentered);
+   CHECK(hub.totalSets == threadCount * iterations);
+   if (!perDevice)
+      CHECK(hub.maxInCalls == 1);
+}
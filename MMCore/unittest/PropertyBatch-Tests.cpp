@@ -0,0 +1,118 @@
+#include <catch2/catch_all.hpp>
+
+#include "DeviceBase.h"
+#include "MMCore.h"
+#include "MockDeviceUtils.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+// Generic device with a free-form property "A", a property "Mode" with
+// allowed values, and a read-only property "Temp".
+struct BatchDevice : CGenericBase<BatchDevice> {
+   std::string name;
+
+   explicit BatchDevice(std::string n) : name(std::move(n)) {}
+
+   int Initialize() override {
+      CreateStringProperty("A", "a0", false);
+      CreateStringProperty("Mode", "Off", false);
+      AddAllowedValue("Mode", "Off");
+      AddAllowedValue("Mode", "On");
+      CreateFloatProperty("Temp", 20.0, true);
+      return DEVICE_OK;
+   }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override { return false; }
+   void GetName(char* buf) const override {
+      CDeviceUtils::CopyLimitedString(buf, name.c_str());
+   }
+};
+
+} // namespace
+
+TEST_CASE("getProperties returns values and per-item errors",
+      "[PropertyBatch]") {
+   BatchDevice dev1("dev1");
+   BatchDevice dev2("dev2");
+   MockAdapterWithDevices adapter1{"adapter1", {{"dev1", &dev1}}};
+   MockAdapterWithDevices adapter2{"adapter2", {{"dev2", &dev2}}};
+   CMMCore c;
+   adapter1.LoadIntoCore(c);
+   adapter2.LoadIntoCore(c);
+
+   std::vector<std::string> errors;
+
+   SECTION("single device") {
+      auto values = c.getProperties("dev1", {"A", "Missing", "Temp"}, errors);
+      REQUIRE(values.size() == 3);
+      REQUIRE(errors.size() == 3);
+      CHECK(values[0] == "a0");
+      CHECK(errors[0].empty());
+      CHECK(values[1].empty());
+      CHECK_FALSE(errors[1].empty());
+      CHECK(values[2] == "20.0000");
+      CHECK(errors[2].empty());
+      CHECK(c.getPropertyFromCache("dev1", "Temp") == "20.0000");
+   }
+
+   SECTION("several devices, including the Core") {
+      auto values = c.getProperties({"dev1", "dev2", "Core", "nodev"},
+         {"A", "Mode", "TimeoutMs", "A"}, errors);
+      REQUIRE(values.size() == 4);
+      CHECK(values[0] == "a0");
+      CHECK(values[1] == "Off");
+      CHECK(values[2] == "5000");
+      CHECK(errors[0].empty());
+      CHECK(errors[1].empty());
+      CHECK(errors[2].empty());
+      CHECK_FALSE(errors[3].empty());
+   }
+
+   SECTION("mismatched sizes throw") {
+      CHECK_THROWS_AS(c.getProperties({"dev1", "dev2"}, {"A"}, errors),
+         CMMError);
+   }
+}
+
+TEST_CASE("setProperties applies valid settings and reports failures",
+      "[PropertyBatch]") {
+   BatchDevice dev1("dev1");
+   BatchDevice dev2("dev2");
+   MockAdapterWithDevices adapter1{"adapter1", {{"dev1", &dev1}}};
+   MockAdapterWithDevices adapter2{"adapter2", {{"dev2", &dev2}}};
+   CMMCore c;
+   adapter1.LoadIntoCore(c);
+   adapter2.LoadIntoCore(c);
+
+   SECTION("single device") {
+      auto errors = c.setProperties("dev1", {"Mode", "A", "Missing"},
+         {"Bad", "a1", "x"});
+      REQUIRE(errors.size() == 3);
+      CHECK_FALSE(errors[0].empty());
+      CHECK(errors[1].empty());
+      CHECK_FALSE(errors[2].empty());
+      CHECK(c.getProperty("dev1", "Mode") == "Off");
+      CHECK(c.getPropertyFromCache("dev1", "A") == "a1");
+   }
+
+   SECTION("several devices, including the Core") {
+      Configuration settings;
+      settings.addSetting(PropertySetting("dev1", "Mode", "On"));
+      settings.addSetting(PropertySetting("dev2", "A", "b1"));
+      settings.addSetting(PropertySetting("Core", "TimeoutMs", "2000"));
+      settings.addSetting(PropertySetting("nodev", "A", "x"));
+      auto errors = c.setProperties(settings);
+      REQUIRE(errors.size() == 4);
+      CHECK(errors[0].empty());
+      CHECK(errors[1].empty());
+      CHECK(errors[2].empty());
+      CHECK_FALSE(errors[3].empty());
+      CHECK(c.getProperty("dev1", "Mode") == "On");
+      CHECK(c.getProperty("dev2", "A") == "b1");
+      CHECK(c.getTimeoutMs() == 2000);
+      CHECK(c.getPropertyFromCache("dev2", "A") == "b1");
+   }
+}
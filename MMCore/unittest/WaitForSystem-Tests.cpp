@@ -0,0 +1,113 @@
+#include <catch2/catch_all.hpp>
+
+#include "DeviceBase.h"
+#include "MMCore.h"
+#include "MockDeviceUtils.h"
+
+#include <atomic>
+#include <functional>
+#include <string>
+
+namespace {
+
+// Generic device that reports busy for a given number of Busy() calls and
+// allows tests to hook into each call.
+struct PolledDevice : CGenericBase<PolledDevice> {
+   std::string name;
+   std::atomic<int> busyPollsLeft{0};
+   std::atomic<int> busyCalls{0};
+   std::function<void()> onBusy;
+
+   explicit PolledDevice(std::string n) : name(std::move(n)) {}
+
+   int Initialize() override { return DEVICE_OK; }
+   int Shutdown() override { return DEVICE_OK; }
+   bool Busy() override {
+      ++busyCalls;
+      if (onBusy)
+         onBusy();
+      return busyPollsLeft-- > 0;
+   }
+   void GetName(char* buf) const override {
+      CDeviceUtils::CopyLimitedString(buf, name.c_str());
+   }
+};
+
+} // namespace
+
+TEST_CASE("waitForSystem polls devices of different modules concurrently",
+      "[WaitForSystem]") {
+   PolledDevice dev1("dev1");
+   PolledDevice dev2("dev2");
+   MockAdapterWithDevices adapter1{"adapter1", {{"dev1", &dev1}}};
+   MockAdapterWithDevices adapter2{"adapter2", {{"dev2", &dev2}}};
+   CMMCore c;
+   adapter1.LoadIntoCore(c);
+   adapter2.LoadIntoCore(c);
+
+   Rendezvous rendezvous(2);
+   dev1.onBusy = [&] { if (dev1.busyCalls == 1) rendezvous.Arrive(); };
+   dev2.onBusy = [&] { if (dev2.busyCalls == 1) rendezvous.Arrive(); };
+
+   SECTION("waitForSystem") {
+      c.waitForSystem();
+      CHECK(rendezvous.ok);
+   }
+
+   SECTION("systemBusy") {
+      CHECK_FALSE(c.systemBusy());
+      CHECK(rendezvous.ok);
+   }
+}
+
+TEST_CASE("waitForSystem stops polling devices that became idle",
+      "[WaitForSystem]") {
+   PolledDevice dev1("dev1");
+   PolledDevice dev2("dev2");
+   PolledDevice dev3("dev3");
+   MockAdapterWithDevices adapter1{"adapter1", {{"dev1", &dev1}, {"dev2", &dev2}}};
+   MockAdapterWithDevices adapter2{"adapter2", {{"dev3", &dev3}}};
+   CMMCore c;
+   adapter1.LoadIntoCore(c);
+   adapter2.LoadIntoCore(c);
+
+   dev2.busyPollsLeft = 3;
+   dev3.busyPollsLeft = 5;
+   c.waitForSystem();
+   CHECK(dev1.busyCalls == 1);
+   CHECK(dev2.busyCalls == 4);
+   CHECK(dev3.busyCalls == 6);
+}
+
+TEST_CASE("deviceTypeBusy reports busy device in any module",
+      "[WaitForSystem]") {
+   PolledDevice dev1("dev1");
+   PolledDevice dev2("dev2");
+   MockAdapterWithDevices adapter1{"adapter1", {{"dev1", &dev1}}};
+   MockAdapterWithDevices adapter2{"adapter2", {{"dev2", &dev2}}};
+   CMMCore c;
+   adapter1.LoadIntoCore(c);
+   adapter2.LoadIntoCore(c);
+
+   dev2.busyPollsLeft = 1;
+   CHECK(c.deviceTypeBusy(MM::GenericDevice));
+   CHECK_FALSE(c.deviceTypeBusy(MM::GenericDevice));
+   CHECK_FALSE(c.deviceTypeBusy(MM::CameraDevice));
+}
+
+TEST_CASE("waitForSystem throws after waiting for all devices",
+      "[WaitForSystem]") {
+   PolledDevice dev1("dev1");
+   PolledDevice dev2("dev2");
+   MockAdapterWithDevices adapter1{"adapter1", {{"dev1", &dev1}}};
+   MockAdapterWithDevices adapter2{"adapter2", {{"dev2", &dev2}}};
+   CMMCore c;
+   adapter1.LoadIntoCore(c);
+   adapter2.LoadIntoCore(c);
+
+   dev1.busyPollsLeft = 1000000;
+   dev2.busyPollsLeft = 3;
+   c.setDeviceTimeoutMs("dev1", 20);
+   CHECK_THROWS_AS(c.waitForSystem(), CMMError);
+   CHECK(dev2.busyPollsLeft < 0);
+}
@@ -312,6 +312,58 @@
    }
 }
 
+// Raw images kept by the Core's demosaic stage are 8- or 16-bit grayscale,
+// whatever the current camera's (demosaiced) pixel type; the PixelType tag
+// of the returned metadata tells which.
+%typemap(out) void* getLastRawImageMD, void* popNextRawImageMD
+{
+   long lSize = (arg1)->getImageWidth() * (arg1)->getImageHeight();
+   bool gray16 = (arg2)->HasTag("PixelType") &&
+      (arg2)->GetSingleTag("PixelType").GetValue() == "GRAY16";
+   if (!(arg2)->HasTag("DemosaicPattern"))
+   {
+      // Not demosaiced: the raw image is the image
+      gray16 = (arg1)->getBytesPerPixel() == 2;
+      if ((arg1)->getBytesPerPixel() != 1 && !gray16)
+      {
+         jclass excep = jenv->FindClass("java/lang/Exception");
+         if (excep)
+            jenv->ThrowNew(excep, "Raw images are only supported for 8- and 16-bit grayscale cameras");
+         $result = 0;
+         return $result;
+      }
+   }
+
+   if (gray16)
+   {
+      jshortArray data = JCALL1(NewShortArray, jenv, lSize);
+      if (data == 0)
+      {
+         jclass excep = jenv->FindClass("java/lang/OutOfMemoryError");
+         if (excep)
+            jenv->ThrowNew(excep, "The system ran out of memory!");
+         $result = 0;
+         return $result;
+      }
+      JCALL4(SetShortArrayRegion, jenv, data, 0, lSize, (jshort*)result);
+      $result = data;
+   }
+   else
+   {
+      jbyteArray data = JCALL1(NewByteArray, jenv, lSize);
+      if (data == 0)
+      {
+         jclass excep = jenv->FindClass("java/lang/OutOfMemoryError");
+         if (excep)
+            jenv->ThrowNew(excep, "The system ran out of memory!");
+         $result = 0;
+         return $result;
+      }
+      JCALL4(SetByteArrayRegion, jenv, data, 0, lSize, (jbyte*)result);
+      $result = data;
+   }
+}
+
 // Java typemap
 // change default SWIG mapping of void* return values
 // to return CObject containing array of pixel values
@@ -608,6 +660,7 @@
 #include "MMDeviceConstants.h"
 #include "Error.h"
 #include "Configuration.h"
+#include "DeviceHandle.h"
 #include "ImageMetadata.h"
 #include "MMEventCallback.h"
 #include "MMCore.h"
@@ -929,6 +982,7 @@ namespace std {
 %include "MMDeviceConstants.h"
 %include "Error.h"
 %include "Configuration.h"
+%include "DeviceHandle.h"
 %include "ImageMetadata.h"
 %include "MMEventCallback.h"
 %include "MMCore.h"
@@ -25,9 +25,544 @@
 
 #include "Debayer.h"
 
+
 #include "MMDeviceConstants.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Images with fewer pixels are processed on the calling thread only
+const std::size_t minPixelsPerThread = 1 << 16;
+const unsigned maxDefaultThreads = 8;
+
+// Rows and columns this close to the image edge take the bounds-checked path
+const int margin = 2;
+
+// Parities, within each 2x2 cell of the mosaic, of the sites whose values go
+// to the red (byte 2) and blue (byte 0) components of the BGRA output.
+//
+// For orders 2 and 3 this reproduces what the original Replication and
+// Smooth-Hue implementations do, which is to swap red and blue relative to the
+// order names. All algorithms use the same convention, so that switching the
+// algorithm does not change the colors.
+struct Mosaic
+{
+   int redX;
+   int redY;
+   int blueX;
+   int blueY;
+
+   bool IsRedRow(int y) const { return ((y ^ redY) & 1) == 0; }
+   // X parity of the red or blue sites in row y
+   int ColorSiteX(int y) const { return IsRedRow(y) ? redX : blueX; }
+   int GreenSiteX(int y) const { return 1 - ColorSiteX(y); }
+   // Orders 0 and 1; the original Smooth-Hue differs at the edges otherwise
+   bool ColorSitesOnDiagonal() const { return redX == redY; }
+};
+
+Mosaic MosaicForOrder(int order)
+{
+   switch (order)
+   {
+      case 0: return Mosaic{0, 0, 1, 1};
+      case 1: return Mosaic{1, 1, 0, 0};
+      case 2: return Mosaic{0, 1, 1, 0};
+      default: return Mosaic{1, 0, 0, 1};
+   }
+}
+
+// Largest u <= v with the given parity (-1 if v is 0 and parity is odd)
+inline int FloorToParity(int v, int parity)
+{
+   return v - ((v ^ parity) & 1);
+}
+
+template <typename T>
+class BayerImage
+{
+public:
+   BayerImage(const T* pixels, int width, int height) :
+      pixels_(pixels), width_(width), height_(height)
+   {}
+
+   int Width() const { return width_; }
+   int Height() const { return height_; }
+
+   const T* Row(int y) const
+   { return pixels_ + static_cast<std::ptrdiff_t>(y) * width_; }
+
+   unsigned At(int x, int y) const { return Row(y)[x]; }
+
+   // Pixels outside of the image read as zero (as in the original algorithms)
+   unsigned AtOrZero(int x, int y) const
+   {
+      if (x < 0 || x >= width_ || y < 0 || y >= height_)
+         return 0;
+      return At(x, y);
+   }
+
+   // Coordinates outside of the image are reflected about the edge pixels,
+   // which keeps the mosaic parity
+   unsigned AtMirrored(int x, int y) const
+   { return At(Mirror(x, width_), Mirror(y, height_)); }
+
+private:
+   static int Mirror(int v, int size)
+   {
+      if (v < 0)
+         v = -v;
+      if (v >= size)
+         v = 2 * (size - 1) - v;
+      return std::min(std::max(v, 0), size - 1);
+   }
+
+   const T* pixels_;
+   int width_;
+   int height_;
+};
+
+// Writes RGB32 (BGRA) rows, scaling the components to 8 bits
+class Rgb32Writer
+{
+public:
+   Rgb32Writer(unsigned char* pixels, int width, int bitShift) :
+      pixels_(pixels), width_(width), bitShift_(bitShift), row_(pixels)
+   {}
+
+   void SetRow(int y)
+   { row_ = pixels_ + 4 * static_cast<std::ptrdiff_t>(y) * width_; }
+
+   void Put(int x, unsigned r, unsigned g, unsigned b)
+   {
+      unsigned char* p = row_ + 4 * x;
+      p[0] = static_cast<unsigned char>(b >> bitShift_);
+      p[1] = static_cast<unsigned char>(g >> bitShift_);
+      p[2] = static_cast<unsigned char>(r >> bitShift_);
+      p[3] = 0;
+   }
+
+private:
+   unsigned char* pixels_;
+   int width_;
+   int bitShift_;
+   unsigned char* row_;
+};
+
+// Writes RGB64 (BGRA, 16 bits per component) rows, keeping the input scale
+class Rgb64Writer
+{
+public:
+   Rgb64Writer(unsigned short* pixels, int width) :
+      pixels_(pixels), width_(width), row_(pixels)
+   {}
+
+   void SetRow(int y)
+   { row_ = pixels_ + 4 * static_cast<std::ptrdiff_t>(y) * width_; }
+
+   void Put(int x, unsigned r, unsigned g, unsigned b)
+   {
+      unsigned short* p = row_ + 4 * x;
+      p[0] = static_cast<unsigned short>(b);
+      p[1] = static_cast<unsigned short>(g);
+      p[2] = static_cast<unsigned short>(r);
+      p[3] = 0;
+   }
+
+private:
+   unsigned short* pixels_;
+   int width_;
+   unsigned short* row_;
+};
+
+// Each component is copied from the nearest site of its color above and to
+// the left; where there is none (first row or column) it is zero.
+class Replication
+{
+public:
+   explicit Replication(const Mosaic& mosaic) : m_(mosaic) {}
+
+   template <typename T, typename Writer>
+   void Rows(const BayerImage<T>& in, Writer w, int y0, int y1) const
+   {
+      const int width = in.Width();
+      for (int y = y0; y < y1; ++y)
+      {
+         w.SetRow(y);
+         const int redY = FloorToParity(y, m_.redY);
+         const int blueY = FloorToParity(y, m_.blueY);
+         const T* row = in.Row(y);
+         const T* redRow = redY >= 0 ? in.Row(redY) : nullptr;
+         const T* blueRow = blueY >= 0 ? in.Row(blueY) : nullptr;
+         const int greenX = m_.GreenSiteX(y);
+
+         int x = 0;
+         if (redRow && blueRow && width > 2)
+         {
+            w.Put(0, Checked(redRow, 0, m_.redX), Checked(row, 0, greenX),
+                  Checked(blueRow, 0, m_.blueX));
+            w.Put(1, redRow[1 - (1 ^ m_.redX)], row[1 - (1 ^ greenX)],
+                  blueRow[1 - (1 ^ m_.blueX)]);
+            // The source columns are at the same offsets for each pair
+            for (x = 2; x + 1 < width; x += 2)
+            {
+               w.Put(x, redRow[x - m_.redX], row[x - greenX],
+                     blueRow[x - m_.blueX]);
+               w.Put(x + 1, redRow[x + m_.redX], row[x + greenX],
+                     blueRow[x + m_.blueX]);
+            }
+         }
+         for (; x < width; ++x)
+            w.Put(x, Checked(redRow, x, m_.redX), Checked(row, x, greenX),
+                  Checked(blueRow, x, m_.blueX));
+      }
+   }
+
+private:
+   template <typename T>
+   static unsigned Checked(const T* row, int x, int siteX)
+   {
+      const int sx = FloorToParity(x, siteX);
+      return row && sx >= 0 ? row[sx] : 0;
+   }
+
+   Mosaic m_;
+};
+
+// The Smooth-Hue algorithm as originally implemented, which does not quite
+// match its name: green is the mean of the 4 nearest green sites (fewer, with
+// quirks, at the top and left edges), and red and blue are the site value at
+// their own sites and otherwise the raw pixel value scaled by the fraction of
+// nonzero same-color sites among the 2 or 4 nearest. Pixels outside of the
+// image read as zero. Results are kept identical to the original.
+class SmoothHue
+{
+public:
+   explicit SmoothHue(const Mosaic& mosaic) : m_(mosaic) {}
+
+   template <typename T, typename Writer>
+   void Rows(const BayerImage<T>& in, Writer w, int y0, int y1) const
+   {
+      const int width = in.Width();
+      const int height = in.Height();
+      for (int y = y0; y < y1; ++y)
+      {
+         w.SetRow(y);
+         const bool interiorRow = y >= margin && y < height - margin;
+         const int x0 = interiorRow ? std::min(margin, width) : width;
+         const int x1 = interiorRow ? std::max(x0, width - margin) : width;
+         for (int x = 0; x < x0; ++x)
+            Pixel<true>(in, x, x & 1, y, w);
+         // Interior pairs of columns, starting at an even one (the margin),
+         // with the column parity known at compile time
+         int x = x0;
+         for (; x + 1 < x1; x += 2)
+         {
+            Pixel<false>(in, x, 0, y, w);
+            Pixel<false>(in, x + 1, 1, y, w);
+         }
+         for (; x < width; ++x)
+            Pixel<true>(in, x, x & 1, y, w);
+      }
+   }
+
+private:
+   template <bool Checked, typename T>
+   static unsigned Read(const BayerImage<T>& in, int x, int y)
+   { return Checked ? in.AtOrZero(x, y) : in.At(x, y); }
+
+   // odd is x & 1
+   template <bool Checked, typename T, typename Writer>
+   void Pixel(const BayerImage<T>& in, int x, int odd, int y, Writer& w) const
+   {
+      w.Put(x, Color<Checked>(in, m_.redX, m_.redY, x, odd, y),
+            Green<Checked>(in, x, odd, y),
+            Color<Checked>(in, m_.blueX, m_.blueY, x, odd, y));
+   }
+
+   template <bool Checked, typename T>
+   unsigned Green(const BayerImage<T>& in, int x, int odd, int y) const
+   {
+      if (Checked && x == 0 && y == 0)
+         return (Read<true>(in, 0, 1) + Read<true>(in, 1, 0)) / 2;
+      if (odd == m_.GreenSiteX(y))
+         return Read<Checked>(in, x, y);
+      if (Checked && x == 0)
+      {
+         if (!m_.ColorSitesOnDiagonal() || in.Width() < 2)
+            return 0;
+         return (Read<true>(in, 1, y) + Read<true>(in, 2, y - 1) +
+               Read<true>(in, 0, y + 1)) / 3;
+      }
+      const unsigned sum = Read<Checked>(in, x - 1, y) +
+         Read<Checked>(in, x + 1, y) + Read<Checked>(in, x, y + 1);
+      if (Checked && (y == 0 || (m_.ColorSitesOnDiagonal() && x == 1)))
+         return sum / 3;
+      return (sum + Read<Checked>(in, x, y - 1)) / 4;
+   }
+
+   template <bool Checked, typename T>
+   static unsigned Color(const BayerImage<T>& in, int siteX, int siteY,
+         int x, int odd, int y)
+   {
+      const int dx = (odd ^ siteX) & 1;
+      const int sx = x - dx;
+      const int sy = FloorToParity(y, siteY);
+      if (Checked && (sx < 0 || sy < 0))
+         return 0;
+      const unsigned site = Read<Checked>(in, sx, sy);
+      if (dx == 0 && sy == y)
+         return site;
+      unsigned nonzero = site != 0;
+      const unsigned value = Read<Checked>(in, x, y);
+      if (sy == y)
+         return value * (nonzero + (Read<Checked>(in, sx + 2, sy) != 0)) / 2;
+      if (dx == 0)
+         return value * (nonzero + (Read<Checked>(in, sx, sy + 2) != 0)) / 2;
+      nonzero += (Read<Checked>(in, sx + 2, sy) != 0) +
+         (Read<Checked>(in, sx, sy + 2) != 0) +
+         (Read<Checked>(in, sx + 2, sy + 2) != 0);
+      return value * nonzero / 4;
+   }
+
+   Mosaic m_;
+};
+
+// Kernels for Interpolation, evaluated at column x of the middle one of 5
+// rows. Cross() is green at a red or blue site; Diagonal() is blue at a red
+// site (or vice versa); Horizontal() and Vertical() are the color whose
+// sites are the left/right and upper/lower neighbors of a green site.
+
+struct BilinearKernels
+{
+   template <typename T>
+   static unsigned Cross(const T* const* p, int x, unsigned)
+   { return (p[1][x] + p[3][x] + p[2][x - 1] + p[2][x + 1] + 2) / 4; }
+
+   template <typename T>
+   static unsigned Diagonal(const T* const* p, int x, unsigned)
+   { return (p[1][x - 1] + p[1][x + 1] + p[3][x - 1] + p[3][x + 1] + 2) / 4; }
+
+   template <typename T>
+   static unsigned Horizontal(const T* const* p, int x, unsigned)
+   { return (p[2][x - 1] + p[2][x + 1] + 1) / 2; }
+
+   template <typename T>
+   static unsigned Vertical(const T* const* p, int x, unsigned)
+   { return (p[1][x] + p[3][x] + 1) / 2; }
+};
+
+// Malvar, He and Cutler, "High-quality linear interpolation for demosaicing
+// of Bayer-patterned color images" (ICASSP 2004): bilinear interpolation
+// corrected by the Laplacian of the site's own color. The 5x5 filters are
+// scaled by 16 to use integer arithmetic.
+struct MalvarKernels
+{
+   static unsigned Normalize(int sum, unsigned maxValue)
+   {
+      if (sum <= 0)
+         return 0;
+      return std::min(maxValue, static_cast<unsigned>(sum + 8) >> 4);
+   }
+
+   template <typename T>
+   static unsigned Cross(const T* const* p, int x, unsigned maxValue)
+   {
+      const int sum = 8 * p[2][x] +
+         4 * (p[1][x] + p[3][x] + p[2][x - 1] + p[2][x + 1]) -
+         2 * (p[0][x] + p[4][x] + p[2][x - 2] + p[2][x + 2]);
+      return Normalize(sum, maxValue);
+   }
+
+   template <typename T>
+   static unsigned Diagonal(const T* const* p, int x, unsigned maxValue)
+   {
+      const int sum = 12 * p[2][x] +
+         4 * (p[1][x - 1] + p[1][x + 1] + p[3][x - 1] + p[3][x + 1]) -
+         3 * (p[0][x] + p[4][x] + p[2][x - 2] + p[2][x + 2]);
+      return Normalize(sum, maxValue);
+   }
+
+   template <typename T>
+   static unsigned Horizontal(const T* const* p, int x, unsigned maxValue)
+   {
+      const int sum = 10 * p[2][x] + 8 * (p[2][x - 1] + p[2][x + 1]) -
+         2 * (p[2][x - 2] + p[2][x + 2] +
+               p[1][x - 1] + p[1][x + 1] + p[3][x - 1] + p[3][x + 1]) +
+         p[0][x] + p[4][x];
+      return Normalize(sum, maxValue);
+   }
+
+   template <typename T>
+   static unsigned Vertical(const T* const* p, int x, unsigned maxValue)
+   {
+      const int sum = 10 * p[2][x] + 8 * (p[1][x] + p[3][x]) -
+         2 * (p[0][x] + p[4][x] +
+               p[1][x - 1] + p[1][x + 1] + p[3][x - 1] + p[3][x + 1]) +
+         p[2][x - 2] + p[2][x + 2];
+      return Normalize(sum, maxValue);
+   }
+};
+
+// Linear interpolation with the given kernels. Interior rows are processed
+// two pixels (a red or blue site and a green site) at a time, without bounds
+// checks; pixels near the edges read a mirrored 5x5 neighborhood.
+template <typename Kernels>
+class Interpolation
+{
+public:
+   Interpolation(const Mosaic& mosaic, unsigned maxValue) :
+      m_(mosaic), maxValue_(maxValue)
+   {}
+
+   template <typename T, typename Writer>
+   void Rows(const BayerImage<T>& in, Writer w, int y0, int y1) const
+   {
+      const int width = in.Width();
+      const int height = in.Height();
+      for (int y = y0; y < y1; ++y)
+      {
+         w.SetRow(y);
+         const bool interiorRow = y >= margin && y < height - margin;
+         const int x0 = interiorRow ? std::min(margin, width) : width;
+         const int x1 = interiorRow ? std::max(x0, width - margin) : width;
+         for (int x = 0; x < x0; ++x)
+            BorderPixel(in, x, y, w);
+         if (x0 < x1)
+         {
+            const T* rows[5];
+            for (int i = 0; i < 5; ++i)
+               rows[i] = in.Row(y - margin + i);
+            if (m_.IsRedRow(y))
+               InteriorRow<true>(rows, x0, x1, m_.redX, w);
+            else
+               InteriorRow<false>(rows, x0, x1, m_.blueX, w);
+         }
+         for (int x = x1; x < width; ++x)
+            BorderPixel(in, x, y, w);
+      }
+   }
+
+private:
+   template <bool RedRow, typename T, typename Writer>
+   void InteriorRow(const T* const* rows, int x0, int x1, int siteX,
+         Writer& w) const
+   {
+      int x = x0;
+      if (((x ^ siteX) & 1) != 0)
+      {
+         GreenSite<RedRow>(rows, x, x, w);
+         ++x;
+      }
+      for (; x + 1 < x1; x += 2)
+      {
+         ColorSite<RedRow>(rows, x, x, w);
+         GreenSite<RedRow>(rows, x + 1, x + 1, w);
+      }
+      if (x < x1)
+         ColorSite<RedRow>(rows, x, x, w);
+   }
+
+   template <typename T, typename Writer>
+   void BorderPixel(const BayerImage<T>& in, int x, int y, Writer& w) const
+   {
+      T patch[5][5];
+      for (int dy = 0; dy < 5; ++dy)
+         for (int dx = 0; dx < 5; ++dx)
+            patch[dy][dx] = static_cast<T>(
+                  in.AtMirrored(x + dx - margin, y + dy - margin));
+      const T* rows[5] = { patch[0], patch[1], patch[2], patch[3], patch[4] };
+
+      const bool colorSite = ((x ^ m_.ColorSiteX(y)) & 1) == 0;
+      if (m_.IsRedRow(y))
+      {
+         if (colorSite)
+            ColorSite<true>(rows, margin, x, w);
+         else
+            GreenSite<true>(rows, margin, x, w);
+      }
+      else
+      {
+         if (colorSite)
+            ColorSite<false>(rows, margin, x, w);
+         else
+            GreenSite<false>(rows, margin, x, w);
+      }
+   }
+
+   template <bool RedRow, typename T, typename Writer>
+   void ColorSite(const T* const* p, int x, int outX, Writer& w) const
+   {
+      const unsigned site = std::min<unsigned>(p[2][x], maxValue_);
+      const unsigned other = Kernels::Diagonal(p, x, maxValue_);
+      const unsigned green = Kernels::Cross(p, x, maxValue_);
+      w.Put(outX, RedRow ? site : other, green, RedRow ? other : site);
+   }
+
+   template <bool RedRow, typename T, typename Writer>
+   void GreenSite(const T* const* p, int x, int outX, Writer& w) const
+   {
+      const unsigned green = std::min<unsigned>(p[2][x], maxValue_);
+      const unsigned horizontal = Kernels::Horizontal(p, x, maxValue_);
+      const unsigned vertical = Kernels::Vertical(p, x, maxValue_);
+      w.Put(outX, RedRow ? horizontal : vertical, green,
+            RedRow ? vertical : horizontal);
+   }
+
+   Mosaic m_;
+   unsigned maxValue_;
+};
+
+// Splits the image into bands of rows, processed in parallel
+template <typename Algorithm, typename T, typename Writer>
+void ProcessBands(const Algorithm& algorithm, const BayerImage<T>& in,
+      const Writer& writer, int maxThreads)
+{
+   const unsigned height = static_cast<unsigned>(in.Height());
+   const std::size_t nrPixels = static_cast<std::size_t>(in.Width()) * height;
+   unsigned nThreads = static_cast<unsigned>(std::max(1, maxThreads));
+   nThreads = static_cast<unsigned>(std::min<std::size_t>(nThreads,
+         std::max<std::size_t>(1, nrPixels / minPixelsPerThread)));
+   nThreads = std::min(nThreads, height);
+
+   auto process = [&](unsigned firstRow, unsigned endRow)
+   {
+      algorithm.Rows(in, writer, static_cast<int>(firstRow),
+            static_cast<int>(endRow));
+   };
+
+   std::vector<std::thread> workers;
+   const unsigned rowsPerThread = (height + nThreads - 1) / nThreads;
+   for (unsigned t = 1; t < nThreads; ++t)
+   {
+      const unsigned firstRow = t * rowsPerThread;
+      const unsigned endRow = std::min(height, firstRow + rowsPerThread);
+      if (firstRow < endRow)
+         workers.emplace_back(process, firstRow, endRow);
+   }
+   process(0, std::min(height, rowsPerThread));
+   for (std::thread& worker : workers)
+      worker.join();
+}
+
+template <typename Algorithm, typename T>
+void Run(const Algorithm& algorithm, const BayerImage<T>& in, unsigned char* out,
+      bool rgb64, int bitShift, int maxThreads)
+{
+   if (rgb64)
+      ProcessBands(algorithm, in, Rgb64Writer(
+               reinterpret_cast<unsigned short*>(out), in.Width()),
+            maxThreads);
+   else
+      ProcessBands(algorithm, in,
+            Rgb32Writer(out, in.Width(), bitShift), maxThreads);
+}
+
+} // namespace
 
 ///////////////////////////////////////////////////////////////////////////////
 // Debayer class implementation
@@ -45,10 +580,14 @@ Debayer::Debayer()
    algorithms.push_back("Bilinear");
    algorithms.push_back("Smooth-Hue");
    algorithms.push_back("Adaptive-Smooth-Hue");
+   algorithms.push_back("Malvar-He-Cutler");
 
    // default settings
    orderIndex = 0; // RGRG ordering
    algoIndex = 0;  // replication - faster
+   rgb64Output = false;
+   maxThreads = static_cast<int>(std::min(std::max(1u,
+         std::thread::hardware_concurrency()), maxDefaultThreads));
 }
 
 Debayer::~Debayer()
@@ -57,8 +596,6 @@ Debayer::~Debayer()
 
 int Debayer::Process(ImgBuffer& out, const ImgBuffer& input, int bitDepth)
 {
-   assert(sizeof(int) == 4);
-
    int byteDepth = input.Depth();
    if (bitDepth > byteDepth * 8)
    {
@@ -66,7 +603,6 @@ int Debayer::Process(ImgBuffer& out, const ImgBuffer& input, int bitDepth)
       return DEVICE_INVALID_INPUT_PARAM;
    }
 
-   out.Resize(input.Width(), input.Height(), 4);
    if (input.Depth() == 1)
    {
       const unsigned char* inBuf = input.GetPixels();
@@ -88,482 +624,53 @@ int Debayer::Process(ImgBuffer& out, const unsigned char* in, int width, int hei
 int Debayer::Process(ImgBuffer& out, const unsigned short* in, int width, int height, int bitDepth)
 { return ProcessT(out, in, width, height, bitDepth); }
 
-template <typename T>
-int Debayer::ProcessT(ImgBuffer& out, const T* in, int width, int height, int bitDepth)
-{
-   assert(sizeof(int) == 4);
-   out.Resize(width, height, 4);
-   int* outBuf = reinterpret_cast<int*>(out.GetPixelsRW());
-   return Convert(in, outBuf, width, height, bitDepth, orderIndex, algoIndex);
-}
-
-template<typename T>
-int Debayer::Convert(const T* input, int* output, int width, int height, int bitDepth, int rowOrder, int algorithm)
-{				
-	if (algorithm == 0)
-      ReplicateDecode(input, output, width, height, bitDepth, rowOrder);
-	else if (algorithm == 1)
-      return DEVICE_NOT_SUPPORTED;
-	else if (algorithm == 2)
-      SmoothDecode(input, output, width, height, bitDepth, rowOrder);
-	else if (algorithm == 3)
-      return DEVICE_NOT_SUPPORTED;
-   else
-      return DEVICE_NOT_SUPPORTED;
-
-
-   return DEVICE_OK;
-}
-
-unsigned short Debayer::GetPixel(const unsigned short* v, int x, int y, int width, int height)
-{
-   if (x >= width || x < 0 || y >= height || y < 0)
-      return 0;
-   else
-      return v[y*width + x];
-}
-
-void Debayer::SetPixel(std::vector<unsigned short>& v, unsigned short val, int x, int y, int width, int height)
-{
-   if (x < width && x >= 0 && y < height && y >= 0)
-      v[y*width + x] = val;
-}
+int Debayer::Process(unsigned char* out, const unsigned char* in, int width, int height, int bitDepth)
+{ return ProcessT(out, in, width, height, bitDepth); }
 
-unsigned short Debayer::GetPixel(const unsigned char* v, int x, int y, int width, int height)
-{
-   if (x >= width || x < 0 || y >= height || y < 0)
-      return 0;
-   else
-      return v[y*width + x];
-}
+int Debayer::Process(unsigned char* out, const unsigned short* in, int width, int height, int bitDepth)
+{ return ProcessT(out, in, width, height, bitDepth); }
 
-// Replication algorithm
 template <typename T>
-void Debayer::ReplicateDecode(const T* input, int* output, int width, int height, int bitDepth, int rowOrder)
+int Debayer::ProcessT(ImgBuffer& out, const T* in, int width, int height, int bitDepth)
 {
-   unsigned numPixels(width*height);
-   if (r.size() != numPixels)
-   {
-      r.resize(numPixels);
-      g.resize(numPixels);
-      b.resize(numPixels);
-   }
-
-   int bitShift = bitDepth - 8;
-	
-	if (rowOrder == 0 || rowOrder == 1) {
-		for (int y=0; y<height; y+=2) {
-			for (int x=0; x<width; x+=2) {
-				unsigned short one = GetPixel(input, x, y, width, height);
-				SetPixel(b, one, x, y, width, height);
-				SetPixel(b, one, x+1, y, width, height);
-				SetPixel(b, one, x, y+1, width, height); 
-				SetPixel(b, one, x+1, y+1, width, height);
-			}
-		}
-		
-		for (int y=1; y<height; y+=2) {
-			for (int x=1; x<width; x+=2) {
-            unsigned short one = GetPixel(input, x, y, width, height);
-				SetPixel(r, one, x, y, width, height);
-				SetPixel(r, one, x+1, y, width, height);
-				SetPixel(r, one, x, y+1, width, height); 
-				SetPixel(r, one, x+1, y+1, width, height);
-			}
-		}
-		
-		for (int y=0; y<height; y+=2) {
-			for (int x=1; x<width; x+=2) {
-				unsigned short one = GetPixel(input, x, y, width, height);
-            SetPixel(g, one, x, y, width, height);
-            SetPixel(g, one, x+1, y, width, height);
-			}
-		}	
-			
-		for (int y=1; y<height; y+=2) {
-			for (int x=0; x<width; x+=2) {
-            unsigned short one = GetPixel(input, x, y, width, height);
-            SetPixel(g, one, x, y, width, height);
-            SetPixel(g, one, x+1, y, width, height);
-			}
-		}	
-		
-		if (rowOrder == 0) {
-         for (int i=0; i<height*width; i++)
-         {
-            output[i] = 0;
-            unsigned char* bytePix = (unsigned char*)(output+i);
-            *bytePix = (unsigned char)(r[i] >> bitShift);
-            *(bytePix+1) = (unsigned char)(g[i] >> bitShift);
-            *(bytePix+2) = (unsigned char)(b[i] >> bitShift);
-
-			   //rgb.addSlice("red",b);	
-			   //rgb.addSlice("green",g);
-			   //rgb.addSlice("blue",r);
-         }
-		}
-		else if (rowOrder == 1) {
-         for (int i=0; i<height*width; i++)
-         {
-            output[i] = 0;
-            unsigned char* bytePix = (unsigned char*)(output+i);
-            *bytePix = (unsigned char)(b[i] >> bitShift);
-            *(bytePix+1) = (unsigned char)(g[i] >> bitShift);
-            *(bytePix+2) = (unsigned char)(r[i] >> bitShift);
-
-			   //rgb.addSlice("red",r);	
-			   //rgb.addSlice("green",g);
-			   //rgb.addSlice("blue",b);			
-		   }
-      }
-	}
-
-	else if (rowOrder == 2 || rowOrder == 3) {
-		for (int y=1; y<height; y+=2) {
-			for (int x=0; x<width; x+=2) {
-				unsigned short one = GetPixel(input, x, y, width, height);
-				SetPixel(b, one, x, y, width, height);
-				SetPixel(b, one, x+1, y, width, height);
-				SetPixel(b, one, x, y+1, width, height); 
-				SetPixel(b, one, x+1, y+1, width, height);
-			}
-		}
-		
-		for (int y=0; y<height; y+=2) {
-			for (int x=1; x<width; x+=2) {
-            unsigned short one = GetPixel(input, x, y, width, height);
-				SetPixel(r, one, x, y, width, height);
-				SetPixel(r, one, x+1, y, width, height);
-				SetPixel(r, one, x, y+1, width, height); 
-				SetPixel(r, one, x+1, y+1, width, height);
-			}
-		}
-		
-		for (int y=0; y<height; y+=2) {
-			for (int x=0; x<width; x+=2) {
-				unsigned short one = GetPixel(input, x, y, width, height);
-            SetPixel(g, one, x, y, width, height);
-            SetPixel(g, one, x+1, y, width, height);
-			}
-		}	
-			
-		for (int y=1; y<height; y+=2) {
-			for (int x=1; x<width; x+=2) {
-            unsigned short one = GetPixel(input, x, y, width, height);
-            SetPixel(g, one, x, y, width, height);
-            SetPixel(g, one, x+1, y, width, height);
-			}
-		}	
-		
-		if (rowOrder == 2) {
-         for (int i=0; i<height*width; i++)
-         {
-            output[i] = 0;
-            unsigned char* bytePix = (unsigned char*)(output+i);
-            *bytePix = (unsigned char)(r[i] >> bitShift);
-            *(bytePix+1) = (unsigned char)(g[i] >> bitShift);
-            *(bytePix+2) = (unsigned char)(b[i] >> bitShift);
-
-            //rgb.addSlice("red",b);	
-			   //rgb.addSlice("green",g);
-			   //rgb.addSlice("blue",r);
-         }
-		}
-		else if (rowOrder == 3) {
-         for (int i=0; i<height*width; i++)
-         {
-            output[i] = 0;
-            unsigned char* bytePix = (unsigned char*)(output+i);
-            *bytePix = (unsigned char)(b[i] >> bitShift);
-            *(bytePix+1) = (unsigned char)(g[i] >> bitShift);
-            *(bytePix+2) = (unsigned char)(r[i] >> bitShift);
-
-            //rgb.addSlice("red",r);	
-			   //rgb.addSlice("green",g);
-			   //rgb.addSlice("blue",b);
-         }
-		}
-	}
+   const bool rgb64 = rgb64Output && sizeof(T) == 2;
+   out.Resize(width, height, rgb64 ? 8 : 4);
+   return ProcessT(out.GetPixelsRW(), in, width, height, bitDepth);
 }
 
-// Smooth Hue algorithm
 template <typename T>
-void Debayer::SmoothDecode(const T* input, int* output, int width, int height, int bitDepth, int rowOrder)
+int Debayer::ProcessT(unsigned char* out, const T* in, int width, int height, int bitDepth)
 {
-   double G1 = 0;
-   double G2 = 0;
-   double G3 = 0;
-   double G4 = 0;
-   double G5 = 0;
-   double G6 = 0;
-   //double G7 = 0;
-   //double G8 = 0;
-   double G9 = 0;
-   double B1 = 0;
-   double B2 = 0;
-   double B3 = 0;
-   double B4 = 0;
-   double R1 = 0;
-   double R2 = 0;
-   double R3 = 0;
-   double R4 = 0;
-
-   unsigned numPixels(width*height);
-   if (r.size() != numPixels)
-   {
-      r.resize(numPixels);
-      g.resize(numPixels);
-      b.resize(numPixels);
-   }
-
-   int bitShift = bitDepth - 8;
-
-   if (rowOrder == 0 || rowOrder == 1) {
-      //Solve for green pixels first
-      for (int y=0; y<height; y+=2) {
-         for (int x=1; x<width; x+=2) {
-            G1 = GetPixel(input, x, y, width, height);
-            G2 = GetPixel(input, x+2, y, width, height);
-            G3 = GetPixel(input, x+1, y+1, width, height);
-            G4 = GetPixel(input, x+1, y-1, width, height);
-
-            SetPixel(g, (unsigned short)G1, x, y, width, height);
-            if (y==0)
-               SetPixel(g, (unsigned short)((G1+G2+G3)/3.0), x+1, y, width, height);
-            else
-               SetPixel(g, (unsigned short)((G1+G2+G3+G4)/4.0), x+1, y, width, height);
-
-            if (x==1)
-               SetPixel(g, (unsigned short)((G1 + G4 + GetPixel(input, x-1, y+1, width, height))/3.0), x-1, y, width, height);
-         }
-      }	
-
-      for (int x=0; x<width; x+=2) {	
-         for (int y=1; y<height; y+=2) {
-
-            G1 = GetPixel(input, x, y, width, height);
-            G2 = GetPixel(input, x+2, y, width, height);
-            G3 = GetPixel(input, x+1, y+1, width, height);
-            G4 = GetPixel(input, x+1, y-1, width, height);
-
-            SetPixel(g, (unsigned short)G1, x, y, width, height);
-            if (x==0)
-               SetPixel(g, (unsigned short)((G1+G2+G3)/3.0), x+1, y, width, height);
-            else
-               SetPixel(g, (unsigned short)((G1+G2+G3+G4)/4.0), x+1, y, width, height);
-         }
-      }	
-
-      SetPixel(g, (unsigned short)((GetPixel(input, 0, 1, width, height) + GetPixel(input, 1, 0, width, height))/2.0), 0, 0, width, height);
-
-      for (int y=0; y<height; y+=2) {
-         for (int x=0; x<width; x+=2) {
-            B1 = GetPixel(input, x, y, width, height);
-            B2 = GetPixel(input, x+2, y, width, height);
-            B3 = GetPixel(input, x, y+2, width, height);
-            B4 = GetPixel(input, x+2, y+2, width, height);
-            G1 = GetPixel(input, x, y, width, height);
-            G2 = GetPixel(input, x+2, y, width, height);
-            G3 = GetPixel(input, x, y+2, width, height);
-            G4 = GetPixel(input, x+2, y+2, width, height);;
-            G5 = GetPixel(input, x+1, y, width, height);
-            G6 = GetPixel(input, x, y+1, width, height);
-            G9 = GetPixel(input, x+1, y+1, width, height);
-            if (G1==0) G1=1;
-            if (G2==0) G2=1;
-            if (G3==0) G3=1;
-            if (G4==0) G4=1;
-
-            SetPixel(b, (unsigned short)B1, x, y, width, height);
-            //b.putPixel(x+1,y,(int)((G5/2 * ((B1/G1) + (B2/G2)) )) );
-            SetPixel(b, (unsigned short)((G5/2 * ((B1/G1) + (B2/G2)) )), x+1, y, width, height);
-            //b.putPixel(x,y+1,(int)(( G6/2 * ((B1/G1) + (B3/G3)) )) );
-            SetPixel(b, (unsigned short)((G6/2 * ((B1/G1) + (B3/G3)) )), x, y+1, width, height);
-            //b.putPixel(x+1,y+1, (int)((G9/4 *  ((B1/G1) + (B3/G3) + (B2/G2) + (B4/G4)) )) );
-            SetPixel(b, (unsigned short)((G9/4 * ((B1/G1) + (B3/G3) + (B2/G2) + (B4/G4)) )), x+1, y+1, width, height);
-         }
-      }
-
-      for (int y=1; y<height; y+=2) {
-         for (int x=1; x<width; x+=2) {
-            R1 = GetPixel(input, x, y, width, height);
-            R2 = GetPixel(input, x+2, y, width, height);
-            R3 = GetPixel(input, x, y+2, width, height);
-            R4 = GetPixel(input, x+2, y+2, width, height);
-            G1 = GetPixel(input, x, y, width, height);
-            G2 = GetPixel(input, x+2, y, width, height);
-            G3 = GetPixel(input, x, y+2, width, height);
-            G4 = GetPixel(input, x+2, y+2, width, height);
-            G5 = GetPixel(input, x+1, y, width, height);
-            G6 = GetPixel(input, x, y+1, width, height);
-            G9 = GetPixel(input, x+1, y+1, width, height);
-            if(G1==0) G1=1;
-            if(G2==0) G2=1;
-            if(G3==0) G3=1;
-            if(G4==0) G4=1;
-
-            //r.putPixel(x,y,(int)(R1));
-            SetPixel(r, (unsigned short)R1, x, y, width, height);
-            //r.putPixel(x+1,y,(int)((G5/2 * ((R1/G1) + (R2/G2) )) ));
-            SetPixel(r, (unsigned short)((G5/2 * ((R1/G1) + (R2/G2) )) ), x+1, y, width, height);
-            //r.putPixel(x,y+1,(int)(( G6/2 * ((R1/G1) + (R3/G3) )) ));
-            SetPixel(r, (unsigned short)(( G6/2 * ((R1/G1) + (R3/G3) )) ), x, y+1, width, height);
-            //r.putPixel(x+1,y+1, (int)((G9/4 *  ((R1/G1) + (R3/G3) + (R2/G2) + (R4/G4)) ) ));
-            SetPixel(r, (unsigned short)((G9/4 *  ((R1/G1) + (R3/G3) + (R2/G2) + (R4/G4)) ) ), x+1, y+1, width, height);
-         }
-      }
-
-
-      if (rowOrder == 0) {
-         for (int i=0; i<height*width; i++)
-         {
-            output[i] = 0;
-            unsigned char* bytePix = (unsigned char*)(output+i);
-            *bytePix = (unsigned char)(r[i] >> bitShift);
-            *(bytePix+1) = (unsigned char)(g[i] >> bitShift);
-            *(bytePix+2) = (unsigned char)(b[i] >> bitShift);
-
-            //rgb.addSlice("red",b);	
-            //rgb.addSlice("green",g);
-            //rgb.addSlice("blue",r);
-         }
-      }
-      else if (rowOrder == 1) {
-         for (int i=0; i<height*width; i++)
-         {
-            output[i] = 0;
-            unsigned char* bytePix = (unsigned char*)(output+i);
-            *bytePix = (unsigned char)(b[i] >> bitShift);
-            *(bytePix+1) = (unsigned char)(g[i] >> bitShift);
-            *(bytePix+2) = (unsigned char)(r[i] >> bitShift);
-
-            //rgb.addSlice("red",r);	
-            //rgb.addSlice("green",g);
-            //rgb.addSlice("blue",b);			
-         }
-      }
-   }
-
-   else if (rowOrder == 2 || rowOrder == 3) {
-
-      for (int y=0; y<height; y+=2) {
-         for (int x=0; x<width; x+=2) {
-            G1 = GetPixel(input, x, y, width, height);
-            G2 = GetPixel(input, x+2, y, width, height);
-            G3 = GetPixel(input, x+1, y+1, width, height);
-            G4 = GetPixel(input, x+1, y-1, width, height);
-
-            SetPixel(g, (unsigned short)G1, x, y, width, height);
-            if (y==0)
-               SetPixel(g, (unsigned short)((G1+G2+G3)/3.0), x+1, y, width, height);
-            else
-               SetPixel(g, (unsigned short)((G1+G2+G3+G4)/4.0), x+1, y, width, height);
-
-            if (x==1)
-               SetPixel(g, (unsigned short)((G1+G4+GetPixel(input, x-1, y+1, width, height))/3.0), x-1, y, width, height);
-         }
-      }	
-
-      for (int y=1; y<height; y+=2) {
-         for (int x=1; x<width; x+=2) {
-            G1 = GetPixel(input, x, y, width, height);
-            G2 = GetPixel(input, x+2, y, width, height);
-            G3 = GetPixel(input, x+1, y+1, width, height);
-            G4 = GetPixel(input, x+1, y-1, width, height);
-
-            SetPixel(g, (unsigned short)G1, x, y, width, height);
-            if (x==0)
-               SetPixel(g, (unsigned short)((G1+G2+G3)/3.0), x+1, y, width, height);
-            else
-               SetPixel(g, (unsigned short)((G1+G2+G3+G4)/4.0), x+1, y, width, height);
-         }
-      }
-
-      SetPixel(g, (unsigned short)((GetPixel(input, 0, 1, width, height) + GetPixel(input, 1, 0, width, height))/2.0), 0, 0, width, height);
-
-      for (int y=1; y<height; y+=2) {
-         for (int x=0; x<width; x+=2) {
-            B1 = GetPixel(input, x, y, width, height);
-            B2 = GetPixel(input, x+2, y, width, height);
-            B3 = GetPixel(input, x, y+2, width, height);
-            B4 = GetPixel(input, x+2, y+2, width, height);
-            G1 = GetPixel(input, x, y, width, height);
-            G2 = GetPixel(input, x+2, y, width, height);
-            G3 = GetPixel(input, x, y+2, width, height);
-            G4 = GetPixel(input, x+2, y+2, width, height);;
-            G5 = GetPixel(input, x+1, y, width, height);
-            G6 = GetPixel(input, x, y+1, width, height);
-            G9 = GetPixel(input, x+1, y+1, width, height);
-            if (G1==0) G1=1;
-            if (G2==0) G2=1;
-            if (G3==0) G3=1;
-            if (G4==0) G4=1;
-
-            SetPixel(b, (unsigned short)B1, x, y, width, height);
-            SetPixel(b, (unsigned short)((G5/2 * ((B1/G1) + (B2/G2)) )), x+1, y, width, height);
-            SetPixel(b, (unsigned short)((G6/2 * ((B1/G1) + (B3/G3)) )), x, y+1, width, height);
-            SetPixel(b, (unsigned short)((G9/4 * ((B1/G1) + (B3/G3) + (B2/G2) + (B4/G4)) )), x+1, y+1, width, height);
-         }
-      }
-
-      for (int y=0; y<height; y+=2) {
-         for (int x=1; x<width; x+=2) {
-            R1 = GetPixel(input, x, y, width, height);
-            R2 = GetPixel(input, x+2, y, width, height);
-            R3 = GetPixel(input, x, y+2, width, height);
-            R4 = GetPixel(input, x+2, y+2, width, height);
-            G1 = GetPixel(input, x, y, width, height);
-            G2 = GetPixel(input, x+2, y, width, height);
-            G3 = GetPixel(input, x, y+2, width, height);
-            G4 = GetPixel(input, x+2, y+2, width, height);
-            G5 = GetPixel(input, x+1, y, width, height);
-            G6 = GetPixel(input, x, y+1, width, height);
-            G9 = GetPixel(input, x+1, y+1, width, height);
-            if(G1==0) G1=1;
-            if(G2==0) G2=1;
-            if(G3==0) G3=1;
-            if(G4==0) G4=1;
-
-            //r.putPixel(x,y,(int)(R1));
-            SetPixel(r, (unsigned short)R1, x, y, width, height);
-            //r.putPixel(x+1,y,(int)((G5/2 * ((R1/G1) + (R2/G2) )) ));
-            SetPixel(r, (unsigned short)((G5/2 * ((R1/G1) + (R2/G2) )) ), x+1, y, width, height);
-            //r.putPixel(x,y+1,(int)(( G6/2 * ((R1/G1) + (R3/G3) )) ));
-            SetPixel(r, (unsigned short)(( G6/2 * ((R1/G1) + (R3/G3) )) ), x, y+1, width, height);
-            //r.putPixel(x+1,y+1, (int)((G9/4 *  ((R1/G1) + (R3/G3) + (R2/G2) + (R4/G4)) ) ));
-            SetPixel(r, (unsigned short)((G9/4 *  ((R1/G1) + (R3/G3) + (R2/G2) + (R4/G4)) ) ), x+1, y+1, width, height);
-         }
-      }
-
+   const bool rgb64 = rgb64Output && sizeof(T) == 2;
+   if (orderIndex < 0 || orderIndex >= static_cast<int>(orders.size()))
+      return DEVICE_INVALID_INPUT_PARAM;
+   if (width <= 0 || height <= 0)
+      return DEVICE_OK;
 
+   const BayerImage<T> image(in, width, height);
+   const Mosaic mosaic = MosaicForOrder(orderIndex);
+   const int bitShift = std::max(0, bitDepth - 8);
+   unsigned maxValue = (1u << (8 * sizeof(T))) - 1;
+   if (bitDepth > 0 && bitDepth < static_cast<int>(8 * sizeof(T)))
+      maxValue = (1u << bitDepth) - 1;
 
-      if (rowOrder == 2) {
-         for (int i=0; i<height*width; i++)
-         {
-            output[i] = 0;
-            unsigned char* bytePix = (unsigned char*)(output+i);
-            *bytePix = (unsigned char)(r[i] >> bitShift);
-            *(bytePix+1) = (unsigned char)(g[i] >> bitShift);
-            *(bytePix+2) = (unsigned char)(b[i] >> bitShift);
-
-            //rgb.addSlice("red",b);	
-            //rgb.addSlice("green",g);
-            //rgb.addSlice("blue",r);
-         }
-      }
-      else if (rowOrder == 3) {
-         for (int i=0; i<height*width; i++)
-         {
-            output[i] = 0;
-            unsigned char* bytePix = (unsigned char*)(output+i);
-            *bytePix = (unsigned char)(b[i] >> bitShift);
-            *(bytePix+1) = (unsigned char)(g[i] >> bitShift);
-            *(bytePix+2) = (unsigned char)(r[i] >> bitShift);
-
-            //rgb.addSlice("red",r);	
-            //rgb.addSlice("green",g);
-            //rgb.addSlice("blue",b);			
-         }
-      }
+   switch (algoIndex)
+   {
+      case 0:
+         Run(Replication(mosaic), image, out, rgb64, bitShift, maxThreads);
+         return DEVICE_OK;
+      case 1:
+         Run(Interpolation<BilinearKernels>(mosaic, maxValue), image, out,
+               rgb64, bitShift, maxThreads);
+         return DEVICE_OK;
+      case 2:
+         Run(SmoothHue(mosaic), image, out, rgb64, bitShift, maxThreads);
+         return DEVICE_OK;
+      case 4:
+         Run(Interpolation<MalvarKernels>(mosaic, maxValue), image, out,
+               rgb64, bitShift, maxThreads);
+         return DEVICE_OK;
+      default: // Including Adaptive-Smooth-Hue, which is not implemented
+         return DEVICE_NOT_SUPPORTED;
    }
 }
@@ -34,6 +34,10 @@
  *
  * Based on the Debayer_Image plugin for ImageJ, by Jennifer West, University
  * of Manitoba.
+ *
+ * The output is RGB32, or RGB64 for 16-bit input if enabled. Large images are
+ * processed in bands of rows on multiple threads. Replication and Smooth-Hue
+ * produce the same results as the original (single-threaded) implementation.
  */
 class Debayer
 {
@@ -45,32 +49,48 @@ public:
    int Process(ImgBuffer& out, const unsigned char* in, int width, int height, int bitDepth);
    int Process(ImgBuffer& out, const unsigned short* in, int width, int height, int bitDepth);
 
+   /**
+    * @brief Process into caller-provided memory.
+    *
+    * out must hold width * height pixels of 4 bytes (RGB32), or 8 bytes
+    * (RGB64) for 16-bit input if SetRGB64Output() is enabled.
+    */
+   int Process(unsigned char* out, const unsigned char* in, int width, int height, int bitDepth);
+   int Process(unsigned char* out, const unsigned short* in, int width, int height, int bitDepth);
+
    const std::vector<std::string> GetOrders() const {return orders;}
    const std::vector<std::string> GetAlgorithms() const {return algorithms;}
 
    void SetOrderIndex(int idx) {orderIndex = idx;}
    void SetAlgorithmIndex(int idx) {algoIndex = idx;}
 
+   /**
+    * @brief Produce RGB64 output (16 bits per component) from 16-bit input.
+    *
+    * The components keep the scale of the input instead of being shifted to
+    * 8 bits. 8-bit input always produces RGB32. Off by default.
+    */
+   void SetRGB64Output(bool enable) {rgb64Output = enable;}
+
+   /**
+    * @brief Set the maximum number of threads used to process an image.
+    *
+    * The default is the number of cores, up to 8. Fewer threads are used for
+    * small images.
+    */
+   void SetMaxThreads(int n) {maxThreads = n < 1 ? 1 : n;}
+
 private:
    template <typename T>
    int ProcessT(ImgBuffer& out, const T* in, int width, int height, int bitDepth);
-   template<typename T>
-   void ReplicateDecode(const T* input, int* out, int width, int height, int bitDepth, int rowOrder);
    template <typename T>
-   void SmoothDecode(const T* input, int* output, int width, int height, int bitDepth, int rowOrder);
-   template<typename T>
-   int Convert(const T* input, int* output, int width, int height, int bitDepth, int rowOrder, int algorithm);
-   unsigned short GetPixel(const unsigned short* v, int x, int y, int width, int height);
-   void SetPixel(std::vector<unsigned short>& v, unsigned short val, int x, int y, int width, int height);
-   unsigned short GetPixel(const unsigned char* v, int x, int y, int width, int height);
-
-   std::vector<unsigned short> r; // red scratch buffer
-   std::vector<unsigned short> g; // green scratch buffer
-   std::vector<unsigned short> b; // blue scratch buffer
+   int ProcessT(unsigned char* out, const T* in, int width, int height, int bitDepth);
 
    std::vector<std::string> orders;
    std::vector<std::string> algorithms;
 
    int orderIndex;
    int algoIndex;
+   bool rgb64Output;
+   int maxThreads;
 };
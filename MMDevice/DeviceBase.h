@@ -28,6 +28,7 @@
 #include "CameraImageMetadata.h"
 #include "DeviceThreads.h"
 #include "DeviceUtils.h"
+#include "ImgBuffer.h"
 #include "MMDeviceConstants.h"
 #include "ModuleInterface.h"
 #include "Property.h"
@@ -35,6 +36,8 @@
 #include <math.h>
 #include <assert.h>
 
+#include <condition_variable>
+#include <deque>
 #include <string>
 #include <vector>
 #include <iomanip>
@@ -182,6 +185,17 @@ public:
     */
    virtual bool UsesDelay() {return usesDelay_;}
 
+   /**
+    * @brief Return true when your device adapter calls OnBusyChanged().
+    *
+    * Default is to let the calling code poll Busy().
+    */
+   virtual int UsesOnBusyChanged(bool& result) const
+   {
+      result = false;
+      return DEVICE_OK;
+   }
+
    /**
     * @brief Return the number of properties.
     */
@@ -554,6 +568,72 @@ public:
       return ret;
    }
 
+   /**
+    * @brief Obtain the value of a Float or Integer property as a number.
+    *
+    * Unless the device has called EnableDirectNumericPropertyAccess(), this
+    * returns DEVICE_INVALID_PROPERTY_TYPE so that the value is obtained
+    * through GetProperty(). Otherwise, returns DEVICE_INVALID_PROPERTY_TYPE
+    * for String properties.
+    */
+   virtual int GetPropertyDouble(const char* name, double& value) const
+   {
+      if (!directNumericPropertyAccess_)
+         return DEVICE_INVALID_PROPERTY_TYPE;
+      int ret = properties_.Get(name, value);
+      if (ret != DEVICE_OK)
+         SetMorePropertyErrorInfo(name);
+      return ret;
+   }
+
+   /**
+    * @brief Set the value of a Float or Integer property from a number.
+    *
+    * Unless the device has called EnableDirectNumericPropertyAccess(), this
+    * returns DEVICE_INVALID_PROPERTY_TYPE so that the value is set through
+    * SetProperty(). Otherwise, returns DEVICE_INVALID_PROPERTY_TYPE for
+    * String properties and for properties with discrete allowed values.
+    */
+   virtual int SetPropertyDouble(const char* name, double value)
+   {
+      if (!directNumericPropertyAccess_)
+         return DEVICE_INVALID_PROPERTY_TYPE;
+      int ret = properties_.Set(name, value);
+      if (ret != DEVICE_OK)
+         SetMorePropertyErrorInfo(name);
+      return ret;
+   }
+
+   /**
+    * @brief Obtain the value of a Float or Integer property as a number.
+    *
+    * See GetPropertyDouble().
+    */
+   virtual int GetPropertyLong(const char* name, long& value) const
+   {
+      if (!directNumericPropertyAccess_)
+         return DEVICE_INVALID_PROPERTY_TYPE;
+      int ret = properties_.Get(name, value);
+      if (ret != DEVICE_OK)
+         SetMorePropertyErrorInfo(name);
+      return ret;
+   }
+
+   /**
+    * @brief Set the value of a Float or Integer property from a number.
+    *
+    * See SetPropertyDouble().
+    */
+   virtual int SetPropertyLong(const char* name, long value)
+   {
+      if (!directNumericPropertyAccess_)
+         return DEVICE_INVALID_PROPERTY_TYPE;
+      int ret = properties_.Set(name, value);
+      if (ret != DEVICE_OK)
+         SetMorePropertyErrorInfo(name);
+      return ret;
+   }
+
    /**
     * @brief Check if device supports a given property.
     */
@@ -847,7 +927,8 @@ public:
 
 protected:
 
-   CDeviceBase() : delayMs_(0), usesDelay_(false), callback_(0)
+   CDeviceBase() : delayMs_(0), usesDelay_(false),
+      directNumericPropertyAccess_(false), callback_(0)
    {
       InitializeDefaultErrorMessages();
    }
@@ -1138,6 +1219,22 @@ protected:
       return DEVICE_NO_CALLBACK_REGISTERED;
    }
 
+   /**
+    * @brief Report that the device became busy or idle.
+    *
+    * Devices that know when an operation finishes (e.g. from a hardware
+    * event or a completion reply) can call this with busy == false at that
+    * point, and override UsesOnBusyChanged() to return true, so that the
+    * Core does not need to poll Busy() while waiting. Busy() must already
+    * return the new state when this is called.
+    */
+   int OnBusyChanged(bool busy)
+   {
+      if (callback_)
+         return callback_->OnBusyChanged(this, busy);
+      return DEVICE_NO_CALLBACK_REGISTERED;
+   }
+
    /**
     * @brief Report position change (for single-axis stage).
     *
@@ -1255,6 +1352,20 @@ protected:
       usesDelay_ = state;
    }
 
+   /**
+    * @brief Let numeric property access bypass GetProperty()/SetProperty().
+    *
+    * By default, the Core gets and sets Float and Integer properties as
+    * strings, through GetProperty() and SetProperty(). A device that does not
+    * override those functions (or whose overrides need not see every access)
+    * can call this, usually in its constructor, so that numeric values are
+    * read from and written to its properties directly.
+    */
+   void EnableDirectNumericPropertyAccess(bool state = true)
+   {
+      directNumericPropertyAccess_ = state;
+   }
+
    /**
     * @brief Create read-only property displaying parentID (hub label).
     *
@@ -1344,6 +1455,7 @@ private:
    std::map<int, std::string> messages_;
    double delayMs_;
    bool usesDelay_;
+   bool directNumericPropertyAccess_;
    MM::Core* callback_;
    // specific information about the errant property, etc.
    mutable std::string morePropertyErrorInfo_;
@@ -1580,6 +1692,10 @@ private:
  * Newer camera device adapters should inherit from CCameraBase.
  * This class contains suboptimal methods for implementing sequence acquisition
  * using a series of snaps.
+ *
+ * Optionally (see UsesPipelinedSequence()), the series of snaps is pipelined:
+ * the exposure and readout of each frame overlap with the insertion of the
+ * previous frame into the core.
  */
 template <class U>
 class CLegacyCameraBase : public CCameraBase<U>
@@ -1592,7 +1708,7 @@ public:
 
    virtual ~CLegacyCameraBase()
    {
-      if (!thd_->IsStopped()) {
+      if (!thd_->IsFinished()) {
          thd_->Stop();
          thd_->wait();
       }
@@ -1617,7 +1733,9 @@ public:
     */
    virtual int StopSequenceAcquisition()
    {
-      if (!thd_->IsStopped()) {
+      // The thread sets its stop flag itself when the sequence ends, before
+      // calling OnThreadExiting(), so wait unless it has finished
+      if (!thd_->IsFinished()) {
          thd_->Stop();
          thd_->wait();
       }
@@ -1642,7 +1760,9 @@ public:
       return DEVICE_OK;
    }
 
-   virtual bool IsCapturing(){return !thd_->IsStopped();}
+   // Remains true until the thread has called OnThreadExiting(), so that
+   // the core is not destroyed while the thread still calls back into it
+   virtual bool IsCapturing(){return !thd_->IsFinished();}
 
 
 protected:
@@ -1701,6 +1821,41 @@ protected:
    virtual bool isStopOnOverflow() {return stopWhenCBOverflows_;}
    virtual void setStopOnOverflow(bool stop) {stopWhenCBOverflows_ = stop;}
 
+   // Pipelined sequence acquisition. If UsesPipelinedSequence() returns true
+   // (checked when each sequence starts), the sequence thread captures frames
+   // with StartExposure() and RetrieveFrame() into a small pool of buffers,
+   // while a second thread inserts the captured frames, in order, with
+   // InsertFrame(). ThreadRun() and InsertImage() are not called in this
+   // mode. Capture stops when the pool is full, so a slow consumer still
+   // paces the camera.
+   virtual bool UsesPipelinedSequence() {return false;}
+
+   // Begin the exposure of the next frame. May return as soon as the
+   // exposure has started. The default snaps a complete image.
+   virtual int StartExposure() {return this->SnapImage();}
+
+   // Wait for the frame started by the last StartExposure() and copy it into
+   // frame (resizing it as needed). The default copies the snapped image.
+   virtual int RetrieveFrame(ImgBuffer& frame)
+   {
+      frame.Resize(this->GetImageWidth(), this->GetImageHeight(),
+         this->GetImageBytesPerPixel());
+      frame.SetPixels(this->GetImageBuffer());
+      return DEVICE_OK;
+   }
+
+   // Insert a retrieved frame into the core. Called on the insertion thread,
+   // concurrently with StartExposure() and RetrieveFrame() for later frames.
+   virtual int InsertFrame(const ImgBuffer& frame)
+   {
+      char label[MM::MaxStrLength];
+      this->GetLabel(label);
+      MM::CameraImageMetadata md;
+      md.AddTag(MM::g_Keyword_Metadata_CameraLabel, label);
+      return this->GetCoreCallback()->InsertImage(this, frame.GetPixels(),
+         frame.Width(), frame.Height(), frame.Depth(), md.Serialize());
+   }
+
    ////////////////////////////////////////////////////////////////////////////
    // Helper Class
    class CaptureRestartHelper
@@ -1727,11 +1882,13 @@ protected:
    {
       friend class CLegacyCameraBase;
       enum { default_numImages=1 };
+      enum { pipelineDepth=3 }; // Frame buffers in pipelined mode
    public:
       BaseSequenceThread(CLegacyCameraBase* pCam)
          :numImages_(default_numImages)
          ,imageCounter_(0)
          ,stop_(true)
+         ,finished_(true)
          ,suspend_(false)
          ,camera_(pCam)
          ,startTime_(0)
@@ -1753,6 +1910,7 @@ protected:
          numImages_=numImages;
          imageCounter_=0;
          stop_ = false;
+         finished_ = false;
          suspend_=false;
          activate();
          actualDuration_ = MM::MMTime{};
@@ -1763,6 +1921,10 @@ protected:
          MMThreadGuard g(this->stopLock_);
          return stop_;
       }
+      bool IsFinished(){
+         MMThreadGuard g(this->stopLock_);
+         return finished_;
+      }
       void Suspend() {
          MMThreadGuard g(this->suspendLock_);
          suspend_ = true;
@@ -1792,25 +1954,132 @@ protected:
          int ret=DEVICE_ERR;
          try
          {
-            do
+            if (camera_->UsesPipelinedSequence())
             {
-               ret=camera_->ThreadRun();
-            } while (DEVICE_OK == ret && !IsStopped() && imageCounter_++ < numImages_-1);
+               ret = RunPipelined();
+            }
+            else
+            {
+               do
+               {
+                  ret=camera_->ThreadRun();
+               } while (DEVICE_OK == ret && !IsStopped() && imageCounter_++ < numImages_-1);
+            }
             if (IsStopped())
                camera_->LogMessage("SeqAcquisition interrupted by the user\n");
 
          }catch(...){
             camera_->LogMessage(g_Msg_EXCEPTION_IN_THREAD, false);
          }
-         stop_=true;
+         Stop();
          UpdateActualDuration();
          camera_->OnThreadExiting();
+         MMThreadGuard g(this->stopLock_);
+         finished_ = true;
          return ret;
       }
+
+      // Capture frames on this thread and insert them on another, passing
+      // them through a pool of pipelineDepth buffers.
+      int RunPipelined()
+      {
+         std::vector<ImgBuffer> pool(pipelineDepth);
+         std::deque<ImgBuffer*> freeFrames;
+         std::deque<ImgBuffer*> capturedFrames;
+         for (ImgBuffer& frame : pool)
+            freeFrames.push_back(&frame);
+         std::mutex mutex;
+         std::condition_variable cv;
+         bool captureDone = false;
+         int insertRet = DEVICE_OK;
+
+         std::thread inserter([&]
+         {
+            for (;;)
+            {
+               ImgBuffer* frame;
+               {
+                  std::unique_lock<std::mutex> lock(mutex);
+                  cv.wait(lock, [&] { return !capturedFrames.empty() || captureDone; });
+                  if (capturedFrames.empty())
+                     return;
+                  frame = capturedFrames.front();
+                  capturedFrames.pop_front();
+               }
+               int ret = DEVICE_ERR;
+               try
+               {
+                  ret = camera_->InsertFrame(*frame);
+               }
+               catch (...)
+               {
+                  camera_->LogMessage(g_Msg_EXCEPTION_IN_THREAD, false);
+               }
+               {
+                  std::lock_guard<std::mutex> lock(mutex);
+                  freeFrames.push_back(frame);
+                  insertRet = ret;
+               }
+               cv.notify_all();
+               if (ret != DEVICE_OK)
+                  return;
+            }
+         });
+
+         auto finishInserting = [&]
+         {
+            {
+               std::lock_guard<std::mutex> lock(mutex);
+               captureDone = true;
+            }
+            cv.notify_all();
+            inserter.join();
+         };
+
+         int ret = DEVICE_OK;
+         try
+         {
+            while (!IsStopped())
+            {
+               ImgBuffer* frame;
+               {
+                  std::unique_lock<std::mutex> lock(mutex);
+                  cv.wait(lock, [&] { return !freeFrames.empty() || insertRet != DEVICE_OK; });
+                  if (insertRet != DEVICE_OK)
+                     break;
+                  frame = freeFrames.front();
+                  freeFrames.pop_front();
+               }
+               ret = camera_->StartExposure();
+               if (ret == DEVICE_OK)
+                  ret = camera_->RetrieveFrame(*frame);
+               {
+                  std::lock_guard<std::mutex> lock(mutex);
+                  if (ret != DEVICE_OK)
+                  {
+                     freeFrames.push_back(frame);
+                     break;
+                  }
+                  capturedFrames.push_back(frame);
+               }
+               cv.notify_all();
+               if (imageCounter_++ >= numImages_-1)
+                  break;
+            }
+         }
+         catch (...)
+         {
+            finishInserting();
+            throw;
+         }
+         finishInserting();
+         return ret != DEVICE_OK ? ret : insertRet;
+      }
    private:
       long numImages_;
       long imageCounter_;
       bool stop_;
+      bool finished_;
       bool suspend_;
       CLegacyCameraBase* camera_;
       MM::MMTime startTime_;
@@ -20,35 +20,216 @@
 ///////////////////////////////////////////////////////////////////////////////
 #include "ImgBuffer.h"
 
-#include <cassert>
+#include <cstdint>
 #include <cstring>
+#include <new>
+#include <utility>
+
+
+constexpr std::size_t ImgBuffer::Alignment;
+
+ImgBufferPool::ImgBufferPool(std::size_t maxRetainedBytes) :
+   maxRetainedBytes_(maxRetainedBytes),
+   retainedBytes_(0)
+{
+}
+
+ImgBufferPool::~ImgBufferPool()
+{
+   Clear();
+}
+
+std::size_t ImgBufferPool::GetRetainedBytes() const
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   return retainedBytes_;
+}
+
+void ImgBufferPool::Clear()
+{
+   std::multimap<std::size_t, Block> blocks;
+   {
+      std::lock_guard<std::mutex> lock(mutex_);
+      blocks.swap(blocks_);
+      retainedBytes_ = 0;
+   }
+   for (const auto& entry : blocks)
+      Free(entry.second);
+}
+
+ImgBufferPool::Block ImgBufferPool::Allocate(std::size_t bytes)
+{
+   Block block;
+   block.storage = new unsigned char[bytes + ImgBuffer::Alignment - 1];
+   const std::size_t misalignment =
+      reinterpret_cast<std::uintptr_t>(block.storage) % ImgBuffer::Alignment;
+   block.pixels = block.storage +
+      (misalignment ? ImgBuffer::Alignment - misalignment : 0);
+   block.capacity = bytes;
+   return block;
+}
+
+void ImgBufferPool::Free(const Block& block)
+{
+   delete[] block.storage;
+}
+
+ImgBufferPool::Block ImgBufferPool::Acquire(std::size_t bytes)
+{
+   {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = blocks_.lower_bound(bytes);
+      // Don't hand out a much larger block than requested
+      if (it != blocks_.end() && it->first / 2 <= bytes)
+      {
+         const Block block = it->second;
+         blocks_.erase(it);
+         retainedBytes_ -= block.capacity;
+         return block;
+      }
+   }
+   return Allocate(bytes);
+}
+
+void ImgBufferPool::Release(const Block& block)
+{
+   {
+      std::lock_guard<std::mutex> lock(mutex_);
+      // Must not throw: called from the destructor and move assignment of
+      // ImgBuffer. If the pool cannot grow, the block is freed instead.
+      if (retainedBytes_ + block.capacity <= maxRetainedBytes_)
+      {
+         try
+         {
+            blocks_.insert(std::make_pair(block.capacity, block));
+            retainedBytes_ += block.capacity;
+            return;
+         }
+         catch (const std::bad_alloc&)
+         {
+         }
+      }
+   }
+   Free(block);
+}
 
 
 ImgBuffer::ImgBuffer(unsigned xSize, unsigned ySize, unsigned pixDepth) :
-   pixels_(0), width_(xSize), height_(ySize), pixDepth_(pixDepth)
+   storage_(0), pixels_(0), capacity_(0),
+   width_(xSize), height_(ySize), pixDepth_(pixDepth)
 {
-   pixels_ = new unsigned char[xSize * ySize * pixDepth];
-   assert(pixels_);
-   std::memset(pixels_, 0, xSize * ySize * pixDepth);
+   Reserve(Size());
+   ResetPixels();
 }
 
 ImgBuffer::ImgBuffer() :
+   storage_(0),
    pixels_(0),
+   capacity_(0),
    width_(0),
    height_(0),
    pixDepth_(0)
 {
 }
 
-ImgBuffer::ImgBuffer(const ImgBuffer& right)                
+ImgBuffer::ImgBuffer(std::shared_ptr<ImgBufferPool> pool) :
+   storage_(0),
+   pixels_(0),
+   capacity_(0),
+   width_(0),
+   height_(0),
+   pixDepth_(0),
+   pool_(std::move(pool))
 {
-   pixels_ = 0;
-   *this = right;
+}
+
+ImgBuffer::ImgBuffer(const ImgBuffer& right) :
+   storage_(0),
+   pixels_(0),
+   capacity_(0),
+   width_(0),
+   height_(0),
+   pixDepth_(0),
+   pool_(right.pool_)
+{
+   Copy(right);
+}
+
+// Like copying, moving does not transfer the name
+ImgBuffer::ImgBuffer(ImgBuffer&& right) noexcept :
+   storage_(right.storage_),
+   pixels_(right.pixels_),
+   capacity_(right.capacity_),
+   width_(right.width_),
+   height_(right.height_),
+   pixDepth_(right.pixDepth_),
+   pool_(right.pool_)
+{
+   right.storage_ = 0;
+   right.pixels_ = 0;
+   right.capacity_ = 0;
+   right.width_ = right.height_ = right.pixDepth_ = 0;
 }
 
 ImgBuffer::~ImgBuffer()
 {
-   delete[] pixels_;
+   Release();
+}
+
+std::size_t ImgBuffer::Size() const
+{
+   return static_cast<std::size_t>(width_) * height_ * pixDepth_;
+}
+
+void ImgBuffer::Reserve(std::size_t bytes)
+{
+   if (bytes <= capacity_)
+      return;
+
+   Release();
+   const ImgBufferPool::Block block = pool_ ?
+      pool_->Acquire(bytes) : ImgBufferPool::Allocate(bytes);
+   storage_ = block.storage;
+   pixels_ = block.pixels;
+   capacity_ = block.capacity;
+}
+
+void ImgBuffer::Release()
+{
+   if (!storage_)
+      return;
+
+   ImgBufferPool::Block block;
+   block.storage = storage_;
+   block.pixels = pixels_;
+   block.capacity = capacity_;
+   if (pool_)
+      pool_->Release(block);
+   else
+      ImgBufferPool::Free(block);
+
+   storage_ = 0;
+   pixels_ = 0;
+   capacity_ = 0;
+}
+
+void ImgBuffer::ShrinkToFit()
+{
+   const std::size_t size = Size();
+   if (size == capacity_)
+      return;
+   if (size == 0)
+   {
+      Release();
+      return;
+   }
+
+   const ImgBufferPool::Block block = ImgBufferPool::Allocate(size);
+   std::memcpy(block.pixels, pixels_, size);
+   Release();
+   storage_ = block.storage;
+   pixels_ = block.pixels;
+   capacity_ = block.capacity;
 }
 
 const unsigned char* ImgBuffer::GetPixels() const
@@ -63,13 +244,21 @@ unsigned char* ImgBuffer::GetPixelsRW()
 
 void ImgBuffer::SetPixels(const void* pix)
 {
-   std::memcpy((void*)pixels_, pix, width_ * height_ * pixDepth_);
+   const std::size_t size = Size();
+   if (size > 0)
+      std::memcpy(pixels_, pix, size);
 }
 
 // Set pixels, from a source that has extra bytes at the end of each scanline
 // (row).
 void ImgBuffer::SetPixelsPadded(const void* pixArray, int paddingBytesPerLine)
 {
+   if (paddingBytesPerLine == 0)
+   {
+      SetPixels(pixArray);
+      return;
+   }
+
    const char* src = reinterpret_cast<const char*>(pixArray);
    char* dst = reinterpret_cast<char*>(pixels_);
    const size_t lineSize = width_ * pixDepth_;
@@ -85,7 +274,7 @@ void ImgBuffer::SetPixelsPadded(const void* pixArray, int paddingBytesPerLine)
 void ImgBuffer::ResetPixels()
 {
    if (pixels_)
-      std::memset(pixels_, 0, width_ * height_ * pixDepth_);
+      std::memset(pixels_, 0, Size());
 }
 
 bool ImgBuffer::Compatible(const ImgBuffer& img) const
@@ -98,15 +287,10 @@ bool ImgBuffer::Compatible(const ImgBuffer& img) const
    return true;
 }
 
+// The pixels are kept if the storage is big enough, and undefined otherwise
 void ImgBuffer::Resize(unsigned xSize, unsigned ySize, unsigned pixDepth)
 {
-   // re-allocate internal buffer if it is not big enough
-   if (width_ * height_ * pixDepth_ < xSize * ySize * pixDepth)
-   {
-      delete[] pixels_;
-      pixels_ = new unsigned char [xSize * ySize * pixDepth];
-      assert(pixels_);
-   }
+   Reserve(static_cast<std::size_t>(xSize) * ySize * pixDepth);
 
    width_ = xSize;
    height_ = ySize;
@@ -115,17 +299,12 @@ void ImgBuffer::Resize(unsigned xSize, unsigned ySize, unsigned pixDepth)
 
 void ImgBuffer::Resize(unsigned xSize, unsigned ySize)
 {
-   // re-allocate internal buffer if it is not big enough
-   if (width_ * height_ < xSize * ySize)
-   {
-      delete[] pixels_;
-      pixels_ = new unsigned char[xSize * ySize * pixDepth_];
-   }
+   Reserve(static_cast<std::size_t>(xSize) * ySize * pixDepth_);
 
    width_ = xSize;
    height_ = ySize;
 
-   std::memset(pixels_, 0, width_ * height_ * pixDepth_);
+   ResetPixels();
 }
 
 void ImgBuffer::Copy(const ImgBuffer& right)
@@ -133,7 +312,7 @@ void ImgBuffer::Copy(const ImgBuffer& right)
    if (!Compatible(right))
       Resize(right.width_, right.height_, right.pixDepth_);
 
-   SetPixels((void*)right.GetPixels());
+   SetPixels(right.GetPixels());
 }
 
 ImgBuffer& ImgBuffer::operator=(const ImgBuffer& img)
@@ -141,15 +320,30 @@ ImgBuffer& ImgBuffer::operator=(const ImgBuffer& img)
    if(this == &img)
       return *this;
 
-   if (pixels_)
-      delete[] pixels_;
+   Copy(img);
 
-   width_ = img.Width();
-   height_ = img.Height();
-   pixDepth_ = img.Depth();
-   pixels_ = new unsigned char[width_ * height_ * pixDepth_];
+   return *this;
+}
 
-   Copy(img);
+// Keeps the pool of this buffer; the storage of any pool can be returned to
+// any other
+ImgBuffer& ImgBuffer::operator=(ImgBuffer&& img) noexcept
+{
+   if(this == &img)
+      return *this;
+
+   Release();
+   storage_ = img.storage_;
+   pixels_ = img.pixels_;
+   capacity_ = img.capacity_;
+   width_ = img.width_;
+   height_ = img.height_;
+   pixDepth_ = img.pixDepth_;
+
+   img.storage_ = 0;
+   img.pixels_ = 0;
+   img.capacity_ = 0;
+   img.width_ = img.height_ = img.pixDepth_ = 0;
 
    return *this;
 }
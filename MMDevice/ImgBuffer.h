@@ -21,15 +21,85 @@
 
 #pragma once
 
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 
 
+/**
+ * @brief Free pixel blocks shared by several ImgBuffers.
+ *
+ * Buffers that use a pool return their storage to it when they grow or are
+ * destroyed, and take storage from it before allocating. Thread safe.
+ */
+class ImgBufferPool
+{
+public:
+   /**
+    * @brief Create a pool that keeps at most maxRetainedBytes of free blocks.
+    */
+   explicit ImgBufferPool(std::size_t maxRetainedBytes = 256 * 1024 * 1024);
+   ~ImgBufferPool();
+
+   ImgBufferPool(const ImgBufferPool&) = delete;
+   ImgBufferPool& operator=(const ImgBufferPool&) = delete;
+
+   std::size_t GetRetainedBytes() const;
+   std::size_t GetMaxRetainedBytes() const { return maxRetainedBytes_; }
+
+   /**
+    * @brief Free all blocks held by the pool.
+    */
+   void Clear();
+
+private:
+   friend class ImgBuffer;
+
+   struct Block
+   {
+      unsigned char* storage; // As allocated
+      unsigned char* pixels; // Aligned
+      std::size_t capacity;
+   };
+
+   static Block Allocate(std::size_t bytes);
+   static void Free(const Block& block);
+
+   // Returns a pooled block of at least the given size (but not much
+   // larger), or a new one
+   Block Acquire(std::size_t bytes);
+   // Keeps the block, unless the pool is full
+   void Release(const Block& block);
+
+   const std::size_t maxRetainedBytes_;
+   mutable std::mutex mutex_;
+   std::multimap<std::size_t, Block> blocks_;
+   std::size_t retainedBytes_;
+};
+
+
+/**
+ * @brief Pixel buffer of an image.
+ *
+ * The pixels are aligned to ImgBuffer::Alignment bytes. The storage is kept
+ * when the image is resized to a size that fits in it; use ShrinkToFit() to
+ * free the rest.
+ */
 class ImgBuffer
 {
 public:
+   static constexpr std::size_t Alignment = 64;
+
    ImgBuffer(unsigned xSize, unsigned ySize, unsigned pixDepth);
    ImgBuffer(const ImgBuffer& ib);
+   ImgBuffer(ImgBuffer&& ib) noexcept;
    ImgBuffer();
+   /**
+    * @brief Create an empty buffer that takes its storage from the pool.
+    */
+   explicit ImgBuffer(std::shared_ptr<ImgBufferPool> pool);
    ~ImgBuffer();
 
    unsigned int Width() const {return width_;}
@@ -45,16 +115,43 @@ public:
    void Resize(unsigned xSize, unsigned ySize);
    bool Compatible(const ImgBuffer& img) const;
 
+   /**
+    * @brief Size of the storage, in bytes.
+    */
+   std::size_t Capacity() const {return capacity_;}
+   /**
+    * @brief Release the storage not needed for the current size.
+    */
+   void ShrinkToFit();
+
+   /**
+    * @brief Use the pool (or none, if null) for further allocations.
+    *
+    * The current storage is kept, and returned to the new pool when no
+    * longer needed.
+    */
+   void SetPool(std::shared_ptr<ImgBufferPool> pool) {pool_ = pool;}
+   const std::shared_ptr<ImgBufferPool>& GetPool() const {return pool_;}
+
    void SetName(const char* name) {name_ = name;}
    const std::string& GetName() {return name_;}
 
    void Copy(const ImgBuffer& rhs);
    ImgBuffer& operator=(const ImgBuffer& rhs);
+   ImgBuffer& operator=(ImgBuffer&& rhs) noexcept;
 
 private:
+   std::size_t Size() const;
+   // Makes room for bytes, discarding the pixels if reallocating
+   void Reserve(std::size_t bytes);
+   void Release();
+
+   unsigned char* storage_;
    unsigned char* pixels_;
+   std::size_t capacity_;
    unsigned int width_;
    unsigned int height_;
    unsigned int pixDepth_;
    std::string name_;
+   std::shared_ptr<ImgBufferPool> pool_;
 };
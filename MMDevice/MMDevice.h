@@ -26,7 +26,7 @@
 
 // Device Interface Version — see README.md for the full versioning policy.
 // Must be incremented for any binary-incompatible change.
-#define DEVICE_INTERFACE_VERSION 75
+#define DEVICE_INTERFACE_VERSION 78
 
 // N.B. Method parameters and return values in Device and its derived
 // classes must be POD types or pointers (no std::string, etc.) to
@@ -197,6 +197,20 @@ namespace MM {
       virtual unsigned GetNumberOfProperties() const = 0;
       virtual int GetProperty(const char* name, char* value) const = 0;
       virtual int SetProperty(const char* name, const char* value) = 0;
+      /**
+       * @brief Numeric access to Float and Integer properties.
+       *
+       * These avoid formatting and parsing strings for properties whose value
+       * is a number. They return DEVICE_INVALID_PROPERTY_TYPE if the property
+       * cannot be accessed this way (String properties, and for setting,
+       * properties with discrete allowed values) or if the device requires
+       * all access to go through GetProperty()/SetProperty(), in which case
+       * the caller should fall back to those.
+       */
+      virtual int GetPropertyDouble(const char* name, double& value) const = 0;
+      virtual int SetPropertyDouble(const char* name, double value) = 0;
+      virtual int GetPropertyLong(const char* name, long& value) const = 0;
+      virtual int SetPropertyLong(const char* name, long value) = 0;
       virtual bool HasProperty(const char* name) const = 0;
       virtual bool GetPropertyName(unsigned idx, char* name) const = 0;
       virtual int GetPropertyReadOnly(const char* name, bool& readOnly) const = 0;
@@ -246,6 +260,17 @@ namespace MM {
 
       virtual bool GetErrorText(int errorCode, char* errMessage) const = 0;
       virtual bool Busy() = 0;
+      /**
+       * @brief Devices can use the OnBusyChanged callback to signal that
+       * they became busy or idle, so that the Core can wait for them
+       * without polling Busy().
+       *
+       * Devices returning true must call OnBusyChanged(false) (or the Core
+       * callback of the same name) whenever Busy() switches to false. The
+       * Core still calls Busy() to confirm the state. The result should not
+       * change over the lifetime of the device.
+       */
+      virtual int UsesOnBusyChanged(bool& result) const = 0;
       virtual double GetDelayMs() const = 0;
       virtual void SetDelayMs(double delay) = 0;
       virtual bool UsesDelay() = 0;
@@ -1679,6 +1704,12 @@ namespace MM {
        * @brief Signal that the shutter opened or closed.
        */
       virtual int OnShutterOpenChanged(const Device* caller, bool open) = 0;
+      /**
+       * @brief Signal that the device became busy or idle.
+       *
+       * @see CDeviceBase::OnBusyChanged()
+       */
+      virtual int OnBusyChanged(const Device* caller, bool busy) = 0;
 
       // Deprecated: Return value overflows in ~72 minutes on Windows.
       // Prefer std::chrono::steady_clock for time delta measurements.
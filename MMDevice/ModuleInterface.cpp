@@ -39,6 +39,13 @@ MM::internal::RegisteredDeviceCollection& TheRegisteredDeviceCollection()
    return devices;
 }
 
+// Whether EnablePerDeviceLocking() has been called
+bool& ThePerDeviceLockingFlag()
+{
+   static bool perDeviceLocking = false;
+   return perDeviceLocking;
+}
+
 } // anonymous namespace
 
 
@@ -72,9 +79,19 @@ MODULE_API bool GetDeviceDescription(const char* deviceName, char* description,
    return TheRegisteredDeviceCollection().GetDeviceDescription(deviceName, description, bufLen);
 }
 
+MODULE_API bool GetPerDeviceLocking()
+{
+   return ThePerDeviceLockingFlag();
+}
+
 void RegisterDevice(const char* deviceName, MM::DeviceType deviceType, const char* deviceDescription)
 {
    TheRegisteredDeviceCollection().RegisterDevice(deviceName, deviceType, deviceDescription);
 }
 
+void EnablePerDeviceLocking()
+{
+   ThePerDeviceLockingFlag() = true;
+}
+
 #endif // MMDEVICE_CLIENT_BUILD
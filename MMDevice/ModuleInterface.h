@@ -38,7 +38,7 @@
 // If any of the exported module API calls (below) changes, the interface
 // version must be incremented. Note that the signature and name of
 // GetModuleVersion() must never change.
-#define MODULE_INTERFACE_VERSION 10
+#define MODULE_INTERFACE_VERSION 11
 
 extern "C" {
 #ifndef MMDEVICE_CLIENT_BUILD
@@ -105,6 +105,7 @@ extern "C" {
    MODULE_API bool GetDeviceName(unsigned deviceIndex, char* name, unsigned bufferLength);
    MODULE_API bool GetDeviceType(const char* deviceName, int* type);
    MODULE_API bool GetDeviceDescription(const char* deviceName, char* name, unsigned bufferLength);
+   MODULE_API bool GetPerDeviceLocking();
 #endif // MMDEVICE_CLIENT_BUILD
 
 #ifdef MMDEVICE_CLIENT_BUILD
@@ -118,6 +119,7 @@ extern "C" {
    typedef bool (*fnGetDeviceName)(unsigned, char*, unsigned);
    typedef bool (*fnGetDeviceType)(const char*, int*);
    typedef bool (*fnGetDeviceDescription)(const char*, char*, unsigned);
+   typedef bool (*fnGetPerDeviceLocking)();
 #endif // MMDEVICE_CLIENT_BUILD
 }
 
@@ -140,4 +142,22 @@ extern "C" {
  */
 void RegisterDevice(const char* deviceName, MM::DeviceType deviceType, const char* description);
 
+/**
+ * @brief Declare that the Core may call different devices concurrently.
+ *
+ * May be called in the device adapter module's implementation of
+ * InitializeModuleData().
+ *
+ * By default, the Core holds a single lock for the whole module while calling
+ * any of its devices. Calling this function makes the Core use a separate
+ * lock for each device instead, so that, for example, polling one device of a
+ * hub does not block a call to another. Each device is still called from only
+ * one thread at a time, but the module must protect any state shared between
+ * devices (including command/reply exchanges on a shared serial port) with
+ * its own locks.
+ *
+ * @see InitializeModuleData()
+ */
+void EnablePerDeviceLocking();
+
 #endif // MMDEVICE_CLIENT_BUILD
@@ -302,6 +302,67 @@ int MM::PropertyCollection::Get(const char* pszPropName, std::string& strValue)
    return DEVICE_OK;
 }
 
+template <typename T>
+int MM::PropertyCollection::SetNumeric(const char* pszPropName, T value)
+{
+   MM::Property* pProp = Find(pszPropName);
+   if (!pProp)
+      return DEVICE_INVALID_PROPERTY; // name not found
+
+   if (pProp->GetReadOnly())
+      return DEVICE_OK; // Same as Set(const char*)
+
+   // Discrete allowed values are strings; leave these to Set(const char*)
+   if (pProp->GetType() == MM::String || pProp->HasAllowedValues())
+      return DEVICE_INVALID_PROPERTY_TYPE;
+
+   // check property limits
+   if (!pProp->Set(value))
+      return DEVICE_INVALID_PROPERTY_VALUE;
+
+   return pProp->Apply();
+}
+
+template <typename T>
+int MM::PropertyCollection::GetNumeric(const char* pszPropName, T& value) const
+{
+   MM::Property* pProp = Find(pszPropName);
+   if (!pProp)
+      return DEVICE_INVALID_PROPERTY; // name not found
+
+   if (pProp->GetType() == MM::String)
+      return DEVICE_INVALID_PROPERTY_TYPE;
+
+   if (!pProp->GetCached())
+   {
+      int nRet = pProp->Update();
+      if (nRet != DEVICE_OK)
+         return nRet;
+   }
+   pProp->Get(value);
+   return DEVICE_OK;
+}
+
+int MM::PropertyCollection::Set(const char* pszPropName, double value)
+{
+   return SetNumeric(pszPropName, value);
+}
+
+int MM::PropertyCollection::Set(const char* pszPropName, long value)
+{
+   return SetNumeric(pszPropName, value);
+}
+
+int MM::PropertyCollection::Get(const char* pszPropName, double& value) const
+{
+   return GetNumeric(pszPropName, value);
+}
+
+int MM::PropertyCollection::Get(const char* pszPropName, long& value) const
+{
+   return GetNumeric(pszPropName, value);
+}
+
 MM::Property* MM::PropertyCollection::Find(const char* pszName) const
 {
    CPropArray::const_iterator it = properties_.find(pszName);
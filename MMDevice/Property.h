@@ -199,6 +199,7 @@ public:
 
    void AddAllowedValue(const char* value);
    void AddAllowedValue(const char* value, long data);
+   bool HasAllowedValues() const { return !values_.empty(); }
    bool IsAllowed(const char* value) const;
    bool GetData(const char* value, long& data) const;
 
@@ -450,6 +451,13 @@ public:
    int GetCurrentPropertyData(const char* name, long& data);
    int Set(const char* propName, const char* Value);
    int Get(const char* propName, std::string& val) const;
+   // Numeric access to Float and Integer properties, without conversion to
+   // and from strings. Return DEVICE_INVALID_PROPERTY_TYPE for String
+   // properties, and (for Set) for properties with discrete allowed values.
+   int Set(const char* propName, double value);
+   int Set(const char* propName, long value);
+   int Get(const char* propName, double& value) const;
+   int Get(const char* propName, long& value) const;
    Property* Find(const char* name) const;
    std::vector<std::string> GetNames() const;
    unsigned GetSize() const;
@@ -460,6 +468,9 @@ public:
    int Apply(const char* Name);
 
 private:
+   template <typename T> int SetNumeric(const char* propName, T value);
+   template <typename T> int GetNumeric(const char* propName, T& value) const;
+
    typedef std::map<std::string, Property*> CPropArray;
    CPropArray properties_;
 };
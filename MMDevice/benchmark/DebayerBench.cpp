@@ -0,0 +1,116 @@
+// Measures Debayer throughput by algorithm, input depth, frame size and
+// number of threads, and reports the results as JSON on stdout, so that runs
+// can be compared across commits. This is run by `meson test --benchmark`.
+//
+// Usage:
+//    debayer_bench [<minimum seconds per case>]
+
+#include "Debayer.h"
+#include "MMDeviceConstants.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double Seconds(Clock::duration d) {
+   return std::chrono::duration<double>(d).count();
+}
+
+template <typename T>
+std::vector<T> MakeMosaic(unsigned width, unsigned height, unsigned mask) {
+   std::mt19937 rng(1);
+   std::vector<T> pixels(static_cast<size_t>(width) * height);
+   for (auto& p : pixels)
+      p = static_cast<T>(rng() & mask);
+   return pixels;
+}
+
+// Process frames until at least minSeconds have passed; return the time per
+// frame in seconds
+template <typename T>
+double TimeFrames(Debayer& d, const std::vector<T>& in, unsigned width,
+      unsigned height, int bitDepth, double minSeconds) {
+   ImgBuffer out;
+   d.Process(out, in.data(), width, height, bitDepth); // Warm up
+   long frames = 0;
+   const auto start = Clock::now();
+   double elapsed = 0.0;
+   do {
+      if (d.Process(out, in.data(), width, height, bitDepth) != DEVICE_OK) {
+         std::cerr << "Debayer failed\n";
+         std::exit(1);
+      }
+      ++frames;
+      elapsed = Seconds(Clock::now() - start);
+   } while (elapsed < minSeconds);
+   return elapsed / frames;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+   if (argc > 2) {
+      std::cerr << "Usage: " << argv[0] << " [<minimum seconds per case>]\n";
+      return 2;
+   }
+   const double minSeconds = argc > 1 ? std::atof(argv[1]) : 0.25;
+
+   struct Size { unsigned width, height; };
+   const Size sizes[] = { {640, 480}, {2048, 2048} };
+   const int bitDepths[] = { 8, 12 };
+   const unsigned maxThreads =
+      std::max(1u, std::min(8u, std::thread::hardware_concurrency()));
+   std::vector<unsigned> threadCounts{ 1 };
+   if (maxThreads > 1)
+      threadCounts.push_back(maxThreads);
+
+   Debayer d;
+   const std::vector<std::string> algorithms = d.GetAlgorithms();
+   std::vector<std::string> entries;
+   for (const Size& size : sizes) {
+      const auto in8 = MakeMosaic<unsigned char>(size.width, size.height, 0xff);
+      const auto in16 = MakeMosaic<unsigned short>(size.width, size.height, 0xfff);
+      for (int bitDepth : bitDepths) {
+         for (size_t algorithm = 0; algorithm < algorithms.size(); ++algorithm) {
+            if (algorithms[algorithm] == "Adaptive-Smooth-Hue")
+               continue; // Not implemented
+            for (unsigned nThreads : threadCounts) {
+               d.SetAlgorithmIndex(static_cast<int>(algorithm));
+               d.SetMaxThreads(static_cast<int>(nThreads));
+               const double s = bitDepth == 8 ?
+                  TimeFrames(d, in8, size.width, size.height, bitDepth, minSeconds) :
+                  TimeFrames(d, in16, size.width, size.height, bitDepth, minSeconds);
+               std::ostringstream out;
+               out << "    {\"name\": \"" << algorithms[algorithm] << "\""
+                  << ", \"width\": " << size.width
+                  << ", \"height\": " << size.height
+                  << ", \"bit_depth\": " << bitDepth
+                  << ", \"threads\": " << nThreads
+                  << ", \"ms_per_frame\": " << 1e3 * s
+                  << ", \"megapixels_per_s\": "
+                  << 1e-6 * size.width * size.height / s << "}";
+               entries.push_back(out.str());
+            }
+         }
+      }
+   }
+
+   std::cout << "{\n"
+      << "  \"min_seconds_per_case\": " << minSeconds << ",\n"
+      << "  \"hardware_threads\": " << std::thread::hardware_concurrency()
+      << ",\n  \"results\": [";
+   for (size_t i = 0; i < entries.size(); ++i)
+      std::cout << (i ? ",\n" : "\n") << entries[i];
+   std::cout << "\n  ]\n}\n";
+   return 0;
+}
@@ -0,0 +1,236 @@
+#include <catch2/catch_all.hpp>
+
+#include "Debayer.h"
+#include "MMDeviceConstants.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+const int replication = 0;
+const int bilinear = 1;
+const int smoothHue = 2;
+const int adaptiveSmoothHue = 3;
+const int malvarHeCutler = 4;
+
+// Random mosaic, including zero pixels (which Smooth-Hue treats specially)
+template <typename T>
+std::vector<T> MakeMosaic(int width, int height, unsigned mask)
+{
+   std::mt19937 rng(42);
+   std::vector<T> pixels(width * height);
+   for (auto& p : pixels)
+   {
+      const unsigned r = rng();
+      p = static_cast<T>(r % 5 == 0 ? 0 : r & mask);
+   }
+   return pixels;
+}
+
+// Mosaic of a uniform color, using the sites that Debayer maps to the red
+// and blue components for each order
+std::vector<unsigned short> MakeUniformMosaic(int width, int height,
+      int order, unsigned short r, unsigned short g, unsigned short b)
+{
+   const int redSite[4][2] = { {0, 0}, {1, 1}, {0, 1}, {1, 0} };
+   std::vector<unsigned short> pixels(width * height);
+   for (int y = 0; y < height; ++y)
+   {
+      for (int x = 0; x < width; ++x)
+      {
+         const bool redRow = (y & 1) == redSite[order][1];
+         const bool colorSite = (x & 1) == (redRow ?
+               redSite[order][0] : 1 - redSite[order][0]);
+         pixels[y * width + x] = colorSite ? (redRow ? r : b) : g;
+      }
+   }
+   return pixels;
+}
+
+std::uint64_t Fnv1a(const unsigned char* p, std::size_t n)
+{
+   std::uint64_t hash = 14695981039346656037ull;
+   for (std::size_t i = 0; i < n; ++i)
+   {
+      hash ^= p[i];
+      hash *= 1099511628211ull;
+   }
+   return hash;
+}
+
+} // namespace
+
+TEST_CASE("Debayer lists the Malvar-He-Cutler algorithm", "[Debayer]")
+{
+   Debayer d;
+   const auto algorithms = d.GetAlgorithms();
+   REQUIRE(algorithms.size() == 5);
+   CHECK(algorithms[malvarHeCutler] == "Malvar-He-Cutler");
+   CHECK(d.GetOrders().size() == 4);
+}
+
+// Hashes of the output of the original (single-threaded, scratch buffer)
+// implementation, for a 37x29 mosaic and orders 0 to 3
+TEST_CASE("Replication and Smooth-Hue match the original output", "[Debayer]")
+{
+   const int width = 37;
+   const int height = 29;
+   const auto in8 = MakeMosaic<unsigned char>(width, height, 0xff);
+   const auto in16 = MakeMosaic<unsigned short>(width, height, 0xfff);
+
+   struct Golden
+   {
+      int algorithm;
+      int bitDepth;
+      std::uint64_t hashes[4];
+   };
+   const Golden goldens[] = {
+      { replication, 8, { 0x4fb8d319fbd48422ull, 0x1ec2b03af877416eull,
+         0x94022ef98bb5ad81ull, 0x0bba3d653a6646e1ull } },
+      { replication, 12, { 0xa5aaa18baff94902ull, 0x841d0b719f413b16ull,
+         0xa19965cc47b8c241ull, 0xd775c95bc6993fa9ull } },
+      { smoothHue, 8, { 0x639b5c2b5077c9f2ull, 0xc5bd07b4b60f07eeull,
+         0x8531d76fc0851794ull, 0xd75dc9ab7899ffd0ull } },
+      { smoothHue, 12, { 0xf3bbf9777b86577dull, 0x49304b0098a95eb5ull,
+         0xc82f5a9976bf2522ull, 0x13ff38fe14f1e7f6ull } },
+   };
+
+   for (const Golden& golden : goldens)
+   {
+      for (int order = 0; order < 4; ++order)
+      {
+         CAPTURE(golden.algorithm, golden.bitDepth, order);
+         Debayer d;
+         d.SetAlgorithmIndex(golden.algorithm);
+         d.SetOrderIndex(order);
+         ImgBuffer out;
+         const int ret = golden.bitDepth == 8 ?
+            d.Process(out, in8.data(), width, height, 8) :
+            d.Process(out, in16.data(), width, height, golden.bitDepth);
+         REQUIRE(ret == DEVICE_OK);
+         REQUIRE(out.Depth() == 4);
+         CHECK(Fnv1a(out.GetPixels(), width * height * 4) == golden.hashes[order]);
+      }
+   }
+}
+
+TEST_CASE("Debayer output does not depend on the number of threads", "[Debayer]")
+{
+   const int width = 517;
+   const int height = 301;
+   const auto in = MakeMosaic<unsigned short>(width, height, 0x3ff);
+
+   for (int algorithm : { replication, bilinear, smoothHue, malvarHeCutler })
+   {
+      CAPTURE(algorithm);
+      ImgBuffer single;
+      ImgBuffer multi;
+      Debayer d;
+      d.SetAlgorithmIndex(algorithm);
+      d.SetOrderIndex(3);
+      d.SetMaxThreads(1);
+      REQUIRE(d.Process(single, in.data(), width, height, 10) == DEVICE_OK);
+      d.SetMaxThreads(3);
+      REQUIRE(d.Process(multi, in.data(), width, height, 10) == DEVICE_OK);
+      CHECK(std::memcmp(single.GetPixels(), multi.GetPixels(),
+               width * height * 4) == 0);
+   }
+}
+
+TEST_CASE("Interpolating algorithms reproduce a uniform color", "[Debayer]")
+{
+   const int width = 9;
+   const int height = 7;
+   for (int algorithm : { bilinear, malvarHeCutler })
+   {
+      for (int order = 0; order < 4; ++order)
+      {
+         CAPTURE(algorithm, order);
+         const auto in = MakeUniformMosaic(width, height, order, 4000, 2000, 800);
+         Debayer d;
+         d.SetAlgorithmIndex(algorithm);
+         d.SetOrderIndex(order);
+         d.SetRGB64Output(true);
+         ImgBuffer out;
+         REQUIRE(d.Process(out, in.data(), width, height, 12) == DEVICE_OK);
+         REQUIRE(out.Depth() == 8);
+         const unsigned short* pix =
+            reinterpret_cast<const unsigned short*>(out.GetPixels());
+         for (int i = 0; i < width * height; ++i)
+         {
+            CAPTURE(i);
+            REQUIRE(pix[4 * i + 0] == 800);
+            REQUIRE(pix[4 * i + 1] == 2000);
+            REQUIRE(pix[4 * i + 2] == 4000);
+            REQUIRE(pix[4 * i + 3] == 0);
+         }
+      }
+   }
+}
+
+TEST_CASE("Malvar-He-Cutler clamps to the bit depth", "[Debayer]")
+{
+   // The gradient correction overshoots near a dark or bright pixel. With
+   // order 0, (3, 3) and (5, 3) are blue sites; red at (5, 3) is corrected
+   // by the Laplacian of blue around it.
+   const int width = 8;
+   const int height = 8;
+   Debayer d;
+   d.SetAlgorithmIndex(malvarHeCutler);
+   ImgBuffer out;
+
+   std::vector<unsigned char> in(width * height, 250);
+   in[3 * width + 3] = 0;
+   REQUIRE(d.Process(out, in.data(), width, height, 8) == DEVICE_OK);
+   CHECK(out.GetPixels()[4 * (3 * width + 5) + 2] == 255);
+
+   std::fill(in.begin(), in.end(), 10);
+   in[3 * width + 3] = 255;
+   REQUIRE(d.Process(out, in.data(), width, height, 8) == DEVICE_OK);
+   CHECK(out.GetPixels()[4 * (3 * width + 5) + 2] == 0);
+}
+
+TEST_CASE("RGB64 output keeps the input scale", "[Debayer]")
+{
+   const int width = 12;
+   const int height = 10;
+   const auto in = MakeMosaic<unsigned short>(width, height, 0xfff);
+
+   Debayer d;
+   ImgBuffer rgb32;
+   REQUIRE(d.Process(rgb32, in.data(), width, height, 12) == DEVICE_OK);
+   d.SetRGB64Output(true);
+   ImgBuffer rgb64;
+   REQUIRE(d.Process(rgb64, in.data(), width, height, 12) == DEVICE_OK);
+   REQUIRE(rgb64.Depth() == 8);
+
+   const unsigned short* wide =
+      reinterpret_cast<const unsigned short*>(rgb64.GetPixels());
+   for (int i = 0; i < width * height * 4; ++i)
+   {
+      CAPTURE(i);
+      REQUIRE(wide[i] >> 4 == rgb32.GetPixels()[i]);
+   }
+
+   // 8-bit input always gives RGB32
+   const auto in8 = MakeMosaic<unsigned char>(width, height, 0xff);
+   ImgBuffer out;
+   REQUIRE(d.Process(out, in8.data(), width, height, 8) == DEVICE_OK);
+   CHECK(out.Depth() == 4);
+}
+
+TEST_CASE("Debayer rejects unsupported settings", "[Debayer]")
+{
+   const auto in = MakeMosaic<unsigned char>(4, 4, 0xff);
+   ImgBuffer out;
+   Debayer d;
+   d.SetAlgorithmIndex(adaptiveSmoothHue);
+   CHECK(d.Process(out, in.data(), 4, 4, 8) == DEVICE_NOT_SUPPORTED);
+   d.SetAlgorithmIndex(replication);
+   d.SetOrderIndex(4);
+   CHECK(d.Process(out, in.data(), 4, 4, 8) == DEVICE_INVALID_INPUT_PARAM);
+}
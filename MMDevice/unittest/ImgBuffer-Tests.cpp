@@ -0,0 +1,143 @@
+#include <catch2/catch_all.hpp>
+
+#include "ImgBuffer.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+bool IsAligned(const unsigned char* p)
+{
+   return reinterpret_cast<std::uintptr_t>(p) % ImgBuffer::Alignment == 0;
+}
+
+} // namespace
+
+TEST_CASE("ImgBuffer pixels are aligned and zeroed", "[ImgBuffer]")
+{
+   ImgBuffer img(13, 7, 3);
+   REQUIRE(img.GetPixels() != nullptr);
+   CHECK(IsAligned(img.GetPixels()));
+   CHECK(img.Capacity() == 13 * 7 * 3);
+   for (unsigned i = 0; i < 13 * 7 * 3; ++i)
+      REQUIRE(img.GetPixels()[i] == 0);
+
+   ImgBuffer empty;
+   CHECK(empty.GetPixels() == nullptr);
+   CHECK(empty.Capacity() == 0);
+}
+
+TEST_CASE("ImgBuffer keeps its storage when shrinking", "[ImgBuffer]")
+{
+   ImgBuffer img(64, 64, 2);
+   const unsigned char* pixels = img.GetPixels();
+
+   img.Resize(32, 16, 2);
+   CHECK(img.GetPixels() == pixels);
+   img.Resize(64, 64);
+   CHECK(img.GetPixels() == pixels);
+   CHECK(img.Width() == 64);
+   CHECK(img.Capacity() == 64 * 64 * 2);
+
+   img.Resize(10, 10, 1);
+   img.ShrinkToFit();
+   CHECK(img.Capacity() == 100);
+   CHECK(IsAligned(img.GetPixels()));
+
+   img.Resize(11, 10);
+   CHECK(img.Capacity() == 110);
+   for (unsigned i = 0; i < 110; ++i)
+      REQUIRE(img.GetPixels()[i] == 0);
+}
+
+TEST_CASE("ImgBuffer copies and moves", "[ImgBuffer]")
+{
+   // Lets containers move rather than copy images
+   STATIC_REQUIRE(std::is_nothrow_move_constructible<ImgBuffer>::value);
+   STATIC_REQUIRE(std::is_nothrow_move_assignable<ImgBuffer>::value);
+
+   ImgBuffer a(5, 4, 2);
+   for (unsigned i = 0; i < 40; ++i)
+      a.GetPixelsRW()[i] = static_cast<unsigned char>(i);
+
+   ImgBuffer b(a);
+   REQUIRE(b.Compatible(a));
+   CHECK(b.GetPixels() != a.GetPixels());
+   CHECK(std::memcmp(b.GetPixels(), a.GetPixels(), 40) == 0);
+
+   ImgBuffer c(10, 10, 1);
+   const unsigned char* cPixels = c.GetPixels();
+   c = a;
+   CHECK(c.GetPixels() == cPixels);
+   CHECK(std::memcmp(c.GetPixels(), a.GetPixels(), 40) == 0);
+
+   const unsigned char* aPixels = a.GetPixels();
+   ImgBuffer d(std::move(a));
+   CHECK(d.GetPixels() == aPixels);
+   CHECK(d.Width() == 5);
+   CHECK(a.GetPixels() == nullptr);
+   CHECK(a.Width() == 0);
+
+   c = std::move(d);
+   CHECK(c.GetPixels() == aPixels);
+   CHECK(d.GetPixels() == nullptr);
+
+   std::vector<ImgBuffer> images;
+   images.emplace_back(3, 3, 1);
+   images.emplace_back(4, 4, 1);
+   CHECK(images[0].Width() == 3);
+}
+
+TEST_CASE("ImgBuffer copies padded rows", "[ImgBuffer]")
+{
+   const unsigned char padded[] = { 1, 2, 9, 3, 4, 9, 5, 6, 9 };
+   ImgBuffer img(2, 3, 1);
+   img.SetPixelsPadded(padded, 1);
+   const unsigned char expected[] = { 1, 2, 3, 4, 5, 6 };
+   CHECK(std::memcmp(img.GetPixels(), expected, 6) == 0);
+
+   img.SetPixelsPadded(expected, 0);
+   CHECK(std::memcmp(img.GetPixels(), expected, 6) == 0);
+}
+
+TEST_CASE("ImgBuffers reuse storage through a pool", "[ImgBuffer]")
+{
+   auto pool = std::make_shared<ImgBufferPool>(1000);
+   const unsigned char* pixels;
+   {
+      ImgBuffer img(pool);
+      img.Resize(20, 20, 1);
+      pixels = img.GetPixels();
+      CHECK(IsAligned(pixels));
+      CHECK(pool->GetRetainedBytes() == 0);
+   }
+   CHECK(pool->GetRetainedBytes() == 400);
+
+   ImgBuffer img(pool);
+   img.Resize(15, 20, 1);
+   CHECK(img.GetPixels() == pixels);
+   CHECK(img.Capacity() == 400);
+   CHECK(pool->GetRetainedBytes() == 0);
+
+   // Not reused for a much smaller image
+   ImgBuffer copy(img);
+   CHECK(copy.GetPool() == pool);
+   img.Resize(2, 2, 1);
+   copy = ImgBuffer();
+   copy.Resize(2, 2, 1);
+   CHECK(copy.Capacity() == 4);
+
+   // Blocks that don't fit are freed
+   {
+      ImgBuffer big(pool);
+      big.Resize(40, 40, 1);
+   }
+   CHECK(pool->GetRetainedBytes() == 300);
+   pool->Clear();
+   CHECK(pool->GetRetainedBytes() == 0);
+}
@@ -0,0 +1,66 @@
+#include <catch2/catch_all.hpp>
+
+#include "MMDeviceConstants.h"
+#include "Property.h"
+
+#include <string>
+
+namespace MM {
+
+TEST_CASE("Numeric set and get of Float property", "[PropertyCollectionNumeric]")
+{
+   PropertyCollection pc;
+   REQUIRE(pc.CreateProperty("Pos", "0.0", Float, false) == DEVICE_OK);
+   REQUIRE(pc.Find("Pos")->SetLimits(-10.0, 10.0));
+
+   double d;
+   long l;
+   CHECK(pc.Set("Pos", 1.23456) == DEVICE_OK);
+   CHECK(pc.Get("Pos", d) == DEVICE_OK);
+   CHECK(d == 1.2346);
+   CHECK(pc.Get("Pos", l) == DEVICE_OK);
+   CHECK(l == 1);
+
+   CHECK(pc.Set("Pos", 3L) == DEVICE_OK);
+   CHECK(pc.Get("Pos", d) == DEVICE_OK);
+   CHECK(d == 3.0);
+
+   CHECK(pc.Set("Pos", 11.0) == DEVICE_INVALID_PROPERTY_VALUE);
+   CHECK(pc.Get("Pos", d) == DEVICE_OK);
+   CHECK(d == 3.0);
+}
+
+TEST_CASE("Numeric access to non-numeric properties is refused",
+   "[PropertyCollectionNumeric]")
+{
+   PropertyCollection pc;
+   REQUIRE(pc.CreateProperty("Name", "abc", String, false) == DEVICE_OK);
+   REQUIRE(pc.CreateProperty("Mode", "0", Integer, false) == DEVICE_OK);
+   pc.AddAllowedValue("Mode", "0");
+   pc.AddAllowedValue("Mode", "1");
+
+   double d;
+   long l;
+   CHECK(pc.Get("Name", d) == DEVICE_INVALID_PROPERTY_TYPE);
+   CHECK(pc.Set("Name", 1.0) == DEVICE_INVALID_PROPERTY_TYPE);
+   CHECK(pc.Set("Mode", 1L) == DEVICE_INVALID_PROPERTY_TYPE);
+   CHECK(pc.Get("Mode", l) == DEVICE_OK);
+   CHECK(l == 0);
+
+   CHECK(pc.Get("Missing", d) == DEVICE_INVALID_PROPERTY);
+   CHECK(pc.Set("Missing", 1.0) == DEVICE_INVALID_PROPERTY);
+}
+
+TEST_CASE("Numeric set of read-only property is ignored",
+   "[PropertyCollectionNumeric]")
+{
+   PropertyCollection pc;
+   REQUIRE(pc.CreateProperty("Temp", "20", Integer, true) == DEVICE_OK);
+
+   long l;
+   CHECK(pc.Set("Temp", 25L) == DEVICE_OK);
+   CHECK(pc.Get("Temp", l) == DEVICE_OK);
+   CHECK(l == 20);
+}
+
+} // namespace MM